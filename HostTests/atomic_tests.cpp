@@ -0,0 +1,191 @@
+//
+// Runs the tiny::atomic tests on the std::atomic backend, the one every build but the MSVC
+// kernel build uses. Host tool, build from the repository root with
+//   cl /std:c++20 /EHsc /IKernelSTL HostTests\atomic_tests.cpp
+//   g++ -std=c++20 -IKernelSTL HostTests/atomic_tests.cpp -o atomic_tests -pthread -latomic
+//
+// usage: atomic_tests, exits with 1 when a check failed
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <thread>
+#include "atomic.hpp"
+
+static int failures;
+
+#define Check(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+		++failures; \
+	} \
+} while (0)
+
+struct tagged {
+	void* pointer;
+	uint64_t tag;
+};
+
+static void testIntegerOperations()
+{
+	tiny::atomic<long> value(5);
+	Check(value.load(tiny::memory_order_relaxed) == 5);
+
+	value.store(7, tiny::memory_order_release);
+	Check(value.load(tiny::memory_order_acquire) == 7);
+	Check(value.exchange(9, tiny::memory_order_acq_rel) == 7);
+	Check(value.fetch_add(3) == 9);
+	Check(value.fetch_sub(2, tiny::memory_order_relaxed) == 12);
+	Check(++value == 11 && value++ == 11 && value == 12);
+	Check(--value == 11 && value-- == 11 && value == 10);
+	Check((value += 5) == 15 && (value -= 15) == 0);
+
+	value = 0x0F;
+	Check(value.fetch_or(0xF0) == 0x0F && value == 0xFF);
+	Check(value.fetch_and(0x3C) == 0xFF && value == 0x3C);
+	Check(value.fetch_xor(0xFF) == 0x3C && value == 0xC3);
+
+	long expected = 1;
+	Check(!value.compare_exchange_strong(expected, 2) && expected == 0xC3);
+	Check(value.compare_exchange_strong(expected, 2) && value == 2);
+
+	while (!value.compare_exchange_weak(expected, 3, tiny::memory_order_acq_rel))
+		;
+
+	Check(value == 3);
+}
+
+static void testSizes()
+{
+	tiny::atomic<unsigned char> byte(0xFF);
+	Check(++byte == 0);
+
+	tiny::atomic<short> word(-1);
+	Check(word.fetch_add(1) == -1 && word == 0);
+
+	tiny::atomic<uint64_t> quad(1ull << 40);
+	Check(quad.fetch_add(1) == 1ull << 40 && quad == (1ull << 40) + 1);
+
+	tiny::atomic<bool> flag;
+	Check(!flag.exchange(true) && flag);
+}
+
+static void testPointers()
+{
+	uint64_t values[4] = {};
+	tiny::atomic<uint64_t*> pointer(values);
+
+	// moves by elements
+	Check(pointer.fetch_add(2) == values && pointer == values + 2);
+	Check(pointer.fetch_sub(1) == values + 2 && pointer == values + 1);
+	Check((pointer += 3) == values + 4);
+}
+
+static void testDoubleWidth()
+{
+	uint64_t node = 0;
+	tiny::atomic<tagged> head(tagged{ nullptr, 0 });
+
+	auto current = head.load(tiny::memory_order_acquire);
+	Check(current.pointer == nullptr && current.tag == 0);
+	Check(head.compare_exchange_strong(current, tagged{ &node, 1 }));
+
+	tagged stale{ nullptr, 0 };
+	Check(!head.compare_exchange_strong(stale, tagged{ nullptr, 2 }));
+	Check(stale.pointer == &node && stale.tag == 1);
+
+	auto previous = head.exchange(tagged{ nullptr, 3 });
+	Check(previous.pointer == &node && previous.tag == 1);
+	Check(head.load().tag == 3);
+}
+
+static void testContention()
+{
+	const int threads = 4;
+	const int rounds = 100000;
+
+	tiny::atomic<uint64_t> sum;
+	tiny::atomic<tagged> pair(tagged{ nullptr, 0 });
+
+	std::thread workers[threads];
+	for (auto& worker : workers)
+	{
+		worker = std::thread([&]() {
+			for (int i = 0; i < rounds; ++i)
+			{
+				sum.fetch_add(1, tiny::memory_order_relaxed);
+
+				auto current = pair.load(tiny::memory_order_relaxed);
+				while (!pair.compare_exchange_weak(current, tagged{ nullptr, current.tag + 1 }))
+					;
+			}
+		});
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+
+	Check(sum == static_cast<uint64_t>(threads) * rounds);
+	Check(pair.load().tag == static_cast<uint64_t>(threads) * rounds);
+}
+
+static void testFlag()
+{
+	tiny::atomic_flag flag;
+	Check(!flag.test());
+	Check(!flag.test_and_set(tiny::memory_order_acquire));
+	Check(flag.test_and_set() && flag.test());
+
+	// returns at once when the value differs
+	flag.wait(false);
+
+	flag.clear(tiny::memory_order_release);
+	Check(!flag.test());
+	flag.notify_all();
+}
+
+static void testWaitNotify()
+{
+	const unsigned long rounds = 1000;
+	tiny::atomic<unsigned long> turn;
+
+	// odd turns are the other thread's
+	std::thread other([&]() {
+		for (unsigned long i = 0; i < rounds; ++i)
+		{
+			turn.wait(2 * i, tiny::memory_order_acquire);
+			turn.store(2 * i + 2, tiny::memory_order_release);
+			turn.notify_one();
+		}
+	});
+
+	for (unsigned long i = 0; i < rounds; ++i)
+	{
+		turn.store(2 * i + 1, tiny::memory_order_release);
+		turn.notify_one();
+		turn.wait(2 * i + 1, tiny::memory_order_acquire);
+	}
+
+	other.join();
+	Check(turn == 2 * rounds);
+}
+
+int main()
+{
+	testIntegerOperations();
+	testSizes();
+	testPointers();
+	testDoubleWidth();
+	testContention();
+	testFlag();
+	testWaitNotify();
+
+	if (failures)
+	{
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("atomic tests passed\n");
+	return 0;
+}
@@ -0,0 +1,81 @@
+//
+// Measures the throughput of tiny::hash_bytes against FNV-1a and the cost of tiny::hash_mix,
+// the host counterpart of benchmarkHash in benchmarks.cpp. Host tool, build from the
+// repository root with optimizations on
+//   cl /std:c++17 /O2 /EHsc /IKernelSTL HostTests\hash_benchmark.cpp
+//   g++ -std=c++17 -O2 -IKernelSTL HostTests/hash_benchmark.cpp -o hash_benchmark
+//
+// usage: hash_benchmark
+//
+
+#include <stdio.h>
+#include <chrono>
+#include "hash_bytes.hpp"
+
+// keeps results alive so the compiler cannot drop the measured calls
+static volatile unsigned long long sink;
+
+static unsigned long long fnv1a(const unsigned char* data, size_t size)
+{
+	unsigned long long hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+template <typename Body>
+static double nsPerCall(size_t iterations, Body&& body)
+{
+	// warms up caches and clock speed
+	for (size_t i = 0; i < iterations / 16; ++i)
+		body(i);
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		body(i);
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+int main()
+{
+	static unsigned char data[65536];
+	for (size_t i = 0; i < sizeof(data); ++i)
+		data[i] = static_cast<unsigned char>(i * 131 + 7);
+
+	const size_t sizes[] = { 8, 16, 32, 64, 256, 1024, 4096, 65536 };
+
+	printf("%8s %14s %10s %14s %10s\n", "bytes", "hash_bytes ns", "GB/s", "fnv1a ns", "GB/s");
+	for (auto size : sizes)
+	{
+		// about 256 MB through each function
+		auto iterations = (256u << 20) / size;
+
+		auto hashNs = nsPerCall(iterations, [&](size_t i) {
+			sink = tiny::hash_bytes(data, size, i);
+		});
+
+		auto fnvNs = nsPerCall(iterations, [&](size_t i) {
+			data[0] = static_cast<unsigned char>(i);
+			sink = fnv1a(data, size);
+		});
+
+		printf("%8zu %14.2f %10.2f %14.2f %10.2f\n", size, hashNs, size / hashNs, fnvNs, size / fnvNs);
+	}
+
+	// each call depends on the previous one, so this is the latency
+	unsigned long long value = 0;
+	auto mixNs = nsPerCall(100000000, [&](size_t i) {
+		value = tiny::hash_mix(value + i);
+	});
+
+	sink = value;
+
+	printf("hash_mix: %.2f ns\n", mixNs);
+	return 0;
+}
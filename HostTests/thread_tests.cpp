@@ -0,0 +1,107 @@
+//
+// Runs system_thread and semaphore on their std::thread backend, the one every build but the
+// kernel build uses. Host tool, build from the repository root with
+//   cl /std:c++20 /EHsc /IKernelSTL HostTests\thread_tests.cpp
+//   g++ -std=c++20 -IKernelSTL HostTests/thread_tests.cpp -o thread_tests -pthread -latomic
+//
+// usage: thread_tests, exits with 1 when a check failed
+//
+
+#include <stdio.h>
+#include "thread.hpp"
+#include "atomic.hpp"
+
+static int failures;
+
+#define Check(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+		++failures; \
+	} \
+} while (0)
+
+struct Counter {
+	tiny::atomic<long> value;
+	long rounds;
+};
+
+static void countRoutine(void* context)
+{
+	auto counter = static_cast<Counter*>(context);
+	for (long i = 0; i < counter->rounds; ++i)
+		counter->value.fetch_add(1, tiny::memory_order_relaxed);
+}
+
+static void testStartJoin()
+{
+	Counter counter{ 0, 100000 };
+
+	{
+		tiny::system_thread threads[4];
+		for (auto& thread : threads)
+		{
+			Check(!thread.joinable());
+			thread.start(countRoutine, &counter);
+			Check(thread.joinable());
+		}
+
+		threads[0].join();
+		Check(!threads[0].joinable());
+
+		// the destructors join the others
+	}
+
+	Check(counter.value == 4 * counter.rounds);
+}
+
+struct Handoff {
+	tiny::semaphore ready;
+	tiny::semaphore done;
+	long items;
+	long consumed;
+};
+
+static void consumeRoutine(void* context)
+{
+	auto handoff = static_cast<Handoff*>(context);
+	for (long i = 0; i < handoff->items; ++i)
+	{
+		handoff->ready.acquire();
+		++handoff->consumed;
+	}
+
+	handoff->done.release();
+}
+
+static void testSemaphore()
+{
+	Handoff handoff{ {}, {}, 1000, 0 };
+
+	tiny::system_thread consumer;
+	consumer.start(consumeRoutine, &handoff);
+
+	// one at a time, then the rest at once
+	for (long i = 0; i < handoff.items / 2; ++i)
+		handoff.ready.release();
+
+	handoff.ready.release(handoff.items - handoff.items / 2);
+	handoff.done.acquire();
+	consumer.join();
+
+	Check(handoff.consumed == handoff.items);
+}
+
+int main()
+{
+	testStartJoin();
+	testSemaphore();
+
+	if (failures)
+	{
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("thread tests passed\n");
+	return 0;
+}
@@ -0,0 +1,836 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace tiny {
+	struct less {
+		template <typename A, typename B>
+		constexpr bool operator()(const A& left, const B& right) const {
+			return left < right;
+		}
+	};
+
+	struct greater {
+		template <typename A, typename B>
+		constexpr bool operator()(const A& left, const B& right) const {
+			return right < left;
+		}
+	};
+
+	struct equal_to {
+		template <typename A, typename B>
+		constexpr bool operator()(const A& left, const B& right) const {
+			return left == right;
+		}
+	};
+
+	template <typename It>
+	using _iter_value_t = remove_cv_t<remove_reference_t<decltype(*tiny::declval<It>())>>;
+
+	template <typename It>
+	inline void iter_swap(It left, It right) {
+		tiny::swap(*left, *right);
+	}
+
+	//
+	// heap helpers, used as the worst case fallback of sort
+	//
+
+	template <typename It, typename Compare>
+	inline void _sift_down(It first, size_t size, size_t hole, Compare& comp) {
+		auto value = tiny::move(first[hole]);
+
+		for (size_t child = 2 * hole + 1; child < size; child = 2 * hole + 1)
+		{
+			if (child + 1 < size && comp(first[child], first[child + 1]))
+				++child;
+
+			if (!comp(value, first[child]))
+				break;
+
+			first[hole] = tiny::move(first[child]);
+			hole = child;
+		}
+
+		first[hole] = tiny::move(value);
+	}
+
+	template <typename It, typename Compare>
+	inline void _heap_sort(It first, It last, Compare& comp) {
+		size_t size = last - first;
+
+		for (size_t i = size / 2; i-- > 0;)
+			_sift_down(first, size, i, comp);
+
+		while (size > 1)
+		{
+			tiny::iter_swap(first, first + --size);
+			_sift_down(first, size, 0, comp);
+		}
+	}
+
+	//
+	// pattern-defeating quicksort
+	//
+
+	inline const size_t _insertion_sort_threshold = 24;
+	inline const size_t _ninther_threshold = 128;
+	inline const size_t _partial_insertion_sort_limit = 8;
+
+	template <typename It, typename Compare>
+	inline void _insertion_sort(It first, It last, Compare& comp) {
+		if (first == last)
+			return;
+
+		for (auto current = first + 1; current != last; ++current)
+		{
+			auto sift = current;
+			auto siftPrev = current - 1;
+
+			if (comp(*sift, *siftPrev))
+			{
+				auto value = tiny::move(*sift);
+
+				do {
+					*sift-- = tiny::move(*siftPrev);
+				} while (sift != first && comp(value, *--siftPrev));
+
+				*sift = tiny::move(value);
+			}
+		}
+	}
+
+	// Requires an element not greater than any element of the range right before first.
+	template <typename It, typename Compare>
+	inline void _unguarded_insertion_sort(It first, It last, Compare& comp) {
+		if (first == last)
+			return;
+
+		for (auto current = first + 1; current != last; ++current)
+		{
+			auto sift = current;
+			auto siftPrev = current - 1;
+
+			if (comp(*sift, *siftPrev))
+			{
+				auto value = tiny::move(*sift);
+
+				do {
+					*sift-- = tiny::move(*siftPrev);
+				} while (comp(value, *--siftPrev));
+
+				*sift = tiny::move(value);
+			}
+		}
+	}
+
+	// Gives up after moving more than _partial_insertion_sort_limit elements.
+	template <typename It, typename Compare>
+	inline bool _partial_insertion_sort(It first, It last, Compare& comp) {
+		if (first == last)
+			return true;
+
+		size_t moves = 0;
+		for (auto current = first + 1; current != last; ++current)
+		{
+			auto sift = current;
+			auto siftPrev = current - 1;
+
+			if (comp(*sift, *siftPrev))
+			{
+				auto value = tiny::move(*sift);
+
+				do {
+					*sift-- = tiny::move(*siftPrev);
+				} while (sift != first && comp(value, *--siftPrev));
+
+				*sift = tiny::move(value);
+				moves += current - sift;
+			}
+
+			if (moves > _partial_insertion_sort_limit)
+				return false;
+		}
+
+		return true;
+	}
+
+	template <typename It, typename Compare>
+	inline void _sort2(It a, It b, Compare& comp) {
+		if (comp(*b, *a))
+			tiny::iter_swap(a, b);
+	}
+
+	template <typename It, typename Compare>
+	inline void _sort3(It a, It b, It c, Compare& comp) {
+		_sort2(a, b, comp);
+		_sort2(b, c, comp);
+		_sort2(a, b, comp);
+	}
+
+	// Moves the median of a few samples to *first.
+	template <typename It, typename Compare>
+	inline void _choose_pivot(It first, It last, Compare& comp) {
+		size_t size = last - first;
+		size_t half = size / 2;
+
+		if (size > _ninther_threshold)
+		{
+			_sort3(first, first + half, last - 1, comp);
+			_sort3(first + 1, first + (half - 1), last - 2, comp);
+			_sort3(first + 2, first + (half + 1), last - 3, comp);
+			_sort3(first + (half - 1), first + half, first + (half + 1), comp);
+			tiny::iter_swap(first, first + half);
+		}
+		else
+			_sort3(first + half, first, last - 1, comp);
+	}
+
+	// Partitions around *first, elements equal to the pivot go to the right side.
+	template <typename It, typename Compare>
+	inline It _partition_right(It begin, It end, Compare& comp, bool& alreadyPartitioned) {
+		auto pivot = tiny::move(*begin);
+		auto first = begin;
+		auto last = end;
+
+		while (comp(*++first, pivot));
+
+		if (first - 1 == begin)
+			while (first < last && !comp(*--last, pivot));
+		else
+			while (!comp(*--last, pivot));
+
+		alreadyPartitioned = first >= last;
+
+		while (first < last)
+		{
+			tiny::iter_swap(first, last);
+			while (comp(*++first, pivot));
+			while (!comp(*--last, pivot));
+		}
+
+		auto pivotPos = first - 1;
+		*begin = tiny::move(*pivotPos);
+		*pivotPos = tiny::move(pivot);
+
+		return pivotPos;
+	}
+
+	// Partitions around *first, elements equal to the pivot go to the left side.
+	template <typename It, typename Compare>
+	inline It _partition_left(It begin, It end, Compare& comp) {
+		auto pivot = tiny::move(*begin);
+		auto first = begin;
+		auto last = end;
+
+		while (comp(pivot, *--last));
+
+		if (last + 1 == end)
+			while (first < last && !comp(pivot, *++first));
+		else
+			while (!comp(pivot, *++first));
+
+		while (first < last)
+		{
+			tiny::iter_swap(first, last);
+			while (comp(pivot, *--last));
+			while (!comp(pivot, *++first));
+		}
+
+		auto pivotPos = last;
+		*begin = tiny::move(*pivotPos);
+		*pivotPos = tiny::move(pivot);
+
+		return pivotPos;
+	}
+
+	template <typename It>
+	inline void _break_patterns(It first, It pivotPos, It last) {
+		size_t leftSize = pivotPos - first;
+		size_t rightSize = last - (pivotPos + 1);
+
+		if (leftSize >= _insertion_sort_threshold)
+		{
+			tiny::iter_swap(first, first + leftSize / 4);
+			tiny::iter_swap(pivotPos - 1, pivotPos - leftSize / 4);
+
+			if (leftSize > _ninther_threshold)
+			{
+				tiny::iter_swap(first + 1, first + (leftSize / 4 + 1));
+				tiny::iter_swap(first + 2, first + (leftSize / 4 + 2));
+				tiny::iter_swap(pivotPos - 2, pivotPos - (leftSize / 4 + 1));
+				tiny::iter_swap(pivotPos - 3, pivotPos - (leftSize / 4 + 2));
+			}
+		}
+
+		if (rightSize >= _insertion_sort_threshold)
+		{
+			tiny::iter_swap(pivotPos + 1, pivotPos + (1 + rightSize / 4));
+			tiny::iter_swap(last - 1, last - rightSize / 4);
+
+			if (rightSize > _ninther_threshold)
+			{
+				tiny::iter_swap(pivotPos + 2, pivotPos + (2 + rightSize / 4));
+				tiny::iter_swap(pivotPos + 3, pivotPos + (3 + rightSize / 4));
+				tiny::iter_swap(last - 2, last - (1 + rightSize / 4));
+				tiny::iter_swap(last - 3, last - (2 + rightSize / 4));
+			}
+		}
+	}
+
+	/*
+	* Recurses into the smaller partition and loops on the larger one, so the stack depth stays
+	* within log2(n) frames which matters on small kernel stacks.
+	*/
+	template <typename It, typename Compare>
+	inline void _pdqsort_loop(It first, It last, Compare& comp, int badAllowed, bool leftmost) {
+		while (true)
+		{
+			size_t size = last - first;
+
+			if (size < _insertion_sort_threshold)
+			{
+				if (leftmost)
+					_insertion_sort(first, last, comp);
+				else
+					_unguarded_insertion_sort(first, last, comp);
+
+				return;
+			}
+
+			_choose_pivot(first, last, comp);
+
+			// pivot equals the element before the range, all equal elements can be skipped at once
+			if (!leftmost && !comp(*(first - 1), *first))
+			{
+				first = _partition_left(first, last, comp) + 1;
+				continue;
+			}
+
+			bool alreadyPartitioned;
+			auto pivotPos = _partition_right(first, last, comp, alreadyPartitioned);
+
+			size_t leftSize = pivotPos - first;
+			size_t rightSize = last - (pivotPos + 1);
+
+			if (leftSize < size / 8 || rightSize < size / 8)
+			{
+				if (--badAllowed == 0)
+					return _heap_sort(first, last, comp);
+
+				_break_patterns(first, pivotPos, last);
+			}
+			else if (alreadyPartitioned
+				&& _partial_insertion_sort(first, pivotPos, comp)
+				&& _partial_insertion_sort(pivotPos + 1, last, comp))
+				return;
+
+			if (leftSize < rightSize)
+			{
+				_pdqsort_loop(first, pivotPos, comp, badAllowed, leftmost);
+				first = pivotPos + 1;
+				leftmost = false;
+			}
+			else
+			{
+				_pdqsort_loop(pivotPos + 1, last, comp, badAllowed, false);
+				last = pivotPos;
+			}
+		}
+	}
+
+	inline int _log2(size_t value) {
+		int result = 0;
+		while (value >>= 1)
+			++result;
+
+		return result;
+	}
+
+	template <typename It, typename Compare>
+	inline void sort(It first, It last, Compare comp) {
+		if (last - first < 2)
+			return;
+
+		_pdqsort_loop(first, last, comp, _log2(last - first), true);
+	}
+
+	template <typename It>
+	inline void sort(It first, It last) {
+		tiny::sort(first, last, tiny::less());
+	}
+
+	//
+	// stable_sort
+	//
+
+	// Merges [first, middle) and [middle, last) using buffer for a copy of the left half.
+	template <typename It, typename T, typename Compare>
+	inline void _merge_with_buffer(It first, It middle, It last, T* buffer, Compare& comp) {
+		size_t leftSize = middle - first;
+		for (size_t i = 0; i < leftSize; ++i)
+			new (buffer + i) T(tiny::move(first[i]));
+
+		auto left = buffer;
+		auto leftEnd = buffer + leftSize;
+		auto right = middle;
+		auto out = first;
+
+		while (left != leftEnd && right != last)
+		{
+			if (comp(*right, *left))
+				*out++ = tiny::move(*right++);
+			else
+				*out++ = tiny::move(*left++);
+		}
+
+		while (left != leftEnd)
+			*out++ = tiny::move(*left++);
+
+		for (size_t i = 0; i < leftSize; ++i)
+			buffer[i].~T();
+	}
+
+	template <typename It, typename T, typename Compare>
+	inline void _merge_sort(It first, It last, T* buffer, Compare& comp) {
+		size_t size = last - first;
+		if (size <= _insertion_sort_threshold)
+			return _insertion_sort(first, last, comp);
+
+		auto middle = first + size / 2;
+		_merge_sort(first, middle, buffer, comp);
+		_merge_sort(middle, last, buffer, comp);
+
+		// halves are already in order
+		if (!comp(*middle, *(middle - 1)))
+			return;
+
+		_merge_with_buffer(first, middle, last, buffer, comp);
+	}
+
+	template <typename It, typename Compare>
+	inline void stable_sort(It first, It last, Compare comp) {
+		using T = _iter_value_t<It>;
+
+		size_t size = last - first;
+		if (size <= _insertion_sort_threshold)
+			return _insertion_sort(first, last, comp);
+
+		auto buffer = reinterpret_cast<T*>(ALLOC_MEMORY((size / 2) * sizeof(T)));
+		if (!buffer)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		_merge_sort(first, last, buffer, comp);
+		FREE_MEMORY(buffer);
+	}
+
+	template <typename It>
+	inline void stable_sort(It first, It last) {
+		tiny::stable_sort(first, last, tiny::less());
+	}
+
+	//
+	// selection
+	//
+
+	template <typename It, typename Compare>
+	inline void nth_element(It first, It nth, It last, Compare comp) {
+		if (nth == last)
+			return;
+
+		int badAllowed = _log2(last - first) * 2;
+
+		while (static_cast<size_t>(last - first) > _insertion_sort_threshold)
+		{
+			if (badAllowed-- == 0)
+				return _heap_sort(first, last, comp);
+
+			_choose_pivot(first, last, comp);
+
+			bool alreadyPartitioned;
+			auto pivotPos = _partition_right(first, last, comp, alreadyPartitioned);
+
+			if (pivotPos == nth)
+				return;
+
+			if (nth < pivotPos)
+				last = pivotPos;
+			else
+				first = pivotPos + 1;
+		}
+
+		_insertion_sort(first, last, comp);
+	}
+
+	template <typename It>
+	inline void nth_element(It first, It nth, It last) {
+		tiny::nth_element(first, nth, last, tiny::less());
+	}
+
+	//
+	// binary search
+	//
+
+	template <typename It, typename V, typename Compare>
+	inline It lower_bound(It first, It last, const V& value, Compare comp) {
+		size_t length = last - first;
+
+		while (length > 0)
+		{
+			auto half = length / 2;
+			if (comp(first[half], value))
+			{
+				first += half + 1;
+				length -= half + 1;
+			}
+			else
+				length = half;
+		}
+
+		return first;
+	}
+
+	template <typename It, typename V>
+	inline It lower_bound(It first, It last, const V& value) {
+		return tiny::lower_bound(first, last, value, tiny::less());
+	}
+
+	template <typename It, typename V, typename Compare>
+	inline It upper_bound(It first, It last, const V& value, Compare comp) {
+		size_t length = last - first;
+
+		while (length > 0)
+		{
+			auto half = length / 2;
+			if (!comp(value, first[half]))
+			{
+				first += half + 1;
+				length -= half + 1;
+			}
+			else
+				length = half;
+		}
+
+		return first;
+	}
+
+	template <typename It, typename V>
+	inline It upper_bound(It first, It last, const V& value) {
+		return tiny::upper_bound(first, last, value, tiny::less());
+	}
+
+	template <typename It, typename V, typename Compare>
+	inline bool binary_search(It first, It last, const V& value, Compare comp) {
+		first = tiny::lower_bound(first, last, value, comp);
+		return first != last && !comp(value, *first);
+	}
+
+	template <typename It, typename V>
+	inline bool binary_search(It first, It last, const V& value) {
+		return tiny::binary_search(first, last, value, tiny::less());
+	}
+
+	//
+	// modifying sequence operations
+	//
+
+	template <typename It, typename Pred>
+	inline It unique(It first, It last, Pred pred) {
+		if (first == last)
+			return last;
+
+		auto result = first;
+		while (++first != last)
+		{
+			if (!pred(*result, *first) && ++result != first)
+				*result = tiny::move(*first);
+		}
+
+		return ++result;
+	}
+
+	template <typename It>
+	inline It unique(It first, It last) {
+		return tiny::unique(first, last, tiny::equal_to());
+	}
+
+	template <typename It, typename Pred>
+	inline It remove_if(It first, It last, Pred pred) {
+		for (; first != last; ++first)
+		{
+			if (pred(*first))
+				break;
+		}
+
+		if (first == last)
+			return last;
+
+		for (auto current = first; ++current != last;)
+		{
+			if (!pred(*current))
+				*first++ = tiny::move(*current);
+		}
+
+		return first;
+	}
+
+	// Kept elements are relocated in runs, see vector::erase_if.
+	template <typename T, typename Allocator, typename Pred>
+	inline size_t erase_if(vector<T, Allocator>& vec, Pred pred) {
+		return vec.erase_if(pred);
+	}
+
+	//
+	// SSE2 reductions for integral element types
+	//
+
+	template <typename It>
+	inline constexpr bool _is_simd_range = is_pointer_v<It> && is_integral_v<remove_pointer_t<It>>
+		&& sizeof(remove_pointer_t<It>) <= 8;
+
+#ifdef TINY_SSE2
+	template <size_t Size>
+	struct _simd_ops;
+
+	template <>
+	struct _simd_ops<1> {
+		static __m128i broadcast(char value) { return _mm_set1_epi8(value); }
+		static __m128i cmpeq(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+		static __m128i cmpgt(__m128i a, __m128i b) { return _mm_cmpgt_epi8(a, b); }
+	};
+
+	template <>
+	struct _simd_ops<2> {
+		static __m128i broadcast(short value) { return _mm_set1_epi16(value); }
+		static __m128i cmpeq(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+		static __m128i cmpgt(__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); }
+	};
+
+	template <>
+	struct _simd_ops<4> {
+		static __m128i broadcast(int value) { return _mm_set1_epi32(value); }
+		static __m128i cmpeq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+		static __m128i cmpgt(__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); }
+	};
+
+	template <>
+	struct _simd_ops<8> {
+		static __m128i broadcast(long long value) { return _mm_set1_epi64x(value); }
+
+		static __m128i cmpeq(__m128i a, __m128i b) {
+			auto eq32 = _mm_cmpeq_epi32(a, b);
+			return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+		}
+	};
+
+	inline unsigned _popcount16(unsigned value) {
+		value = value - ((value >> 1) & 0x5555);
+		value = (value & 0x3333) + ((value >> 2) & 0x3333);
+		value = (value + (value >> 4)) & 0x0F0F;
+		return (value + (value >> 8)) & 0x1F;
+	}
+
+	template <typename T>
+	inline const T* _simd_find(const T* first, const T* last, T value) {
+		using ops = _simd_ops<sizeof(T)>;
+		const size_t lanes = 16 / sizeof(T);
+		auto needle = ops::broadcast(value);
+
+		for (; static_cast<size_t>(last - first) >= lanes; first += lanes)
+		{
+			auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			auto mask = static_cast<unsigned long>(_mm_movemask_epi8(ops::cmpeq(chunk, needle)));
+
+			unsigned long index;
+			if (_BitScanForward(&index, mask))
+				return first + index / sizeof(T);
+		}
+
+		for (; first != last; ++first)
+		{
+			if (*first == value)
+				return first;
+		}
+
+		return last;
+	}
+
+	template <typename T>
+	inline size_t _simd_count(const T* first, const T* last, T value) {
+		using ops = _simd_ops<sizeof(T)>;
+		const size_t lanes = 16 / sizeof(T);
+		auto needle = ops::broadcast(value);
+		size_t result = 0;
+
+		for (; static_cast<size_t>(last - first) >= lanes; first += lanes)
+		{
+			auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			result += _popcount16(_mm_movemask_epi8(ops::cmpeq(chunk, needle))) / sizeof(T);
+		}
+
+		for (; first != last; ++first)
+			result += *first == value;
+
+		return result;
+	}
+
+	// Returns the minimum (Max == false) or maximum value of a non-empty range of up to 4 byte integers.
+	template <bool Max, typename T>
+	inline T _simd_extreme(const T* first, const T* last) {
+		using ops = _simd_ops<sizeof(T)>;
+		const size_t lanes = 16 / sizeof(T);
+
+		// unsigned values are biased so the signed comparison orders them correctly
+		auto bias = ops::broadcast(is_signed_v<T> ? 0 : static_cast<T>(1ull << (sizeof(T) * 8 - 1)));
+		auto result = *first;
+
+		if (static_cast<size_t>(last - first) >= lanes)
+		{
+			auto best = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), bias);
+			first += lanes;
+
+			for (; static_cast<size_t>(last - first) >= lanes; first += lanes)
+			{
+				auto chunk = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), bias);
+				auto replace = Max ? ops::cmpgt(chunk, best) : ops::cmpgt(best, chunk);
+				best = _mm_or_si128(_mm_and_si128(replace, chunk), _mm_andnot_si128(replace, best));
+			}
+
+			alignas(16) T values[lanes];
+			_mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_xor_si128(best, bias));
+
+			result = values[0];
+			for (size_t i = 1; i < lanes; ++i)
+			{
+				if (Max ? result < values[i] : values[i] < result)
+					result = values[i];
+			}
+		}
+
+		for (; first != last; ++first)
+		{
+			if (Max ? result < *first : *first < result)
+				result = *first;
+		}
+
+		return result;
+	}
+#endif
+
+	template <typename It, typename V>
+	inline It find(It first, It last, const V& value) {
+#ifdef TINY_SSE2
+		if constexpr (_is_simd_range<It>) {
+			using T = remove_cv_t<remove_pointer_t<It>>;
+			if (static_cast<V>(static_cast<T>(value)) != value)
+				return last;
+
+			return first + (_simd_find<T>(first, last, static_cast<T>(value)) - first);
+		}
+#endif
+		for (; first != last; ++first)
+		{
+			if (*first == value)
+				return first;
+		}
+
+		return last;
+	}
+
+	template <typename It, typename Pred>
+	inline It find_if(It first, It last, Pred pred) {
+		for (; first != last; ++first)
+		{
+			if (pred(*first))
+				return first;
+		}
+
+		return last;
+	}
+
+	template <typename It, typename V>
+	inline size_t count(It first, It last, const V& value) {
+#ifdef TINY_SSE2
+		if constexpr (_is_simd_range<It>) {
+			using T = remove_cv_t<remove_pointer_t<It>>;
+			if (static_cast<V>(static_cast<T>(value)) != value)
+				return 0;
+
+			return _simd_count<T>(first, last, static_cast<T>(value));
+		}
+#endif
+		size_t result = 0;
+		for (; first != last; ++first)
+			result += *first == value;
+
+		return result;
+	}
+
+	template <typename It, typename Pred>
+	inline size_t count_if(It first, It last, Pred pred) {
+		size_t result = 0;
+		for (; first != last; ++first)
+			result += pred(*first) ? 1 : 0;
+
+		return result;
+	}
+
+	template <typename It, typename Compare>
+	inline It min_element(It first, It last, Compare comp) {
+		if (first == last)
+			return last;
+
+		auto result = first;
+		while (++first != last)
+		{
+			if (comp(*first, *result))
+				result = first;
+		}
+
+		return result;
+	}
+
+	template <typename It, typename Compare>
+	inline It max_element(It first, It last, Compare comp) {
+		if (first == last)
+			return last;
+
+		auto result = first;
+		while (++first != last)
+		{
+			if (comp(*result, *first))
+				result = first;
+		}
+
+		return result;
+	}
+
+	// Integral ranges find the extreme value with SSE2 and then locate its first occurrence.
+	template <typename It>
+	inline It min_element(It first, It last) {
+#ifdef TINY_SSE2
+		if constexpr (_is_simd_range<It> && sizeof(remove_pointer_t<It>) <= 4) {
+			if (first == last)
+				return last;
+
+			return tiny::find(first, last, _simd_extreme<false>(first, last));
+		}
+#endif
+		return tiny::min_element(first, last, tiny::less());
+	}
+
+	template <typename It>
+	inline It max_element(It first, It last) {
+#ifdef TINY_SSE2
+		if constexpr (_is_simd_range<It> && sizeof(remove_pointer_t<It>) <= 4) {
+			if (first == last)
+				return last;
+
+			return tiny::find(first, last, _simd_extreme<true>(first, last));
+		}
+#endif
+		return tiny::max_element(first, last, tiny::less());
+	}
+}
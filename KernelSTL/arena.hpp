@@ -0,0 +1,151 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+
+namespace tiny {
+	/*
+	* Bump allocator for memory that lives exactly as long as one request. An allocation takes
+	* the next bytes of the current block, nothing is freed on its own and release() returns all
+	* blocks to the pool at once. The first block can be a caller supplied buffer, e.g. on the
+	* stack, so small requests never touch the pool. Destructors of objects placed in the arena
+	* are not run by release(). Not synchronized, an arena belongs to one request.
+	*/
+	class arena {
+	public:
+		inline static const size_t default_block_size = 16 * 1024;
+
+		arena& operator=(const arena&) = delete;
+		arena(const arena&) = delete;
+
+		explicit arena(size_t blockSize = default_block_size) noexcept
+			: arena(nullptr, 0, blockSize) {
+		}
+
+		// the buffer is used first and never freed by the arena
+		arena(void* buffer, size_t size, size_t blockSize = default_block_size) noexcept
+			: _blocks(nullptr), _current(static_cast<char*>(buffer)), _end(static_cast<char*>(buffer) + size),
+			_initial(static_cast<char*>(buffer)), _initialSize(size), _blockSize(blockSize), _used(0), _reserved(0) {
+		}
+
+		~arena() {
+			this->release();
+		}
+
+		// alignment has to be a power of two, nullptr when the pool is exhausted
+		void* allocate(size_t size, size_t alignment = MEMORY_ALLOCATION_ALIGNMENT) noexcept {
+			auto result = _align(_current, alignment);
+			if (!_current || result + size > _end)
+			{
+				result = this->_allocateSlow(size, alignment);
+				if (!result)
+					return nullptr;
+			}
+			else
+			{
+				_current = result + size;
+			}
+
+			_used += size;
+			return result;
+		}
+
+		// Only the most recent allocation is given back, anything else stays until release().
+		void deallocate(void* ptr, size_t size) noexcept {
+			if (static_cast<char*>(ptr) + size == _current)
+			{
+				_current = static_cast<char*>(ptr);
+				_used -= size;
+			}
+		}
+
+		// frees every pool block, the initial buffer is reused
+		void release() noexcept {
+			while (_blocks)
+				FREE_MEMORY(tiny::exchange(_blocks, _blocks->next));
+
+			_current = _initial;
+			_end = _initial + _initialSize;
+			_used = 0;
+			_reserved = 0;
+		}
+
+		// bytes handed out since the last release
+		size_t used() const noexcept {
+			return _used;
+		}
+
+		// bytes held in pool blocks
+		size_t reserved() const noexcept {
+			return _reserved;
+		}
+	private:
+		struct _block {
+			_block* next;
+		};
+
+		_block* _blocks;
+		char* _current;
+		char* _end;
+		char* _initial;
+		size_t _initialSize;
+		size_t _blockSize;
+		size_t _used;
+		size_t _reserved;
+
+		static char* _align(char* ptr, size_t alignment) noexcept {
+			return reinterpret_cast<char*>((reinterpret_cast<ULONG_PTR>(ptr) + alignment - 1) & ~(alignment - 1));
+		}
+
+		char* _allocateSlow(size_t size, size_t alignment) noexcept {
+			// large requests get a block of their own, the rest of the current one stays usable
+			auto dedicated = size > _blockSize / 4;
+			auto bytes = sizeof(_block) + alignment + (dedicated ? size : _blockSize);
+
+			auto block = static_cast<_block*>(ALLOC_MEMORY(bytes));
+			if (!block)
+				return nullptr;
+
+			block->next = _blocks;
+			_blocks = block;
+			_reserved += bytes;
+
+			auto result = _align(reinterpret_cast<char*>(block + 1), alignment);
+			if (!dedicated)
+			{
+				_current = result + size;
+				_end = reinterpret_cast<char*>(block) + bytes;
+			}
+
+			return result;
+		}
+	};
+
+	// Container allocator drawing from an arena, the container must not outlive the arena.
+	class arena_allocator {
+	public:
+		explicit arena_allocator(arena& owner) noexcept
+			: _arena(&owner) {
+		}
+
+		void* allocate(size_t size) const noexcept {
+			return _arena->allocate(size);
+		}
+
+		void deallocate(void* ptr, size_t size) const noexcept {
+			_arena->deallocate(ptr, size);
+		}
+	private:
+		arena* _arena;
+	};
+
+	// The destructor is not run by the arena, call it before release() when it matters.
+	template <typename T, typename... Args>
+	inline T* arena_new(arena& owner, Args&&... args) {
+		void* memory = owner.allocate(sizeof(T), alignof(T) > MEMORY_ALLOCATION_ALIGNMENT ? alignof(T) : MEMORY_ALLOCATION_ALIGNMENT);
+		if (!memory)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		return new (memory) T(tiny::forward<Args>(args)...);
+	}
+}
@@ -0,0 +1,603 @@
+#pragma once
+
+// MSVC kernel builds map atomics to the Interlocked intrinsics and wait on kernel events. Any
+// other build, e.g. HostTests\atomic_tests.cpp, maps them to std::atomic and needs C++20 for
+// its wait and notify, this header then uses nothing from the kernel.
+#if defined(_KERNEL_MODE) && defined(_MSC_VER)
+#define TINY_KERNEL_ATOMICS 1
+#include "common.hpp"
+#include "utility.hpp"
+#include <intrin.h>
+#else
+#include <stddef.h>
+#include <atomic>
+#include <type_traits>
+#endif
+
+namespace tiny {
+	enum class memory_order {
+		relaxed,
+		acquire,
+		release,
+		acq_rel,
+		seq_cst
+	};
+
+	inline constexpr memory_order memory_order_relaxed = memory_order::relaxed;
+	inline constexpr memory_order memory_order_acquire = memory_order::acquire;
+	inline constexpr memory_order memory_order_release = memory_order::release;
+	inline constexpr memory_order memory_order_acq_rel = memory_order::acq_rel;
+	inline constexpr memory_order memory_order_seq_cst = memory_order::seq_cst;
+
+#ifdef TINY_KERNEL_ATOMICS
+	template <typename T>
+	inline constexpr bool _atomic_copyable = is_trivially_copyable_v<T>;
+
+#if defined(_M_ARM64) || defined(_M_ARM64EC)
+	// ARM64 has acquire loads (ldar), release stores (stlr) and interlocked operations with
+	// acquire, release or no barrier, the plain ones are full barriers.
+#define _TINY_ORDERED(name, order, ...) \
+	((order) == memory_order::relaxed ? name##_nf(__VA_ARGS__) \
+	: (order) == memory_order::acquire ? name##_acq(__VA_ARGS__) \
+	: (order) == memory_order::release ? name##_rel(__VA_ARGS__) \
+	: name(__VA_ARGS__))
+#define _TINY_LOAD(BITS, p, order) \
+	((order) == memory_order::relaxed ? __iso_volatile_load##BITS(reinterpret_cast<const volatile __int##BITS*>(p)) \
+	: static_cast<__int##BITS>(__load_acquire##BITS(reinterpret_cast<const volatile unsigned __int##BITS*>(p))))
+#define _TINY_STORE(BITS, SUFFIX, p, value, order) \
+	((order) == memory_order::relaxed ? __iso_volatile_store##BITS(reinterpret_cast<volatile __int##BITS*>(p), static_cast<__int##BITS>(value)) \
+	: (_ReadWriteBarrier(), __stlr##BITS(reinterpret_cast<volatile unsigned __int##BITS*>(p), static_cast<unsigned __int##BITS>(value))))
+#else
+	// x64 loads acquire and stores release by themselves, they only must not be reordered by
+	// the compiler. A sequentially consistent store needs xchg, every interlocked operation is
+	// a full barrier.
+#define _TINY_ORDERED(name, order, ...) ((void)(order), name(__VA_ARGS__))
+#define _TINY_LOAD(BITS, p, order) \
+	((void)(order), _atomic_compiler_barrier_after(__iso_volatile_load##BITS(reinterpret_cast<const volatile __int##BITS*>(p))))
+#define _TINY_STORE(BITS, SUFFIX, p, value, order) \
+	((order) == memory_order::seq_cst ? (void)_InterlockedExchange##SUFFIX(p, value) \
+	: (_ReadWriteBarrier(), __iso_volatile_store##BITS(reinterpret_cast<volatile __int##BITS*>(p), static_cast<__int##BITS>(value))))
+
+	template <typename T>
+	inline T _atomic_compiler_barrier_after(T value) noexcept {
+		_ReadWriteBarrier();
+		return value;
+	}
+#endif
+
+#define _TINY_ATOMIC_INTEGER(BITS, SUFFIX, INT) \
+	inline INT _atomic_load(const volatile INT* p, memory_order order) noexcept { \
+		return static_cast<INT>(_TINY_LOAD(BITS, p, order)); \
+	} \
+	inline void _atomic_store(volatile INT* p, INT value, memory_order order) noexcept { \
+		_TINY_STORE(BITS, SUFFIX, p, value, order); \
+	} \
+	inline INT _atomic_exchange(volatile INT* p, INT value, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedExchange##SUFFIX, order, p, value); \
+	} \
+	inline INT _atomic_compare_exchange(volatile INT* p, INT expected, INT desired, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedCompareExchange##SUFFIX, order, p, desired, expected); \
+	} \
+	inline INT _atomic_fetch_add(volatile INT* p, INT value, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedExchangeAdd##SUFFIX, order, p, value); \
+	} \
+	inline INT _atomic_fetch_and(volatile INT* p, INT value, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedAnd##SUFFIX, order, p, value); \
+	} \
+	inline INT _atomic_fetch_or(volatile INT* p, INT value, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedOr##SUFFIX, order, p, value); \
+	} \
+	inline INT _atomic_fetch_xor(volatile INT* p, INT value, memory_order order) noexcept { \
+		return _TINY_ORDERED(_InterlockedXor##SUFFIX, order, p, value); \
+	}
+
+	_TINY_ATOMIC_INTEGER(8, 8, char)
+	_TINY_ATOMIC_INTEGER(16, 16, short)
+	_TINY_ATOMIC_INTEGER(32, , long)
+	_TINY_ATOMIC_INTEGER(64, 64, __int64)
+
+#undef _TINY_ATOMIC_INTEGER
+#undef _TINY_STORE
+#undef _TINY_LOAD
+
+	template <size_t Size>
+	struct _atomic_int;
+
+	template <> struct _atomic_int<1> { using type = char; };
+	template <> struct _atomic_int<2> { using type = short; };
+	template <> struct _atomic_int<4> { using type = long; };
+	template <> struct _atomic_int<8> { using type = __int64; };
+
+	// Operations on the bits of T, through the integer of its size.
+	template <typename T, size_t Size = sizeof(T)>
+	class _atomic_base {
+	public:
+		constexpr _atomic_base(T value) noexcept
+			: _value(value) {
+		}
+
+		T load(memory_order order) const noexcept {
+			return _fromInt(_atomic_load(this->_ptr(), order));
+		}
+
+		void store(T desired, memory_order order) noexcept {
+			_atomic_store(this->_ptr(), _toInt(desired), order);
+		}
+
+		T exchange(T desired, memory_order order) noexcept {
+			return _fromInt(_atomic_exchange(this->_ptr(), _toInt(desired), order));
+		}
+
+		bool compare_exchange_strong(T& expected, T desired, memory_order order) noexcept {
+			auto comparand = _toInt(expected);
+			auto previous = _atomic_compare_exchange(this->_ptr(), comparand, _toInt(desired), order);
+			if (previous == comparand)
+				return true;
+
+			expected = _fromInt(previous);
+			return false;
+		}
+
+		// pointers move by elements like std::atomic
+		template <typename D>
+		T fetch_add(D delta, memory_order order) noexcept {
+			return _fromInt(_atomic_fetch_add(this->_ptr(), _scale(delta), order));
+		}
+
+		template <typename D>
+		T fetch_sub(D delta, memory_order order) noexcept {
+			return _fromInt(_atomic_fetch_add(this->_ptr(), static_cast<_int>(0 - _scale(delta)), order));
+		}
+
+		T fetch_and(T value, memory_order order) noexcept {
+			return _fromInt(_atomic_fetch_and(this->_ptr(), _toInt(value), order));
+		}
+
+		T fetch_or(T value, memory_order order) noexcept {
+			return _fromInt(_atomic_fetch_or(this->_ptr(), _toInt(value), order));
+		}
+
+		T fetch_xor(T value, memory_order order) noexcept {
+			return _fromInt(_atomic_fetch_xor(this->_ptr(), _toInt(value), order));
+		}
+
+		const volatile void* _address() const noexcept {
+			return &_value;
+		}
+	private:
+		using _int = typename _atomic_int<Size>::type;
+
+		alignas(Size) T _value;
+
+		volatile _int* _ptr() const noexcept {
+			return reinterpret_cast<volatile _int*>(const_cast<T*>(&_value));
+		}
+
+		static _int _toInt(T value) noexcept {
+			_int result;
+			memcpy(&result, &value, Size);
+			return result;
+		}
+
+		static T _fromInt(_int value) noexcept {
+			T result;
+			memcpy(&result, &value, Size);
+			return result;
+		}
+
+		template <typename D>
+		static _int _scale(D delta) noexcept {
+			if constexpr (is_pointer_v<T>)
+				return static_cast<_int>(delta * static_cast<LONG_PTR>(sizeof(remove_pointer_t<T>)));
+			else
+				return static_cast<_int>(delta);
+		}
+	};
+
+	// Double-width values such as a pointer with a tag, every operation is a cmpxchg16b or
+	// casp through _InterlockedCompareExchange128.
+	template <typename T>
+	class _atomic_base<T, 16> {
+	public:
+		constexpr _atomic_base(T value) noexcept
+			: _value(value) {
+		}
+
+		T load(memory_order order) const noexcept {
+			// a compare against zero that stores zero when it matches and else returns the value
+			__int64 current[2] = {};
+			_TINY_ORDERED(_InterlockedCompareExchange128, order, this->_ptr(), 0, 0, current);
+			return _fromInt(current);
+		}
+
+		void store(T desired, memory_order order) noexcept {
+			this->exchange(desired, order);
+		}
+
+		T exchange(T desired, memory_order order) noexcept {
+			__int64 current[2];
+			memcpy(current, const_cast<T*>(&_value), 16);
+
+			__int64 value[2];
+			memcpy(value, &desired, 16);
+
+			while (!_TINY_ORDERED(_InterlockedCompareExchange128, order, this->_ptr(), value[1], value[0], current))
+				;
+
+			return _fromInt(current);
+		}
+
+		bool compare_exchange_strong(T& expected, T desired, memory_order order) noexcept {
+			__int64 current[2];
+			memcpy(current, &expected, 16);
+
+			__int64 value[2];
+			memcpy(value, &desired, 16);
+
+			if (_TINY_ORDERED(_InterlockedCompareExchange128, order, this->_ptr(), value[1], value[0], current))
+				return true;
+
+			expected = _fromInt(current);
+			return false;
+		}
+
+		const volatile void* _address() const noexcept {
+			return &_value;
+		}
+	private:
+		alignas(16) T _value;
+
+		volatile __int64* _ptr() const noexcept {
+			return reinterpret_cast<volatile __int64*>(const_cast<T*>(&_value));
+		}
+
+		static T _fromInt(const __int64* value) noexcept {
+			T result;
+			memcpy(&result, value, 16);
+			return result;
+		}
+	};
+
+#undef _TINY_ORDERED
+#else
+	template <typename T>
+	inline constexpr bool _atomic_copyable = std::is_trivially_copyable_v<T>;
+
+	constexpr std::memory_order _std_order(memory_order order) noexcept {
+		return order == memory_order::relaxed ? std::memory_order_relaxed
+			: order == memory_order::acquire ? std::memory_order_acquire
+			: order == memory_order::release ? std::memory_order_release
+			: order == memory_order::acq_rel ? std::memory_order_acq_rel
+			: std::memory_order_seq_cst;
+	}
+
+	// loads do not release and stores do not acquire
+	constexpr std::memory_order _std_load_order(memory_order order) noexcept {
+		return order == memory_order::release ? std::memory_order_relaxed
+			: order == memory_order::acq_rel ? std::memory_order_acquire
+			: _std_order(order);
+	}
+
+	constexpr std::memory_order _std_store_order(memory_order order) noexcept {
+		return order == memory_order::acquire ? std::memory_order_relaxed
+			: order == memory_order::acq_rel ? std::memory_order_release
+			: _std_order(order);
+	}
+
+	template <typename T, size_t Size = sizeof(T)>
+	class _atomic_base {
+	public:
+		constexpr _atomic_base(T value) noexcept
+			: _value(value) {
+		}
+
+		T load(memory_order order) const noexcept {
+			return _value.load(_std_load_order(order));
+		}
+
+		void store(T desired, memory_order order) noexcept {
+			_value.store(desired, _std_store_order(order));
+		}
+
+		T exchange(T desired, memory_order order) noexcept {
+			return _value.exchange(desired, _std_order(order));
+		}
+
+		bool compare_exchange_strong(T& expected, T desired, memory_order order) noexcept {
+			return _value.compare_exchange_strong(expected, desired, _std_order(order), _std_load_order(order));
+		}
+
+		template <typename D>
+		T fetch_add(D delta, memory_order order) noexcept {
+			return _value.fetch_add(delta, _std_order(order));
+		}
+
+		template <typename D>
+		T fetch_sub(D delta, memory_order order) noexcept {
+			return _value.fetch_sub(delta, _std_order(order));
+		}
+
+		T fetch_and(T value, memory_order order) noexcept {
+			return _value.fetch_and(value, _std_order(order));
+		}
+
+		T fetch_or(T value, memory_order order) noexcept {
+			return _value.fetch_or(value, _std_order(order));
+		}
+
+		T fetch_xor(T value, memory_order order) noexcept {
+			return _value.fetch_xor(value, _std_order(order));
+		}
+
+		void _wait(T old, memory_order order) const noexcept {
+			_value.wait(old, _std_load_order(order));
+		}
+
+		void _notify(bool all) noexcept {
+			if (all)
+				_value.notify_all();
+			else
+				_value.notify_one();
+		}
+	private:
+		std::atomic<T> _value;
+	};
+#endif
+
+#ifdef TINY_KERNEL_ATOMICS
+	//
+	// wait and notify
+	//
+
+	struct _atomic_waiter {
+		_atomic_waiter* next;
+		const volatile void* address;
+		KEVENT event;
+	};
+
+	// Waiters of all atomics hashed by address, zero is the initial state of every bucket so
+	// the table needs no constructor.
+	struct _atomic_wait_bucket {
+		KSPIN_LOCK lock;
+		_atomic_waiter* first;
+	};
+
+	inline _atomic_wait_bucket _atomicWaitBuckets[64];
+
+	inline _atomic_wait_bucket& _atomic_wait_bucket_for(const volatile void* address) noexcept {
+		auto key = static_cast<ULONG64>(reinterpret_cast<ULONG_PTR>(address));
+		return _atomicWaitBuckets[(key * 0x9E3779B97F4A7C15ull) >> 58];
+	}
+
+	// Blocks until notified unless unchanged() is false under the bucket lock, which a notify
+	// after the store takes too, so no wakeup is lost. May return spuriously.
+	template <typename Unchanged>
+	inline void _atomic_wait(const volatile void* address, Unchanged&& unchanged) {
+		auto& bucket = _atomic_wait_bucket_for(address);
+
+		_atomic_waiter waiter;
+		waiter.address = address;
+		KeInitializeEvent(&waiter.event, NotificationEvent, FALSE);
+
+		KIRQL oldIrql;
+		KeAcquireSpinLock(&bucket.lock, &oldIrql);
+		if (!unchanged())
+		{
+			KeReleaseSpinLock(&bucket.lock, oldIrql);
+			return;
+		}
+
+		waiter.next = bucket.first;
+		bucket.first = &waiter;
+		KeReleaseSpinLock(&bucket.lock, oldIrql);
+
+		// the notifier unlinks the waiter before it sets the event
+		KeWaitForSingleObject(&waiter.event, Executive, KernelMode, FALSE, nullptr);
+	}
+
+	inline void _atomic_notify(const volatile void* address, bool all) noexcept {
+		auto& bucket = _atomic_wait_bucket_for(address);
+
+		KIRQL oldIrql;
+		KeAcquireSpinLock(&bucket.lock, &oldIrql);
+
+		for (auto link = &bucket.first; *link;)
+		{
+			auto waiter = *link;
+			if (waiter->address != address)
+			{
+				link = &waiter->next;
+				continue;
+			}
+
+			*link = waiter->next;
+			KeSetEvent(&waiter->event, IO_NO_INCREMENT, FALSE);
+
+			if (!all)
+				break;
+		}
+
+		KeReleaseSpinLock(&bucket.lock, oldIrql);
+	}
+#endif
+
+	/*
+	* Atomic integral, pointer or trivially copyable value of 1, 2, 4, 8 or 16 bytes. Each
+	* operation takes a memory order and compiles to the cheapest instruction giving it: on x64
+	* plain loads and stores for all but seq_cst stores, on ARM64 ldar/stlr and the _acq, _rel
+	* and _nf interlocked variants. 16 byte values only load, store, exchange and compare.
+	* wait() blocks on a kernel event at IRQL <= APC_LEVEL, notify works up to DISPATCH_LEVEL.
+	* Host builds wait through std::atomic.
+	*/
+	template <typename T>
+	class atomic : private _atomic_base<T> {
+	public:
+		static_assert(_atomic_copyable<T>, "atomic values are copied bitwise");
+		static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8 || sizeof(T) == 16,
+			"atomic values are 1, 2, 4, 8 or 16 bytes");
+
+		using value_type = T;
+
+		atomic& operator=(const atomic&) = delete;
+		atomic(const atomic&) = delete;
+
+		constexpr atomic() noexcept
+			: _atomic_base<T>(T()) {
+		}
+
+		constexpr atomic(T desired) noexcept
+			: _atomic_base<T>(desired) {
+		}
+
+		T load(memory_order order = memory_order::seq_cst) const noexcept {
+			return _atomic_base<T>::load(order);
+		}
+
+		void store(T desired, memory_order order = memory_order::seq_cst) noexcept {
+			_atomic_base<T>::store(desired, order);
+		}
+
+		T exchange(T desired, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::exchange(desired, order);
+		}
+
+		// on failure expected receives the current value
+		bool compare_exchange_strong(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::compare_exchange_strong(expected, desired, order);
+		}
+
+		bool compare_exchange_weak(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::compare_exchange_strong(expected, desired, order);
+		}
+
+		// integral and pointer types
+		template <typename D>
+		T fetch_add(D delta, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::fetch_add(delta, order);
+		}
+
+		template <typename D>
+		T fetch_sub(D delta, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::fetch_sub(delta, order);
+		}
+
+		// integral types
+		T fetch_and(T value, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::fetch_and(value, order);
+		}
+
+		T fetch_or(T value, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::fetch_or(value, order);
+		}
+
+		T fetch_xor(T value, memory_order order = memory_order::seq_cst) noexcept {
+			return _atomic_base<T>::fetch_xor(value, order);
+		}
+
+		operator T() const noexcept {
+			return this->load();
+		}
+
+		T operator=(T desired) noexcept {
+			this->store(desired);
+			return desired;
+		}
+
+		T operator++() noexcept {
+			return this->fetch_add(1) + 1;
+		}
+
+		T operator++(int) noexcept {
+			return this->fetch_add(1);
+		}
+
+		T operator--() noexcept {
+			return this->fetch_sub(1) - 1;
+		}
+
+		T operator--(int) noexcept {
+			return this->fetch_sub(1);
+		}
+
+		template <typename D>
+		T operator+=(D delta) noexcept {
+			return this->fetch_add(delta) + delta;
+		}
+
+		template <typename D>
+		T operator-=(D delta) noexcept {
+			return this->fetch_sub(delta) - delta;
+		}
+
+		// Blocks while the value is old, returns once a notify found it changed.
+		void wait(T old, memory_order order = memory_order::seq_cst) const {
+#ifdef TINY_KERNEL_ATOMICS
+			while (_equal(this->load(order), old))
+			{
+				_atomic_wait(this->_address(), [&]() {
+					return _equal(this->load(memory_order::relaxed), old);
+				});
+			}
+#else
+			_atomic_base<T>::_wait(old, order);
+#endif
+		}
+
+		void notify_one() noexcept {
+			this->_notify(false);
+		}
+
+		void notify_all() noexcept {
+			this->_notify(true);
+		}
+	private:
+#ifdef TINY_KERNEL_ATOMICS
+		void _notify(bool all) noexcept {
+			_atomic_notify(this->_address(), all);
+		}
+
+
+		static bool _equal(const T& left, const T& right) noexcept {
+			return !memcmp(&left, &right, sizeof(T));
+		}
+#endif
+	};
+
+	// Lock-free flag, clear when constructed.
+	class atomic_flag {
+	public:
+		atomic_flag& operator=(const atomic_flag&) = delete;
+		atomic_flag(const atomic_flag&) = delete;
+
+		constexpr atomic_flag() noexcept
+			: _value(0) {
+		}
+
+		// returns whether it was set before
+		bool test_and_set(memory_order order = memory_order::seq_cst) noexcept {
+			return _value.exchange(1, order) != 0;
+		}
+
+		void clear(memory_order order = memory_order::seq_cst) noexcept {
+			_value.store(0, order);
+		}
+
+		bool test(memory_order order = memory_order::seq_cst) const noexcept {
+			return _value.load(order) != 0;
+		}
+
+		void wait(bool old, memory_order order = memory_order::seq_cst) const {
+			_value.wait(old ? 1 : 0, order);
+		}
+
+		void notify_one() noexcept {
+			_value.notify_one();
+		}
+
+		void notify_all() noexcept {
+			_value.notify_all();
+		}
+	private:
+		atomic<unsigned char> _value;
+	};
+}
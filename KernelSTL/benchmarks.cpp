@@ -0,0 +1,1313 @@
+#include "benchmarks.hpp"
+#include "tiny_stl.hpp"
+
+#define Message(msg, ...) do {DbgPrintEx(0, 0, "[TinyBench]: " msg "\n", __VA_ARGS__);}while(0)
+#define Execute(benchmarkName) \
+Message(#benchmarkName); \
+benchmarkName()
+#define Measure(caseName, iterations, ...) \
+do { \
+	LARGE_INTEGER frequency; \
+	auto start = KeQueryPerformanceCounter(&frequency); \
+	for (size_t iteration = 0; iteration < (iterations); ++iteration) \
+		{ __VA_ARGS__ } \
+	auto stop = KeQueryPerformanceCounter(nullptr); \
+	Message("    %-48s %10llu ns/op", caseName, \
+		nanosecondsPerOperation(stop.QuadPart - start.QuadPart, frequency.QuadPart, iterations)); \
+} while (0)
+
+static volatile ULONG_PTR sink;
+
+static unsigned long long nanosecondsPerOperation(LONGLONG ticks, LONGLONG frequency, size_t iterations)
+{
+	return static_cast<unsigned long long>(ticks) * 1000000000ull / frequency / iterations;
+}
+
+struct BenchmarkPayload {
+	ULONG_PTR values[4];
+};
+
+static void benchmarkSharedPtr()
+{
+	const size_t iterations = 100000;
+
+	Measure("shared_ptr(new T) (two allocations)", iterations,
+		tiny::shared_ptr<BenchmarkPayload> ptr(new BenchmarkPayload());
+		sink = reinterpret_cast<ULONG_PTR>(ptr.get());
+	);
+
+	Measure("make_shared<T> (single allocation)", iterations,
+		auto ptr = tiny::make_shared<BenchmarkPayload>();
+		sink = reinterpret_cast<ULONG_PTR>(ptr.get());
+	);
+
+	Measure("make_unique<T>", iterations,
+		auto ptr = tiny::make_unique<BenchmarkPayload>();
+		sink = reinterpret_cast<ULONG_PTR>(ptr.get());
+	);
+
+	auto shared = tiny::make_shared<BenchmarkPayload>();
+	Measure("shared_ptr copy (interlocked inc/dec)", iterations,
+		auto copy = shared;
+		sink = reinterpret_cast<ULONG_PTR>(copy.get());
+	);
+}
+
+static void benchmarkStringBuilding()
+{
+	const size_t iterations = 10000;
+	const wchar_t component[] = L"\\Windows\\System32\\DriverStore\\FileRepository\\";
+
+	Measure("wstring push_back x260", iterations,
+		tiny::wstring path;
+		for (size_t i = 0; i < 260; ++i)
+			path.push_back(component[i % (RTL_NUMBER_OF(component) - 1)]);
+		sink = path.size();
+	);
+
+	Measure("wstring append x6", iterations,
+		tiny::wstring path;
+		for (size_t i = 0; i < 6; ++i)
+			path.append(component);
+		sink = path.size();
+	);
+
+	Measure("wstring_builder(reserved) x6", iterations,
+		tiny::wstring_builder builder(260);
+		for (size_t i = 0; i < 6; ++i)
+			builder << component;
+		sink = builder.size();
+	);
+
+	Measure("concat<wstring> x6", iterations,
+		auto path = tiny::concat<tiny::wstring>(component, component, component, component, component, component);
+		sink = path.size();
+	);
+
+	Measure("format_to(wchar_t[260])", iterations,
+		wchar_t buffer[260];
+		sink = tiny::format_to(buffer, L"{}\\{}\\{x}", component, 1234, 0xC0000001u);
+	);
+}
+
+static unsigned benchmarkRandom(unsigned& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static void fillRandom(tiny::vector<int>& vec, size_t count, unsigned seed)
+{
+	vec.resize(count);
+	for (auto& v : vec)
+		v = static_cast<int>(benchmarkRandom(seed) % 100000);
+}
+
+static void insertionSort(int* first, int* last)
+{
+	for (auto current = first + 1; current < last; ++current)
+	{
+		auto value = *current;
+		auto sift = current;
+
+		for (; sift != first && value < *(sift - 1); --sift)
+			*sift = *(sift - 1);
+
+		*sift = value;
+	}
+}
+
+static void benchmarkAlgorithm()
+{
+	const size_t sortSize = 4096;
+	const size_t iterations = 20;
+	tiny::vector<int> vec;
+
+	Measure("hand-written insertion sort (4096)", iterations,
+		fillRandom(vec, sortSize, static_cast<unsigned>(iteration + 1));
+		insertionSort(vec.begin(), vec.end());
+	);
+
+	Measure("tiny::sort (4096)", iterations,
+		fillRandom(vec, sortSize, static_cast<unsigned>(iteration + 1));
+		tiny::sort(vec.begin(), vec.end());
+	);
+
+	Measure("tiny::stable_sort (4096)", iterations,
+		fillRandom(vec, sortSize, static_cast<unsigned>(iteration + 1));
+		tiny::stable_sort(vec.begin(), vec.end());
+	);
+
+	Measure("fill only (4096)", iterations,
+		fillRandom(vec, sortSize, static_cast<unsigned>(iteration + 1));
+	);
+
+	fillRandom(vec, 65536, 1);
+
+	Measure("scalar count (65536)", iterations,
+		size_t result = 0;
+		for (auto v : vec)
+			result += v == 42;
+		sink = result;
+	);
+
+	Measure("tiny::count (65536)", iterations,
+		sink = tiny::count(vec.begin(), vec.end(), 42);
+	);
+
+	Measure("scalar min (65536)", iterations,
+		auto result = vec[0];
+		for (auto v : vec)
+			result = v < result ? v : result;
+		sink = result;
+	);
+
+	Measure("tiny::min_element (65536)", iterations,
+		sink = *tiny::min_element(vec.begin(), vec.end());
+	);
+
+	Measure("tiny::find miss (65536)", iterations,
+		sink = tiny::find(vec.begin(), vec.end(), -1) - vec.begin();
+	);
+}
+
+static void benchmarkThreadPool()
+{
+	const size_t entries = 262144;
+	const size_t iterations = 10;
+
+	tiny::vector<unsigned> verdicts;
+	verdicts.resize(entries);
+	for (size_t i = 0; i < entries; ++i)
+		verdicts[i] = static_cast<unsigned>(i * 2654435761u);
+
+	// stands in for re-validating one cached verdict
+	auto revalidate = [&](size_t i) {
+		auto value = verdicts[i];
+		for (int round = 0; round < 16; ++round)
+			value = (value ^ (value >> 15)) * 2246822519u;
+
+		return static_cast<unsigned long long>(value & 1);
+	};
+
+	Measure("single thread rescan (262144)", iterations,
+		unsigned long long result = 0;
+		for (size_t i = 0; i < entries; ++i)
+			result += revalidate(i);
+		sink = static_cast<ULONG_PTR>(result);
+	);
+
+	auto processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+	for (ULONG workers = 1; ; workers *= 2)
+	{
+		if (workers > processors)
+			workers = processors;
+
+		tiny::thread_pool pool(workers);
+		char caseName[64];
+		tiny::format_to(caseName, "parallel_reduce rescan, {} workers", workers);
+
+		Measure(caseName, iterations,
+			sink = static_cast<ULONG_PTR>(pool.parallel_reduce(0, entries, 0ull, revalidate,
+				[](unsigned long long a, unsigned long long b) { return a + b; }));
+		);
+
+		if (workers == processors)
+			break;
+	}
+}
+
+static void benchmarkWorkQueue()
+{
+	const size_t items = 4096;
+	const size_t iterations = 20;
+
+	{
+		tiny::work_queue<> queue(items, 0);
+
+		Measure("work_queue submit + run_pending (4096)", iterations,
+			for (size_t i = 0; i < items; ++i)
+				queue.try_submit([i] { sink = i; });
+			queue.run_pending();
+		);
+
+		Measure("work_queue coalesced submit (4096 on 64 keys)", iterations,
+			for (size_t i = 0; i < items; ++i)
+				queue.try_submit(i % 64, [i] { sink = i; });
+			queue.run_pending();
+		);
+	}
+
+	auto processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+	tiny::work_queue<> queue(1024, processors);
+
+	Measure("work_queue submit to workers (4096)", iterations,
+		for (size_t i = 0; i < items; ++i)
+			queue.submit([i] { sink = i; });
+		queue.run_pending();
+	);
+
+	auto stats = queue.stats();
+	Message("    work_queue stats: batches %llu, executed %llu, max depth %llu, avg latency %lluus, max latency %lluus",
+		stats.batches, stats.executed, static_cast<ULONG64>(stats.maxDepth), stats.averageLatencyUs, stats.maxLatencyUs);
+}
+
+static void benchmarkFuture()
+{
+	const size_t iterations = 100000;
+
+	Measure("promise/future round trip, pool state", iterations,
+		tiny::promise<int> promise;
+		auto future = promise.get_future();
+		promise.set_value(1);
+		sink = static_cast<ULONG_PTR>(future.get());
+	);
+
+	tiny::future_slab<int> slab;
+	Measure("promise/future round trip, slab state", iterations,
+		tiny::promise<int> promise(slab);
+		auto future = promise.get_future();
+		promise.set_value(1);
+		sink = static_cast<ULONG_PTR>(future.get());
+	);
+
+	Measure("promise/future with inline continuation", iterations,
+		tiny::promise<int> promise(slab);
+		promise.get_future().then([](tiny::future<int>&& completed) { sink = static_cast<ULONG_PTR>(completed.get()); });
+		promise.set_value(1);
+	);
+}
+
+static void benchmarkBitset()
+{
+	const size_t slots = 65536;
+	const size_t iterations = 1000;
+
+	// every slot but the last one is taken, the worst case for a free-slot search
+	tiny::vector<unsigned char> bytes;
+	bytes.assign(slots, 1);
+	bytes[slots - 1] = 0;
+
+	tiny::dynamic_bitset bits(slots, true);
+	bits.reset(slots - 1);
+
+	Measure("free slot, byte array loop (65536)", iterations,
+		size_t slot = 0;
+		while (slot < slots && bytes[slot])
+			++slot;
+		sink = slot;
+	);
+
+	Measure("free slot, byte array tiny::find (65536)", iterations,
+		sink = static_cast<ULONG_PTR>(tiny::find(bytes.begin(), bytes.end(), 0) - bytes.begin());
+	);
+
+	Measure("free slot, dynamic_bitset (65536)", iterations,
+		sink = bits.find_first_clear();
+	);
+
+	Measure("count, dynamic_bitset (65536)", iterations,
+		sink = bits.count();
+	);
+
+	tiny::atomic_bitset atomicBits(slots);
+	Measure("claim + release, atomic_bitset", iterations * 100,
+		auto slot = atomicBits.claim();
+		atomicBits.release(slot);
+		sink = slot;
+	);
+}
+
+static void benchmarkIntern()
+{
+	const size_t names = 2000;
+	const size_t copies = 16;
+
+	tiny::vector<tiny::wstring> paths;
+	for (size_t i = 0; i < names; ++i)
+	{
+		tiny::wstring path;
+		tiny::format_to(path, L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\Product\\module{}.dll", i);
+		paths.push_back(tiny::move(path));
+	}
+
+	tiny::wintern_table table;
+	tiny::vector<tiny::winterned_string> interned;
+	for (size_t copy = 0; copy < copies; ++copy)
+	{
+		for (auto& path : paths)
+			interned.push_back(table.intern(path.view()));
+	}
+
+	auto stats = table.stats();
+	Message("    intern: %llu entries, %llu handles, %llu bytes stored, %llu bytes saved",
+		static_cast<ULONG64>(stats.entries), static_cast<ULONG64>(stats.references),
+		static_cast<ULONG64>(stats.storedBytes), static_cast<ULONG64>(stats.savedBytes));
+
+	tiny::wstring left(paths[names - 1].view());
+	tiny::wstring right(paths[names - 1].view());
+	auto leftInterned = interned[names - 1];
+	auto rightInterned = interned[2 * names - 1];
+
+	Measure("wstring equality (same contents)", 100000,
+		sink = left.compare(right) == 0;
+	);
+
+	Measure("interned_string equality", 100000,
+		sink = leftInterned == rightInterned;
+	);
+
+	Measure("intern lookup (hit)", 100000,
+		sink = reinterpret_cast<ULONG_PTR>(table.intern(left.view()).data());
+	);
+}
+
+static ULONG64 fnv1a(const unsigned char* data, size_t size)
+{
+	ULONG64 hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static void benchmarkHash()
+{
+	tiny::vector<unsigned char> data;
+	data.resize(65536);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+
+	const size_t sizes[] = { 16, 64, 256, 4096, 65536 };
+	for (auto size : sizes)
+	{
+		char caseName[64];
+		auto iterations = 4194304 / size;
+
+		tiny::format_to(caseName, "FNV-1a, {} bytes", size);
+		Measure(caseName, iterations,
+			sink = static_cast<ULONG_PTR>(fnv1a(data.begin(), size));
+		);
+
+		tiny::format_to(caseName, "tiny::hash_bytes, {} bytes", size);
+		Measure(caseName, iterations,
+			sink = static_cast<ULONG_PTR>(tiny::hash_bytes(data.begin(), size));
+		);
+	}
+
+	tiny::wstring path(L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\Product\\Module.dll");
+	Measure("tiny::hash<wstring> path", 100000,
+		sink = tiny::hash<tiny::wstring>()(path);
+	);
+
+	Measure("tiny::case_insensitive_hash<wstring> path", 100000,
+		sink = tiny::case_insensitive_hash<tiny::wstring>()(path);
+	);
+
+	Measure("tiny::hash<ULONG64>", 1000000,
+		sink = tiny::hash<ULONG64>()(sink);
+	);
+}
+
+static void benchmarkDeque()
+{
+	const size_t count = 1 << 18;
+	const size_t iterations = 20;
+
+	// grown by hand to track the peak, the old and the new buffer coexist at each doubling
+	size_t vectorPeak = 0;
+	Measure("grow to 262144, tiny::vector doubling", iterations,
+		tiny::vector<ULONG_PTR> values;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (values.size() == values.capacity())
+			{
+				auto capacity = values.capacity() ? values.capacity() * 2 : 16;
+				auto peak = (values.capacity() + capacity) * sizeof(ULONG_PTR);
+				vectorPeak = peak > vectorPeak ? peak : vectorPeak;
+				values.reserve(capacity);
+			}
+
+			values.push_back(i);
+		}
+		sink = values[count - 1];
+	);
+
+	size_t dequePeak = 0;
+	Measure("grow to 262144, tiny::deque", iterations,
+		tiny::deque<ULONG_PTR> values;
+		for (size_t i = 0; i < count; ++i)
+			values.push_back(i);
+		dequePeak = values.allocated_bytes();
+		sink = values[count - 1];
+	);
+
+	Message("    %-48s %10llu KB", "peak memory, tiny::vector doubling", static_cast<unsigned long long>(vectorPeak / 1024));
+	Message("    %-48s %10llu KB", "peak memory, tiny::deque", static_cast<unsigned long long>(dequePeak / 1024));
+
+	tiny::deque<ULONG_PTR> queue;
+	Measure("push_back + pop_front, tiny::deque", iterations * 100000,
+		queue.push_back(iteration);
+		sink = queue.front();
+		queue.pop_front();
+	);
+}
+
+// A request that builds a few temporary buffers and a list, then drops everything.
+template <typename Allocate, typename Vector>
+static void simulateRequest(Allocate allocate, Vector& entries)
+{
+	const size_t sizes[] = { 48, 160, 32, 520, 96, 64, 256, 40, 128, 80, 200, 24 };
+	for (auto size : sizes)
+	{
+		auto memory = static_cast<char*>(allocate(size));
+		memory[0] = 1;
+		sink = reinterpret_cast<ULONG_PTR>(memory);
+	}
+
+	for (ULONG_PTR i = 0; i < 48; ++i)
+		entries.push_back(i);
+}
+
+static void benchmarkArena()
+{
+	const size_t iterations = 100000;
+
+	Measure("request, pool allocations", iterations,
+		void* blocks[12];
+		size_t count = 0;
+		{
+			tiny::vector<ULONG_PTR> entries;
+			simulateRequest([&](size_t size) { return blocks[count++] = ALLOC_MEMORY(size); }, entries);
+		}
+		while (count)
+			FREE_MEMORY(blocks[--count]);
+	);
+
+	Measure("request, arena", iterations,
+		tiny::arena arena;
+		tiny::vector<ULONG_PTR, tiny::arena_allocator> entries((tiny::arena_allocator(arena)));
+		simulateRequest([&](size_t size) { return arena.allocate(size); }, entries);
+	);
+
+	Measure("request, arena with 4KB stack buffer", iterations,
+		alignas(16) char buffer[4096];
+		tiny::arena arena(buffer, sizeof(buffer));
+		tiny::vector<ULONG_PTR, tiny::arena_allocator> entries((tiny::arena_allocator(arena)));
+		simulateRequest([&](size_t size) { return arena.allocate(size); }, entries);
+	);
+}
+
+// Shaped like a per-stream context.
+struct BenchmarkContext {
+	ULONG_PTR fields[12];
+
+	BenchmarkContext(ULONG_PTR id) {
+		fields[0] = id;
+	}
+};
+
+static void benchmarkObjectPool()
+{
+	const size_t rounds = 16384;
+	const size_t iterations = 10;
+
+	auto processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+	tiny::thread_pool workers(processors);
+	tiny::object_pool<BenchmarkContext> pool;
+
+	// every round creates a burst of contexts and destroys them again
+	Measure("churn 16384 x 16, new/delete", iterations,
+		workers.parallel_for(0, rounds, [](size_t i) {
+			BenchmarkContext* contexts[16];
+			for (size_t j = 0; j < 16; ++j)
+				contexts[j] = new BenchmarkContext(i + j);
+
+			for (auto context : contexts)
+				delete context;
+		});
+	);
+
+	Measure("churn 16384 x 16, object_pool", iterations,
+		workers.parallel_for(0, rounds, [&](size_t i) {
+			tiny::object_pool<BenchmarkContext>::handle contexts[16];
+			for (size_t j = 0; j < 16; ++j)
+				contexts[j] = pool.acquire(i + j);
+		});
+	);
+
+	auto stats = pool.stats();
+	Message("    object_pool stats: %llu slots, high-water %llu", static_cast<ULONG64>(stats.slots), static_cast<ULONG64>(stats.highWater));
+}
+
+struct BenchmarkFlatRecord {
+	ULONG pid;
+	ULONG flags;
+	tiny::flat_string<wchar_t> image;
+};
+
+// What marshalling does today, one allocation per record and per string.
+struct BenchmarkCopiedRecord {
+	ULONG pid;
+	ULONG flags;
+	tiny::wstring image;
+};
+
+static void benchmarkFlat()
+{
+	const size_t records = 4096;
+	const size_t iterations = 100;
+
+	tiny::vector<tiny::wstring> images;
+	for (size_t i = 0; i < records; ++i)
+	{
+		tiny::wstring image(L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\agent");
+		image += (i % 2) ? L"_x64.exe" : L".exe";
+		images.push_back(image);
+	}
+
+	Measure("snapshot 4096 records, per-record copies", iterations,
+		tiny::vector<BenchmarkCopiedRecord*> copies;
+		copies.reserve(records);
+		for (size_t i = 0; i < records; ++i)
+		{
+			auto copy = new BenchmarkCopiedRecord();
+			copy->pid = static_cast<ULONG>(i);
+			copy->flags = 0;
+			copy->image = images[i];
+			copies.push_back(copy);
+		}
+
+		for (auto copy : copies)
+			delete copy;
+	);
+
+	Measure("snapshot 4096 records, flat_writer", iterations,
+		tiny::flat_writer writer(256 * 1024);
+		auto root = writer.create<tiny::flat_vector<BenchmarkFlatRecord>>();
+		auto items = writer.create_array<BenchmarkFlatRecord>(records);
+		for (size_t i = 0; i < records; ++i)
+		{
+			auto record = writer.element(items, i);
+			writer.get(record)->pid = static_cast<ULONG>(i);
+			writer.link(writer.field(record, &BenchmarkFlatRecord::image), writer.write(images[i].view()));
+		}
+		writer.link(root, items);
+		writer.finish(root);
+		sink = writer.size();
+	);
+
+	tiny::flat_writer writer;
+	auto root = writer.create<tiny::flat_vector<BenchmarkFlatRecord>>();
+	auto items = writer.create_array<BenchmarkFlatRecord>(records);
+	for (size_t i = 0; i < records; ++i)
+		writer.link(writer.field(writer.element(items, i), &BenchmarkFlatRecord::image), writer.write(images[i].view()));
+	writer.link(root, items);
+	writer.finish(root);
+
+	Measure("read 4096 records in place, flat_reader checked", iterations,
+		tiny::flat_reader reader(writer.data(), writer.size());
+		auto snapshot = reader.root<tiny::flat_vector<BenchmarkFlatRecord>>();
+		size_t characters = 0;
+		if (snapshot && reader.contains(*snapshot))
+		{
+			for (auto& record : *snapshot)
+			{
+				if (reader.contains(record.image))
+					characters += record.image.size();
+			}
+		}
+		sink = characters;
+	);
+
+	Message("    %-48s %10llu bytes", "flat buffer, 4096 records", static_cast<unsigned long long>(writer.size()));
+}
+
+static constexpr auto benchmarkProcessNames = tiny::make_keyword_set(
+	L"System", L"smss.exe", L"csrss.exe", L"wininit.exe", L"winlogon.exe", L"services.exe",
+	L"lsass.exe", L"lsaiso.exe", L"svchost.exe", L"fontdrvhost.exe", L"dwm.exe", L"MsMpEng.exe",
+	L"Registry", L"Memory Compression", L"spoolsv.exe", L"explorer.exe", L"sihost.exe", L"taskhostw.exe");
+
+static void benchmarkKeywordSet()
+{
+	const size_t iterations = 100000;
+
+	// the compare chain as the checks are written today
+	tiny::vector<tiny::wstring> chain;
+	for (size_t i = 0; i < benchmarkProcessNames.size(); ++i)
+	{
+		auto name = benchmarkProcessNames[i];
+		tiny::wstring key;
+		key.append(name.data(), name.size());
+		chain.push_back(key);
+	}
+
+	// mostly names that are not on the list, as in practice
+	tiny::vector<tiny::wstring> inputs;
+	const wchar_t* samples[] = { L"chrome.exe", L"svchost.exe", L"code.exe", L"notepad.exe", L"Teams.exe",
+		L"explorer.exe", L"python.exe", L"msedge.exe" };
+	for (auto sample : samples)
+		inputs.push_back(tiny::wstring(sample));
+
+	Measure("match 8 names, wstring::compare chain", iterations,
+		size_t matches = 0;
+		for (auto& input : inputs)
+		{
+			for (auto& key : chain)
+			{
+				if (input.compare(key) == 0)
+				{
+					++matches;
+					break;
+				}
+			}
+		}
+		sink = matches;
+	);
+
+	Measure("match 8 names, keyword_set", iterations,
+		size_t matches = 0;
+		for (auto& input : inputs)
+			matches += benchmarkProcessNames.contains(input);
+		sink = matches;
+	);
+}
+
+static void benchmarkBloomFilter()
+{
+	const size_t iterations = 1000;
+
+	// protected path rules, checked against paths that almost never match one
+	tiny::vector<tiny::wstring> rules;
+	tiny::vector<tiny::wstring> paths;
+	wchar_t text[96];
+
+	for (unsigned i = 0; i < 256; ++i)
+	{
+		auto length = tiny::format_to(text, L"\\Device\\HarddiskVolume3\\ProgramData\\Vendor{}\\config{}.bin", i % 16, i);
+		rules.push_back(tiny::wstring(tiny::wstring_view(text, length)));
+	}
+
+	for (unsigned i = 0; i < 64; ++i)
+	{
+		auto length = tiny::format_to(text, L"\\Device\\HarddiskVolume3\\Users\\user\\AppData\\Local\\Temp\\file{}.tmp", i);
+		paths.push_back(tiny::wstring(tiny::wstring_view(text, length)));
+	}
+
+	tiny::bloom_filter<tiny::wstring> bloom(rules, 10000);
+	tiny::cuckoo_filter<tiny::wstring> cuckoo(rules, 10000);
+	tiny::hash<tiny::wstring_view> hasher;
+
+	Message("    %-48s %10llu bytes", "bloom_filter, 256 rules", static_cast<unsigned long long>(bloom.size_in_bytes()));
+	Message("    %-48s %10llu bytes", "cuckoo_filter, 256 rules", static_cast<unsigned long long>(cuckoo.size_in_bytes()));
+
+	Measure("64 misses, compare against 256 rules", iterations,
+		size_t matches = 0;
+		for (auto& path : paths)
+		{
+			for (auto& rule : rules)
+			{
+				if (path.compare(rule) == 0)
+				{
+					++matches;
+					break;
+				}
+			}
+		}
+		sink = matches;
+	);
+
+	Measure("64 misses, hash only", iterations,
+		size_t total = 0;
+		for (auto& path : paths)
+			total += hasher(path);
+		sink = total;
+	);
+
+	Measure("64 misses, bloom_filter", iterations,
+		size_t matches = 0;
+		for (auto& path : paths)
+			matches += bloom.contains(path);
+		sink = matches;
+	);
+
+	Measure("64 misses, cuckoo_filter", iterations,
+		size_t matches = 0;
+		for (auto& path : paths)
+			matches += cuckoo.contains(path);
+		sink = matches;
+	);
+}
+
+struct BenchmarkVerdict {
+	ULONG64 fileId;
+	ULONG result;
+};
+
+static void benchmarkLruCache()
+{
+	const size_t iterations = 1000;
+	const ULONG64 capacity = 4096;
+
+	// the verdict list as it is kept today, searched front to back
+	tiny::vector<BenchmarkVerdict> list;
+	tiny::lru_cache<ULONG64, ULONG> cache(capacity);
+	tiny::sharded_lru_cache<ULONG64, ULONG> sharded(capacity);
+
+	for (ULONG64 i = 0; i < capacity; ++i)
+	{
+		list.push_back(BenchmarkVerdict{ i * 2, 1 });
+		cache.put(i * 2, 1);
+		sharded.put(i * 2, 1);
+	}
+
+	// half of the file IDs were scanned before
+	tiny::vector<ULONG64> lookups;
+	unsigned state = 5;
+	for (int i = 0; i < 64; ++i)
+		lookups.push_back(benchmarkRandom(state) % (capacity * 4));
+
+	Measure("64 lookups in 4096 verdicts, vector scan", iterations,
+		size_t hits = 0;
+		for (auto fileId : lookups)
+		{
+			for (auto& verdict : list)
+			{
+				if (verdict.fileId == fileId)
+				{
+					++hits;
+					break;
+				}
+			}
+		}
+		sink = hits;
+	);
+
+	Measure("64 lookups in 4096 verdicts, lru_cache", iterations,
+		size_t hits = 0;
+		ULONG result;
+		for (auto fileId : lookups)
+			hits += cache.get(fileId, result);
+		sink = hits;
+	);
+
+	Measure("64 lookups in 4096 verdicts, sharded_lru_cache", iterations,
+		size_t hits = 0;
+		ULONG result;
+		for (auto fileId : lookups)
+			hits += sharded.get(fileId, result);
+		sink = hits;
+	);
+
+	// every put of a new file evicts one
+	ULONG64 next = capacity * 2;
+	Measure("put with eviction, lru_cache", iterations * 64,
+		cache.put(next, 1);
+		next += 2;
+	);
+}
+
+static void benchmarkHistogram()
+{
+	const size_t iterations = 1000000;
+	tiny::histogram values("values");
+	TINY_HISTOGRAM(emptyScope, "empty scope");
+
+	Measure("stopwatch start and read", iterations,
+		tiny::stopwatch stopwatch;
+		sink = static_cast<ULONG_PTR>(stopwatch.elapsed());
+	);
+
+	Measure("cycle_stopwatch start and read", iterations,
+		tiny::cycle_stopwatch stopwatch;
+		sink = static_cast<ULONG_PTR>(stopwatch.elapsed());
+	);
+
+	Measure("histogram::record", iterations,
+		values.record(iteration & 0xFFFF);
+	);
+
+	Measure("TINY_SCOPED_CYCLE_TIMER, empty scope", iterations,
+		TINY_SCOPED_CYCLE_TIMER(emptyScope);
+	);
+
+	Measure("histogram::snapshot", 1000,
+		sink = static_cast<ULONG_PTR>(values.snapshot().count());
+	);
+
+	auto summary = emptyScope.summary();
+	Message("    %-48s %10llu cycles", "empty scope p50", static_cast<unsigned long long>(summary.p50));
+	Message("    %-48s %10llu cycles", "empty scope p99", static_cast<unsigned long long>(summary.p99));
+	Message("    %-48s %10llu cycles", "empty scope p999", static_cast<unsigned long long>(summary.p999));
+}
+
+static void benchmarkTrace()
+{
+	const size_t iterations = 1000000;
+	tiny::trace_buffer trace(65536);
+
+	// the Debug macro's path, kept short since every call reaches the debugger
+	Measure("DbgPrintEx, 2 arguments", 32,
+		DbgPrintEx(0, 0, "[TinyBench]: vector grow %llu -> %llu\n", static_cast<ULONG64>(iteration), static_cast<ULONG64>(iteration * 2));
+	);
+
+	Measure("trace_buffer::write, 2 arguments", iterations,
+		TINY_TRACE(trace, 1, iteration, iteration * 2);
+	);
+
+	auto processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+	tiny::thread_pool workers(processors);
+
+	// every processor writes its own ring
+	LARGE_INTEGER frequency;
+	auto start = KeQueryPerformanceCounter(&frequency);
+	workers.parallel_for(0, iterations, [&](size_t i) {
+		TINY_TRACE(trace, 1, i, i * 2);
+	}, 4096);
+	auto stop = KeQueryPerformanceCounter(nullptr);
+
+	auto ticks = static_cast<ULONG64>(stop.QuadPart - start.QuadPart);
+	Message("    %-48s %10llu events/s", "trace_buffer::write, all processors",
+		static_cast<unsigned long long>(ticks ? iterations * static_cast<ULONG64>(frequency.QuadPart) / ticks : 0));
+
+	tiny::vector<tiny::trace_record> records;
+	Measure("drain 64K events per processor", 1,
+		sink = static_cast<ULONG_PTR>(trace.drain(records));
+	);
+}
+
+static void benchmarkVectorBulk()
+{
+	const size_t count = 1000000;
+	const size_t iterations = 10;
+
+	tiny::vector<int> source;
+	fillRandom(source, count, 3);
+
+	Measure("load 1M ints, push_back loop", iterations,
+		tiny::vector<int> vec;
+		for (auto v : source)
+			vec.push_back(v);
+		sink = vec[count / 2];
+	);
+
+	Measure("load 1M ints, append_range", iterations,
+		tiny::vector<int> vec;
+		vec.append_range(source);
+		sink = vec[count / 2];
+	);
+
+	Measure("insert 1M ints at the front of 1M, insert range", iterations,
+		tiny::vector<int> vec;
+		vec.assign(source.begin(), source.end());
+		vec.insert(0, source.begin(), source.end());
+		sink = vec[count + count / 2];
+	);
+
+	Measure("1M ints, resize", iterations,
+		tiny::vector<int> vec;
+		vec.resize(count);
+		sink = vec.size();
+	);
+
+	Measure("1M ints, resize_for_overwrite", iterations,
+		tiny::vector<int> vec;
+		vec.resize_for_overwrite(count);
+		sink = vec.size();
+	);
+
+	Measure("append 1M ints and erase a third, erase_if", iterations,
+		tiny::vector<int> vec;
+		vec.append_range(source);
+		sink = vec.erase_if([](int v) { return v % 3 == 0; });
+	);
+}
+
+// mostly ASCII paths as they come from configuration, a few with names outside of it
+static const char* const benchmarkPaths[] = {
+	"\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\etc\\hosts",
+	"\\Device\\HarddiskVolume3\\Program Files\\Common Files\\microsoft shared\\ClickToRun\\OfficeClickToRun.exe",
+	"\\Device\\HarddiskVolume3\\Users\\J\xC3\xBC" "rgen\\AppData\\Local\\Temp\\~DF3A1C.tmp",
+	"\\Device\\HarddiskVolume3\\Windows\\WinSxS\\amd64_microsoft-windows-kernel32_31bf3856ad364e35_10.0.19041.3636_none\\kernel32.dll",
+	"\\REGISTRY\\MACHINE\\SYSTEM\\ControlSet001\\Services\\Tcpip\\Parameters\\Interfaces",
+	"\\Device\\HarddiskVolume3\\Users\\\xE5\xB1\xB1\xE7\x94\xB0\\Documents\\\xE8\xA6\x8B\xE7\xA9\x8D\xE6\x9B\xB8.docx",
+	"\\Device\\Mup\\fileserver\\share\\builds\\nightly\\x64\\release\\setup.msi",
+	"\\??\\C:\\ProgramData\\Microsoft\\Windows Defender\\Scans\\History\\Service\\DetectionHistory",
+};
+
+static void benchmarkUnicode()
+{
+	const size_t iterations = 100000;
+	const size_t count = RTL_NUMBER_OF(benchmarkPaths);
+
+	tiny::string_view paths[count];
+	tiny::wstring widePaths[count];
+	for (size_t i = 0; i < count; ++i)
+	{
+		paths[i] = benchmarkPaths[i];
+		tiny::to_wstring(paths[i], widePaths[i]);
+	}
+
+	Measure("8 paths to wstring, Rtl into temporary buffer", iterations,
+		for (auto path : paths)
+		{
+			auto size = static_cast<ULONG>(path.size());
+			ULONG bytes = 0;
+			RtlUTF8ToUnicodeN(nullptr, 0, &bytes, path.data(), size);
+
+			auto buffer = static_cast<PWSTR>(ALLOC_MEMORY(bytes));
+			RtlUTF8ToUnicodeN(buffer, bytes, &bytes, path.data(), size);
+
+			tiny::wstring wide(tiny::wstring_view(buffer, bytes / sizeof(WCHAR)));
+			FREE_MEMORY(buffer);
+			sink = wide.size();
+		}
+	);
+
+	Measure("8 paths to wstring, to_wstring", iterations,
+		for (auto path : paths)
+		{
+			tiny::wstring wide;
+			tiny::to_wstring(path, wide);
+			sink = wide.size();
+		}
+	);
+
+	Measure("8 paths to wstring, to_wstring into an arena", iterations,
+		char buffer[2048];
+		tiny::arena arena(buffer, sizeof(buffer));
+		for (auto path : paths)
+		{
+			tiny::wstring_view wide;
+			tiny::to_wstring(path, arena, wide);
+			sink = wide.size();
+		}
+	);
+
+	Measure("8 paths to string, Rtl into temporary buffer", iterations,
+		for (auto& path : widePaths)
+		{
+			auto size = static_cast<ULONG>(path.size() * sizeof(WCHAR));
+			ULONG bytes = 0;
+			RtlUnicodeToUTF8N(nullptr, 0, &bytes, path.data(), size);
+
+			auto buffer = static_cast<PCHAR>(ALLOC_MEMORY(bytes));
+			RtlUnicodeToUTF8N(buffer, bytes, &bytes, path.data(), size);
+
+			tiny::string narrow(tiny::string_view(buffer, bytes));
+			FREE_MEMORY(buffer);
+			sink = narrow.size();
+		}
+	);
+
+	Measure("8 paths to string, to_string", iterations,
+		for (auto& path : widePaths)
+		{
+			tiny::string narrow;
+			tiny::to_string(path, narrow);
+			sink = narrow.size();
+		}
+	);
+}
+
+static void benchmarkTimers()
+{
+	const size_t outstanding = 1000000;
+	const ULONG64 horizon = 1000; // ticks ahead the deadlines spread over, about as many expire per tick as are added
+	const size_t perTick = 1000; // new deadlines between two ticks
+	const size_t iterations = 20;
+
+	tiny::vector<ULONG64> deadlines;
+	unsigned state = 9;
+	for (size_t i = 0; i < outstanding + perTick * iterations; ++i)
+		deadlines.push_back(1 + benchmarkRandom(state) % horizon);
+
+	// expiration as done today, the deadlines are sorted on every tick and the due ones cut off the front
+	{
+		tiny::vector<ULONG64> pending;
+		pending.append_range(deadlines.begin(), deadlines.begin() + outstanding);
+		size_t next = outstanding;
+		ULONG64 now = 0;
+
+		Measure("tick with 1M timers, sort and scan", iterations,
+			pending.append_range(deadlines.begin() + next, deadlines.begin() + next + perTick);
+			next += perTick;
+			++now;
+
+			tiny::sort(pending.begin(), pending.end());
+			size_t due = 0;
+			while (due < pending.size() && pending[due] <= now)
+				++due;
+
+			pending.erase(0, due);
+			sink = due;
+		);
+	}
+
+	{
+		tiny::priority_queue<ULONG64, tiny::greater> queue;
+		queue.reserve(outstanding + perTick * iterations);
+		for (size_t i = 0; i < outstanding; ++i)
+			queue.push(deadlines[i]);
+
+		size_t next = outstanding;
+		ULONG64 now = 0;
+
+		Measure("tick with 1M timers, priority_queue", iterations,
+			for (size_t i = 0; i < perTick; ++i)
+				queue.push(deadlines[next++]);
+			++now;
+
+			size_t due = 0;
+			for (; !queue.empty() && queue.top() <= now; ++due)
+				queue.pop();
+
+			sink = due;
+		);
+	}
+
+	{
+		tiny::timer_wheel<ULONG> wheel;
+		wheel.reserve(outstanding + perTick * iterations);
+		for (size_t i = 0; i < outstanding; ++i)
+			wheel.schedule(deadlines[i], static_cast<ULONG>(i));
+
+		size_t next = outstanding;
+
+		Measure("tick with 1M timers, timer_wheel", iterations,
+			for (size_t i = 0; i < perTick; ++i, ++next)
+				wheel.schedule(deadlines[next], static_cast<ULONG>(next));
+
+			sink = wheel.advance(wheel.now() + 1, [](ULONG) {});
+		);
+	}
+
+	Measure("schedule 1M timers, priority_queue", 1,
+		tiny::priority_queue<ULONG64, tiny::greater> queue;
+		queue.reserve(outstanding);
+		for (size_t i = 0; i < outstanding; ++i)
+			queue.push(deadlines[i]);
+		sink = queue.size();
+	);
+
+	{
+		tiny::vector<tiny::timer_wheel<ULONG>::timer_id> ids;
+		tiny::timer_wheel<ULONG> wheel;
+		ids.reserve(outstanding);
+		wheel.reserve(outstanding);
+
+		Measure("schedule 1M timers, timer_wheel", 1,
+			for (size_t i = 0; i < outstanding; ++i)
+				ids.push_back(wheel.schedule(deadlines[i], static_cast<ULONG>(i)));
+			sink = wheel.size();
+		);
+
+		// most pending operations complete before their deadline
+		Measure("cancel 1M timers, timer_wheel", 1,
+			for (auto id : ids)
+				wheel.cancel(id);
+			sink = wheel.size();
+		);
+	}
+
+	{
+		tiny::vector<tiny::priority_queue<ULONG64, tiny::greater>::handle> handles;
+		tiny::priority_queue<ULONG64, tiny::greater> queue;
+		handles.reserve(outstanding);
+		queue.reserve(outstanding);
+		for (size_t i = 0; i < outstanding; ++i)
+			handles.push_back(queue.push(deadlines[i]));
+
+		Measure("cancel 1M timers, priority_queue", 1,
+			for (auto handle : handles)
+				queue.erase(handle);
+			sink = queue.size();
+		);
+	}
+}
+
+static void benchmarkAtomic()
+{
+	const size_t iterations = 1000000;
+
+	// publishing a value with raw intrinsics as done today, each one a full barrier
+	{
+		volatile LONG value = 0;
+
+		Measure("publish and read, Interlocked", iterations,
+			InterlockedExchange(&value, static_cast<LONG>(sink));
+			sink = InterlockedCompareExchange(&value, 0, 0);
+		);
+	}
+
+	{
+		tiny::atomic<LONG> value;
+
+		Measure("publish and read, release and acquire", iterations,
+			value.store(static_cast<LONG>(sink), tiny::memory_order_release);
+			sink = value.load(tiny::memory_order_acquire);
+		);
+	}
+}
+
+// The normalization done today, one find and erase pass over the string for each rule.
+static ULONG normalizePathMultiPass(tiny::wstring& path, const tiny::volume_map& volumes)
+{
+	const tiny::wstring_view prefixes[] = { L"\\DosDevices\\", L"\\GLOBAL??\\" };
+	for (auto prefix : prefixes)
+	{
+		if (path.find(prefix) == 0)
+			path = tiny::concat<tiny::wstring>(tiny::wstring_view(L"\\??\\"), path.view().substr(prefix.size()));
+	}
+
+	for (auto pos = path.find(L"\\\\"); pos != tiny::wstring::npos; pos = path.find(L"\\\\", pos))
+		path.erase(pos);
+
+	for (auto pos = path.find(L"\\.\\"); pos != tiny::wstring::npos; pos = path.find(L"\\.\\", pos))
+		path.erase(pos, pos + 2);
+
+	for (auto pos = path.find(L"\\..\\"); pos != tiny::wstring::npos; pos = path.find(L"\\..\\"))
+	{
+		auto first = pos;
+		while (first && path.data()[first - 1] != L'\\')
+			--first;
+
+		path.erase(first ? first - 1 : 0, pos + 3);
+	}
+
+	while (path.size() > 1 && path.data()[path.size() - 1] == L'\\')
+		path.pop_back();
+
+	for (auto& c : path)
+		c = RtlUpcaseUnicodeChar(c);
+
+	ULONG volume = 0;
+	if (path.find(L"\\DEVICE\\") == 0)
+	{
+		auto end = path.find(L"\\", 8);
+		volume = volumes.find(path.view().substr(0, end));
+		if (volume)
+		{
+			path.erase(0, end == tiny::wstring::npos ? path.size() : end);
+			if (path.empty())
+				path = L"\\";
+		}
+	}
+
+	return volume;
+}
+
+static void benchmarkPath()
+{
+	const tiny::wstring_view roots[] = {
+		L"\\Device\\HarddiskVolume3",
+		L"\\??\\C:",
+		L"\\DosDevices\\D:",
+		L"\\Device\\HarddiskVolume1",
+	};
+
+	const tiny::wstring_view directories[] = {
+		L"\\Windows\\System32",
+		L"\\Windows\\System32\\drivers\\..\\config",
+		L"\\Windows\\WinSxS\\amd64_microsoft.windows.common-controls_6595b64144ccf1df_6.0.19041.1110_none_60b5254171f9507e",
+		L"\\Program Files\\Microsoft Office\\root\\Office16",
+		L"\\Program Files (x86)\\Common Files\\.\\Microsoft Shared\\VC",
+		L"\\Users\\Public\\Documents\\",
+		L"\\ProgramData\\Microsoft\\Windows Defender\\Platform\\4.18.2205.7-0",
+		L"\\Users\\someone\\AppData\\Local\\Temp\\\\7zS4A2B",
+	};
+
+	tiny::volume_map volumes;
+	volumes.set(L"\\Device\\HarddiskVolume3", 3);
+	volumes.set(L"\\Device\\HarddiskVolume1", 1);
+
+	tiny::vector<tiny::wstring> paths;
+	for (size_t i = 0; i < 1024; ++i)
+	{
+		tiny::wstring path;
+		tiny::format_to(path, L"{}{}\\file{}.dll", roots[i % RTL_NUMBER_OF(roots)],
+			directories[i / RTL_NUMBER_OF(roots) % RTL_NUMBER_OF(directories)], i);
+		paths.push_back(tiny::move(path));
+	}
+
+	// the same buffer is refilled for every path, so neither side pays for allocations
+	tiny::wstring work;
+	work.reserve(512);
+	size_t next = 0;
+
+	Measure("normalize path, find/erase passes", 100000,
+		work = paths[next++ % paths.size()];
+		sink = normalizePathMultiPass(work, volumes);
+	);
+
+	Measure("normalize path, normalize_path", 100000,
+		work = paths[next++ % paths.size()];
+		sink = tiny::normalize_path(work, volumes);
+	);
+
+	// components as copies the way a find loop yields them, against views
+	Measure("path components, wstring copies", 100000,
+		auto& path = paths[next++ % paths.size()];
+		size_t count = 0;
+		for (size_t first = 0; first < path.size();)
+		{
+			auto last = path.find(L"\\", first);
+			if (last == tiny::wstring::npos)
+				last = path.size();
+
+			if (last != first)
+			{
+				tiny::wstring component(path.view().substr(first, last - first));
+				count += component.size();
+			}
+
+			first = last + 1;
+		}
+
+		sink = count;
+	);
+
+	Measure("path components, path_components", 100000,
+		auto& path = paths[next++ % paths.size()];
+		size_t count = 0;
+		for (auto component : tiny::path_components(path))
+			count += component.size();
+
+		sink = count;
+	);
+}
+
+namespace tiny {
+	void runBenchmarks() {
+		Message("Starting...");
+		Execute(benchmarkSharedPtr);
+		Execute(benchmarkStringBuilding);
+		Execute(benchmarkAlgorithm);
+		Execute(benchmarkThreadPool);
+		Execute(benchmarkWorkQueue);
+		Execute(benchmarkFuture);
+		Execute(benchmarkBitset);
+		Execute(benchmarkIntern);
+		Execute(benchmarkHash);
+		Execute(benchmarkDeque);
+		Execute(benchmarkArena);
+		Execute(benchmarkObjectPool);
+		Execute(benchmarkFlat);
+		Execute(benchmarkKeywordSet);
+		Execute(benchmarkBloomFilter);
+		Execute(benchmarkLruCache);
+		Execute(benchmarkHistogram);
+		Execute(benchmarkTrace);
+		Execute(benchmarkVectorBulk);
+		Execute(benchmarkUnicode);
+		Execute(benchmarkTimers);
+		Execute(benchmarkAtomic);
+		Execute(benchmarkPath);
+		Message("Finished...");
+	}
+}
\ No newline at end of file
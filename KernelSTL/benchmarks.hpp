@@ -0,0 +1,5 @@
+#pragma once
+
+namespace tiny{
+void runBenchmarks();
+}
\ No newline at end of file
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "common.hpp"
+#include "vector.hpp"
+
+// POPCNT is not part of the x64 baseline, define TINY_POPCNT when the target always has it.
+#if defined(__POPCNT__) || defined(__AVX__)
+#define TINY_POPCNT 1
+#endif
+
+namespace tiny {
+	inline size_t _popcount64(ULONG64 value) {
+#ifdef TINY_POPCNT
+		return static_cast<size_t>(__popcnt64(value));
+#else
+		value = value - ((value >> 1) & 0x5555555555555555ull);
+		value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<size_t>((value * 0x0101010101010101ull) >> 56);
+#endif
+	}
+
+	// value must not be zero
+	inline size_t _lowest_bit(ULONG64 value) {
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+	}
+
+	// value must not be zero
+	inline size_t _highest_bit(ULONG64 value) {
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+	}
+
+	// Bits packed into 64-bit words, searches skip a whole word per step.
+	class dynamic_bitset {
+	public:
+		inline static const size_t npos = static_cast<size_t>(-1);
+
+		dynamic_bitset() noexcept
+			: _size(0) {
+		}
+
+		explicit dynamic_bitset(size_t count, bool value = false)
+			: _size(0) {
+			this->resize(count, value);
+		}
+
+		size_t size() const noexcept {
+			return _size;
+		}
+
+		bool empty() const noexcept {
+			return _size == 0;
+		}
+
+		// bits added by growing take the given value
+		void resize(size_t count, bool value = false) {
+			auto oldSize = _size;
+			_words.resize(_wordCount(count));
+			_size = count;
+
+			if (value && count > oldSize)
+				this->_fill(oldSize, count, true);
+
+			this->_trim();
+		}
+
+		bool test(size_t pos) const noexcept {
+			return (_words[pos / 64] >> (pos % 64)) & 1;
+		}
+
+		bool operator [](size_t pos) const noexcept {
+			return this->test(pos);
+		}
+
+		dynamic_bitset& set(size_t pos, bool value = true) noexcept {
+			if (value)
+				_words[pos / 64] |= 1ull << (pos % 64);
+			else
+				_words[pos / 64] &= ~(1ull << (pos % 64));
+
+			return *this;
+		}
+
+		dynamic_bitset& reset(size_t pos) noexcept {
+			return this->set(pos, false);
+		}
+
+		dynamic_bitset& flip(size_t pos) noexcept {
+			_words[pos / 64] ^= 1ull << (pos % 64);
+			return *this;
+		}
+
+		dynamic_bitset& set() noexcept {
+			for (auto& word : _words)
+				word = ~0ull;
+
+			this->_trim();
+			return *this;
+		}
+
+		dynamic_bitset& reset() noexcept {
+			for (auto& word : _words)
+				word = 0;
+
+			return *this;
+		}
+
+		dynamic_bitset& flip() noexcept {
+			for (auto& word : _words)
+				word = ~word;
+
+			this->_trim();
+			return *this;
+		}
+
+		// sets or clears [first, last)
+		dynamic_bitset& set(size_t first, size_t last, bool value) noexcept {
+			this->_fill(first, last, value);
+			return *this;
+		}
+
+		size_t count() const noexcept {
+			size_t result = 0;
+			for (auto word : _words)
+				result += _popcount64(word);
+
+			return result;
+		}
+
+		bool any() const noexcept {
+			for (auto word : _words)
+			{
+				if (word)
+					return true;
+			}
+
+			return false;
+		}
+
+		bool none() const noexcept {
+			return !this->any();
+		}
+
+		bool all() const noexcept {
+			return this->find_first_clear() == npos;
+		}
+
+		size_t find_first() const noexcept {
+			return this->_findSet(0);
+		}
+
+		// first set bit after pos
+		size_t find_next(size_t pos) const noexcept {
+			return this->_findSet(pos + 1);
+		}
+
+		size_t find_last() const noexcept {
+			for (auto i = _words.size(); i--; )
+			{
+				if (_words[i])
+					return i * 64 + _highest_bit(_words[i]);
+			}
+
+			return npos;
+		}
+
+		size_t find_first_clear() const noexcept {
+			return this->_findClear(0);
+		}
+
+		// first clear bit after pos
+		size_t find_next_clear(size_t pos) const noexcept {
+			return this->_findClear(pos + 1);
+		}
+
+		// Bulk operations expect bitsets of the same size.
+		dynamic_bitset& operator&=(const dynamic_bitset& other) noexcept {
+			for (size_t i = 0; i < _words.size(); ++i)
+				_words[i] &= other._words[i];
+
+			return *this;
+		}
+
+		dynamic_bitset& operator|=(const dynamic_bitset& other) noexcept {
+			for (size_t i = 0; i < _words.size(); ++i)
+				_words[i] |= other._words[i];
+
+			return *this;
+		}
+
+		dynamic_bitset& operator^=(const dynamic_bitset& other) noexcept {
+			for (size_t i = 0; i < _words.size(); ++i)
+				_words[i] ^= other._words[i];
+
+			return *this;
+		}
+
+		// clears every bit that is set in other
+		dynamic_bitset& and_not(const dynamic_bitset& other) noexcept {
+			for (size_t i = 0; i < _words.size(); ++i)
+				_words[i] &= ~other._words[i];
+
+			return *this;
+		}
+
+		bool operator==(const dynamic_bitset& other) const noexcept {
+			if (_size != other._size)
+				return false;
+
+			return !_words.size() || memcmp(_words.data(), other._words.data(), _words.size() * sizeof(ULONG64)) == 0;
+		}
+
+		bool operator!=(const dynamic_bitset& other) const noexcept {
+			return !(*this == other);
+		}
+
+		const ULONG64* words() const noexcept {
+			return _words.data();
+		}
+
+		size_t word_count() const noexcept {
+			return _words.size();
+		}
+	private:
+		tiny::vector<ULONG64> _words;
+		size_t _size;
+
+		static size_t _wordCount(size_t bits) noexcept {
+			return (bits + 63) / 64;
+		}
+
+		// bits past the size are kept clear so counting and searching need no masking
+		void _trim() noexcept {
+			if (_size % 64)
+				_words[_size / 64] &= (1ull << (_size % 64)) - 1;
+		}
+
+		void _fill(size_t first, size_t last, bool value) noexcept {
+			while (first < last)
+			{
+				auto bit = first % 64;
+				auto span = 64 - bit < last - first ? 64 - bit : last - first;
+				auto mask = span == 64 ? ~0ull : ((1ull << span) - 1) << bit;
+
+				if (value)
+					_words[first / 64] |= mask;
+				else
+					_words[first / 64] &= ~mask;
+
+				first += span;
+			}
+		}
+
+		size_t _findSet(size_t pos) const noexcept {
+			if (pos >= _size)
+				return npos;
+
+			auto index = pos / 64;
+			auto word = _words[index] & (~0ull << (pos % 64));
+
+			while (true)
+			{
+				if (word)
+					return index * 64 + _lowest_bit(word);
+
+				if (++index == _words.size())
+					return npos;
+
+				word = _words[index];
+			}
+		}
+
+		size_t _findClear(size_t pos) const noexcept {
+			if (pos >= _size)
+				return npos;
+
+			auto index = pos / 64;
+			auto word = ~_words[index] & (~0ull << (pos % 64));
+
+			while (true)
+			{
+				if (word)
+				{
+					auto result = index * 64 + _lowest_bit(word);
+					return result < _size ? result : npos;
+				}
+
+				if (++index == _words.size())
+					return npos;
+
+				word = ~_words[index];
+			}
+		}
+	};
+
+	/*
+	* Fixed size bitset for concurrent slot allocation, usable at any IRQL from non-paged memory.
+	* claim() takes a clear bit with an interlocked bit-test-and-set, so two callers never get
+	* the same slot and no lock is involved.
+	*/
+	class atomic_bitset {
+	public:
+		inline static const size_t npos = static_cast<size_t>(-1);
+
+		atomic_bitset& operator=(const atomic_bitset&) = delete;
+		atomic_bitset(const atomic_bitset&) = delete;
+
+		explicit atomic_bitset(size_t count)
+			: _size(count), _hint(0) {
+			_words.resize((count + 63) / 64);
+
+			// bits past the size are permanently taken
+			if (count % 64)
+				_words[count / 64] = ~((1ull << (count % 64)) - 1);
+		}
+
+		size_t size() const noexcept {
+			return _size;
+		}
+
+		bool test(size_t pos) const noexcept {
+			return (this->_word(pos / 64) >> (pos % 64)) & 1;
+		}
+
+		// returns the previous value
+		bool set(size_t pos) noexcept {
+			return InterlockedBitTestAndSet64(this->_wordPtr(pos / 64), pos % 64) != 0;
+		}
+
+		// returns the previous value
+		bool reset(size_t pos) noexcept {
+			return InterlockedBitTestAndReset64(this->_wordPtr(pos / 64), pos % 64) != 0;
+		}
+
+		// Sets and returns a bit that was clear, npos when all are set.
+		size_t claim() noexcept {
+			auto wordCount = _words.size();
+			auto start = _hint;
+
+			for (size_t i = 0; i < wordCount; ++i)
+			{
+				auto index = (start + i) % wordCount;
+				auto free = ~this->_word(index);
+
+				while (free)
+				{
+					auto bit = _lowest_bit(free);
+					if (!InterlockedBitTestAndSet64(this->_wordPtr(index), bit))
+					{
+						_hint = index;
+						return index * 64 + bit;
+					}
+
+					free = ~this->_word(index);
+				}
+			}
+
+			return npos;
+		}
+
+		void release(size_t pos) noexcept {
+			this->reset(pos);
+		}
+
+		// snapshot, may be stale as soon as it returns
+		size_t count() const noexcept {
+			size_t result = 0;
+			for (size_t i = 0; i < _words.size(); ++i)
+				result += _popcount64(this->_word(i));
+
+			return result - (_words.size() * 64 - _size);
+		}
+	private:
+		tiny::vector<ULONG64> _words;
+		size_t _size;
+		volatile size_t _hint; // word of the last claim, spreads claims away from full words
+
+		volatile LONG64* _wordPtr(size_t index) noexcept {
+			return reinterpret_cast<volatile LONG64*>(_words.begin() + index);
+		}
+
+		ULONG64 _word(size_t index) const noexcept {
+			return *reinterpret_cast<volatile const ULONG64*>(_words.begin() + index);
+		}
+	};
+}
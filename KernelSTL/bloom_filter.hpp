@@ -0,0 +1,421 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "hash.hpp"
+#include "bitset.hpp"
+#include "mutex.hpp"
+
+namespace tiny {
+	// Bits per key giving a false positive rate of 2^-i. A block receives a Poisson number of keys,
+	// k with mean 256 / bits, and a probe hits with (1 - (31/32)^k)^8 as every key sets one bit
+	// in each word. The table is the smallest bits per key whose rate summed over k is 2^-i.
+	inline constexpr UCHAR _filterBitsPerKey[] = {
+		8, 8, 8, 8, 8, 9, 10, 12, 13, 15, 17, 20, 23, 26, 29, 34, 38, 44, 50, 57, 66, 76, 88, 101, 118
+	};
+
+	// Bits per key for a false positive rate of at most one in oneIn. The eight bits of a key cost
+	// more and more space below that, so rates below one in 2^24 get the 2^24 size.
+	inline size_t _filter_bits_per_key(ULONG64 oneIn) noexcept {
+		if (oneIn <= 1)
+			return _filterBitsPerKey[0];
+
+		auto log2 = _highest_bit(oneIn) + ((oneIn & (oneIn - 1)) ? 1 : 0);
+		auto last = RTL_NUMBER_OF(_filterBitsPerKey) - 1;
+		return _filterBitsPerKey[log2 < last ? log2 : last];
+	}
+
+	// Pool memory aligned to a cache line, the raw allocation is kept for freeing.
+	class _cache_aligned_buffer {
+	public:
+		_cache_aligned_buffer& operator=(const _cache_aligned_buffer&) = delete;
+		_cache_aligned_buffer(const _cache_aligned_buffer&) = delete;
+
+		explicit _cache_aligned_buffer(size_t size) {
+			_allocation = ALLOC_MEMORY(size + 64);
+			if (!_allocation)
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+			_data = reinterpret_cast<void*>((reinterpret_cast<ULONG_PTR>(_allocation) + 63) & ~static_cast<ULONG_PTR>(63));
+			memset(_data, 0, size);
+		}
+
+		~_cache_aligned_buffer() {
+			FREE_MEMORY(_allocation);
+		}
+
+		template <typename T>
+		T* get() const noexcept {
+			return static_cast<T*>(_data);
+		}
+	private:
+		void* _allocation;
+		void* _data;
+	};
+
+	/*
+	* Split block Bloom filter. A key sets one bit in each of the eight 32-bit words of a single
+	* 256-bit block, so a probe reads half a cache line and tests all eight bits at once.
+	* Inserts set bits with interlocked operations and lookups take no lock, both can run
+	* concurrently at any IRQL. A lookup racing the insert of the same key may still miss it.
+	*/
+	template <typename Key, typename Hash = tiny::hash<Key>>
+	class bloom_filter {
+	public:
+		bloom_filter& operator=(const bloom_filter&) = delete;
+		bloom_filter(const bloom_filter&) = delete;
+
+		// Sized for expectedKeys with at most one false positive in falsePositiveOneIn lookups, down
+		// to one in 2^24.
+		bloom_filter(size_t expectedKeys, ULONG64 falsePositiveOneIn, const Hash& hasher = Hash())
+			: _hasher(hasher), _blockCount(_blocksFor(expectedKeys, falsePositiveOneIn)), _blocks(_blockCount * sizeof(_block)) {
+		}
+
+		// e.g. from a tiny::vector<tiny::wstring> of paths
+		template <typename T, typename Allocator>
+		bloom_filter(const tiny::vector<T, Allocator>& keys, ULONG64 falsePositiveOneIn, const Hash& hasher = Hash())
+			: bloom_filter(keys.size(), falsePositiveOneIn, hasher) {
+			for (auto& key : keys)
+				this->insert(key);
+		}
+
+		template <typename K>
+		void insert(const K& key) noexcept {
+			this->insert_hash(static_cast<ULONG64>(_hasher(key)));
+		}
+
+		// false means the key was never inserted
+		template <typename K>
+		bool contains(const K& key) const noexcept {
+			return this->contains_hash(static_cast<ULONG64>(_hasher(key)));
+		}
+
+		void insert_hash(ULONG64 hash) noexcept {
+			auto& block = this->_blockFor(hash);
+			ULONG masks[8];
+			_masks(static_cast<ULONG>(hash), masks);
+
+			for (int i = 0; i < 8; ++i)
+			{
+				if ((block.words[i] & masks[i]) != masks[i])
+					InterlockedOr(reinterpret_cast<volatile LONG*>(&block.words[i]), static_cast<LONG>(masks[i]));
+			}
+		}
+
+		bool contains_hash(ULONG64 hash) const noexcept {
+			auto& block = this->_blockFor(hash);
+#ifdef TINY_SSE2
+			__m128i low, high;
+			_masks(static_cast<ULONG>(hash), low, high);
+
+			auto words = reinterpret_cast<const __m128i*>(const_cast<const ULONG*>(block.words));
+			auto missing = _mm_or_si128(_mm_andnot_si128(_mm_load_si128(words), low), _mm_andnot_si128(_mm_load_si128(words + 1), high));
+			return _mm_movemask_epi8(_mm_cmpeq_epi32(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+			ULONG masks[8];
+			_masks(static_cast<ULONG>(hash), masks);
+
+			for (int i = 0; i < 8; ++i)
+			{
+				if ((block.words[i] & masks[i]) != masks[i])
+					return false;
+			}
+
+			return true;
+#endif
+		}
+
+		size_t size_in_bytes() const noexcept {
+			return _blockCount * sizeof(_block);
+		}
+	private:
+		struct _block {
+			volatile ULONG words[8];
+		};
+
+		static constexpr ULONG _salts[8] = {
+			0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du, 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+		};
+
+		Hash _hasher;
+		size_t _blockCount;
+		_cache_aligned_buffer _blocks;
+
+		static size_t _blocksFor(size_t keys, ULONG64 oneIn) noexcept {
+			auto blocks = (keys * _filter_bits_per_key(oneIn) + 255) / 256;
+			return blocks ? blocks : 1;
+		}
+
+		_block& _blockFor(ULONG64 hash) const noexcept {
+			// the upper half picks the block without a division
+			return _blocks.get<_block>()[((hash >> 32) * _blockCount) >> 32];
+		}
+
+		// bit (hash * salt) >> 27 of every word
+		static void _masks(ULONG hash, ULONG (&masks)[8]) noexcept {
+			for (int i = 0; i < 8; ++i)
+				masks[i] = 1u << ((hash * _salts[i]) >> 27);
+		}
+
+#ifdef TINY_SSE2
+		static void _masks(ULONG hash, __m128i& low, __m128i& high) noexcept {
+			low = _mask4(hash, _mm_setr_epi32(_salts[0], _salts[1], _salts[2], _salts[3]));
+			high = _mask4(hash, _mm_setr_epi32(_salts[4], _salts[5], _salts[6], _salts[7]));
+		}
+
+		static __m128i _mask4(ULONG hash, __m128i salts) noexcept {
+			// SSE2 has no 32-bit multiply, two 32x32->64 multiplies give the low halves
+			auto value = _mm_set1_epi32(static_cast<int>(hash));
+			auto even = _mm_mul_epu32(value, salts);
+			auto odd = _mm_mul_epu32(value, _mm_srli_si128(salts, 4));
+			auto products = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+
+			// nor a variable shift, 1 << n is built as the float 2^n and converted back,
+			// 2^31 converts to 0x80000000 which is the wanted bit as well
+			auto exponents = _mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(products, 27), _mm_set1_epi32(127)), 23);
+			return _mm_cvttps_epi32(_mm_castsi128_ps(exponents));
+		}
+#endif
+	};
+
+	/*
+	* Cuckoo filter with 16-bit fingerprints in buckets of four, which unlike a Bloom filter
+	* supports erase. A key lives in one of two buckets, the second derived from the first and
+	* the fingerprint, and a lookup compares both buckets with a single SSE2 compare.
+	* Writers are serialized by a spin lock and bump a sequence number around each change,
+	* readers take no lock and retry when a writer moved fingerprints under them.
+	*/
+	template <typename Key, typename Hash = tiny::hash<Key>>
+	class cuckoo_filter {
+	public:
+		cuckoo_filter& operator=(const cuckoo_filter&) = delete;
+		cuckoo_filter(const cuckoo_filter&) = delete;
+
+		// A lookup meets about 8 * load stored fingerprints of 16 bits, rates below one in 8K
+		// lower the load instead of the fingerprint size.
+		cuckoo_filter(size_t expectedKeys, ULONG64 falsePositiveOneIn, const Hash& hasher = Hash())
+			: _hasher(hasher), _bucketMask(_bucketsFor(expectedKeys, falsePositiveOneIn) - 1), _buckets((_bucketMask + 1) * sizeof(_bucket)),
+			_sequence(0), _count(0) {
+		}
+
+		template <typename T, typename Allocator>
+		cuckoo_filter(const tiny::vector<T, Allocator>& keys, ULONG64 falsePositiveOneIn, const Hash& hasher = Hash())
+			: cuckoo_filter(keys.size(), falsePositiveOneIn, hasher) {
+			for (auto& key : keys)
+				this->insert(key);
+		}
+
+		// false when the filter is too full to take the key
+		template <typename K>
+		bool insert(const K& key) noexcept {
+			return this->insert_hash(static_cast<ULONG64>(_hasher(key)));
+		}
+
+		// only keys that were inserted may be erased
+		template <typename K>
+		bool erase(const K& key) noexcept {
+			return this->erase_hash(static_cast<ULONG64>(_hasher(key)));
+		}
+
+		template <typename K>
+		bool contains(const K& key) const noexcept {
+			return this->contains_hash(static_cast<ULONG64>(_hasher(key)));
+		}
+
+		bool insert_hash(ULONG64 hash) noexcept;
+		bool erase_hash(ULONG64 hash) noexcept;
+		bool contains_hash(ULONG64 hash) const noexcept;
+
+		size_t size() const noexcept {
+			return _count;
+		}
+
+		size_t size_in_bytes() const noexcept {
+			return (_bucketMask + 1) * sizeof(_bucket);
+		}
+	private:
+		static constexpr int _maxKicks = 500;
+
+		struct _bucket {
+			volatile USHORT slots[4]; // 0 is empty
+		};
+
+		Hash _hasher;
+		size_t _bucketMask;
+		_cache_aligned_buffer _buckets;
+
+		tiny::spin_lock _lock;
+		volatile LONG _sequence; // odd while a writer is moving fingerprints
+		size_t _count;
+
+		// 95% full at most, buckets of four reach that reliably
+		static size_t _bucketsFor(size_t keys, ULONG64 oneIn) noexcept {
+			auto slots = keys * 100 / 95 + 1;
+			if (oneIn > 8192)
+				slots = slots > keys * (oneIn / 8192) ? slots : keys * (oneIn / 8192);
+
+			size_t buckets = 1;
+			while (buckets * 4 < slots)
+				buckets <<= 1;
+
+			return buckets;
+		}
+
+		static USHORT _fingerprint(ULONG64 hash) noexcept {
+			auto fingerprint = static_cast<USHORT>(hash >> 48);
+			return fingerprint ? fingerprint : 1;
+		}
+
+		size_t _index(ULONG64 hash) const noexcept {
+			return static_cast<size_t>(hash) & _bucketMask;
+		}
+
+		// an involution, so either bucket leads to the other
+		size_t _alternate(size_t index, USHORT fingerprint) const noexcept {
+			return (index ^ static_cast<size_t>(hash_mix(fingerprint))) & _bucketMask;
+		}
+
+		_bucket& _at(size_t index) const noexcept {
+			return _buckets.get<_bucket>()[index];
+		}
+
+		static int _kickSlot(ULONG64 hash, int kick) noexcept {
+			return static_cast<int>((hash >> (kick % 16)) & 3);
+		}
+
+		bool _tryPut(size_t index, USHORT fingerprint) noexcept {
+			auto& bucket = this->_at(index);
+			for (auto& slot : bucket.slots)
+			{
+				if (!slot)
+				{
+					slot = fingerprint;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool _matches(size_t first, size_t second, USHORT fingerprint) const noexcept;
+	};
+
+	template <typename Key, typename Hash>
+	inline bool cuckoo_filter<Key, Hash>::insert_hash(ULONG64 hash) noexcept {
+		auto fingerprint = _fingerprint(hash);
+		auto index = this->_index(hash);
+
+		tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+		if (this->_tryPut(index, fingerprint) || this->_tryPut(this->_alternate(index, fingerprint), fingerprint))
+		{
+			++_count;
+			return true;
+		}
+
+		// Evict fingerprints along a chain until one finds room. Readers may see a fingerprint
+		// in neither bucket while it moves, the sequence number sends them around again.
+		InterlockedIncrement(&_sequence);
+
+		auto current = fingerprint;
+		if (hash & (1ull << 40))
+			index = this->_alternate(index, fingerprint);
+
+		for (int kicks = 0; kicks < _maxKicks; ++kicks)
+		{
+			auto& slot = this->_at(index).slots[_kickSlot(hash, kicks)];
+			auto evicted = slot;
+			slot = current;
+			current = evicted;
+
+			index = this->_alternate(index, current);
+			if (this->_tryPut(index, current))
+			{
+				++_count;
+				InterlockedIncrement(&_sequence);
+				return true;
+			}
+		}
+
+		// Too full, walk the chain backwards and put every fingerprint back where it was.
+		// Each step is undone by the same swap, the alternate bucket leads back.
+		for (auto kicks = _maxKicks; kicks--; )
+		{
+			index = this->_alternate(index, current);
+
+			auto& slot = this->_at(index).slots[_kickSlot(hash, kicks)];
+			auto restored = slot;
+			slot = current;
+			current = restored;
+		}
+
+		InterlockedIncrement(&_sequence);
+		return false;
+	}
+
+	template <typename Key, typename Hash>
+	inline bool cuckoo_filter<Key, Hash>::erase_hash(ULONG64 hash) noexcept {
+		auto fingerprint = _fingerprint(hash);
+		auto first = this->_index(hash);
+		size_t indices[2] = { first, this->_alternate(first, fingerprint) };
+
+		tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+		for (auto index : indices)
+		{
+			for (auto& slot : this->_at(index).slots)
+			{
+				if (slot == fingerprint)
+				{
+					slot = 0;
+					--_count;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	template <typename Key, typename Hash>
+	inline bool cuckoo_filter<Key, Hash>::contains_hash(ULONG64 hash) const noexcept {
+		auto fingerprint = _fingerprint(hash);
+		auto first = this->_index(hash);
+		auto second = this->_alternate(first, fingerprint);
+
+		while (true)
+		{
+			auto sequence = _sequence;
+			if (this->_matches(first, second, fingerprint))
+				return true;
+
+			// a miss only counts when no eviction chain ran meanwhile
+			if (!(sequence & 1) && sequence == _sequence)
+				return false;
+
+			YieldProcessor();
+		}
+	}
+
+	template <typename Key, typename Hash>
+	inline bool cuckoo_filter<Key, Hash>::_matches(size_t first, size_t second, USHORT fingerprint) const noexcept {
+#ifdef TINY_SSE2
+		auto both = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->_at(first))),
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->_at(second))));
+		return _mm_movemask_epi8(_mm_cmpeq_epi16(both, _mm_set1_epi16(static_cast<short>(fingerprint)))) != 0;
+#else
+		size_t indices[2] = { first, second };
+		for (auto index : indices)
+		{
+			for (auto slot : this->_at(index).slots)
+			{
+				if (slot == fingerprint)
+					return true;
+			}
+		}
+
+		return false;
+#endif
+	}
+}
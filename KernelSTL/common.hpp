@@ -1,24 +1,48 @@
-#pragma once
-
-#include <ntifs.h>
-
-#define ALLOC_MEMORY(_size) ExAllocatePool2(POOL_FLAG_NON_PAGED, _size, 'YNIT')
-#define FREE_MEMORY(__mem) ExFreePoolWithTag(__mem, 0)
-
-void* __cdecl operator new(size_t Size) noexcept(false);
-void __cdecl operator delete(void* mem);
-
-namespace tiny {
-	template <typename T>
-	inline void global_object_pointer_initialize(T** globalObjectPointer)
-	{
-		*globalObjectPointer = new T();
-	}
-
-	template <typename T>
-	inline void global_object_pointer_destroy(T** globalObjectPointer)
-	{
-		delete *globalObjectPointer;
-		*globalObjectPointer = nullptr;
-	}
+#pragma once
+
+#include <ntifs.h>
+
+#include "simd.hpp"
+
+#define TINY_POOL_TAG 'YNIT'
+#define ALLOC_MEMORY(_size) ExAllocatePool2(POOL_FLAG_NON_PAGED, _size, TINY_POOL_TAG)
+#define FREE_MEMORY(__mem) ExFreePoolWithTag(__mem, 0)
+
+void* __cdecl operator new(size_t Size) noexcept(false);
+void __cdecl operator delete(void* mem);
+
+#ifndef __PLACEMENT_NEW_INLINE
+#define __PLACEMENT_NEW_INLINE
+inline void* __cdecl operator new(size_t, void* where) noexcept {
+	return where;
+}
+
+inline void __cdecl operator delete(void*, void*) noexcept {
+}
+#endif
+
+namespace tiny {
+	// Default allocator of the containers, allocate returns nullptr when the pool is exhausted.
+	struct pool_allocator {
+		void* allocate(size_t size) const noexcept {
+			return ALLOC_MEMORY(size);
+		}
+
+		void deallocate(void* ptr, size_t) const noexcept {
+			FREE_MEMORY(ptr);
+		}
+	};
+
+	template <typename T>
+	inline void global_object_pointer_initialize(T** globalObjectPointer)
+	{
+		*globalObjectPointer = new T();
+	}
+
+	template <typename T>
+	inline void global_object_pointer_destroy(T** globalObjectPointer)
+	{
+		delete *globalObjectPointer;
+		*globalObjectPointer = nullptr;
+	}
 }
\ No newline at end of file
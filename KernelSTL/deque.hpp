@@ -0,0 +1,343 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+
+namespace tiny {
+	// Elements per chunk, a power of two so indexing compiles to shifts and masks.
+	template <typename T, size_t ChunkBytes>
+	constexpr size_t _deque_chunk_size() noexcept {
+		size_t count = ChunkBytes / sizeof(T);
+		if (count < 16)
+			return 16;
+
+		size_t result = 1;
+		while (result * 2 <= count)
+			result *= 2;
+
+		return result;
+	}
+
+	template <typename Deque, typename T>
+	class _deque_iterator {
+	public:
+		_deque_iterator(Deque* owner, size_t index) noexcept
+			: _owner(owner), _index(index) {
+		}
+
+		T& operator*() const noexcept {
+			return (*_owner)[_index];
+		}
+
+		T* operator->() const noexcept {
+			return &(*_owner)[_index];
+		}
+
+		T& operator[](ptrdiff_t offset) const noexcept {
+			return (*_owner)[_index + offset];
+		}
+
+		_deque_iterator& operator++() noexcept {
+			++_index;
+			return *this;
+		}
+
+		_deque_iterator& operator--() noexcept {
+			--_index;
+			return *this;
+		}
+
+		_deque_iterator& operator+=(ptrdiff_t offset) noexcept {
+			_index += offset;
+			return *this;
+		}
+
+		_deque_iterator operator+(ptrdiff_t offset) const noexcept {
+			return _deque_iterator(_owner, _index + offset);
+		}
+
+		_deque_iterator operator-(ptrdiff_t offset) const noexcept {
+			return _deque_iterator(_owner, _index - offset);
+		}
+
+		ptrdiff_t operator-(const _deque_iterator& other) const noexcept {
+			return static_cast<ptrdiff_t>(_index - other._index);
+		}
+
+		bool operator==(const _deque_iterator& other) const noexcept {
+			return _index == other._index;
+		}
+
+		bool operator!=(const _deque_iterator& other) const noexcept {
+			return _index != other._index;
+		}
+
+		bool operator<(const _deque_iterator& other) const noexcept {
+			return _index < other._index;
+		}
+	private:
+		Deque* _owner;
+		size_t _index;
+	};
+
+	/*
+	* Double ended queue built from fixed size chunks and a map of chunk pointers. Growing at
+	* either end allocates one chunk and at most reallocates the map, elements never move, so
+	* references stay valid until the element is popped. Chunks are freed as soon as they empty.
+	*/
+	template <typename T, size_t ChunkBytes = 4096>
+	class deque {
+	public:
+		using value_type = T;
+		using iterator = _deque_iterator<deque, T>;
+		using const_iterator = _deque_iterator<const deque, const T>;
+
+		static constexpr size_t ChunkSize = _deque_chunk_size<T, ChunkBytes>();
+
+		deque() noexcept
+			: _map(nullptr), _mapCapacity(0), _mapBegin(0), _mapEnd(0), _offset(0), _size(0) {
+		}
+
+		deque(const deque& other)
+			: deque() {
+			for (const auto& value : other)
+				this->push_back(value);
+		}
+
+		deque(deque&& other) noexcept
+			: deque() {
+			this->_swap(other);
+		}
+
+		deque& operator=(const deque& other) {
+			if (this != &other)
+			{
+				deque copy(other);
+				this->_swap(copy);
+			}
+
+			return *this;
+		}
+
+		deque& operator=(deque&& other) noexcept {
+			if (this != &other)
+			{
+				this->clear();
+				this->_swap(other);
+			}
+
+			return *this;
+		}
+
+		~deque() {
+			this->clear();
+
+			if (_map)
+				FREE_MEMORY(_map);
+		}
+
+		bool empty() const noexcept {
+			return _size == 0;
+		}
+
+		size_t size() const noexcept {
+			return _size;
+		}
+
+		T& operator[](size_t idx) noexcept {
+			auto position = _offset + idx;
+			return _map[_mapBegin + position / ChunkSize][position % ChunkSize];
+		}
+
+		const T& operator[](size_t idx) const noexcept {
+			auto position = _offset + idx;
+			return _map[_mapBegin + position / ChunkSize][position % ChunkSize];
+		}
+
+		T& front() noexcept {
+			return (*this)[0];
+		}
+
+		const T& front() const noexcept {
+			return (*this)[0];
+		}
+
+		T& back() noexcept {
+			return (*this)[_size - 1];
+		}
+
+		const T& back() const noexcept {
+			return (*this)[_size - 1];
+		}
+
+		iterator begin() noexcept {
+			return iterator(this, 0);
+		}
+
+		iterator end() noexcept {
+			return iterator(this, _size);
+		}
+
+		const_iterator begin() const noexcept {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const noexcept {
+			return const_iterator(this, _size);
+		}
+
+		void push_back(const T& value) {
+			this->emplace_back(value);
+		}
+
+		void push_back(T&& value) {
+			this->emplace_back(tiny::move(value));
+		}
+
+		void push_front(const T& value) {
+			this->emplace_front(value);
+		}
+
+		void push_front(T&& value) {
+			this->emplace_front(tiny::move(value));
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args) {
+			if (_offset + _size == this->_chunkCount() * ChunkSize)
+				this->_addChunk(false);
+
+			auto slot = &(*this)[_size];
+			new (slot) T(tiny::forward<Args>(args)...);
+			++_size;
+
+			return *slot;
+		}
+
+		template <typename... Args>
+		T& emplace_front(Args&&... args) {
+			if (_offset == 0)
+			{
+				this->_addChunk(true);
+				_offset = ChunkSize;
+			}
+
+			auto position = _offset - 1;
+			auto slot = &_map[_mapBegin + position / ChunkSize][position % ChunkSize];
+			new (slot) T(tiny::forward<Args>(args)...);
+
+			_offset = position;
+			++_size;
+
+			return *slot;
+		}
+
+		void pop_back() {
+			this->back().~T();
+			--_size;
+
+			// the last chunk holds no element anymore
+			if ((this->_chunkCount() - 1) * ChunkSize >= _offset + _size)
+				this->_freeChunk(false);
+		}
+
+		void pop_front() {
+			this->front().~T();
+			--_size;
+
+			if (++_offset == ChunkSize)
+			{
+				this->_freeChunk(true);
+				_offset = 0;
+			}
+		}
+
+		void clear() noexcept {
+			for (size_t i = 0; i < _size; ++i)
+				(*this)[i].~T();
+
+			for (auto i = _mapBegin; i < _mapEnd; ++i)
+				FREE_MEMORY(_map[i]);
+
+			_mapBegin = _mapEnd = _mapCapacity / 2;
+			_offset = 0;
+			_size = 0;
+		}
+
+		// chunks plus the chunk map
+		size_t allocated_bytes() const noexcept {
+			return this->_chunkCount() * ChunkSize * sizeof(T) + _mapCapacity * sizeof(T*);
+		}
+	private:
+		T** _map;
+		size_t _mapCapacity;
+		size_t _mapBegin; // used map slots are [_mapBegin, _mapEnd)
+		size_t _mapEnd;
+		size_t _offset; // position of the first element inside the first chunk
+		size_t _size;
+
+		size_t _chunkCount() const noexcept {
+			return _mapEnd - _mapBegin;
+		}
+
+		void _addChunk(bool front) {
+			if (front ? _mapBegin == 0 : _mapEnd == _mapCapacity)
+				this->_growMap();
+
+			auto chunk = static_cast<T*>(ALLOC_MEMORY(ChunkSize * sizeof(T)));
+			if (!chunk)
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+			if (front)
+				_map[--_mapBegin] = chunk;
+			else
+				_map[_mapEnd++] = chunk;
+		}
+
+		void _freeChunk(bool front) noexcept {
+			FREE_MEMORY(front ? _map[_mapBegin++] : _map[--_mapEnd]);
+		}
+
+		// Centers the used chunk pointers in a map with room on both sides, only pointers move.
+		void _growMap() {
+			auto count = this->_chunkCount();
+			auto capacity = _mapCapacity;
+
+			if (count * 2 >= capacity)
+				capacity = capacity ? capacity * 2 : 8;
+
+			auto map = _map;
+			if (capacity != _mapCapacity)
+			{
+				map = static_cast<T**>(ALLOC_MEMORY(capacity * sizeof(T*)));
+				if (!map)
+					ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+			}
+
+			auto begin = (capacity - count) / 2;
+			if (count)
+				memmove(map + begin, _map + _mapBegin, count * sizeof(T*));
+
+			if (map != _map)
+			{
+				if (_map)
+					FREE_MEMORY(_map);
+
+				_map = map;
+				_mapCapacity = capacity;
+			}
+
+			_mapBegin = begin;
+			_mapEnd = begin + count;
+		}
+
+		void _swap(deque& other) noexcept {
+			tiny::swap(_map, other._map);
+			tiny::swap(_mapCapacity, other._mapCapacity);
+			tiny::swap(_mapBegin, other._mapBegin);
+			tiny::swap(_mapEnd, other._mapEnd);
+			tiny::swap(_offset, other._offset);
+			tiny::swap(_size, other._size);
+		}
+	};
+}
@@ -1,23 +1,33 @@
-//
-// Kernel STL containers example
-//
-
-#include "tiny_stl.hpp"
-#include "tests.hpp"
-
-extern "C" void DriverUnload(PDRIVER_OBJECT pDriverObject);
-extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT pDriverObject, PUNICODE_STRING pUniStr)
-{
-	UNREFERENCED_PARAMETER(pUniStr);
-
-	pDriverObject->DriverUnload = DriverUnload;
-
-	tiny::runTests();
-
-	return STATUS_SUCCESS;
-}
-
-extern "C" void DriverUnload(PDRIVER_OBJECT pDriverObject)
-{
-	UNREFERENCED_PARAMETER(pDriverObject);
+//
+// Kernel STL containers example
+//
+
+#include "tiny_stl.hpp"
+#include "tests.hpp"
+#include "benchmarks.hpp"
+
+// The benchmarks hold up the driver load for a long time, build with TINY_RUN_BENCHMARKS=1 to
+// run them after the tests.
+#ifndef TINY_RUN_BENCHMARKS
+#define TINY_RUN_BENCHMARKS 0
+#endif
+
+extern "C" void DriverUnload(PDRIVER_OBJECT pDriverObject);
+extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT pDriverObject, PUNICODE_STRING pUniStr)
+{
+	UNREFERENCED_PARAMETER(pUniStr);
+
+	pDriverObject->DriverUnload = DriverUnload;
+
+	tiny::runTests();
+#if TINY_RUN_BENCHMARKS
+	tiny::runBenchmarks();
+#endif
+
+	return STATUS_SUCCESS;
+}
+
+extern "C" void DriverUnload(PDRIVER_OBJECT pDriverObject)
+{
+	UNREFERENCED_PARAMETER(pDriverObject);
 }
\ No newline at end of file
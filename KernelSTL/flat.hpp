@@ -0,0 +1,210 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "string_view.hpp"
+#include "flat_layout.hpp"
+
+namespace tiny {
+	// Position of an object inside a flat_writer, stays valid when the buffer grows.
+	template <typename T>
+	struct flat_ref {
+		size_t offset;
+	};
+
+	template <typename T>
+	struct flat_array_ref {
+		size_t offset;
+		size_t count;
+	};
+
+	/*
+	* Builds a flat buffer front to back. Objects are placed with create() and write(), refer
+	* to each other through link(), and finish() fills in the header. The buffer either grows
+	* from the pool or is a fixed caller buffer, e.g. a section shared with user mode, that is
+	* written in place. Padding is zeroed so no stale memory leaves the kernel.
+	* Element types have to be trivially copyable and may only refer to others by flat_ptr.
+	*/
+	class flat_writer {
+	public:
+		flat_writer& operator=(const flat_writer&) = delete;
+		flat_writer(const flat_writer&) = delete;
+
+		explicit flat_writer(size_t reserveBytes = 4096)
+			: _data(nullptr), _capacity(0), _size(sizeof(flat_header)), _fixed(false) {
+			this->_grow(reserveBytes > sizeof(flat_header) ? reserveBytes : sizeof(flat_header));
+			memset(_data, 0, sizeof(flat_header));
+		}
+
+		// buffer has to be aligned to 8 bytes, writing past capacity raises STATUS_BUFFER_TOO_SMALL
+		flat_writer(void* buffer, size_t capacity)
+			: _data(static_cast<unsigned char*>(buffer)), _capacity(capacity), _size(sizeof(flat_header)), _fixed(true) {
+			if (capacity < sizeof(flat_header))
+				ExRaiseStatus(STATUS_BUFFER_TOO_SMALL);
+
+			memset(_data, 0, sizeof(flat_header));
+		}
+
+		~flat_writer() {
+			if (!_fixed && _data)
+				FREE_MEMORY(_data);
+		}
+
+		// zero initialized
+		template <typename T>
+		flat_ref<T> create() {
+			return flat_ref<T>{ this->_allocate(sizeof(T), alignof(T)) };
+		}
+
+		template <typename T>
+		flat_array_ref<T> create_array(size_t count) {
+			return flat_array_ref<T>{ this->_allocate(count * sizeof(T), alignof(T)), count };
+		}
+
+		template <typename T>
+		flat_array_ref<T> write(const T* items, size_t count) {
+			auto result = this->create_array<T>(count);
+			if (count)
+				memcpy(_data + result.offset, items, count * sizeof(T));
+
+			return result;
+		}
+
+		template <typename T, typename Allocator>
+		flat_array_ref<T> write(const tiny::vector<T, Allocator>& items) {
+			return this->write(items.data(), items.size());
+		}
+
+		// the terminator is written but not counted
+		template <typename T>
+		flat_array_ref<T> write(basic_string_view<T> text) {
+			auto result = this->create_array<T>(text.size() + 1);
+			if (text.size())
+				memcpy(_data + result.offset, text.data(), text.size() * sizeof(T));
+
+			result.count = text.size();
+			return result;
+		}
+
+		// String is anything with value_type that converts to a string view, e.g. tiny::wstring.
+		template <typename String, typename Allocator>
+		flat_array_ref<flat_string<typename String::value_type>> write_strings(const tiny::vector<String, Allocator>& strings) {
+			using char_type = typename String::value_type;
+
+			auto result = this->create_array<flat_string<char_type>>(strings.size());
+			for (size_t i = 0; i < strings.size(); ++i)
+				this->link(this->element(result, i), this->write(basic_string_view<char_type>(strings[i])));
+
+			return result;
+		}
+
+		template <typename Parent, typename Member>
+		flat_ref<Member> field(flat_ref<Parent> parent, Member Parent::* member) noexcept {
+			auto object = this->get(parent);
+			auto offset = reinterpret_cast<unsigned char*>(&(object->*member)) - reinterpret_cast<unsigned char*>(object);
+
+			return flat_ref<Member>{ parent.offset + offset };
+		}
+
+		template <typename T>
+		flat_ref<T> element(flat_array_ref<T> array, size_t idx) const noexcept {
+			return flat_ref<T>{ array.offset + idx * sizeof(T) };
+		}
+
+		// pointers are invalidated by the next create or write when the buffer grows
+		template <typename T>
+		T* get(flat_ref<T> ref) noexcept {
+			return reinterpret_cast<T*>(_data + ref.offset);
+		}
+
+		template <typename T>
+		T* get(flat_array_ref<T> array) noexcept {
+			return reinterpret_cast<T*>(_data + array.offset);
+		}
+
+		template <typename T>
+		void link(flat_ref<flat_ptr<T>> field, flat_ref<T> target) noexcept {
+			this->get(field)->offset = this->_relative(field.offset, target.offset);
+		}
+
+		template <typename T>
+		void link(flat_ref<flat_vector<T>> field, flat_array_ref<T> items) noexcept {
+			auto vector = this->get(field);
+			vector->items.offset = items.count ? this->_relative(field.offset, items.offset) : 0;
+			vector->count = static_cast<unsigned int>(items.count);
+		}
+
+		template <typename T>
+		void link(flat_ref<flat_string<T>> field, flat_array_ref<T> text) noexcept {
+			auto string = this->get(field);
+			string->text.offset = text.count ? this->_relative(field.offset, text.offset) : 0;
+			string->length = static_cast<unsigned int>(text.count);
+		}
+
+		// Fills in the header, the buffer is complete afterwards.
+		template <typename T>
+		void finish(flat_ref<T> root) noexcept {
+			auto header = reinterpret_cast<flat_header*>(_data);
+			header->magic = flat_magic;
+			header->version = flat_version;
+			header->headerSize = sizeof(flat_header);
+			header->size = static_cast<unsigned int>(_size);
+			header->root = static_cast<unsigned int>(root.offset);
+		}
+
+		const void* data() const noexcept {
+			return _data;
+		}
+
+		size_t size() const noexcept {
+			return _size;
+		}
+	private:
+		unsigned char* _data;
+		size_t _capacity;
+		size_t _size;
+		bool _fixed;
+
+		void _grow(size_t capacity) {
+			auto data = static_cast<unsigned char*>(ALLOC_MEMORY(capacity));
+			if (!data)
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+			if (_data)
+			{
+				memcpy(data, _data, _size);
+				FREE_MEMORY(_data);
+			}
+
+			_data = data;
+			_capacity = capacity;
+		}
+
+		static int _relative(size_t from, size_t to) noexcept {
+			return static_cast<int>(static_cast<LONG_PTR>(to) - static_cast<LONG_PTR>(from));
+		}
+
+		size_t _allocate(size_t size, size_t alignment) {
+			auto offset = (_size + alignment - 1) & ~(alignment - 1);
+			auto end = offset + size;
+
+			// offsets are 32-bit in the layout
+			if (end > MAXLONG)
+				ExRaiseStatus(STATUS_BUFFER_OVERFLOW);
+
+			if (end > _capacity)
+			{
+				if (_fixed)
+					ExRaiseStatus(STATUS_BUFFER_TOO_SMALL);
+
+				this->_grow(end > _capacity * 2 ? end : _capacity * 2);
+			}
+
+			// padding included
+			memset(_data + _size, 0, end - _size);
+			_size = end;
+			return offset;
+		}
+	};
+}
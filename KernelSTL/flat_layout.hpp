@@ -0,0 +1,156 @@
+#pragma once
+
+// Layout of flat buffers and the reader for them. This header has no kernel dependencies,
+// the user-mode side includes it on its own to read what flat_writer produced.
+#include <stddef.h>
+
+namespace tiny {
+	constexpr unsigned int flat_magic = 0x54414C46; // "FLAT"
+	constexpr unsigned short flat_version = 1;
+
+	struct flat_header {
+		unsigned int magic;
+		unsigned short version;
+		unsigned short headerSize;
+		unsigned int size; // whole buffer including the header
+		unsigned int root; // offset of the root object from the start of the buffer
+	};
+
+	// Offset from its own address to the target, 0 is null. Stays valid wherever the buffer is mapped.
+	template <typename T>
+	struct flat_ptr {
+		int offset;
+
+		const T* get() const noexcept {
+			return offset ? reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset) : nullptr;
+		}
+
+		const T* operator->() const noexcept {
+			return this->get();
+		}
+
+		const T& operator*() const noexcept {
+			return *this->get();
+		}
+
+		explicit operator bool() const noexcept {
+			return offset != 0;
+		}
+	};
+
+	template <typename T>
+	struct flat_vector {
+		flat_ptr<T> items;
+		unsigned int count;
+
+		const T* begin() const noexcept {
+			return items.get();
+		}
+
+		const T* end() const noexcept {
+			return items.get() + count;
+		}
+
+		size_t size() const noexcept {
+			return count;
+		}
+
+		bool empty() const noexcept {
+			return count == 0;
+		}
+
+		const T& operator[](size_t idx) const noexcept {
+			return items.get()[idx];
+		}
+	};
+
+	// Characters are followed by a terminator that is not part of the count.
+	template <typename T>
+	struct flat_string {
+		flat_ptr<T> text;
+		unsigned int length;
+
+		const T* data() const noexcept {
+			static const T empty = 0;
+			return length ? text.get() : &empty;
+		}
+
+		size_t size() const noexcept {
+			return length;
+		}
+
+		bool empty() const noexcept {
+			return length == 0;
+		}
+
+		const T& operator[](size_t idx) const noexcept {
+			return text.get()[idx];
+		}
+	};
+
+	/*
+	* Reads a flat buffer in place. valid() checks the header against the buffer, contains()
+	* checks that what a flat_ptr, flat_vector or flat_string points at lies inside of it, which
+	* is what a reader of a buffer it does not trust has to do before each access.
+	*/
+	class flat_reader {
+	public:
+		flat_reader(const void* data, size_t size) noexcept
+			: _data(static_cast<const char*>(data)), _size(size) {
+		}
+
+		bool valid() const noexcept {
+			if (!_data || _size < sizeof(flat_header) || reinterpret_cast<size_t>(_data) % alignof(flat_header))
+				return false;
+
+			auto header = this->header();
+			return header->magic == flat_magic && header->version == flat_version && header->headerSize == sizeof(flat_header)
+				&& header->size <= _size && header->root >= sizeof(flat_header) && header->root < header->size;
+		}
+
+		const flat_header* header() const noexcept {
+			return reinterpret_cast<const flat_header*>(_data);
+		}
+
+		// nullptr when the buffer is not valid or the root does not fit
+		template <typename T>
+		const T* root() const noexcept {
+			if (!this->valid())
+				return nullptr;
+
+			auto result = reinterpret_cast<const T*>(_data + this->header()->root);
+			return this->contains(result, 1) ? result : nullptr;
+		}
+
+		template <typename T>
+		bool contains(const T* items, size_t count) const noexcept {
+			auto first = reinterpret_cast<const char*>(items);
+			auto end = _data + this->header()->size;
+
+			return first >= _data + sizeof(flat_header) && first <= end && reinterpret_cast<size_t>(first) % alignof(T) == 0
+				&& count <= static_cast<size_t>(end - first) / sizeof(T);
+		}
+
+		template <typename T>
+		bool contains(const flat_ptr<T>& ptr) const noexcept {
+			return ptr && this->contains(ptr.get(), 1);
+		}
+
+		template <typename T>
+		bool contains(const flat_vector<T>& vector) const noexcept {
+			return !vector.count || (vector.items && this->contains(vector.items.get(), vector.count));
+		}
+
+		// includes the terminator
+		template <typename T>
+		bool contains(const flat_string<T>& string) const noexcept {
+			if (!string.length)
+				return true;
+
+			return string.text && this->contains(string.text.get(), string.length + 1) && string.text.get()[string.length] == 0;
+		}
+	private:
+		const char* _data;
+		size_t _size;
+	};
+}
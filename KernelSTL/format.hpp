@@ -0,0 +1,270 @@
+#pragma once
+
+#include "common.hpp"
+#include "string.hpp"
+
+namespace tiny {
+	// Hexadecimal formatting for integers, '{x}' placeholder does the same.
+	struct hex {
+		explicit hex(unsigned long long v) : value(v) {
+		}
+
+		unsigned long long value;
+	};
+
+	// Writes into a caller provided buffer, output beyond the capacity is counted but dropped.
+	template <typename T>
+	class _format_writer {
+	public:
+		_format_writer(T* buffer, size_t capacity) noexcept
+			: _buffer(buffer), _capacity(capacity), _written(0) {
+		}
+
+		void put(T c) noexcept {
+			if (_written < _capacity)
+				_buffer[_written] = c;
+
+			++_written;
+		}
+
+		template <typename U>
+		void put(const U* str, size_t count) noexcept {
+			if (_written < _capacity)
+			{
+				auto available = _capacity - _written;
+				auto toCopy = count < available ? count : available;
+
+				for (size_t i = 0; i < toCopy; ++i)
+					_buffer[_written + i] = static_cast<T>(str[i]);
+			}
+
+			_written += count;
+		}
+
+		void putUnsigned(unsigned long long value, unsigned base) noexcept {
+			char digits[24];
+			size_t count = 0;
+
+			do {
+				digits[count++] = "0123456789abcdef"[value % base];
+				value /= base;
+			} while (value);
+
+			while (count)
+				this->put(static_cast<T>(digits[--count]));
+		}
+
+		void putSigned(long long value) noexcept {
+			if (value < 0)
+			{
+				this->put(static_cast<T>('-'));
+				this->putUnsigned(0ull - static_cast<unsigned long long>(value), 10);
+				return;
+			}
+
+			this->putUnsigned(static_cast<unsigned long long>(value), 10);
+		}
+
+		size_t written() const noexcept {
+			return _written;
+		}
+
+		// terminates the output, truncating it when the buffer is full
+		void finish() noexcept {
+			if (!_capacity)
+				return;
+
+			_buffer[_written < _capacity ? _written : _capacity - 1] = 0;
+		}
+	private:
+		T* _buffer;
+		size_t _capacity;
+		size_t _written;
+	};
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, long long value) {
+		if (asHex)
+			return out.putUnsigned(static_cast<unsigned long long>(value), 16);
+
+		out.putSigned(value);
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, unsigned long long value) {
+		out.putUnsigned(value, asHex ? 16 : 10);
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, int value) {
+		_format_arg(out, asHex, static_cast<long long>(value));
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, long value) {
+		_format_arg(out, asHex, static_cast<long long>(value));
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, unsigned int value) {
+		_format_arg(out, asHex, static_cast<unsigned long long>(value));
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, unsigned long value) {
+		_format_arg(out, asHex, static_cast<unsigned long long>(value));
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool asHex, unsigned short value) {
+		_format_arg(out, asHex, static_cast<unsigned long long>(value));
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, hex value) {
+		out.putUnsigned(value.value, 16);
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, bool value) {
+		if (value)
+			return out.put("true", 4);
+
+		out.put("false", 5);
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, T value) {
+		out.put(value);
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, const void* value) {
+		out.put("0x", 2);
+		out.putUnsigned(reinterpret_cast<ULONG_PTR>(value), 16);
+	}
+
+	// narrow text is widened as is, it is expected to be ASCII
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, const char* value) {
+		string_view view(value);
+		out.put(view.data(), view.size());
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, string_view value) {
+		out.put(value.data(), value.size());
+	}
+
+	inline void _format_arg(_format_writer<wchar_t>& out, bool, const wchar_t* value) {
+		wstring_view view(value);
+		out.put(view.data(), view.size());
+	}
+
+	inline void _format_arg(_format_writer<wchar_t>& out, bool, wstring_view value) {
+		out.put(value.data(), value.size());
+	}
+
+	inline void _format_arg(_format_writer<wchar_t>& out, bool, const wstring& value) {
+		out.put(value.data(), value.size());
+	}
+
+	template <typename T>
+	inline void _format_arg(_format_writer<T>& out, bool, const string& value) {
+		out.put(value.data(), value.size());
+	}
+
+	// Copies literal text up to the next placeholder, returns pointer past it or nullptr at the end.
+	template <typename T>
+	inline const T* _format_literal(_format_writer<T>& out, const T* fmt, bool& asHex) {
+		while (*fmt)
+		{
+			if (fmt[0] == '{' && fmt[1] == '{')
+			{
+				out.put(static_cast<T>('{'));
+				fmt += 2;
+				continue;
+			}
+
+			if (fmt[0] == '}' && fmt[1] == '}')
+			{
+				out.put(static_cast<T>('}'));
+				fmt += 2;
+				continue;
+			}
+
+			if (fmt[0] == '{' && fmt[1] == '}')
+			{
+				asHex = false;
+				return fmt + 2;
+			}
+
+			if (fmt[0] == '{' && fmt[1] == 'x' && fmt[2] == '}')
+			{
+				asHex = true;
+				return fmt + 3;
+			}
+
+			out.put(*fmt++);
+		}
+
+		return nullptr;
+	}
+
+	template <typename T>
+	inline void _format_next(_format_writer<T>& out, const T* fmt) {
+		bool asHex;
+		while (fmt)
+			fmt = _format_literal(out, fmt, asHex); // placeholders without arguments print nothing
+	}
+
+	template <typename T, typename Arg, typename... Args>
+	inline void _format_next(_format_writer<T>& out, const T* fmt, const Arg& arg, const Args&... args) {
+		bool asHex = false;
+		fmt = _format_literal(out, fmt, asHex);
+		if (!fmt)
+			return;
+
+		_format_arg(out, asHex, arg);
+		_format_next(out, fmt, args...);
+	}
+
+	/*
+	* Formats into a preallocated buffer without allocating, '{}' is replaced by the next argument
+	* and '{x}' prints integers in hexadecimal. Output is always null terminated and truncated when
+	* the buffer is too small. Returns the length the full output needs, excluding terminator,
+	* so `result >= capacity` means it was truncated.
+	*/
+	template <typename T, typename... Args>
+	inline size_t format_to(T* buffer, size_t capacity, const T* fmt, const Args&... args) {
+		_format_writer<T> out(buffer, capacity);
+		_format_next(out, fmt, args...);
+		out.finish();
+
+		return out.written();
+	}
+
+	template <typename T, size_t N, typename... Args>
+	inline size_t format_to(T (&buffer)[N], const T* fmt, const Args&... args) {
+		return tiny::format_to(buffer, N, fmt, args...);
+	}
+
+	// Appends to the string, reallocating at most once.
+	template <typename T, typename... Args>
+	inline size_t format_to(basic_string<T>& str, const T* fmt, const Args&... args) {
+		auto oldSize = str.size();
+		auto available = str.capacity() - oldSize;
+
+		str.resize(oldSize + available);
+		auto length = tiny::format_to(str.begin() + oldSize, available + 1, fmt, args...);
+
+		if (length > available)
+		{
+			str.resize(oldSize + length);
+			tiny::format_to(str.begin() + oldSize, length + 1, fmt, args...);
+		}
+
+		str.resize(oldSize + length);
+		return length;
+	}
+}
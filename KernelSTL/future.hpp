@@ -0,0 +1,425 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "mutex.hpp"
+#include "work_queue.hpp"
+
+namespace tiny {
+	template <typename T>
+	class future;
+
+	template <typename T>
+	class promise;
+
+	template <typename T>
+	class future_slab;
+
+	template <typename T>
+	struct _future_value {
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T& get() noexcept {
+			return *reinterpret_cast<T*>(storage);
+		}
+
+		template <typename... Args>
+		void construct(Args&&... args) {
+			new (storage) T(tiny::forward<Args>(args)...);
+		}
+
+		void destroy() noexcept {
+			this->get().~T();
+		}
+	};
+
+	template <>
+	struct _future_value<void> {
+		void construct() noexcept {
+		}
+
+		void destroy() noexcept {
+		}
+	};
+
+	/*
+	* State shared by one promise and its future. It is reference counted so whichever side is
+	* released last frees it, either to the pool or back to the future_slab it came from.
+	* A single continuation is stored inline, attaching it never allocates.
+	*/
+	template <typename T>
+	class _future_state {
+	public:
+		static const size_t ContinuationSize = 64;
+
+		_future_state& operator=(const _future_state&) = delete;
+		_future_state(const _future_state&) = delete;
+
+		explicit _future_state(PLOOKASIDE_LIST_EX lookaside) noexcept
+			: _uses(2), _status(STATUS_PENDING), _ready(false), _hasValue(false), _invoke(nullptr), _lookaside(lookaside) {
+			KeInitializeEvent(&_event, NotificationEvent, FALSE);
+		}
+
+		static _future_state* create(PLOOKASIDE_LIST_EX lookaside) {
+			void* memory = lookaside ? ExAllocateFromLookasideListEx(lookaside) : ALLOC_MEMORY(sizeof(_future_state));
+			if (!memory)
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+			return new (memory) _future_state(lookaside);
+		}
+
+		void incref() noexcept {
+			InterlockedIncrement(&_uses);
+		}
+
+		void decref() {
+			if (InterlockedDecrement(&_uses) != 0)
+				return;
+
+			auto lookaside = _lookaside;
+			this->~_future_state();
+
+			if (lookaside)
+				ExFreeToLookasideListEx(lookaside, this);
+			else
+				FREE_MEMORY(this);
+		}
+
+		bool ready() const noexcept {
+			return _ready;
+		}
+
+		NTSTATUS status() const noexcept {
+			return _status;
+		}
+
+		_future_value<T>& value() noexcept {
+			return _value;
+		}
+
+		template <typename... Args>
+		bool succeed(Args&&... args) {
+			if (!this->_claim(STATUS_SUCCESS))
+				return false;
+
+			_value.construct(tiny::forward<Args>(args)...);
+			_hasValue = true;
+			this->_finish();
+
+			return true;
+		}
+
+		bool fail(NTSTATUS status) {
+			if (!this->_claim(status))
+				return false;
+
+			this->_finish();
+			return true;
+		}
+
+		NTSTATUS wait(PLARGE_INTEGER timeout) {
+			if (_ready)
+				return STATUS_SUCCESS;
+
+			return KeWaitForSingleObject(&_event, Executive, KernelMode, FALSE, timeout);
+		}
+
+		// runs the continuation right away when the state is already complete
+		template <typename F>
+		void set_continuation(F&& callable) {
+			using Callable = remove_cv_t<remove_reference_t<F>>;
+			static_assert(sizeof(Callable) <= ContinuationSize, "continuation does not fit into the future state");
+			static_assert(alignof(Callable) <= 16, "continuation is over-aligned");
+
+			new (_continuation) Callable(tiny::forward<F>(callable));
+
+			bool alreadyReady;
+			{
+				tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+				_invoke = [](void* storage, _future_state* state) {
+					auto& continuation = *static_cast<Callable*>(storage);
+					future<T> keepAlive(state); // the continuation itself lives in the state
+
+					state->incref();
+					continuation(future<T>(state));
+					continuation.~Callable();
+				};
+				alreadyReady = _ready;
+			}
+
+			if (alreadyReady)
+				this->_runContinuation();
+		}
+	private:
+		volatile LONG _uses;
+		KEVENT _event;
+		tiny::spin_lock _lock;
+		NTSTATUS _status;
+		volatile bool _ready;
+		bool _hasValue;
+		_future_value<T> _value;
+
+		alignas(16) unsigned char _continuation[ContinuationSize];
+		void (*_invoke)(void* storage, _future_state* state);
+		PLOOKASIDE_LIST_EX _lookaside;
+
+		~_future_state() {
+			if (_hasValue)
+				_value.destroy();
+		}
+
+		// only the first completion wins
+		bool _claim(NTSTATUS status) {
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+			if (_status != STATUS_PENDING)
+				return false;
+
+			_status = status;
+			return true;
+		}
+
+		void _finish() {
+			bool runContinuation;
+			{
+				tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+				_ready = true;
+				runContinuation = _invoke != nullptr;
+			}
+
+			KeSetEvent(&_event, 0, FALSE);
+
+			if (runContinuation)
+				this->_runContinuation();
+		}
+
+		void _runContinuation() {
+			this->incref(); // released by the continuation invoker
+			_invoke(_continuation, this);
+		}
+	};
+
+	// Lookaside backed slab for future states, has to outlive all promises created from it.
+	template <typename T>
+	class future_slab {
+	public:
+		future_slab& operator=(const future_slab&) = delete;
+		future_slab(const future_slab&) = delete;
+
+		future_slab() {
+			auto status = ExInitializeLookasideListEx(&_lookaside, nullptr, nullptr, NonPagedPoolNx, 0,
+				sizeof(_future_state<T>), TINY_POOL_TAG, 0);
+			if (!NT_SUCCESS(status))
+				ExRaiseStatus(status);
+		}
+
+		~future_slab() {
+			ExDeleteLookasideListEx(&_lookaside);
+		}
+	private:
+		friend class promise<T>;
+
+		LOOKASIDE_LIST_EX _lookaside;
+	};
+
+	template <typename T>
+	class future {
+	public:
+		future& operator=(const future&) = delete;
+		future(const future&) = delete;
+
+		future() noexcept
+			: _state(nullptr) {
+		}
+
+		future(future&& other) noexcept
+			: _state(tiny::exchange(other._state, nullptr)) {
+		}
+
+		future& operator=(future&& other) noexcept {
+			if (this != &other)
+			{
+				this->_release();
+				_state = tiny::exchange(other._state, nullptr);
+			}
+
+			return *this;
+		}
+
+		~future() {
+			this->_release();
+		}
+
+		bool valid() const noexcept {
+			return _state != nullptr;
+		}
+
+		bool ready() const noexcept {
+			return _state->ready();
+		}
+
+		void wait() const {
+			_state->wait(nullptr);
+		}
+
+		// false when the timeout elapsed first
+		bool wait_for(ULONG milliseconds) const {
+			LARGE_INTEGER timeout;
+			timeout.QuadPart = -static_cast<LONGLONG>(milliseconds) * 10000;
+
+			return _state->wait(&timeout) != STATUS_TIMEOUT;
+		}
+
+		// waits for completion, STATUS_CANCELLED when the promise was dropped without a result
+		NTSTATUS status() const {
+			this->wait();
+			return _state->status();
+		}
+
+		// waits for completion, raises the failure status when there is no value
+		template <typename U = T, typename = enable_if_t<!is_same_v<U, void>>>
+		U& get() const {
+			auto status = this->status();
+			if (!NT_SUCCESS(status))
+				ExRaiseStatus(status);
+
+			return _state->value().get();
+		}
+
+		/*
+		* Attaches the single continuation of this future, it receives the completed future<T>.
+		* The continuation runs inline on the thread completing the promise, possibly at
+		* DISPATCH_LEVEL, or right away when the future is already complete.
+		*/
+		template <typename F>
+		void then(F&& callable) {
+			_state->set_continuation(tiny::forward<F>(callable));
+		}
+
+		// Runs the continuation on the queue, inline when the queue is full.
+		template <size_t InlineSize, size_t BatchSize, typename F>
+		void then(work_queue<InlineSize, BatchSize>& queue, F&& callable) {
+			using Callable = remove_cv_t<remove_reference_t<F>>;
+
+			_state->set_continuation([&queue, continuation = Callable(tiny::forward<F>(callable))](future<T>&& completed) mutable {
+				auto posted = [completed = tiny::move(completed), continuation = tiny::move(continuation)]() mutable {
+					continuation(tiny::move(completed));
+				};
+
+				if (queue.try_submit(tiny::move(posted)) == work_queue_result::full)
+					posted();
+			});
+		}
+	private:
+		friend class _future_state<T>;
+		friend class promise<T>;
+
+		_future_state<T>* _state;
+
+		explicit future(_future_state<T>* state) noexcept
+			: _state(state) {
+		}
+
+		void _release() {
+			if (_state)
+				tiny::exchange(_state, nullptr)->decref();
+		}
+	};
+
+	template <typename T>
+	class promise {
+	public:
+		promise& operator=(const promise&) = delete;
+		promise(const promise&) = delete;
+
+		promise()
+			: _state(_future_state<T>::create(nullptr)), _futureTaken(false) {
+		}
+
+		explicit promise(future_slab<T>& slab)
+			: _state(_future_state<T>::create(&slab._lookaside)), _futureTaken(false) {
+		}
+
+		promise(promise&& other) noexcept
+			: _state(tiny::exchange(other._state, nullptr)), _futureTaken(other._futureTaken) {
+		}
+
+		// an unfulfilled promise completes its future with STATUS_CANCELLED
+		~promise() {
+			if (!_state)
+				return;
+
+			_state->fail(STATUS_CANCELLED);
+			if (!_futureTaken)
+				_state->decref();
+
+			_state->decref();
+		}
+
+		// can be called once
+		future<T> get_future() {
+			_futureTaken = true;
+			return future<T>(_state);
+		}
+
+		// usable up to DISPATCH_LEVEL, returns false when the promise was already fulfilled
+		template <typename... Args>
+		bool set_value(Args&&... args) {
+			return _state->succeed(tiny::forward<Args>(args)...);
+		}
+
+		bool set_status(NTSTATUS status) {
+			return _state->fail(NT_SUCCESS(status) ? STATUS_UNSUCCESSFUL : status);
+		}
+	private:
+		_future_state<T>* _state;
+		bool _futureTaken;
+	};
+
+	/*
+	* Completes once every future in the vector is complete, the status is the first failure
+	* or STATUS_SUCCESS. Takes the continuation slot of each future, so they can still be
+	* waited on and read, but not chained any further.
+	*/
+	template <typename T, typename Allocator>
+	inline future<void> when_all(tiny::vector<future<T>, Allocator>& futures) {
+		struct join_state {
+			promise<void> done;
+			volatile LONG pending;
+			volatile LONG failure;
+
+			static void arrive(join_state* join) {
+				if (InterlockedDecrement(&join->pending) != 0)
+					return;
+
+				if (NT_SUCCESS(join->failure))
+					join->done.set_value();
+				else
+					join->done.set_status(join->failure);
+
+				delete join;
+			}
+		};
+
+		auto join = new join_state();
+		auto result = join->done.get_future();
+
+		// the extra count keeps the join open until every continuation is attached
+		join->pending = static_cast<LONG>(futures.size()) + 1;
+		join->failure = STATUS_SUCCESS;
+
+		for (auto& item : futures)
+		{
+			item.then([join](future<T>&& completed) {
+				auto status = completed.status();
+				if (!NT_SUCCESS(status))
+					InterlockedCompareExchange(&join->failure, status, STATUS_SUCCESS);
+
+				join_state::arrive(join);
+			});
+		}
+
+		join_state::arrive(join);
+		return result;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "string_view.hpp"
+#include "string.hpp"
+#include "hash_bytes.hpp"
+
+namespace tiny {
+	inline char _hash_upcase(char c) noexcept {
+		return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+	}
+
+	inline wchar_t _hash_upcase(wchar_t c) noexcept {
+		return RtlUpcaseUnicodeChar(c);
+	}
+
+	// Produces the words an upcased copy of the text would contain, offsets are whole characters.
+	template <typename T>
+	struct _hash_upcase_reader {
+		const T* data;
+
+		ULONG64 load(size_t offset, size_t count) const noexcept {
+			ULONG64 value = 0;
+			auto first = data + offset / sizeof(T);
+
+			for (size_t i = 0; i < count / sizeof(T); ++i)
+			{
+				auto c = static_cast<ULONG64>(_hash_upcase(first[i])) & ((1ull << (sizeof(T) * 8)) - 1);
+				value |= c << (i * sizeof(T) * 8);
+			}
+
+			return value;
+		}
+
+		ULONG64 load8(size_t offset) const noexcept {
+			return this->load(offset, 8);
+		}
+	};
+
+	// Same value hash_bytes gives for the upcased text, without making the copy.
+	// wchar_t is upcased with RtlUpcaseUnicodeChar, char as ASCII only.
+	template <typename T>
+	inline ULONG64 hash_upcase(const T* text, size_t count, ULONG64 seed = 0) noexcept {
+		_hash_upcase_reader<T> in = { text };
+		return _hash_read<_hash_scalar_lanes<_hash_upcase_reader<T>>>(in, count * sizeof(T), seed);
+	}
+
+	//
+	// hash functors
+	//
+
+	template <typename T, typename = void>
+	struct hash;
+
+	template <typename T>
+	struct hash<T, enable_if_t<is_integral_v<T>>> {
+		constexpr size_t operator()(T value) const noexcept {
+			return static_cast<size_t>(hash_mix(static_cast<ULONG64>(value)));
+		}
+	};
+
+	template <typename T>
+	struct hash<T*> {
+		size_t operator()(const T* value) const noexcept {
+			return static_cast<size_t>(hash_mix(reinterpret_cast<ULONG_PTR>(value)));
+		}
+	};
+
+	template <typename T>
+	struct hash<basic_string_view<T>> {
+		size_t operator()(basic_string_view<T> value) const noexcept {
+			return static_cast<size_t>(hash_bytes(value.data(), value.size() * sizeof(T)));
+		}
+	};
+
+	// strings hash through their view, so a string and a view with equal text hash the same
+	template <>
+	struct hash<string> : hash<string_view> {
+	};
+
+	template <>
+	struct hash<wstring> : hash<wstring_view> {
+	};
+
+	template <typename T>
+	struct case_insensitive_hash;
+
+	template <typename T>
+	struct case_insensitive_hash<basic_string_view<T>> {
+		size_t operator()(basic_string_view<T> value) const noexcept {
+			return static_cast<size_t>(hash_upcase(value.data(), value.size()));
+		}
+	};
+
+	template <>
+	struct case_insensitive_hash<string> : case_insensitive_hash<string_view> {
+	};
+
+	template <>
+	struct case_insensitive_hash<wstring> : case_insensitive_hash<wstring_view> {
+	};
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+// hash_bytes and hash_mix. This header has no kernel dependencies, hash.hpp adds the functors
+// and case-insensitive hashing on top and host tools include it on its own.
+#include <stddef.h>
+#include <string.h>
+#include "simd.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_AMD64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+namespace tiny {
+	inline constexpr unsigned long long _hash_p0 = 0xa0761d6478bd642full;
+	inline constexpr unsigned long long _hash_p1 = 0xe7037ed1a0b428dbull;
+	inline constexpr unsigned long long _hash_p2 = 0x8ebc6af09c88c6e3ull;
+	inline constexpr unsigned long long _hash_p3 = 0x589965cc75374cc3ull;
+
+	// Per-lane keys for the long input loop, stripe n of a block uses the keys starting at n.
+	struct _hash_key_table {
+		unsigned long long values[24];
+
+		constexpr _hash_key_table()
+			: values() {
+			unsigned long long state = _hash_p0;
+			for (auto& value : values)
+			{
+				state += 0x9e3779b97f4a7c15ull;
+				auto mixed = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ull;
+				mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+				value = mixed ^ (mixed >> 31);
+			}
+		}
+	};
+
+	inline constexpr _hash_key_table _hash_keys;
+
+	// full 128-bit product, low half in a and high half in b
+	inline void _hash_mul128(unsigned long long& a, unsigned long long& b) noexcept {
+#if defined(_M_AMD64)
+		a = _umul128(a, b, &b);
+#elif defined(_M_ARM64)
+		auto low = a * b;
+		b = __umulh(a, b);
+		a = low;
+#elif defined(__SIZEOF_INT128__)
+		auto product = static_cast<unsigned __int128>(a) * b;
+		a = static_cast<unsigned long long>(product);
+		b = static_cast<unsigned long long>(product >> 64);
+#else
+		auto ha = a >> 32, hb = b >> 32, la = a & 0xffffffff, lb = b & 0xffffffff;
+		auto high = ha * hb, middle0 = ha * lb, middle1 = hb * la, low = la * lb;
+		auto t = low + (middle0 << 32);
+		auto carry = static_cast<unsigned long long>(t < low);
+		low = t + (middle1 << 32);
+		carry += low < t;
+		a = low;
+		b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+	}
+
+	inline unsigned long long _hash_mum(unsigned long long a, unsigned long long b) noexcept {
+		_hash_mul128(a, b);
+		return a ^ b;
+	}
+
+	// Loads little-endian words straight from memory.
+	struct _hash_bytes_reader {
+		const unsigned char* data;
+
+		unsigned long long load8(size_t offset) const noexcept {
+			unsigned long long value;
+			memcpy(&value, data + offset, sizeof(value));
+			return value;
+		}
+
+		unsigned long long load(size_t offset, size_t count) const noexcept {
+			unsigned long long value = 0;
+			memcpy(&value, data + offset, count);
+			return value;
+		}
+	};
+
+	/*
+	* Long inputs run eight independent 64-bit lanes over 64 byte stripes, each lane adds the
+	* 32x32 bit product of its keyed halves plus the neighbouring lane's input. Every 16 stripes
+	* the lanes get scrambled. The SSE2 version computes exactly the same values.
+	*/
+	template <typename Reader>
+	struct _hash_scalar_lanes {
+		static void accumulate(unsigned long long* acc, const Reader& in, size_t offset, size_t stripes, const unsigned long long* keys) noexcept {
+			for (size_t stripe = 0; stripe < stripes; ++stripe)
+			{
+				for (size_t lane = 0; lane < 8; ++lane)
+				{
+					auto data = in.load8(offset + stripe * 64 + lane * 8);
+					auto keyed = data ^ keys[stripe + lane];
+
+					acc[lane ^ 1] += data;
+					acc[lane] += (keyed & 0xffffffff) * (keyed >> 32);
+				}
+			}
+		}
+
+		static void scramble(unsigned long long* acc, const unsigned long long* keys) noexcept {
+			for (size_t lane = 0; lane < 8; ++lane)
+				acc[lane] = (acc[lane] ^ (acc[lane] >> 47) ^ keys[lane]) * 0x9e3779b1ull;
+		}
+	};
+
+#ifdef TINY_SSE2
+	struct _hash_sse2_lanes {
+		static void accumulate(unsigned long long* acc, const _hash_bytes_reader& in, size_t offset, size_t stripes, const unsigned long long* keys) noexcept {
+			__m128i lanes[4];
+			for (int i = 0; i < 4; ++i)
+				lanes[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(acc) + i);
+
+			auto input = in.data + offset;
+			for (size_t stripe = 0; stripe < stripes; ++stripe, input += 64)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+					auto key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + stripe) + i);
+					auto keyed = _mm_xor_si128(data, key);
+
+					auto product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+					auto swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+					lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, swapped));
+				}
+			}
+
+			for (int i = 0; i < 4; ++i)
+				_mm_store_si128(reinterpret_cast<__m128i*>(acc) + i, lanes[i]);
+		}
+
+		static void scramble(unsigned long long* acc, const unsigned long long* keys) noexcept {
+			auto prime = _mm_set1_epi32(static_cast<int>(0x9e3779b1u));
+
+			for (int i = 0; i < 4; ++i)
+			{
+				auto lane = _mm_load_si128(reinterpret_cast<const __m128i*>(acc) + i);
+				auto key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys) + i);
+				lane = _mm_xor_si128(_mm_xor_si128(lane, _mm_srli_epi64(lane, 47)), key);
+
+				// 64x32 bit multiply out of two 32x32 bit halves
+				auto low = _mm_mul_epu32(lane, prime);
+				auto high = _mm_mul_epu32(_mm_srli_epi64(lane, 32), prime);
+				_mm_store_si128(reinterpret_cast<__m128i*>(acc) + i, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+			}
+		}
+	};
+#endif
+
+	inline unsigned long long _hash_final(unsigned long long a, unsigned long long b, unsigned long long seed, size_t size) noexcept {
+		a ^= _hash_p1;
+		b ^= seed;
+		_hash_mul128(a, b);
+
+		return _hash_mum(a ^ _hash_p0 ^ size, b ^ _hash_p1);
+	}
+
+	template <typename Reader>
+	inline unsigned long long _hash_medium(const Reader& in, size_t size, unsigned long long seed) noexcept {
+		size_t offset = 0;
+		auto remaining = size;
+
+		if (remaining > 32)
+		{
+			auto second = seed;
+			for (; remaining > 32; offset += 32, remaining -= 32)
+			{
+				seed = _hash_mum(in.load8(offset) ^ _hash_p1, in.load8(offset + 8) ^ seed);
+				second = _hash_mum(in.load8(offset + 16) ^ _hash_p2, in.load8(offset + 24) ^ second);
+			}
+
+			seed ^= second;
+		}
+
+		if (remaining > 16)
+		{
+			seed = _hash_mum(in.load8(offset) ^ _hash_p1, in.load8(offset + 8) ^ seed);
+			offset += 16;
+			remaining -= 16;
+		}
+
+		// the last 16 bytes may overlap already hashed ones
+		return _hash_final(in.load8(offset + remaining - 16), in.load8(offset + remaining - 8), seed, size);
+	}
+
+	template <typename Lanes, typename Reader>
+	inline unsigned long long _hash_long(const Reader& in, size_t size, unsigned long long seed) noexcept {
+		const size_t stripesPerBlock = 16;
+		auto keys = _hash_keys.values;
+
+		alignas(16) unsigned long long acc[8] = {
+			_hash_p0 + seed, _hash_p1 - seed, _hash_p2 + seed, _hash_p3 - seed,
+			(_hash_p0 ^ _hash_p1) + seed, (_hash_p1 ^ _hash_p2) - seed, (_hash_p2 ^ _hash_p3) + seed, (_hash_p3 ^ _hash_p0) - seed
+		};
+
+		// the last stripe is always hashed separately, possibly overlapping the previous one
+		auto stripes = (size - 1) / 64;
+		size_t offset = 0;
+
+		for (; stripes >= stripesPerBlock; stripes -= stripesPerBlock, offset += stripesPerBlock * 64)
+		{
+			Lanes::accumulate(acc, in, offset, stripesPerBlock, keys);
+			Lanes::scramble(acc, keys + 16);
+		}
+
+		Lanes::accumulate(acc, in, offset, stripes, keys);
+		Lanes::accumulate(acc, in, size - 64, 1, keys + 11);
+
+		auto result = size * _hash_p0;
+		for (size_t i = 0; i < 8; i += 2)
+			result += _hash_mum(acc[i] ^ keys[16 + i], acc[i + 1] ^ keys[17 + i]);
+
+		return _hash_mum(result ^ _hash_p1, seed ^ _hash_p2);
+	}
+
+	template <typename Lanes, typename Reader>
+	inline unsigned long long _hash_read(const Reader& in, size_t size, unsigned long long seed) noexcept {
+		seed ^= _hash_mum(seed ^ _hash_p0, _hash_p1);
+
+		if (size <= 16)
+		{
+			if (size > 8)
+				return _hash_final(in.load8(0), in.load8(size - 8), seed, size);
+
+			return _hash_final(size ? in.load(0, size) : 0, 0, seed, size);
+		}
+
+		if (size <= 256)
+			return _hash_medium(in, size, seed);
+
+		return _hash_long<Lanes>(in, size, seed);
+	}
+
+	/*
+	* 64-bit hash of arbitrary bytes in the spirit of wyhash, inputs over 256 bytes go through
+	* eight parallel lanes (SSE2 on x64). The value is stable for a given build and seed only,
+	* never persist it.
+	*/
+	inline unsigned long long hash_bytes(const void* data, size_t size, unsigned long long seed = 0) noexcept {
+		_hash_bytes_reader in = { static_cast<const unsigned char*>(data) };
+
+#ifdef TINY_SSE2
+		return _hash_read<_hash_sse2_lanes>(in, size, seed);
+#else
+		return _hash_read<_hash_scalar_lanes<_hash_bytes_reader>>(in, size, seed);
+#endif
+	}
+
+	// Bijective integer mixer, every input bit affects every output bit.
+	inline constexpr unsigned long long hash_mix(unsigned long long value) noexcept {
+		value ^= value >> 32;
+		value *= 0xd6e8feb86659fd93ull;
+		value ^= value >> 32;
+		value *= 0xd6e8feb86659fd93ull;
+		value ^= value >> 32;
+
+		return value;
+	}
+}
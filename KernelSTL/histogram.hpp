@@ -0,0 +1,298 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "bitset.hpp"
+#include "stopwatch.hpp"
+
+namespace tiny {
+	struct histogram_summary {
+		ULONG64 count;
+		ULONG64 mean;
+		ULONG64 p50;
+		ULONG64 p99;
+		ULONG64 p999;
+		ULONG64 max;
+	};
+
+	// Log-linear buckets: values below 16 exactly, above that 16 buckets per power of two,
+	// so a reported value is at most 1/16 above the recorded one. Values from 2^40 on share
+	// the last bucket, max still reports them exactly.
+	struct _histogram_layout {
+		static constexpr size_t SubBucketBits = 4;
+		static constexpr size_t SubBuckets = 1 << SubBucketBits;
+		static constexpr size_t RangeBits = 40;
+		static constexpr size_t BucketCount = (RangeBits - SubBucketBits + 1) * SubBuckets;
+
+		static size_t index(ULONG64 value) noexcept {
+			if (value < SubBuckets)
+				return static_cast<size_t>(value);
+
+			auto exponent = _highest_bit(value);
+			if (exponent >= RangeBits)
+				return BucketCount - 1;
+
+			return (exponent - SubBucketBits + 1) * SubBuckets + static_cast<size_t>((value >> (exponent - SubBucketBits)) & (SubBuckets - 1));
+		}
+
+		// largest value that falls into the bucket
+		static ULONG64 highest(size_t index) noexcept {
+			if (index < SubBuckets)
+				return index;
+
+			auto shift = index / SubBuckets - 1;
+			auto lowest = static_cast<ULONG64>(SubBuckets + index % SubBuckets) << shift;
+			return lowest + (1ull << shift) - 1;
+		}
+	};
+
+	// Merged counts of one or more histograms, for reading percentiles.
+	class histogram_snapshot {
+	public:
+		histogram_snapshot()
+			: _count(0), _total(0), _max(0) {
+			_counts.resize(_histogram_layout::BucketCount);
+		}
+
+		void add(const histogram_snapshot& other) noexcept {
+			for (size_t i = 0; i < _histogram_layout::BucketCount; ++i)
+				_counts[i] += other._counts[i];
+
+			_count += other._count;
+			_total += other._total;
+			_max = other._max > _max ? other._max : _max;
+		}
+
+		ULONG64 count() const noexcept {
+			return _count;
+		}
+
+		ULONG64 max() const noexcept {
+			return _max;
+		}
+
+		ULONG64 mean() const noexcept {
+			return _count ? _total / _count : 0;
+		}
+
+		// value at or below which perMille of the recordings lie, e.g. 990 for p99
+		ULONG64 value_at(ULONG perMille) const noexcept;
+
+		histogram_summary summary() const noexcept;
+	private:
+		friend class histogram;
+
+		tiny::vector<ULONG64> _counts;
+		ULONG64 _count;
+		ULONG64 _total;
+		ULONG64 _max;
+	};
+
+	inline ULONG64 histogram_snapshot::value_at(ULONG perMille) const noexcept {
+		if (!_count)
+			return 0;
+
+		// rank of the wanted recording, rounded up
+		auto rank = (_count * perMille + 999) / 1000;
+		if (!rank)
+			rank = 1;
+
+		ULONG64 seen = 0;
+		for (size_t i = 0; i < _histogram_layout::BucketCount; ++i)
+		{
+			seen += _counts[i];
+			if (seen >= rank)
+			{
+				// the last bucket is open ended
+				auto value = i + 1 < _histogram_layout::BucketCount ? _histogram_layout::highest(i) : _max;
+				return value < _max ? value : _max;
+			}
+		}
+
+		return _max;
+	}
+
+	inline histogram_summary histogram_snapshot::summary() const noexcept {
+		histogram_summary result;
+		result.count = _count;
+		result.mean = this->mean();
+		result.p50 = this->value_at(500);
+		result.p99 = this->value_at(990);
+		result.p999 = this->value_at(999);
+		result.max = _max;
+
+		return result;
+	}
+
+	/*
+	* Latency histogram with a set of buckets per processor. record() only touches the buckets
+	* of the processor it runs on, with interlocked operations in case the thread moved, so it
+	* takes no lock and recorders on different processors share no cache lines. snapshot()
+	* merges the processors while recording goes on. Usable at any IRQL.
+	*/
+	class histogram {
+	public:
+		histogram& operator=(const histogram&) = delete;
+		histogram(const histogram&) = delete;
+
+		// the name is not copied, pass a literal
+		explicit histogram(const char* name = "");
+		~histogram();
+
+		const char* name() const noexcept {
+			return _name;
+		}
+
+		void record(ULONG64 value) noexcept;
+
+		histogram_snapshot snapshot() const;
+
+		histogram_summary summary() const {
+			return this->snapshot().summary();
+		}
+
+		// recordings that race with it may survive
+		void reset() noexcept;
+	private:
+		struct _processor {
+			volatile LONG64 counts[_histogram_layout::BucketCount];
+			volatile LONG64 total;
+			volatile LONG64 max;
+			char padding[64];
+		};
+
+		const char* _name;
+		_processor* _processors;
+		ULONG _processorCount;
+	};
+
+	inline histogram::histogram(const char* name)
+		: _name(name) {
+		_processorCount = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+		_processors = static_cast<_processor*>(ALLOC_MEMORY(_processorCount * sizeof(_processor)));
+		if (!_processors)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		memset(_processors, 0, _processorCount * sizeof(_processor));
+	}
+
+	inline histogram::~histogram() {
+		FREE_MEMORY(_processors);
+	}
+
+	inline void histogram::record(ULONG64 value) noexcept {
+		auto& processor = _processors[KeGetCurrentProcessorNumberEx(nullptr) % _processorCount];
+
+		InterlockedIncrement64(&processor.counts[_histogram_layout::index(value)]);
+		InterlockedAdd64(&processor.total, static_cast<LONG64>(value));
+
+		for (auto max = processor.max; static_cast<ULONG64>(max) < value; max = processor.max)
+		{
+			if (InterlockedCompareExchange64(&processor.max, static_cast<LONG64>(value), max) == max)
+				break;
+		}
+	}
+
+	inline histogram_snapshot histogram::snapshot() const {
+		histogram_snapshot result;
+
+		for (ULONG p = 0; p < _processorCount; ++p)
+		{
+			auto& processor = _processors[p];
+			for (size_t i = 0; i < _histogram_layout::BucketCount; ++i)
+				result._counts[i] += static_cast<ULONG64>(processor.counts[i]);
+
+			result._total += static_cast<ULONG64>(processor.total);
+
+			auto max = static_cast<ULONG64>(processor.max);
+			result._max = max > result._max ? max : result._max;
+		}
+
+		for (auto count : result._counts)
+			result._count += count;
+
+		return result;
+	}
+
+	inline void histogram::reset() noexcept {
+		for (ULONG p = 0; p < _processorCount; ++p)
+		{
+			auto& processor = _processors[p];
+			for (auto& count : processor.counts)
+				InterlockedExchange64(&count, 0);
+
+			InterlockedExchange64(&processor.total, 0);
+			InterlockedExchange64(&processor.max, 0);
+		}
+	}
+
+	// Stands in for the histograms of TINY_HISTOGRAM when instrumentation is compiled out,
+	// it allocates nothing and reads as empty.
+	class null_histogram {
+	public:
+		null_histogram& operator=(const null_histogram&) = delete;
+		null_histogram(const null_histogram&) = delete;
+
+		constexpr explicit null_histogram(const char* name = "") noexcept
+			: _name(name) {
+		}
+
+		const char* name() const noexcept {
+			return _name;
+		}
+
+		void record(ULONG64) noexcept {
+		}
+
+		histogram_snapshot snapshot() const {
+			return histogram_snapshot();
+		}
+
+		histogram_summary summary() const noexcept {
+			return histogram_summary{};
+		}
+
+		void reset() noexcept {
+		}
+	private:
+		const char* _name;
+	};
+
+	// Records the lifetime of the scope into a histogram, in nanoseconds or with
+	// cycle_stopwatch in TSC cycles.
+	template <typename Stopwatch = stopwatch>
+	class scoped_timer {
+	public:
+		scoped_timer& operator=(const scoped_timer&) = delete;
+		scoped_timer(const scoped_timer&) = delete;
+
+		explicit scoped_timer(histogram& target) noexcept
+			: _target(target) {
+		}
+
+		~scoped_timer() {
+			_target.record(_stopwatch.elapsed());
+		}
+	private:
+		histogram& _target;
+		Stopwatch _stopwatch;
+	};
+}
+
+#define TINY_CONCAT_IMPL(a, b) a##b
+#define TINY_CONCAT(a, b) TINY_CONCAT_IMPL(a, b)
+
+#if TINY_INSTRUMENTATION
+// TINY_HISTOGRAM(scanLatency, "scan"); declares the histogram the timers below record into
+#define TINY_HISTOGRAM(name, label) tiny::histogram name(label)
+// TINY_SCOPED_TIMER(scanLatency); records the rest of the scope into the histogram scanLatency
+#define TINY_SCOPED_TIMER(histogram) tiny::scoped_timer<tiny::stopwatch> TINY_CONCAT(_tinyScopedTimer, __LINE__)(histogram)
+#define TINY_SCOPED_CYCLE_TIMER(histogram) tiny::scoped_timer<tiny::cycle_stopwatch> TINY_CONCAT(_tinyScopedTimer, __LINE__)(histogram)
+#define TINY_RECORD(histogram, value) (histogram).record(value)
+#else
+#define TINY_HISTOGRAM(name, label) tiny::null_histogram name(label)
+#define TINY_SCOPED_TIMER(histogram)
+#define TINY_SCOPED_CYCLE_TIMER(histogram)
+#define TINY_RECORD(histogram, value) ((void)0)
+#endif
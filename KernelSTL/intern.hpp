@@ -0,0 +1,395 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "mutex.hpp"
+#include "string.hpp"
+#include "string_view.hpp"
+#include "hash.hpp"
+
+namespace tiny {
+	struct intern_stats {
+		size_t entries;
+		size_t references; // live interned_string handles
+		size_t storedBytes; // memory held by the entries
+		size_t savedBytes; // string memory the duplicate handles would need as separate copies
+		ULONG64 lookups;
+		ULONG64 hits;
+	};
+
+	// Immutable text with its hash, allocated in one block together with the characters.
+	template <typename T>
+	struct _intern_entry {
+		_intern_entry* volatile next;
+		volatile LONG refs;
+		ULONG64 hash;
+		size_t size;
+		T text[1];
+
+		static size_t allocationSize(size_t size) noexcept {
+			return sizeof(_intern_entry) + size * sizeof(T);
+		}
+
+		void incref() noexcept {
+			InterlockedIncrement(&refs);
+		}
+
+		void decref() noexcept {
+			if (InterlockedDecrement(&refs) == 0)
+				FREE_MEMORY(this);
+		}
+
+		// fails once the entry is being purged
+		bool tryIncref() noexcept {
+			for (LONG current = refs; current; current = refs)
+			{
+				if (InterlockedCompareExchange(&refs, current + 1, current) == current)
+					return true;
+			}
+
+			return false;
+		}
+	};
+
+	// Handle to an interned string, equal contents from the same table share one entry.
+	template <typename T>
+	class basic_interned_string {
+	public:
+		basic_interned_string() noexcept
+			: _entry(nullptr) {
+		}
+
+		basic_interned_string(const basic_interned_string& other) noexcept
+			: _entry(other._entry) {
+			if (_entry)
+				_entry->incref();
+		}
+
+		basic_interned_string(basic_interned_string&& other) noexcept
+			: _entry(tiny::exchange(other._entry, nullptr)) {
+		}
+
+		basic_interned_string& operator=(basic_interned_string other) noexcept {
+			tiny::swap(_entry, other._entry);
+			return *this;
+		}
+
+		~basic_interned_string() {
+			if (_entry)
+				_entry->decref();
+		}
+
+		explicit operator bool() const noexcept {
+			return _entry != nullptr;
+		}
+
+		const T* data() const noexcept {
+			return _entry ? _entry->text : nullptr;
+		}
+
+		size_t size() const noexcept {
+			return _entry ? _entry->size : 0;
+		}
+
+		basic_string_view<T> view() const noexcept {
+			return _entry ? basic_string_view<T>(_entry->text, _entry->size) : basic_string_view<T>();
+		}
+
+		operator basic_string_view<T>() const noexcept {
+			return this->view();
+		}
+
+		// computed once when the string was interned
+		ULONG64 hash() const noexcept {
+			return _entry ? _entry->hash : 0;
+		}
+
+		// only meaningful for handles from the same table
+		bool operator==(const basic_interned_string& other) const noexcept {
+			return _entry == other._entry;
+		}
+
+		bool operator!=(const basic_interned_string& other) const noexcept {
+			return _entry != other._entry;
+		}
+	private:
+		template <typename U>
+		friend class basic_intern_table;
+
+		_intern_entry<T>* _entry;
+
+		// takes over a reference
+		explicit basic_interned_string(_intern_entry<T>* entry) noexcept
+			: _entry(entry) {
+		}
+	};
+
+	/*
+	* Concurrent table mapping string contents to a single refcounted entry. Lookups of strings
+	* that are already interned take no lock, they only bump the reader count of the current
+	* epoch. Inserts are serialized by a spin lock, so both work up to DISPATCH_LEVEL.
+	* The table keeps a reference on every entry, purge() drops entries no handle uses anymore.
+	*/
+	template <typename T>
+	class basic_intern_table {
+	public:
+		basic_intern_table& operator=(const basic_intern_table&) = delete;
+		basic_intern_table(const basic_intern_table&) = delete;
+
+		// the bucket count is fixed, it is rounded up to a power of two
+		explicit basic_intern_table(size_t bucketCount = 4096);
+
+		// entries still referenced by handles stay alive until the last handle is gone
+		~basic_intern_table();
+
+		basic_interned_string<T> intern(basic_string_view<T> text);
+
+		basic_interned_string<T> intern(const T* text) {
+			return this->intern(basic_string_view<T>(text));
+		}
+
+		// empty handle when the text was not interned
+		basic_interned_string<T> find(basic_string_view<T> text);
+
+		// PASSIVE_LEVEL only, frees unreferenced entries and returns their count
+		size_t purge();
+
+		intern_stats stats();
+	private:
+		tiny::vector<_intern_entry<T>*> _buckets;
+		size_t _mask;
+
+		tiny::spin_lock _insertLock;
+		tiny::mutex _purgeLock;
+
+		// readers register in the current epoch, purge flips it and waits for the old one to drain
+		volatile LONG _epoch;
+		volatile LONG _readers[2];
+
+		volatile LONG64 _lookups;
+		volatile LONG64 _hits;
+
+		static ULONG64 _hash(basic_string_view<T> text) noexcept;
+
+		LONG _enterRead() noexcept;
+		void _leaveRead(LONG epoch) noexcept;
+		_intern_entry<T>* _lookup(basic_string_view<T> text, ULONG64 hash) noexcept;
+		_intern_entry<T>* _bucket(ULONG64 hash) const noexcept;
+	};
+
+	template <typename T>
+	inline basic_intern_table<T>::basic_intern_table(size_t bucketCount)
+		: _epoch(0), _lookups(0), _hits(0) {
+		size_t buckets = 1;
+		while (buckets < bucketCount)
+			buckets <<= 1;
+
+		_buckets.resize(buckets);
+		_mask = buckets - 1;
+		_readers[0] = 0;
+		_readers[1] = 0;
+	}
+
+	template <typename T>
+	inline basic_intern_table<T>::~basic_intern_table() {
+		for (auto& head : _buckets)
+		{
+			for (auto entry = head; entry; )
+			{
+				auto next = entry->next;
+				entry->decref();
+				entry = next;
+			}
+
+			head = nullptr;
+		}
+	}
+
+	template <typename T>
+	inline basic_interned_string<T> basic_intern_table<T>::intern(basic_string_view<T> text) {
+		auto hash = _hash(text);
+		InterlockedIncrement64(&_lookups);
+
+		auto epoch = this->_enterRead();
+		auto found = this->_lookup(text, hash);
+		this->_leaveRead(epoch);
+
+		if (found)
+		{
+			InterlockedIncrement64(&_hits);
+			return basic_interned_string<T>(found);
+		}
+
+		auto entry = static_cast<_intern_entry<T>*>(ALLOC_MEMORY(_intern_entry<T>::allocationSize(text.size())));
+		if (!entry)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		entry->refs = 2; // the table and the returned handle
+		entry->hash = hash;
+		entry->size = text.size();
+		if (text.size())
+			memcpy(entry->text, text.data(), text.size() * sizeof(T));
+		entry->text[text.size()] = 0;
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_insertLock);
+
+			// another thread may have inserted the same text meanwhile
+			found = this->_lookup(text, hash);
+			if (!found)
+			{
+				auto& head = _buckets[hash & _mask];
+				entry->next = head;
+				InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&head), entry);
+			}
+		}
+
+		if (found)
+		{
+			FREE_MEMORY(entry);
+			InterlockedIncrement64(&_hits);
+			return basic_interned_string<T>(found);
+		}
+
+		return basic_interned_string<T>(entry);
+	}
+
+	template <typename T>
+	inline basic_interned_string<T> basic_intern_table<T>::find(basic_string_view<T> text) {
+		auto hash = _hash(text);
+
+		auto epoch = this->_enterRead();
+		auto found = this->_lookup(text, hash);
+		this->_leaveRead(epoch);
+
+		return basic_interned_string<T>(found);
+	}
+
+	template <typename T>
+	inline size_t basic_intern_table<T>::purge() {
+		tiny::scoped_lock<tiny::mutex> purgeLock(_purgeLock);
+		_intern_entry<T>* unlinked = nullptr;
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_insertLock);
+
+			for (auto& head : _buckets)
+			{
+				_intern_entry<T>* volatile* link = &head;
+				while (auto entry = *link)
+				{
+					// the table holds the only reference, nobody can take a new one after this
+					if (InterlockedCompareExchange(&entry->refs, 0, 1) != 1)
+					{
+						link = &entry->next;
+						continue;
+					}
+
+					*link = entry->next;
+					entry->next = unlinked;
+					unlinked = entry;
+				}
+			}
+		}
+
+		// readers that started before the unlink may still walk through the entries
+		auto oldEpoch = InterlockedExchange(&_epoch, 1 - _epoch);
+		while (_readers[oldEpoch])
+			YieldProcessor();
+
+		size_t freed = 0;
+		while (unlinked)
+		{
+			auto next = unlinked->next;
+			FREE_MEMORY(unlinked);
+			unlinked = next;
+			++freed;
+		}
+
+		return freed;
+	}
+
+	template <typename T>
+	inline intern_stats basic_intern_table<T>::stats() {
+		intern_stats result = {};
+
+		tiny::scoped_lock<tiny::spin_lock> lock(_insertLock);
+		for (auto head : _buckets)
+		{
+			for (auto entry = head; entry; entry = entry->next)
+			{
+				auto handles = static_cast<size_t>(entry->refs > 1 ? entry->refs - 1 : 0);
+
+				++result.entries;
+				result.references += handles;
+				result.storedBytes += _intern_entry<T>::allocationSize(entry->size);
+
+				if (handles > 1)
+					result.savedBytes += (handles - 1) * (entry->size + 1) * sizeof(T);
+			}
+		}
+
+		result.lookups = static_cast<ULONG64>(_lookups);
+		result.hits = static_cast<ULONG64>(_hits);
+
+		return result;
+	}
+
+	//
+	// private
+	//
+
+	template <typename T>
+	inline ULONG64 basic_intern_table<T>::_hash(basic_string_view<T> text) noexcept {
+		return tiny::hash_bytes(text.data(), text.size() * sizeof(T));
+	}
+
+	template <typename T>
+	inline LONG basic_intern_table<T>::_enterRead() noexcept {
+		while (true)
+		{
+			auto epoch = _epoch;
+			InterlockedIncrement(&_readers[epoch]);
+
+			// purge flipped the epoch meanwhile and may not wait for this reader
+			if (epoch == _epoch)
+				return epoch;
+
+			InterlockedDecrement(&_readers[epoch]);
+		}
+	}
+
+	template <typename T>
+	inline void basic_intern_table<T>::_leaveRead(LONG epoch) noexcept {
+		InterlockedDecrement(&_readers[epoch]);
+	}
+
+	// Returns the entry with a new reference or nullptr.
+	template <typename T>
+	inline _intern_entry<T>* basic_intern_table<T>::_lookup(basic_string_view<T> text, ULONG64 hash) noexcept {
+		for (auto entry = this->_bucket(hash); entry; entry = entry->next)
+		{
+			if (entry->hash != hash || entry->size != text.size())
+				continue;
+
+			if (text.size() && memcmp(entry->text, text.data(), text.size() * sizeof(T)) != 0)
+				continue;
+
+			if (entry->tryIncref())
+				return entry;
+		}
+
+		return nullptr;
+	}
+
+	template <typename T>
+	inline _intern_entry<T>* basic_intern_table<T>::_bucket(ULONG64 hash) const noexcept {
+		return *static_cast<_intern_entry<T>* volatile const*>(&_buckets[hash & _mask]);
+	}
+
+	using interned_string = basic_interned_string<char>;
+	using winterned_string = basic_interned_string<wchar_t>;
+	using intern_table = basic_intern_table<char>;
+	using wintern_table = basic_intern_table<wchar_t>;
+}
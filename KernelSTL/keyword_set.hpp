@@ -0,0 +1,209 @@
+#pragma once
+
+#include "common.hpp"
+#include "string_view.hpp"
+
+namespace tiny {
+	template <bool CaseInsensitive, typename T>
+	constexpr ULONG64 _keyword_char(T c) noexcept {
+		if (CaseInsensitive && c >= T('a') && c <= T('z'))
+			c = static_cast<T>(c - T('a') + T('A'));
+
+		return static_cast<ULONG64>(static_cast<unsigned int>(c) & 0xFFFF);
+	}
+
+	// Evaluated the same way at compile time and at run time, keywords are short.
+	template <bool CaseInsensitive, typename T>
+	constexpr ULONG64 _keyword_hash(const T* text, size_t size, ULONG64 seed) noexcept {
+		auto hash = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull) ^ size;
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ _keyword_char<CaseInsensitive>(text[i])) * 0x100000001B3ull;
+
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		return hash ^ (hash >> 33);
+	}
+
+	// Not constexpr, reaching it during constant evaluation turns into a compile error.
+	inline void _keyword_set_invalid() {
+		ExRaiseStatus(STATUS_INVALID_PARAMETER);
+	}
+
+	constexpr size_t _keyword_power_of_two(size_t value) noexcept {
+		size_t result = 1;
+		while (result < value)
+			result <<= 1;
+
+		return result;
+	}
+
+	/*
+	* Fixed set of keywords with a perfect hash built at compile time. Keys are spread over
+	* buckets by their hash, each bucket gets a displacement that moves its keys into free slots
+	* of the table, so a lookup is one hash, one slot read and one comparison with the only
+	* candidate. Case-insensitive sets fold ASCII letters, the keywords are names and extensions.
+	* Construction fails to compile for duplicate keywords.
+	*/
+	template <typename T, size_t N, bool CaseInsensitive = false>
+	class keyword_set {
+	public:
+		static_assert(N > 0 && N < 0xFFFF, "keyword_set holds 1 to 65534 keywords");
+
+		inline static const size_t npos = static_cast<size_t>(-1);
+
+		template <typename... Keys>
+		constexpr explicit keyword_set(Keys... keys)
+			: _keys{ keys... } {
+			for (ULONG64 seed = 0; seed < 64; ++seed)
+			{
+				if (this->_build(seed))
+					return;
+			}
+
+			_keyword_set_invalid();
+		}
+
+		constexpr size_t size() const noexcept {
+			return N;
+		}
+
+		constexpr basic_string_view<T> operator[](size_t idx) const noexcept {
+			return _keys[idx];
+		}
+
+		// index of the keyword in the list the set was made from, npos when it is none of them
+		constexpr size_t find(const T* text, size_t size) const noexcept {
+			auto hash = _keyword_hash<CaseInsensitive>(text, size, _seed);
+			auto index = _slots[this->_slot(hash, _displacements[hash & (BucketCount - 1)])];
+			if (!index)
+				return npos;
+
+			auto& key = _keys[index - 1];
+			if (key.size() != size)
+				return npos;
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (_keyword_char<CaseInsensitive>(key[i]) != _keyword_char<CaseInsensitive>(text[i]))
+					return npos;
+			}
+
+			return index - 1;
+		}
+
+		constexpr size_t find(basic_string_view<T> text) const noexcept {
+			return this->find(text.data(), text.size());
+		}
+
+		constexpr bool contains(const T* text, size_t size) const noexcept {
+			return this->find(text, size) != npos;
+		}
+
+		constexpr bool contains(basic_string_view<T> text) const noexcept {
+			return this->find(text.data(), text.size()) != npos;
+		}
+	private:
+		// half full at most, so displacements are found quickly
+		static constexpr size_t TableSize = _keyword_power_of_two(N * 2);
+		static constexpr size_t BucketCount = _keyword_power_of_two((N + 1) / 2);
+
+		basic_string_view<T> _keys[N];
+		unsigned short _slots[TableSize] = {}; // keyword index + 1, 0 is empty
+		unsigned short _displacements[BucketCount] = {};
+		ULONG64 _seed = 0;
+
+		static constexpr size_t _slot(ULONG64 hash, size_t displacement) noexcept {
+			return static_cast<size_t>((hash >> 32) + displacement * ((hash >> 8) | 1)) & (TableSize - 1);
+		}
+
+		constexpr bool _build(ULONG64 seed) noexcept {
+			ULONG64 hashes[N] = {};
+			size_t bucketSizes[BucketCount] = {};
+			size_t largest = 0;
+
+			for (size_t i = 0; i < N; ++i)
+			{
+				hashes[i] = _keyword_hash<CaseInsensitive>(_keys[i].data(), _keys[i].size(), seed);
+
+				auto& bucketSize = bucketSizes[hashes[i] & (BucketCount - 1)];
+				if (++bucketSize > largest)
+					largest = bucketSize;
+			}
+
+			for (auto& slot : _slots)
+				slot = 0;
+
+			// crowded buckets first, while the table still has room
+			for (auto size = largest; size; --size)
+			{
+				for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+				{
+					if (bucketSizes[bucket] != size)
+						continue;
+
+					if (!this->_place(hashes, bucket))
+						return false;
+				}
+			}
+
+			_seed = seed;
+			return true;
+		}
+
+		// finds a displacement under which every key of the bucket lands on its own free slot
+		constexpr bool _place(const ULONG64 (&hashes)[N], size_t bucket) noexcept {
+			for (size_t displacement = 0; displacement < TableSize; ++displacement)
+			{
+				size_t placed = 0;
+				for (size_t i = 0; i < N; ++i)
+				{
+					if ((hashes[i] & (BucketCount - 1)) != bucket)
+						continue;
+
+					auto& slot = _slots[_slot(hashes[i], displacement)];
+					if (slot)
+						break;
+
+					slot = static_cast<unsigned short>(i + 1);
+					++placed;
+				}
+
+				if (placed == this->_bucketSize(hashes, bucket))
+				{
+					_displacements[bucket] = static_cast<unsigned short>(displacement);
+					return true;
+				}
+
+				// undo the partial placement
+				for (size_t i = 0; i < N; ++i)
+				{
+					if ((hashes[i] & (BucketCount - 1)) == bucket && _slots[_slot(hashes[i], displacement)] == i + 1)
+						_slots[_slot(hashes[i], displacement)] = 0;
+				}
+			}
+
+			return false;
+		}
+
+		static constexpr size_t _bucketSize(const ULONG64 (&hashes)[N], size_t bucket) noexcept {
+			size_t result = 0;
+			for (auto hash : hashes)
+				result += (hash & (BucketCount - 1)) == bucket;
+
+			return result;
+		}
+	};
+
+	// keys are string literals, e.g. make_keyword_set(L"csrss.exe", L"lsass.exe")
+	template <typename T, size_t... Sizes>
+	constexpr keyword_set<T, sizeof...(Sizes)> make_keyword_set(const T (&... keys)[Sizes]) {
+		return keyword_set<T, sizeof...(Sizes)>(basic_string_view<T>(keys, Sizes - 1)...);
+	}
+
+	template <typename T, size_t... Sizes>
+	constexpr keyword_set<T, sizeof...(Sizes), true> make_case_insensitive_keyword_set(const T (&... keys)[Sizes]) {
+		return keyword_set<T, sizeof...(Sizes), true>(basic_string_view<T>(keys, Sizes - 1)...);
+	}
+}
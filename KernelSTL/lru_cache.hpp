@@ -0,0 +1,426 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "hash.hpp"
+#include "mutex.hpp"
+
+namespace tiny {
+	struct lru_cache_stats {
+		size_t entries;
+		size_t bytes; // as given to put()
+		ULONG64 hits;
+		ULONG64 misses;
+		ULONG64 evictions; // entries pushed out by the capacity, not erased or replaced
+	};
+
+	template <typename K, typename V, typename Hash>
+	class sharded_lru_cache;
+
+	/*
+	* Cache with a hash index and an intrusive recency list, get, put and eviction are O(1).
+	* Recency is approximated the CLOCK way: a hit only sets the referenced flag of its entry and
+	* eviction gives referenced entries at the tail a second round instead of moving them on each
+	* hit. That keeps get() from writing to the list, so gets may run concurrently with each other,
+	* put(), erase() and clear() need exclusive access. sharded_lru_cache does the locking.
+	*/
+	template <typename K, typename V, typename Hash = tiny::hash<K>>
+	class lru_cache {
+	public:
+		lru_cache& operator=(const lru_cache&) = delete;
+		lru_cache(const lru_cache&) = delete;
+
+		// maxBytes 0 limits the entry count only, the bytes of an entry are what put() is told
+		explicit lru_cache(size_t maxEntries, size_t maxBytes = 0, const Hash& hasher = Hash());
+		~lru_cache();
+
+		// copies the value out, false on a miss
+		bool get(const K& key, V& value) noexcept {
+			return this->_get(key, static_cast<ULONG64>(_hasher(key)), value);
+		}
+
+		// Inserts or replaces, evicting as needed. False when the entry alone is above maxBytes,
+		// it is not cached then.
+		bool put(const K& key, const V& value, size_t bytes = 0) {
+			return this->_put(key, static_cast<ULONG64>(_hasher(key)), value, bytes);
+		}
+
+		bool erase(const K& key) noexcept {
+			return this->_erase(key, static_cast<ULONG64>(_hasher(key)));
+		}
+
+		void clear() noexcept;
+
+		size_t size() const noexcept {
+			return _size;
+		}
+
+		lru_cache_stats stats() const noexcept;
+	private:
+		template <typename, typename, typename>
+		friend class sharded_lru_cache;
+
+		struct _node {
+			_node* chain; // next in the hash bucket
+			_node* prev;  // towards the most recent
+			_node* next;  // towards the least recent
+			ULONG64 hash;
+			size_t bytes;
+			volatile char referenced;
+			K key;
+			V value;
+
+			_node(const K& k, const V& v)
+				: key(k), value(v) {
+			}
+		};
+
+		static_assert(alignof(_node) <= MEMORY_ALLOCATION_ALIGNMENT, "lru_cache entries are only pool aligned");
+
+		Hash _hasher;
+		size_t _maxEntries;
+		size_t _maxBytes;
+
+		tiny::vector<_node*> _buckets;
+		_node* _head; // most recently inserted
+		_node* _tail;
+		size_t _size;
+		size_t _bytes;
+
+		volatile LONG64 _hits;
+		volatile LONG64 _misses;
+		volatile LONG64 _evictions;
+
+		bool _get(const K& key, ULONG64 hash, V& value) noexcept;
+		bool _put(const K& key, ULONG64 hash, const V& value, size_t bytes);
+		bool _erase(const K& key, ULONG64 hash) noexcept;
+
+		_node* _find(const K& key, ULONG64 hash) const noexcept;
+		void _evict() noexcept;
+		void _unlink(_node* node) noexcept;
+		void _pushFront(_node* node) noexcept;
+		void _rehash(size_t bucketCount);
+	};
+
+	template <typename K, typename V, typename Hash>
+	inline lru_cache<K, V, Hash>::lru_cache(size_t maxEntries, size_t maxBytes, const Hash& hasher)
+		: _hasher(hasher), _maxEntries(maxEntries ? maxEntries : 1), _maxBytes(maxBytes), _head(nullptr), _tail(nullptr),
+		_size(0), _bytes(0), _hits(0), _misses(0), _evictions(0) {
+		this->_rehash(16);
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline lru_cache<K, V, Hash>::~lru_cache() {
+		this->clear();
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline void lru_cache<K, V, Hash>::clear() noexcept {
+		while (_head)
+		{
+			auto node = tiny::exchange(_head, _head->next);
+			node->~_node();
+			FREE_MEMORY(node);
+		}
+
+		for (auto& bucket : _buckets)
+			bucket = nullptr;
+
+		_tail = nullptr;
+		_size = 0;
+		_bytes = 0;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline lru_cache_stats lru_cache<K, V, Hash>::stats() const noexcept {
+		lru_cache_stats result;
+		result.entries = _size;
+		result.bytes = _bytes;
+		result.hits = static_cast<ULONG64>(_hits);
+		result.misses = static_cast<ULONG64>(_misses);
+		result.evictions = static_cast<ULONG64>(_evictions);
+
+		return result;
+	}
+
+	//
+	// private
+	//
+
+	template <typename K, typename V, typename Hash>
+	inline bool lru_cache<K, V, Hash>::_get(const K& key, ULONG64 hash, V& value) noexcept {
+		auto node = this->_find(key, hash);
+		if (!node)
+		{
+			InterlockedIncrement64(&_misses);
+			return false;
+		}
+
+		// racing readers all store the same value, read first so a hot entry's line stays shared
+		if (!node->referenced)
+			node->referenced = 1;
+
+		value = node->value;
+		InterlockedIncrement64(&_hits);
+		return true;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline bool lru_cache<K, V, Hash>::_put(const K& key, ULONG64 hash, const V& value, size_t bytes) {
+		if (_maxBytes && bytes > _maxBytes)
+		{
+			this->_erase(key, hash);
+			return false;
+		}
+
+		if (auto node = this->_find(key, hash))
+		{
+			node->value = value;
+			node->referenced = 1;
+			_bytes = _bytes - node->bytes + bytes;
+			node->bytes = bytes;
+
+			while (_maxBytes && _bytes > _maxBytes)
+				this->_evict();
+
+			return true;
+		}
+
+		while (_size && (_size >= _maxEntries || (_maxBytes && _bytes + bytes > _maxBytes)))
+			this->_evict();
+
+		if (_size >= _buckets.size())
+			this->_rehash(_buckets.size() * 2);
+
+		auto node = static_cast<_node*>(ALLOC_MEMORY(sizeof(_node)));
+		if (!node)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		new (node) _node(key, value);
+		node->hash = hash;
+		node->bytes = bytes;
+		node->referenced = 0;
+
+		auto& bucket = _buckets[hash & (_buckets.size() - 1)];
+		node->chain = bucket;
+		bucket = node;
+
+		this->_pushFront(node);
+		++_size;
+		_bytes += bytes;
+
+		return true;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline bool lru_cache<K, V, Hash>::_erase(const K& key, ULONG64 hash) noexcept {
+		for (auto link = &_buckets[hash & (_buckets.size() - 1)]; *link; link = &(*link)->chain)
+		{
+			auto node = *link;
+			if (node->hash != hash || !(node->key == key))
+				continue;
+
+			*link = node->chain;
+			this->_unlink(node);
+			--_size;
+			_bytes -= node->bytes;
+
+			node->~_node();
+			FREE_MEMORY(node);
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline typename lru_cache<K, V, Hash>::_node* lru_cache<K, V, Hash>::_find(const K& key, ULONG64 hash) const noexcept {
+		for (auto node = _buckets[hash & (_buckets.size() - 1)]; node; node = node->chain)
+		{
+			if (node->hash == hash && node->key == key)
+				return node;
+		}
+
+		return nullptr;
+	}
+
+	// Evicts the least recent entry that was not hit since it last came around. Every entry that
+	// is passed over loses its flag, so this ends within one round of the list.
+	template <typename K, typename V, typename Hash>
+	inline void lru_cache<K, V, Hash>::_evict() noexcept {
+		while (_tail->referenced && _tail != _head)
+		{
+			auto node = _tail;
+			node->referenced = 0;
+
+			this->_unlink(node);
+			this->_pushFront(node);
+		}
+
+		auto victim = _tail;
+		InterlockedIncrement64(&_evictions);
+		this->_erase(victim->key, victim->hash);
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline void lru_cache<K, V, Hash>::_unlink(_node* node) noexcept {
+		if (node->prev)
+			node->prev->next = node->next;
+		else
+			_head = node->next;
+
+		if (node->next)
+			node->next->prev = node->prev;
+		else
+			_tail = node->prev;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline void lru_cache<K, V, Hash>::_pushFront(_node* node) noexcept {
+		node->prev = nullptr;
+		node->next = _head;
+
+		if (_head)
+			_head->prev = node;
+		else
+			_tail = node;
+
+		_head = node;
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline void lru_cache<K, V, Hash>::_rehash(size_t bucketCount) {
+		tiny::vector<_node*> buckets;
+		buckets.resize(bucketCount);
+
+		for (auto node = _head; node; node = node->next)
+		{
+			auto& bucket = buckets[node->hash & (bucketCount - 1)];
+			node->chain = bucket;
+			bucket = node;
+		}
+
+		_buckets = tiny::move(buckets);
+	}
+
+	/*
+	* lru_cache split into shards by the key hash, each behind its own push lock. Gets take the
+	* lock shared, so lookups of the same shard run in parallel and only puts and erases contend.
+	* Capacity is divided evenly, so a shard evicts on its own once its part is full.
+	* PASSIVE_LEVEL and APC_LEVEL only.
+	*/
+	template <typename K, typename V, typename Hash = tiny::hash<K>>
+	class sharded_lru_cache {
+	public:
+		sharded_lru_cache& operator=(const sharded_lru_cache&) = delete;
+		sharded_lru_cache(const sharded_lru_cache&) = delete;
+
+		// shardCount 0 picks one per processor, rounded up to a power of two
+		explicit sharded_lru_cache(size_t maxEntries, size_t maxBytes = 0, size_t shardCount = 0, const Hash& hasher = Hash());
+		~sharded_lru_cache();
+
+		bool get(const K& key, V& value) {
+			auto hash = static_cast<ULONG64>(_hasher(key));
+			auto& shard = this->_shardFor(hash);
+
+			tiny::shared_lock lock(shard.lock);
+			return shard.cache._get(key, hash, value);
+		}
+
+		bool put(const K& key, const V& value, size_t bytes = 0) {
+			auto hash = static_cast<ULONG64>(_hasher(key));
+			auto& shard = this->_shardFor(hash);
+
+			tiny::scoped_lock<tiny::shared_mutex> lock(shard.lock);
+			return shard.cache._put(key, hash, value, bytes);
+		}
+
+		bool erase(const K& key) {
+			auto hash = static_cast<ULONG64>(_hasher(key));
+			auto& shard = this->_shardFor(hash);
+
+			tiny::scoped_lock<tiny::shared_mutex> lock(shard.lock);
+			return shard.cache._erase(key, hash);
+		}
+
+		void clear();
+
+		// summed over the shards, each is read under its lock but not all at once
+		lru_cache_stats stats();
+	private:
+		struct _shard {
+			tiny::shared_mutex lock;
+			lru_cache<K, V, Hash> cache;
+			char padding[64];
+
+			_shard(size_t maxEntries, size_t maxBytes, const Hash& hasher)
+				: cache(maxEntries, maxBytes, hasher) {
+			}
+		};
+
+		Hash _hasher;
+		_shard* _shards;
+		size_t _shardCount;
+
+		// the low bits pick the bucket inside the shard
+		_shard& _shardFor(ULONG64 hash) noexcept {
+			return _shards[(hash >> 48) & (_shardCount - 1)];
+		}
+	};
+
+	template <typename K, typename V, typename Hash>
+	inline sharded_lru_cache<K, V, Hash>::sharded_lru_cache(size_t maxEntries, size_t maxBytes, size_t shardCount, const Hash& hasher)
+		: _hasher(hasher), _shardCount(1) {
+		if (!shardCount)
+			shardCount = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+
+		while (_shardCount < shardCount)
+			_shardCount <<= 1;
+
+		_shards = static_cast<_shard*>(ALLOC_MEMORY(_shardCount * sizeof(_shard)));
+		if (!_shards)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		auto entries = (maxEntries + _shardCount - 1) / _shardCount;
+		auto bytes = (maxBytes + _shardCount - 1) / _shardCount;
+		for (size_t i = 0; i < _shardCount; ++i)
+			new (_shards + i) _shard(entries, bytes, hasher);
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline sharded_lru_cache<K, V, Hash>::~sharded_lru_cache() {
+		for (size_t i = 0; i < _shardCount; ++i)
+			_shards[i].~_shard();
+
+		FREE_MEMORY(_shards);
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline void sharded_lru_cache<K, V, Hash>::clear() {
+		for (size_t i = 0; i < _shardCount; ++i)
+		{
+			tiny::scoped_lock<tiny::shared_mutex> lock(_shards[i].lock);
+			_shards[i].cache.clear();
+		}
+	}
+
+	template <typename K, typename V, typename Hash>
+	inline lru_cache_stats sharded_lru_cache<K, V, Hash>::stats() {
+		lru_cache_stats result = {};
+
+		for (size_t i = 0; i < _shardCount; ++i)
+		{
+			tiny::shared_lock lock(_shards[i].lock);
+			auto shard = _shards[i].cache.stats();
+
+			result.entries += shard.entries;
+			result.bytes += shard.bytes;
+			result.hits += shard.hits;
+			result.misses += shard.misses;
+			result.evictions += shard.evictions;
+		}
+
+		return result;
+	}
+}
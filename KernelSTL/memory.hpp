@@ -0,0 +1,519 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+
+namespace tiny {
+	//
+	// deleters
+	//
+
+	template <typename T>
+	struct default_delete {
+		constexpr default_delete() noexcept = default;
+
+		template <typename U, typename = enable_if_t<is_base_of_v<T, U>>>
+		default_delete(const default_delete<U>&) noexcept {
+		}
+
+		void operator()(T* ptr) const {
+			delete ptr;
+		}
+	};
+
+	// Frees objects created with pool_new<T, Tag> back to the pool with a matching tag.
+	template <typename T, ULONG Tag>
+	struct pool_delete {
+		void operator()(T* ptr) const {
+			ptr->~T();
+			ExFreePoolWithTag(ptr, Tag);
+		}
+	};
+
+	// Frees objects created with lookaside_new<T> back to the lookaside list they came from.
+	template <typename T>
+	class lookaside_delete {
+	public:
+		lookaside_delete() noexcept
+			: _lookaside(nullptr) {
+		}
+
+		explicit lookaside_delete(PLOOKASIDE_LIST_EX lookaside) noexcept
+			: _lookaside(lookaside) {
+		}
+
+		void operator()(T* ptr) const {
+			ptr->~T();
+			ExFreeToLookasideListEx(_lookaside, ptr);
+		}
+	private:
+		PLOOKASIDE_LIST_EX _lookaside;
+	};
+
+	template <typename T, ULONG Tag, typename... Args>
+	inline T* pool_new(Args&&... args) {
+		void* memory = ExAllocatePool2(POOL_FLAG_NON_PAGED, sizeof(T), Tag);
+		if (!memory)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		return new (memory) T(tiny::forward<Args>(args)...);
+	}
+
+	// Lookaside list has to be initialized for blocks of at least sizeof(T) bytes.
+	template <typename T, typename... Args>
+	inline T* lookaside_new(PLOOKASIDE_LIST_EX lookaside, Args&&... args) {
+		void* memory = ExAllocateFromLookasideListEx(lookaside);
+		if (!memory)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		return new (memory) T(tiny::forward<Args>(args)...);
+	}
+
+	//
+	// unique_ptr
+	//
+
+	// Stores the deleter as a base class so empty deleters take no space.
+	template <typename T, typename D>
+	class _pointer_with_deleter : private D {
+	public:
+		constexpr _pointer_with_deleter(T* ptr) noexcept
+			: D(), _ptr(ptr) {
+		}
+
+		template <typename DArg>
+		constexpr _pointer_with_deleter(T* ptr, DArg&& deleter) noexcept
+			: D(tiny::forward<DArg>(deleter)), _ptr(ptr) {
+		}
+
+		D& deleter() noexcept {
+			return *this;
+		}
+
+		const D& deleter() const noexcept {
+			return *this;
+		}
+
+		T* _ptr;
+	};
+
+	template <typename T, typename D = default_delete<T>>
+	class unique_ptr {
+	public:
+		unique_ptr& operator=(const unique_ptr&) = delete;
+		unique_ptr(const unique_ptr&) = delete;
+
+		constexpr unique_ptr() noexcept
+			: _pair(nullptr) {
+		}
+
+		constexpr unique_ptr(decltype(nullptr)) noexcept
+			: _pair(nullptr) {
+		}
+
+		explicit unique_ptr(T* ptr) noexcept
+			: _pair(ptr) {
+		}
+
+		unique_ptr(T* ptr, const D& deleter) noexcept
+			: _pair(ptr, deleter) {
+		}
+
+		unique_ptr(unique_ptr&& other) noexcept
+			: _pair(other.release(), tiny::move(other.get_deleter())) {
+		}
+
+		template <typename U, typename E>
+		unique_ptr(unique_ptr<U, E>&& other) noexcept
+			: _pair(other.release(), tiny::move(other.get_deleter())) {
+		}
+
+		~unique_ptr() {
+			this->reset();
+		}
+
+		unique_ptr& operator=(unique_ptr&& other) noexcept {
+			if (this != &other) {
+				this->reset(other.release());
+				this->get_deleter() = tiny::move(other.get_deleter());
+			}
+
+			return *this;
+		}
+
+		unique_ptr& operator=(decltype(nullptr)) noexcept {
+			this->reset();
+			return *this;
+		}
+
+		T* get() const noexcept {
+			return _pair._ptr;
+		}
+
+		D& get_deleter() noexcept {
+			return _pair.deleter();
+		}
+
+		const D& get_deleter() const noexcept {
+			return _pair.deleter();
+		}
+
+		T* release() noexcept {
+			return tiny::exchange(_pair._ptr, nullptr);
+		}
+
+		void reset(T* ptr = nullptr) {
+			auto oldPtr = tiny::exchange(_pair._ptr, ptr);
+			if (oldPtr)
+				_pair.deleter()(oldPtr);
+		}
+
+		void swap(unique_ptr& other) noexcept {
+			tiny::swap(_pair._ptr, other._pair._ptr);
+			tiny::swap(_pair.deleter(), other._pair.deleter());
+		}
+
+		T& operator*() const {
+			return *_pair._ptr;
+		}
+
+		T* operator->() const noexcept {
+			return _pair._ptr;
+		}
+
+		explicit operator bool() const noexcept {
+			return _pair._ptr != nullptr;
+		}
+	private:
+		_pointer_with_deleter<T, D> _pair;
+	};
+
+	template <typename T, typename... Args>
+	inline unique_ptr<T> make_unique(Args&&... args) {
+		return unique_ptr<T>(new T(tiny::forward<Args>(args)...));
+	}
+
+	template <typename T, ULONG Tag, typename... Args>
+	inline unique_ptr<T, pool_delete<T, Tag>> make_unique_pool(Args&&... args) {
+		return unique_ptr<T, pool_delete<T, Tag>>(tiny::pool_new<T, Tag>(tiny::forward<Args>(args)...));
+	}
+
+	template <typename T, typename... Args>
+	inline unique_ptr<T, lookaside_delete<T>> make_unique_lookaside(PLOOKASIDE_LIST_EX lookaside, Args&&... args) {
+		return unique_ptr<T, lookaside_delete<T>>(
+			tiny::lookaside_new<T>(lookaside, tiny::forward<Args>(args)...),
+			lookaside_delete<T>(lookaside));
+	}
+
+	//
+	// shared_ptr
+	//
+
+	class _shared_count_base {
+	public:
+		_shared_count_base& operator=(const _shared_count_base&) = delete;
+		_shared_count_base(const _shared_count_base&) = delete;
+
+		void incref() noexcept {
+			InterlockedIncrement(&_uses);
+		}
+
+		void decref() {
+			if (InterlockedDecrement(&_uses) == 0) {
+				this->_destroy();
+				this->_deleteThis();
+			}
+		}
+
+		LONG use_count() const noexcept {
+			return _uses;
+		}
+	protected:
+		_shared_count_base() noexcept
+			: _uses(1) {
+		}
+
+		~_shared_count_base() = default;
+	private:
+		volatile LONG _uses;
+
+		// destroys managed object
+		virtual void _destroy() = 0;
+		// releases control block
+		virtual void _deleteThis() = 0;
+	};
+
+	// Control block for pointers adopted by shared_ptr, allocated separately from the object.
+	template <typename T, typename D>
+	class _shared_count_ptr final : public _shared_count_base {
+	public:
+		_shared_count_ptr(T* ptr, const D& deleter)
+			: _pair(ptr, deleter) {
+		}
+	private:
+		_pointer_with_deleter<T, D> _pair;
+
+		void _destroy() override {
+			_pair.deleter()(_pair._ptr);
+		}
+
+		void _deleteThis() override {
+			delete this;
+		}
+	};
+
+	// Control block created by make_shared, the object lives in the same allocation.
+	template <typename T>
+	class _shared_count_obj final : public _shared_count_base {
+	public:
+		template <typename... Args>
+		explicit _shared_count_obj(Args&&... args) {
+			new (_storage) T(tiny::forward<Args>(args)...);
+		}
+
+		T* get() noexcept {
+			return reinterpret_cast<T*>(_storage);
+		}
+	private:
+		alignas(T) unsigned char _storage[sizeof(T)];
+
+		void _destroy() override {
+			this->get()->~T();
+		}
+
+		void _deleteThis() override {
+			delete this;
+		}
+	};
+
+	template <typename T>
+	class shared_ptr {
+	public:
+		constexpr shared_ptr() noexcept
+			: _ptr(nullptr), _rep(nullptr) {
+		}
+
+		constexpr shared_ptr(decltype(nullptr)) noexcept
+			: shared_ptr() {
+		}
+
+		explicit shared_ptr(T* ptr)
+			: shared_ptr(ptr, default_delete<T>()) {
+		}
+
+		// ptr is deleted when the control block cannot be allocated
+		template <typename D>
+		shared_ptr(T* ptr, const D& deleter)
+			: _ptr(ptr), _rep(nullptr) {
+			if (!ptr)
+				return;
+
+			auto rep = ALLOC_MEMORY(sizeof(_shared_count_ptr<T, D>));
+			if (!rep)
+			{
+				D owner(deleter);
+				owner(ptr);
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+			}
+
+			_rep = new (rep) _shared_count_ptr<T, D>(ptr, deleter);
+		}
+
+		shared_ptr(const shared_ptr& other) noexcept
+			: _ptr(other._ptr), _rep(other._rep) {
+			if (_rep)
+				_rep->incref();
+		}
+
+		template <typename U, typename = enable_if_t<is_base_of_v<T, U>>>
+		shared_ptr(const shared_ptr<U>& other) noexcept
+			: _ptr(other._ptr), _rep(other._rep) {
+			if (_rep)
+				_rep->incref();
+		}
+
+		shared_ptr(shared_ptr&& other) noexcept
+			: _ptr(tiny::exchange(other._ptr, nullptr)), _rep(tiny::exchange(other._rep, nullptr)) {
+		}
+
+		~shared_ptr() {
+			if (_rep)
+				_rep->decref();
+		}
+
+		shared_ptr& operator=(const shared_ptr& other) {
+			shared_ptr(other).swap(*this);
+			return *this;
+		}
+
+		shared_ptr& operator=(shared_ptr&& other) {
+			shared_ptr(tiny::move(other)).swap(*this);
+			return *this;
+		}
+
+		void reset() {
+			shared_ptr().swap(*this);
+		}
+
+		void reset(T* ptr) {
+			shared_ptr(ptr).swap(*this);
+		}
+
+		void swap(shared_ptr& other) noexcept {
+			tiny::swap(_ptr, other._ptr);
+			tiny::swap(_rep, other._rep);
+		}
+
+		T* get() const noexcept {
+			return _ptr;
+		}
+
+		long use_count() const noexcept {
+			return _rep ? _rep->use_count() : 0;
+		}
+
+		T& operator*() const {
+			return *_ptr;
+		}
+
+		T* operator->() const noexcept {
+			return _ptr;
+		}
+
+		explicit operator bool() const noexcept {
+			return _ptr != nullptr;
+		}
+	private:
+		template <typename U>
+		friend class shared_ptr;
+
+		template <typename U, typename... Args>
+		friend shared_ptr<U> make_shared(Args&&... args);
+
+		T* _ptr;
+		_shared_count_base* _rep;
+	};
+
+	// Allocates control block and the object with a single allocation.
+	template <typename T, typename... Args>
+	inline shared_ptr<T> make_shared(Args&&... args) {
+		auto rep = new _shared_count_obj<T>(tiny::forward<Args>(args)...);
+
+		shared_ptr<T> result;
+		result._ptr = rep->get();
+		result._rep = rep;
+		return result;
+	}
+
+	//
+	// ref_ptr
+	//
+
+	// Base for intrusively counted objects, released with delete once the last reference is gone.
+	template <typename T>
+	class ref_counted {
+	public:
+		ref_counted& operator=(const ref_counted&) = delete;
+		ref_counted(const ref_counted&) = delete;
+
+		void add_ref() const noexcept {
+			InterlockedIncrement(&_refCount);
+		}
+
+		void release() const {
+			if (InterlockedDecrement(&_refCount) == 0)
+				delete static_cast<const T*>(this);
+		}
+
+		LONG ref_count() const noexcept {
+			return _refCount;
+		}
+	protected:
+		ref_counted() noexcept
+			: _refCount(0) {
+		}
+
+		~ref_counted() = default;
+	private:
+		mutable volatile LONG _refCount;
+	};
+
+	// Pointer to an object that carries its own count through add_ref()/release().
+	template <typename T>
+	class ref_ptr {
+	public:
+		constexpr ref_ptr() noexcept
+			: _ptr(nullptr) {
+		}
+
+		constexpr ref_ptr(decltype(nullptr)) noexcept
+			: _ptr(nullptr) {
+		}
+
+		// addRef == false adopts a reference which is already owned by the caller
+		ref_ptr(T* ptr, bool addRef = true) noexcept
+			: _ptr(ptr) {
+			if (_ptr && addRef)
+				_ptr->add_ref();
+		}
+
+		ref_ptr(const ref_ptr& other) noexcept
+			: ref_ptr(other._ptr) {
+		}
+
+		ref_ptr(ref_ptr&& other) noexcept
+			: _ptr(tiny::exchange(other._ptr, nullptr)) {
+		}
+
+		~ref_ptr() {
+			if (_ptr)
+				_ptr->release();
+		}
+
+		ref_ptr& operator=(const ref_ptr& other) {
+			ref_ptr(other).swap(*this);
+			return *this;
+		}
+
+		ref_ptr& operator=(ref_ptr&& other) {
+			ref_ptr(tiny::move(other)).swap(*this);
+			return *this;
+		}
+
+		void reset(T* ptr = nullptr) {
+			ref_ptr(ptr).swap(*this);
+		}
+
+		// gives up the reference without releasing it
+		T* detach() noexcept {
+			return tiny::exchange(_ptr, nullptr);
+		}
+
+		void swap(ref_ptr& other) noexcept {
+			tiny::swap(_ptr, other._ptr);
+		}
+
+		T* get() const noexcept {
+			return _ptr;
+		}
+
+		T& operator*() const {
+			return *_ptr;
+		}
+
+		T* operator->() const noexcept {
+			return _ptr;
+		}
+
+		explicit operator bool() const noexcept {
+			return _ptr != nullptr;
+		}
+	private:
+		T* _ptr;
+	};
+
+	template <typename T, typename... Args>
+	inline ref_ptr<T> make_ref(Args&&... args) {
+		return ref_ptr<T>(new T(tiny::forward<Args>(args)...));
+	}
+}
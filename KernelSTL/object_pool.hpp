@@ -0,0 +1,391 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "memory.hpp"
+#include "mutex.hpp"
+
+// Freed slots are filled with a pattern that is checked on reuse, on by default in checked builds.
+#ifndef TINY_POOL_POISON
+#if DBG
+#define TINY_POOL_POISON 1
+#else
+#define TINY_POOL_POISON 0
+#endif
+#endif
+
+namespace tiny {
+	struct object_pool_stats {
+		size_t slots; // allocated from the system pool, in use or free
+		size_t inUse;
+		size_t highWater; // most slots in use at once since the last trim
+	};
+
+	template <typename T>
+	class object_pool;
+
+	// Returns objects acquired from an object_pool<T> to that pool.
+	template <typename T>
+	class object_pool_delete {
+	public:
+		object_pool_delete() noexcept
+			: _pool(nullptr) {
+		}
+
+		explicit object_pool_delete(object_pool<T>* pool) noexcept
+			: _pool(pool) {
+		}
+
+		void operator()(T* ptr) const {
+			_pool->release(ptr);
+		}
+	private:
+		object_pool<T>* _pool;
+	};
+
+	/*
+	* Recycles fixed size slots for objects of one type. Released slots go to the cache of the
+	* current processor and are taken from there first, so steady churn never reaches the system
+	* pool. Caches overflow into and refill from a shared free list in batches. Slots are only
+	* returned to the system by trim() and the destructor. Usable up to DISPATCH_LEVEL.
+	*/
+	template <typename T>
+	class object_pool {
+	public:
+		using handle = unique_ptr<T, object_pool_delete<T>>;
+
+		object_pool& operator=(const object_pool&) = delete;
+		object_pool(const object_pool&) = delete;
+
+		// minimumCount slots are allocated up front and never trimmed
+		explicit object_pool(size_t minimumCount = 0, size_t cacheSize = 64);
+
+		// every handle has to be released before
+		~object_pool();
+
+		template <typename... Args>
+		handle acquire(Args&&... args);
+
+		// destroys the object and keeps its slot
+		void release(T* object) noexcept;
+
+		// Frees the free slots the pool holds beyond its high-water mark and starts a new
+		// measurement, returns the number of slots freed.
+		size_t trim();
+
+		object_pool_stats stats() const noexcept;
+	private:
+		static_assert(alignof(T) <= MEMORY_ALLOCATION_ALIGNMENT, "object_pool slots are only pool aligned");
+
+		struct _slot {
+			_slot* next;
+		};
+
+		// padded so neighbouring processors do not share a cache line
+		struct _cache {
+			tiny::spin_lock lock;
+			_slot* head;
+			size_t count;
+			char padding[64];
+		};
+
+		static constexpr size_t _slotSize = sizeof(T) > sizeof(_slot) ? sizeof(T) : sizeof(_slot);
+		static constexpr unsigned char _poisonByte = 0xDD;
+
+		_cache* _caches;
+		ULONG _cacheCount;
+		size_t _cacheSize;
+		size_t _minimumCount;
+
+		tiny::spin_lock _lock;
+		_slot* _free;
+
+		volatile LONG64 _slots;
+		volatile LONG64 _inUse;
+		volatile LONG64 _highWater;
+
+		_cache& _localCache() noexcept;
+		_slot* _take();
+		void _put(_slot* slot) noexcept;
+		void _flush(_cache& cache) noexcept;
+		_slot* _allocateSlot();
+
+		static void _poison(_slot* slot) noexcept;
+		static void _checkPoison(_slot* slot) noexcept;
+	};
+
+	template <typename T>
+	inline object_pool<T>::object_pool(size_t minimumCount, size_t cacheSize)
+		: _cacheSize(cacheSize ? cacheSize : 1), _minimumCount(minimumCount), _free(nullptr),
+		_slots(0), _inUse(0), _highWater(0) {
+		_cacheCount = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+		_caches = static_cast<_cache*>(ALLOC_MEMORY(_cacheCount * sizeof(_cache)));
+		if (!_caches)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		for (ULONG i = 0; i < _cacheCount; ++i)
+		{
+			auto cache = new (_caches + i) _cache();
+			cache->head = nullptr;
+			cache->count = 0;
+		}
+
+		// pre-warm the shared list, every processor draws from it
+		for (size_t i = 0; i < minimumCount; ++i)
+		{
+			auto slot = static_cast<_slot*>(ALLOC_MEMORY(_slotSize));
+			if (!slot)
+			{
+				while (_free)
+					FREE_MEMORY(tiny::exchange(_free, _free->next));
+
+				FREE_MEMORY(_caches);
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+			}
+
+			_poison(slot);
+			slot->next = _free;
+			_free = slot;
+			++_slots;
+		}
+	}
+
+	template <typename T>
+	inline object_pool<T>::~object_pool() {
+		for (ULONG i = 0; i < _cacheCount; ++i)
+		{
+			this->_flush(_caches[i]);
+			_caches[i].~_cache();
+		}
+
+		while (_free)
+			FREE_MEMORY(tiny::exchange(_free, _free->next));
+
+		FREE_MEMORY(_caches);
+	}
+
+	template <typename T>
+	template <typename... Args>
+	inline typename object_pool<T>::handle object_pool<T>::acquire(Args&&... args) {
+		auto slot = this->_take();
+		if (!slot)
+			slot = this->_allocateSlot();
+
+		auto object = new (slot) T(tiny::forward<Args>(args)...);
+
+		auto inUse = InterlockedIncrement64(&_inUse);
+		for (auto highWater = _highWater; inUse > highWater; highWater = _highWater)
+		{
+			if (InterlockedCompareExchange64(&_highWater, inUse, highWater) == highWater)
+				break;
+		}
+
+		return handle(object, object_pool_delete<T>(this));
+	}
+
+	template <typename T>
+	inline void object_pool<T>::release(T* object) noexcept {
+		object->~T();
+		InterlockedDecrement64(&_inUse);
+
+		this->_put(reinterpret_cast<_slot*>(object));
+	}
+
+	template <typename T>
+	inline size_t object_pool<T>::trim() {
+		for (ULONG i = 0; i < _cacheCount; ++i)
+			this->_flush(_caches[i]);
+
+		_slot* unlinked = nullptr;
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+			auto keep = static_cast<LONG64>(_minimumCount > static_cast<size_t>(_highWater) ? _minimumCount : _highWater);
+			while (_free && _slots > keep)
+			{
+				auto slot = _free;
+				_free = slot->next;
+				InterlockedDecrement64(&_slots);
+
+				slot->next = unlinked;
+				unlinked = slot;
+			}
+
+			InterlockedExchange64(&_highWater, _inUse);
+		}
+
+		size_t freed = 0;
+		while (unlinked)
+		{
+			FREE_MEMORY(tiny::exchange(unlinked, unlinked->next));
+			++freed;
+		}
+
+		return freed;
+	}
+
+	template <typename T>
+	inline object_pool_stats object_pool<T>::stats() const noexcept {
+		object_pool_stats result;
+		result.slots = static_cast<size_t>(_slots);
+		result.inUse = static_cast<size_t>(_inUse);
+		result.highWater = static_cast<size_t>(_highWater);
+
+		return result;
+	}
+
+	//
+	// private
+	//
+
+	template <typename T>
+	inline typename object_pool<T>::_cache& object_pool<T>::_localCache() noexcept {
+		return _caches[KeGetCurrentProcessorNumberEx(nullptr) % _cacheCount];
+	}
+
+	// Pops a free slot, refilling the local cache from the shared list when it is empty.
+	template <typename T>
+	inline typename object_pool<T>::_slot* object_pool<T>::_take() {
+		auto& cache = this->_localCache();
+		_slot* slot = nullptr;
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(cache.lock);
+			if (cache.head)
+			{
+				slot = cache.head;
+				cache.head = slot->next;
+				--cache.count;
+			}
+		}
+
+		if (!slot)
+		{
+			_slot* batch = nullptr;
+			size_t batchCount = 0;
+
+			{
+				tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+				while (_free && batchCount < _cacheSize / 2 + 1)
+				{
+					auto next = _free->next;
+					_free->next = batch;
+					batch = _free;
+					_free = next;
+					++batchCount;
+				}
+			}
+
+			if (!batch)
+				return nullptr;
+
+			slot = batch;
+			batch = batch->next;
+
+			if (batch)
+			{
+				auto tail = batch;
+				while (tail->next)
+					tail = tail->next;
+
+				tiny::scoped_lock<tiny::spin_lock> lock(cache.lock);
+				tail->next = cache.head;
+				cache.head = batch;
+				cache.count += batchCount - 1;
+			}
+		}
+
+		_checkPoison(slot);
+		return slot;
+	}
+
+	// Pushes a slot to the local cache, half of a full cache moves to the shared list.
+	template <typename T>
+	inline void object_pool<T>::_put(_slot* slot) noexcept {
+		_poison(slot);
+
+		auto& cache = this->_localCache();
+		_slot* spill = nullptr;
+		_slot* spillTail = nullptr;
+		size_t spillCount = 0;
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(cache.lock);
+			slot->next = cache.head;
+			cache.head = slot;
+
+			if (++cache.count > _cacheSize)
+			{
+				spillCount = cache.count / 2;
+				spill = cache.head;
+				spillTail = spill;
+
+				for (size_t i = 1; i < spillCount; ++i)
+					spillTail = spillTail->next;
+
+				cache.head = spillTail->next;
+				cache.count -= spillCount;
+			}
+		}
+
+		if (spill)
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+			spillTail->next = _free;
+			_free = spill;
+		}
+	}
+
+	template <typename T>
+	inline void object_pool<T>::_flush(_cache& cache) noexcept {
+		_slot* head;
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(cache.lock);
+			head = tiny::exchange(cache.head, nullptr);
+			cache.count = 0;
+		}
+
+		if (!head)
+			return;
+
+		auto tail = head;
+		while (tail->next)
+			tail = tail->next;
+
+		tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+		tail->next = _free;
+		_free = head;
+	}
+
+	template <typename T>
+	inline typename object_pool<T>::_slot* object_pool<T>::_allocateSlot() {
+		auto slot = static_cast<_slot*>(ALLOC_MEMORY(_slotSize));
+		if (!slot)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		InterlockedIncrement64(&_slots);
+		return slot;
+	}
+
+	template <typename T>
+	inline void object_pool<T>::_poison(_slot* slot) noexcept {
+#if TINY_POOL_POISON
+		memset(slot, _poisonByte, _slotSize);
+#else
+		UNREFERENCED_PARAMETER(slot);
+#endif
+	}
+
+	// everything past the free list link has to still hold the pattern
+	template <typename T>
+	inline void object_pool<T>::_checkPoison(_slot* slot) noexcept {
+#if TINY_POOL_POISON
+		auto bytes = reinterpret_cast<const unsigned char*>(slot);
+		for (auto i = sizeof(_slot); i < _slotSize; ++i)
+			NT_ASSERTMSG("object_pool slot was written after release", bytes[i] == _poisonByte);
+#else
+		UNREFERENCED_PARAMETER(slot);
+#endif
+	}
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "string.hpp"
+#include "string_view.hpp"
+
+namespace tiny {
+	inline wchar_t _path_upcase(wchar_t c) noexcept {
+		if (c < 0x80)
+			return c >= L'a' && c <= L'z' ? static_cast<wchar_t>(c - (L'a' - L'A')) : c;
+
+		return RtlUpcaseUnicodeChar(c);
+	}
+
+	inline bool _path_equals_upcased(wstring_view text, wstring_view upcased) noexcept {
+		if (text.size() != upcased.size())
+			return false;
+
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (_path_upcase(text[i]) != upcased[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	/*
+	* Volume IDs by device name, e.g. \Device\HarddiskVolume3 mapped to the ID the caller keeps
+	* for that volume. Filled when volumes arrive, normalize_path() then replaces a known device
+	* prefix with the ID. Names compare case-insensitively. Not synchronized, share it read-only
+	* or behind the lock of its owner.
+	*/
+	class volume_map {
+	public:
+		size_t size() const noexcept {
+			return _entries.size();
+		}
+
+		// id must not be 0, an existing device gets the new id
+		void set(wstring_view device, ULONG id);
+
+		bool erase(wstring_view device) noexcept;
+
+		// 0 for an unknown device
+		ULONG find(wstring_view device) const noexcept;
+	private:
+		struct _entry {
+			tiny::wstring device; // upcased
+			ULONG id;
+		};
+
+		tiny::vector<_entry> _entries;
+
+		size_t _indexOf(wstring_view device) const noexcept;
+	};
+
+	inline void volume_map::set(wstring_view device, ULONG id) {
+		auto index = this->_indexOf(device);
+		if (index != _entries.size())
+		{
+			_entries[index].id = id;
+			return;
+		}
+
+		tiny::wstring upcased;
+		upcased.resize_for_overwrite(device.size());
+		for (size_t i = 0; i < device.size(); ++i)
+			upcased.begin()[i] = _path_upcase(device[i]);
+
+		_entries.push_back(_entry{ tiny::move(upcased), id });
+	}
+
+	inline bool volume_map::erase(wstring_view device) noexcept {
+		auto index = this->_indexOf(device);
+		if (index == _entries.size())
+			return false;
+
+		_entries.erase(index);
+		return true;
+	}
+
+	inline ULONG volume_map::find(wstring_view device) const noexcept {
+		auto index = this->_indexOf(device);
+		return index != _entries.size() ? _entries[index].id : 0;
+	}
+
+	inline size_t volume_map::_indexOf(wstring_view device) const noexcept {
+		for (size_t index = 0; index < _entries.size(); ++index)
+		{
+			if (_path_equals_upcased(device, _entries[index].device.view()))
+				return index;
+		}
+
+		return _entries.size();
+	}
+
+	//
+	// normalization
+	//
+
+	// Copies and upcases one component up to the next separator, returns the read position
+	// after it. w never passes r, so the copy can run in place.
+	inline size_t _path_copy_component(wchar_t* path, size_t size, size_t r, size_t& w) noexcept {
+#ifdef TINY_SSE2
+		// eight ASCII characters without a separator at a time
+		auto separator = _mm_set1_epi16(L'\\');
+		auto nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+		auto beforeLower = _mm_set1_epi16(L'a' - 1);
+		auto afterLower = _mm_set1_epi16(L'z' + 1);
+		auto caseBit = _mm_set1_epi16(L'a' - L'A');
+
+		while (r + 8 <= size)
+		{
+			auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(path + r));
+			auto stop = _mm_or_si128(_mm_cmpeq_epi16(chunk, separator),
+				_mm_cmpeq_epi16(_mm_cmpeq_epi16(_mm_and_si128(chunk, nonAscii), _mm_setzero_si128()), _mm_setzero_si128()));
+			if (_mm_movemask_epi8(stop))
+				break;
+
+			auto lower = _mm_and_si128(_mm_cmpgt_epi16(chunk, beforeLower), _mm_cmplt_epi16(chunk, afterLower));
+			chunk = _mm_sub_epi16(chunk, _mm_and_si128(lower, caseBit));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(path + w), chunk);
+
+			r += 8;
+			w += 8;
+		}
+#endif
+
+		for (; r < size && path[r] != L'\\'; ++r)
+			path[w++] = _path_upcase(path[r]);
+
+		return r;
+	}
+
+	/*
+	* Normalizes an NT path in one pass over its size characters, in place, and returns the new
+	* size. \DosDevices\ and \GLOBAL??\ become \??\, runs of separators collapse, . components
+	* are removed and .. removes the component before it but never the root: the drive or UNC
+	* server and share after \??\, or the device after \Device\. Trailing separators are trimmed
+	* and the path is upcased the way the object manager compares names. When volumes maps the
+	* \Device\<name> prefix, it is removed, the rest is relative to the volume root \ and volume
+	* receives the ID, else 0.
+	*/
+	inline size_t normalize_path(wchar_t* path, size_t size, const volume_map* volumes = nullptr, ULONG* volume = nullptr) noexcept {
+		if (volume)
+			*volume = 0;
+
+		auto absolute = size && path[0] == L'\\';
+		size_t r = 0;
+		size_t w = 0;
+		size_t root = 0; // .. stops here
+		ULONG rootComponents = 0; // components still to come that belong to the root
+		bool dosDevices = false;
+		bool device = false;
+
+		while (r < size)
+		{
+			if (path[r] == L'\\')
+			{
+				++r;
+				continue;
+			}
+
+			auto rest = size - r;
+			if (path[r] == L'.' && (rest == 1 || path[r + 1] == L'\\'))
+			{
+				++r;
+				continue;
+			}
+
+			if (path[r] == L'.' && rest >= 2 && path[r + 1] == L'.' && (rest == 2 || path[r + 2] == L'\\'))
+			{
+				r += 2;
+				if (rootComponents)
+					continue;
+
+				if (w > root)
+				{
+					while (--w > root && path[w] != L'\\')
+						;
+
+					continue;
+				}
+
+				// a relative path keeps the .. it cannot resolve
+				if (!absolute)
+				{
+					if (w)
+						path[w++] = L'\\';
+
+					path[w++] = L'.';
+					path[w++] = L'.';
+					root = w;
+				}
+
+				continue;
+			}
+
+			if (w || absolute)
+				path[w++] = L'\\';
+
+			auto start = w;
+			r = _path_copy_component(path, size, r, w);
+
+			// the first component says what the root is
+			if (start == 1 && absolute && !dosDevices && !device)
+			{
+				auto first = wstring_view(path + start, w - start);
+				if (first == L"??" || first == L"DOSDEVICES" || first == L"GLOBAL??")
+				{
+					path[1] = L'?';
+					path[2] = L'?';
+					w = root = 3;
+					dosDevices = true;
+					rootComponents = 1;
+					continue;
+				}
+
+				if (first == L"DEVICE")
+				{
+					device = true;
+					rootComponents = 1;
+					continue;
+				}
+			}
+
+			if (dosDevices && rootComponents == 1 && start == 4 && wstring_view(path + start, w - start) == L"UNC")
+				rootComponents = 3;
+
+			if (rootComponents && !--rootComponents)
+			{
+				root = w;
+
+				auto id = device && volumes ? volumes->find(wstring_view(path, w)) : 0;
+				if (id)
+				{
+					if (volume)
+						*volume = id;
+
+					w = root = 0;
+				}
+			}
+		}
+
+		if (!w && absolute)
+			path[w++] = L'\\';
+
+		return w;
+	}
+
+	inline void normalize_path(tiny::wstring& path) {
+		path.resize(normalize_path(path.begin(), path.size()));
+	}
+
+	// returns the volume ID the path is now relative to, 0 when its device is not mapped
+	inline ULONG normalize_path(tiny::wstring& path, const volume_map& volumes) {
+		ULONG volume;
+		path.resize(normalize_path(path.begin(), path.size(), &volumes, &volume));
+		return volume;
+	}
+
+	//
+	// components
+	//
+
+	class _path_component_iterator {
+	public:
+		_path_component_iterator(const wchar_t* position, const wchar_t* end) noexcept
+			: _position(position), _end(end), _size(0) {
+			this->_skip();
+		}
+
+		wstring_view operator*() const noexcept {
+			return wstring_view(_position, _size);
+		}
+
+		_path_component_iterator& operator++() noexcept {
+			_position += _size;
+			this->_skip();
+			return *this;
+		}
+
+		bool operator==(const _path_component_iterator& other) const noexcept {
+			return _position == other._position;
+		}
+
+		bool operator!=(const _path_component_iterator& other) const noexcept {
+			return _position != other._position;
+		}
+	private:
+		const wchar_t* _position;
+		const wchar_t* _end;
+		size_t _size;
+
+		void _skip() noexcept {
+			while (_position != _end && *_position == L'\\')
+				++_position;
+
+			auto next = _position;
+			while (next != _end && *next != L'\\')
+				++next;
+
+			_size = next - _position;
+		}
+	};
+
+	// The components of a path as views into it, without copying. Separators are skipped, so
+	// \??\C:\Windows yields ??, C: and Windows.
+	class path_components {
+	public:
+		using iterator = _path_component_iterator;
+
+		explicit path_components(wstring_view path) noexcept
+			: _path(path) {
+		}
+
+		iterator begin() const noexcept {
+			return iterator(_path.begin(), _path.end());
+		}
+
+		iterator end() const noexcept {
+			return iterator(_path.end(), _path.end());
+		}
+	private:
+		wstring_view _path;
+	};
+}
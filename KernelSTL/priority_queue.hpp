@@ -0,0 +1,205 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "algorithm.hpp"
+
+namespace tiny {
+	/*
+	* Heap on a tiny::vector where every node has Arity children, so it is shallower than a
+	* binary heap and a sift touches fewer cache lines. Like std::priority_queue the top is the
+	* largest element by Compare, tiny::greater makes it the smallest, e.g. the next deadline.
+	* push() returns a handle through which the element can be updated (decrease-key and its
+	* opposite) or erased in O(log n), a handle is valid until its element leaves the queue.
+	*/
+	template <typename T, typename Compare = tiny::less, size_t Arity = 4>
+	class priority_queue {
+	public:
+		static_assert(Arity >= 2, "a heap node needs at least two children");
+
+		using handle = size_t;
+
+		explicit priority_queue(const Compare& comp = Compare())
+			: _comp(comp), _freeHandle(_noHandle) {
+		}
+
+		constexpr bool empty() const noexcept {
+			return _heap.empty();
+		}
+
+		constexpr size_t size() const noexcept {
+			return _heap.size();
+		}
+
+		const T& top() const {
+			return _heap[0].value;
+		}
+
+		handle top_handle() const {
+			return _heap[0].id;
+		}
+
+		const T& get(handle h) const {
+			return _heap[_positions[h]].value;
+		}
+
+		void reserve(size_t count) {
+			_heap.reserve(count);
+			_positions.reserve(count);
+		}
+
+		handle push(const T& value) {
+			return this->_push(T(value));
+		}
+
+		handle push(T&& value) {
+			return this->_push(tiny::move(value));
+		}
+
+		void pop() {
+			this->_remove(0);
+		}
+
+		// Replaces the element and restores the heap order in whichever direction it moved.
+		void update(handle h, const T& value);
+
+		void erase(handle h) {
+			this->_remove(_positions[h]);
+		}
+
+		// invalidates every handle
+		void clear() noexcept {
+			_heap.clear();
+			_positions.clear();
+			_freeHandle = _noHandle;
+		}
+	private:
+		static constexpr size_t _noHandle = static_cast<size_t>(-1);
+
+		struct _entry {
+			T value;
+			handle id;
+		};
+
+		Compare _comp;
+		tiny::vector<_entry> _heap;
+		tiny::vector<size_t> _positions; // heap index by handle, for free handles the next free one
+		size_t _freeHandle;
+
+		handle _push(T&& value);
+		void _remove(size_t index);
+		void _siftUp(size_t index);
+		void _siftDown(size_t index);
+
+		void _place(size_t index, _entry&& entry) {
+			_positions[entry.id] = index;
+			_heap[index] = tiny::move(entry);
+		}
+	};
+
+	template <typename T, typename Compare, size_t Arity>
+	inline void priority_queue<T, Compare, Arity>::update(handle h, const T& value) {
+		auto index = _positions[h];
+		auto raised = _comp(_heap[index].value, value);
+
+		_heap[index].value = value;
+		if (raised)
+			this->_siftUp(index);
+		else
+			this->_siftDown(index);
+	}
+
+	//
+	// private
+	//
+
+	template <typename T, typename Compare, size_t Arity>
+	inline typename priority_queue<T, Compare, Arity>::handle priority_queue<T, Compare, Arity>::_push(T&& value) {
+		handle h;
+		if (_freeHandle != _noHandle)
+		{
+			h = _freeHandle;
+			_freeHandle = _positions[h];
+		}
+		else
+		{
+			h = _positions.size();
+			_positions.push_back(0);
+		}
+
+		_heap.push_back(_entry{ tiny::move(value), h });
+		_positions[h] = _heap.size() - 1;
+		this->_siftUp(_heap.size() - 1);
+
+		return h;
+	}
+
+	template <typename T, typename Compare, size_t Arity>
+	inline void priority_queue<T, Compare, Arity>::_remove(size_t index) {
+		auto h = _heap[index].id;
+		auto last = _heap.size() - 1;
+
+		if (index != last)
+		{
+			// the last element fills the hole and moves whichever way it belongs
+			auto raised = _comp(_heap[index].value, _heap[last].value);
+			this->_place(index, tiny::move(_heap[last]));
+			_heap.pop_back();
+
+			if (raised)
+				this->_siftUp(index);
+			else
+				this->_siftDown(index);
+		}
+		else
+			_heap.pop_back();
+
+		_positions[h] = _freeHandle;
+		_freeHandle = h;
+	}
+
+	template <typename T, typename Compare, size_t Arity>
+	inline void priority_queue<T, Compare, Arity>::_siftUp(size_t index) {
+		if (!index)
+			return;
+
+		auto entry = tiny::move(_heap[index]);
+		while (index)
+		{
+			auto parent = (index - 1) / Arity;
+			if (!_comp(_heap[parent].value, entry.value))
+				break;
+
+			this->_place(index, tiny::move(_heap[parent]));
+			index = parent;
+		}
+
+		this->_place(index, tiny::move(entry));
+	}
+
+	template <typename T, typename Compare, size_t Arity>
+	inline void priority_queue<T, Compare, Arity>::_siftDown(size_t index) {
+		auto size = _heap.size();
+		auto entry = tiny::move(_heap[index]);
+
+		for (auto first = index * Arity + 1; first < size; first = index * Arity + 1)
+		{
+			auto best = first;
+			auto end = first + Arity < size ? first + Arity : size;
+			for (auto child = first + 1; child < end; ++child)
+			{
+				if (_comp(_heap[best].value, _heap[child].value))
+					best = child;
+			}
+
+			if (!_comp(entry.value, _heap[best].value))
+				break;
+
+			this->_place(index, tiny::move(_heap[best]));
+			index = best;
+		}
+
+		this->_place(index, tiny::move(entry));
+	}
+}
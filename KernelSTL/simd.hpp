@@ -0,0 +1,8 @@
+#pragma once
+
+// SSE2 is part of x64, so the vector paths need no CPU check. No kernel dependencies, host
+// tools include it as well.
+#if defined(_M_AMD64) || defined(__x86_64__)
+#include <emmintrin.h>
+#define TINY_SSE2 1
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "common.hpp"
+
+// Hot path instrumentation through the timer, histogram and trace macros, define as 0 to compile
+// it out. Histograms declared with TINY_HISTOGRAM then allocate nothing either.
+#ifndef TINY_INSTRUMENTATION
+#define TINY_INSTRUMENTATION 1
+#endif
+
+namespace tiny {
+	// Elapsed nanoseconds between two performance counter readings, without overflow.
+	inline ULONG64 _ticks_to_nanoseconds(ULONG64 ticks, ULONG64 frequency) noexcept {
+		return ticks / frequency * 1000000000ull + ticks % frequency * 1000000000ull / frequency;
+	}
+
+	/*
+	* Measures wall time with the performance counter, which Windows backs by the invariant TSC
+	* where there is one. Resolution is the counter frequency, 100ns on most systems.
+	*/
+	class stopwatch {
+	public:
+		stopwatch() noexcept
+			: _start(KeQueryPerformanceCounter(nullptr).QuadPart) {
+		}
+
+		void restart() noexcept {
+			_start = KeQueryPerformanceCounter(nullptr).QuadPart;
+		}
+
+		ULONG64 elapsed_ticks() const noexcept {
+			return static_cast<ULONG64>(KeQueryPerformanceCounter(nullptr).QuadPart - _start);
+		}
+
+		ULONG64 elapsed_nanoseconds() const noexcept {
+			LARGE_INTEGER frequency;
+			auto now = KeQueryPerformanceCounter(&frequency).QuadPart;
+
+			return _ticks_to_nanoseconds(static_cast<ULONG64>(now - _start), static_cast<ULONG64>(frequency.QuadPart));
+		}
+
+		// what scoped timers record
+		ULONG64 elapsed() const noexcept {
+			return this->elapsed_nanoseconds();
+		}
+	private:
+		LONGLONG _start;
+	};
+
+	/*
+	* Counts TSC cycles, for operations shorter than the performance counter resolves. Cycles
+	* are not converted to time, the TSC frequency is not known without calibration. Readings
+	* from different processors are only comparable on systems with a synchronized TSC.
+	*/
+	class cycle_stopwatch {
+	public:
+		cycle_stopwatch() noexcept
+			: _start(ReadTimeStampCounter()) {
+		}
+
+		void restart() noexcept {
+			_start = ReadTimeStampCounter();
+		}
+
+		ULONG64 elapsed_cycles() const noexcept {
+			return ReadTimeStampCounter() - _start;
+		}
+
+		ULONG64 elapsed() const noexcept {
+			return this->elapsed_cycles();
+		}
+	private:
+		ULONG64 _start;
+	};
+}
@@ -1,294 +1,577 @@
-#pragma once
-
-#include "vector.hpp"
-
-namespace tiny {
-	template <typename T>
-	class basic_string {
-	public:
-		inline static const size_t npos = static_cast<size_t>(-1);
-
-		void assign(size_t count, const T& value);
-
-		constexpr const T* data() const noexcept;
-		constexpr const T& back() const;
-		constexpr const T& front() const;
-
-		constexpr T* begin() const noexcept;
-		constexpr T* end() const;
-
-		constexpr bool empty() const noexcept;
-		constexpr size_t size() const noexcept;
-		constexpr size_t capacity() const noexcept;
-		constexpr size_t max_size() const noexcept;
-
-		int compare(const basic_string& other) const noexcept;
-
-		size_t find(const basic_string& other, size_t pos = 0) const noexcept;
-		size_t find(const T* str, size_t pos = 0) const noexcept;
-		size_t find(char c, size_t pos = 0) const noexcept;
-
-		void resize(size_t count);
-		void reserve(size_t count);
-		void erase(size_t pos);
-		void erase(size_t first, size_t last);
-		void clear() noexcept;
-		void shrink_to_fit();
-
-		constexpr T& at(size_t pos) const;
-
-		constexpr void insert(size_t pos, const T& value);
-		constexpr void push_back(const T& value);
-		constexpr void pop_back();
-
-		constexpr const T& operator [](size_t idx) const {
-			return _vector[idx - 1];
-		}
-
-		T& operator [](size_t idx) {
-			return _vector[idx - 1];
-		}
-
-		basic_string& operator=(const basic_string& other) {
-			this->_vector = other._vector;
-			return *this;
-		};
-
-		basic_string& operator=(const T* str) {
-			size_t otherSize = _getTSize(str);
-
-			this->resize(otherSize);
-			memcpy(this->begin(), str, otherSize * sizeof(T));
-			_vector[otherSize] = 0;
-
-			return *this;
-		};
-	protected:
-		basic_string();
-		basic_string(size_t count);
-
-		basic_string(const T* other) {
-			operator=(other);
-		};
-
-		basic_string(const basic_string& other) {
-			operator=(other);
-		};
-
-	private:
-		tiny::vector<T> _vector;
-
-		size_t _getTSize(const T* str) const noexcept;
-		int _compareTStr(const T* str1, const T* str2) const noexcept;
-		int _ncompareTStr(const T* str1, const T* str2, size_t n) const noexcept;
-	};
-
-	template <typename T>
-	inline basic_string<T>::basic_string()
-		: basic_string((size_t)0) {
-	}
-
-	template <typename T>
-	inline basic_string<T>::basic_string(size_t count) {
-		this->resize(count);
-	}
-
-	template <typename T>
-	inline void basic_string<T>::assign(size_t count, const T& value) {
-		_vector.assign(count + 1, value);
-		_vector[count] = 0;
-	}
-
-	template <typename T>
-	inline constexpr const T* basic_string<T>::data() const noexcept {
-		return _vector.data();
-	}
-
-	template <typename T>
-	inline constexpr const T& basic_string<T>::back() const {
-		return _vector[this->size() - 1];
-	}
-
-	template <typename T>
-	inline constexpr const T& basic_string<T>::front() const {
-		return _vector[this->size()];
-	}
-
-	template <typename T>
-	inline constexpr T* basic_string<T>::begin() const noexcept {
-		return _vector.begin();
-	}
-
-	template <typename T>
-	inline constexpr T* basic_string<T>::end() const {
-		return this->begin() + this->size();
-	}
-
-	template <typename T>
-	inline constexpr bool basic_string<T>::empty() const noexcept {
-		return this->size() == 0;
-	}
-
-	template <typename T>
-	inline constexpr size_t basic_string<T>::size() const noexcept {
-		return _vector.size() - 1; // remove terminatrion character
-	}
-
-	template <typename T>
-	inline constexpr size_t basic_string<T>::capacity() const noexcept {
-		return _vector.capacity() - 1;
-	}
-
-	template <typename T>
-	inline constexpr size_t basic_string<T>::max_size() const noexcept {
-		return _vector.max_size();
-	}
-
-	template <typename T>
-	inline int basic_string<T>::compare(const basic_string& other) const noexcept {
-		return this->_compareTStr(this->begin(), other.begin());
-	}
-	template <typename T>
-	inline size_t basic_string<T>::find(const basic_string& other, size_t pos) const noexcept {
-		return this->find(other.begin(), pos);
-	}
-
-	template <typename T>
-	inline size_t basic_string<T>::find(const T* str, size_t pos) const noexcept {
-		auto strSize = this->_getTSize(str);
-		for (size_t i = pos; i < this->size(); i++)
-		{
-			if (!this->_ncompareTStr(this->begin() + i, str, strSize))
-				return i;
-		}
-
-		return basic_string::npos;
-	}
-
-	template <typename T>
-	inline size_t basic_string<T>::find(char c, size_t pos) const noexcept {
-		for (size_t i = pos; i < this->size(); i++)
-		{
-			if (_vector[i] && _vector[i] == c)
-				return i;
-		}
-
-		return basic_string::npos;
-	}
-
-	template <typename T>
-	inline void basic_string<T>::resize(size_t count) {
-		_vector.resize(count + 1);
-		_vector[count] = 0;
-	}
-
-	template <typename T>
-	inline void basic_string<T>::reserve(size_t count) {
-		_vector.reserve(count + 1);
-	}
-
-	template <typename T>
-	inline void basic_string<T>::erase(size_t pos) {
-		_vector.erase(pos);
-	}
-
-	template <typename T>
-	inline void basic_string<T>::erase(size_t first, size_t last) {
-		_vector.erase(first, last);
-	}
-
-	template <typename T>
-	inline void basic_string<T>::clear() noexcept {
-		this->resize(0);
-	}
-
-	template <typename T>
-	inline void basic_string<T>::shrink_to_fit() {
-		_vector.shrink_to_fit();
-	}
-
-	template <typename T>
-	inline constexpr T& basic_string<T>::at(size_t pos) const {
-		_vector.at(pos - 1);
-	}
-
-	template <typename T>
-	inline constexpr void basic_string<T>::insert(size_t pos, const T& value) {
-		_vector.insert(pos - 1, value);
-	}
-
-	template <typename T>
-	inline constexpr void basic_string<T>::push_back(const T& value) {
-		_vector[this->size()] = value;
-		_vector.push_back(0);
-	}
-
-	template <typename T>
-	inline constexpr void basic_string<T>::pop_back() {
-		this->resize(this->size() - 1);
-	}
-
-	//
-	// private 
-	//
-
-	template <typename T>
-	inline size_t basic_string<T>::_getTSize(const T* str) const noexcept {
-		size_t strSize = 0;
-		while (str[strSize])
-			++strSize;
-
-		return strSize;
-	}
-
-	template <typename T>
-	inline int basic_string<T>::_compareTStr(const T* str1, const T* str2) const noexcept {
-		while (*str1 && (*str1 == *str2))
-		{
-			++str1;
-			++str2;
-		}
-
-		if (*str1 == *str2)
-			return 0;
-
-		return *str1 < *str2 ? -1 : 1;
-	}
-
-	template <typename T>
-	inline int basic_string<T>::_ncompareTStr(const T* str1, const T* str2, size_t n) const noexcept {
-		while (*str1 && (*str1 == *str2))
-		{
-			++str1;
-			++str2;
-
-			if (!--n)
-				return 0;
-		}
-
-		if (*str1 == *str2)
-			return 0;
-
-		return *str1 < *str2 ? -1 : 1;
-	}
-
-	//
-	//
-	//
-
-	class string : public basic_string<char> {
-	public:
-		inline string() = default;
-		inline string(size_t count) : basic_string(count) {};
-		inline string(const char* other) : basic_string(other) {};
-		inline string(const string& other) : basic_string(other) {};
-	};
-
-	class wstring : public basic_string<wchar_t> {
-	public:
-		inline wstring() = default;
-		inline wstring(size_t count) : basic_string(count) {};
-		inline wstring(const wchar_t* other) : basic_string(other) {};
-		inline wstring(const wstring& other) : basic_string(other) {};
-	};
+#pragma once
+
+#include "vector.hpp"
+#include "string_view.hpp"
+#include "utility.hpp"
+
+namespace tiny {
+	template <typename T>
+	class basic_string {
+	public:
+		using value_type = T;
+
+		inline static const size_t npos = static_cast<size_t>(-1);
+
+		void assign(size_t count, const T& value);
+
+		constexpr const T* data() const noexcept;
+		constexpr const T& back() const;
+		constexpr const T& front() const;
+
+		constexpr T* begin() const noexcept;
+		constexpr T* end() const;
+
+		constexpr bool empty() const noexcept;
+		constexpr size_t size() const noexcept;
+		constexpr size_t capacity() const noexcept;
+		constexpr size_t max_size() const noexcept;
+
+		int compare(const basic_string& other) const noexcept;
+
+		bool operator==(const basic_string& other) const noexcept {
+			return this->view() == other.view();
+		}
+
+		bool operator!=(const basic_string& other) const noexcept {
+			return this->view() != other.view();
+		}
+
+		size_t find(const basic_string& other, size_t pos = 0) const noexcept;
+		size_t find(const T* str, size_t pos = 0) const noexcept;
+		size_t find(basic_string_view<T> str, size_t pos = 0) const noexcept;
+		size_t find(char c, size_t pos = 0) const noexcept;
+
+		void resize(size_t count);
+		// new characters are left uninitialized, for callers that write all of them
+		void resize_for_overwrite(size_t count);
+		void reserve(size_t count);
+		void erase(size_t pos);
+		void erase(size_t first, size_t last);
+		void clear() noexcept;
+		void shrink_to_fit();
+
+		constexpr T& at(size_t pos) const;
+
+		constexpr void insert(size_t pos, const T& value);
+		constexpr void push_back(const T& value);
+		constexpr void pop_back();
+
+		basic_string& append(const T* str, size_t count);
+		basic_string& append(basic_string_view<T> str);
+
+		constexpr basic_string_view<T> view() const noexcept {
+			return basic_string_view<T>(this->data(), this->size());
+		}
+
+		constexpr operator basic_string_view<T>() const noexcept {
+			return this->view();
+		}
+
+		basic_string& operator+=(const T& value) {
+			this->push_back(value);
+			return *this;
+		}
+
+		basic_string& operator+=(const T* str) {
+			return this->append(basic_string_view<T>(str));
+		}
+
+		basic_string& operator+=(const basic_string& other) {
+			return this->append(other.view());
+		}
+
+		basic_string& operator+=(basic_string_view<T> str) {
+			return this->append(str);
+		}
+
+		constexpr const T& operator [](size_t idx) const {
+			return _vector[idx - 1];
+		}
+
+		T& operator [](size_t idx) {
+			return _vector[idx - 1];
+		}
+
+		basic_string& operator=(const basic_string& other) {
+			this->_vector = other._vector;
+			return *this;
+		};
+
+		basic_string& operator=(basic_string&& other) noexcept {
+			this->_vector = tiny::move(other._vector);
+			return *this;
+		};
+
+		basic_string& operator=(const T* str) {
+			size_t otherSize = _getTSize(str);
+
+			this->resize(otherSize);
+			memcpy(this->begin(), str, otherSize * sizeof(T));
+			_vector[otherSize] = 0;
+
+			return *this;
+		};
+	protected:
+		basic_string();
+		basic_string(size_t count);
+
+		basic_string(const T* other) {
+			operator=(other);
+		};
+
+		basic_string(const basic_string& other) {
+			operator=(other);
+		};
+
+		basic_string(basic_string&& other) noexcept
+			: _vector(tiny::move(other._vector)) {
+		};
+
+	private:
+		tiny::vector<T> _vector;
+
+		void _growFor(size_t count);
+		size_t _getTSize(const T* str) const noexcept;
+	protected:
+		template <typename NtString>
+		NTSTATUS _releaseTo(NtString& ntString) noexcept;
+
+		template <typename NtString>
+		NTSTATUS _adopt(NtString& ntString);
+
+		template <typename NtString>
+		NTSTATUS _ntString(NtString& ntString) const noexcept;
+	};
+
+	template <typename T>
+	inline basic_string<T>::basic_string()
+		: basic_string((size_t)0) {
+	}
+
+	template <typename T>
+	inline basic_string<T>::basic_string(size_t count) {
+		this->resize(count);
+	}
+
+	template <typename T>
+	inline void basic_string<T>::assign(size_t count, const T& value) {
+		_vector.assign(count + 1, value);
+		_vector[count] = 0;
+	}
+
+	template <typename T>
+	inline constexpr const T* basic_string<T>::data() const noexcept {
+		return _vector.data();
+	}
+
+	template <typename T>
+	inline constexpr const T& basic_string<T>::back() const {
+		return _vector[this->size() - 1];
+	}
+
+	template <typename T>
+	inline constexpr const T& basic_string<T>::front() const {
+		return _vector[this->size()];
+	}
+
+	template <typename T>
+	inline constexpr T* basic_string<T>::begin() const noexcept {
+		return _vector.begin();
+	}
+
+	template <typename T>
+	inline constexpr T* basic_string<T>::end() const {
+		return this->begin() + this->size();
+	}
+
+	template <typename T>
+	inline constexpr bool basic_string<T>::empty() const noexcept {
+		return this->size() == 0;
+	}
+
+	template <typename T>
+	inline constexpr size_t basic_string<T>::size() const noexcept {
+		if (_vector.empty()) // moved-from string
+			return 0;
+
+		return _vector.size() - 1; // remove terminatrion character
+	}
+
+	template <typename T>
+	inline constexpr size_t basic_string<T>::capacity() const noexcept {
+		if (!_vector.capacity()) // moved-from string
+			return 0;
+
+		return _vector.capacity() - 1;
+	}
+
+	template <typename T>
+	inline constexpr size_t basic_string<T>::max_size() const noexcept {
+		return _vector.max_size();
+	}
+
+	template <typename T>
+	inline int basic_string<T>::compare(const basic_string& other) const noexcept {
+		return this->view().compare(other.view());
+	}
+
+	template <typename T>
+	inline size_t basic_string<T>::find(const basic_string& other, size_t pos) const noexcept {
+		return this->find(other.view(), pos);
+	}
+
+	template <typename T>
+	inline size_t basic_string<T>::find(const T* str, size_t pos) const noexcept {
+		return this->find(basic_string_view<T>(str, this->_getTSize(str)), pos);
+	}
+
+	template <typename T>
+	inline size_t basic_string<T>::find(basic_string_view<T> str, size_t pos) const noexcept {
+		if (str.empty() || str.size() > this->size())
+			return basic_string::npos;
+
+		for (size_t i = pos; i <= this->size() - str.size(); i++)
+		{
+			if (!memcmp(this->begin() + i, str.data(), str.size() * sizeof(T)))
+				return i;
+		}
+
+		return basic_string::npos;
+	}
+
+	template <typename T>
+	inline size_t basic_string<T>::find(char c, size_t pos) const noexcept {
+		for (size_t i = pos; i < this->size(); i++)
+		{
+			if (_vector[i] && _vector[i] == c)
+				return i;
+		}
+
+		return basic_string::npos;
+	}
+
+	template <typename T>
+	inline void basic_string<T>::resize(size_t count) {
+		_vector.resize(count + 1);
+		_vector[count] = 0;
+	}
+
+	template <typename T>
+	inline void basic_string<T>::resize_for_overwrite(size_t count) {
+		_vector.resize_for_overwrite(count + 1);
+		_vector[count] = 0;
+	}
+
+	template <typename T>
+	inline void basic_string<T>::reserve(size_t count) {
+		_vector.reserve(count + 1);
+	}
+
+	template <typename T>
+	inline void basic_string<T>::erase(size_t pos) {
+		_vector.erase(pos);
+	}
+
+	template <typename T>
+	inline void basic_string<T>::erase(size_t first, size_t last) {
+		_vector.erase(first, last);
+	}
+
+	template <typename T>
+	inline void basic_string<T>::clear() noexcept {
+		this->resize(0);
+	}
+
+	template <typename T>
+	inline void basic_string<T>::shrink_to_fit() {
+		_vector.shrink_to_fit();
+	}
+
+	template <typename T>
+	inline constexpr T& basic_string<T>::at(size_t pos) const {
+		_vector.at(pos - 1);
+	}
+
+	template <typename T>
+	inline constexpr void basic_string<T>::insert(size_t pos, const T& value) {
+		_vector.insert(pos - 1, value);
+	}
+
+	template <typename T>
+	inline constexpr void basic_string<T>::push_back(const T& value) {
+		this->append(&value, 1);
+	}
+
+	template <typename T>
+	inline constexpr void basic_string<T>::pop_back() {
+		this->resize(this->size() - 1);
+	}
+
+	template <typename T>
+	inline basic_string<T>& basic_string<T>::append(const T* str, size_t count) {
+		if (!count)
+			return *this;
+
+		// str may point into this string, growing moves it along with the buffer
+		auto oldSize = this->size();
+		auto inside = this->begin() && str >= this->begin() && str <= this->end();
+		auto offset = inside ? str - this->begin() : 0;
+
+		this->_growFor(oldSize + count);
+		if (inside)
+			str = this->begin() + offset;
+
+		_vector.resize_for_overwrite(oldSize + count + 1);
+		memcpy(this->begin() + oldSize, str, count * sizeof(T));
+		_vector[oldSize + count] = 0;
+
+		return *this;
+	}
+
+	template <typename T>
+	inline basic_string<T>& basic_string<T>::append(basic_string_view<T> str) {
+		return this->append(str.data(), str.size());
+	}
+
+	//
+	// private 
+	//
+
+	// Grows capacity geometrically so repeated appends reallocate only O(log n) times.
+	template <typename T>
+	inline void basic_string<T>::_growFor(size_t count) {
+		if (count <= this->capacity())
+			return;
+
+		auto newCapacity = this->capacity() * 2;
+		if (newCapacity < count)
+			newCapacity = count;
+
+		this->reserve(newCapacity);
+	}
+
+	template <typename T>
+	template <typename NtString>
+	inline NTSTATUS basic_string<T>::_releaseTo(NtString& ntString) noexcept {
+		if (this->size() * sizeof(T) > MAXUSHORT)
+			return STATUS_NAME_TOO_LONG;
+
+		auto maximumLength = _vector.capacity() * sizeof(T);
+		if (maximumLength > MAXUSHORT)
+			maximumLength = MAXUSHORT - MAXUSHORT % sizeof(T);
+
+		ntString.Length = static_cast<USHORT>(this->size() * sizeof(T));
+		ntString.MaximumLength = static_cast<USHORT>(maximumLength);
+		ntString.Buffer = _vector.release();
+
+		return STATUS_SUCCESS;
+	}
+
+	template <typename T>
+	template <typename NtString>
+	inline NTSTATUS basic_string<T>::_adopt(NtString& ntString) {
+		if (ntString.Length > ntString.MaximumLength || ntString.Length % sizeof(T))
+			return STATUS_INVALID_PARAMETER;
+
+		auto size = ntString.Length / sizeof(T);
+		auto capacity = ntString.MaximumLength / sizeof(T);
+
+		_vector.adopt(ntString.Buffer, size, capacity);
+		ntString.Length = 0;
+		ntString.MaximumLength = 0;
+		ntString.Buffer = nullptr;
+
+		// no room for the terminator, grow once
+		if (size == capacity)
+			this->reserve(size);
+
+		_vector.resize(size + 1);
+		_vector[size] = 0;
+
+		return STATUS_SUCCESS;
+	}
+
+	template <typename T>
+	template <typename NtString>
+	inline NTSTATUS basic_string<T>::_ntString(NtString& ntString) const noexcept {
+		if (this->size() * sizeof(T) > MAXUSHORT)
+			return STATUS_NAME_TOO_LONG;
+
+		ntString.Length = static_cast<USHORT>(this->size() * sizeof(T));
+		ntString.MaximumLength = ntString.Length;
+		ntString.Buffer = this->begin();
+
+		return STATUS_SUCCESS;
+	}
+
+	template <typename T>
+	inline size_t basic_string<T>::_getTSize(const T* str) const noexcept {
+		size_t strSize = 0;
+		while (str[strSize])
+			++strSize;
+
+		return strSize;
+	}
+
+	//
+	//
+	//
+
+	class string : public basic_string<char> {
+	public:
+		inline string() = default;
+		inline string(size_t count) : basic_string(count) {};
+		inline string(const char* other) : basic_string(other) {};
+		inline string(const string& other) : basic_string(other) {};
+		inline string(string&& other) noexcept : basic_string(tiny::move(other)) {};
+		inline string(string_view other) : basic_string() { this->append(other); };
+
+		inline string& operator=(const string& other) = default;
+		inline string& operator=(string&& other) = default;
+		using basic_string::operator=;
+
+		// Moves the buffer into ansiString without copying, free it with tiny::free_string.
+		inline NTSTATUS release_to(ANSI_STRING& ansiString) noexcept {
+			return this->_releaseTo(ansiString);
+		}
+
+		// Takes over the buffer of ansiString. The tag cannot be checked, the caller guarantees the
+		// buffer is from release_to or ExAllocatePool2(POOL_FLAG_NON_PAGED, ..., TINY_POOL_TAG).
+		inline NTSTATUS adopt(ANSI_STRING&& ansiString) {
+			return this->_adopt(ansiString);
+		}
+
+		// Read-only ANSI_STRING pointing into this string, valid until it is modified.
+		// STATUS_NAME_TOO_LONG when the size does not fit the USHORT Length.
+		inline NTSTATUS ansi_string(ANSI_STRING& ansiString) const noexcept {
+			return this->_ntString(ansiString);
+		}
+	};
+
+	class wstring : public basic_string<wchar_t> {
+	public:
+		inline wstring() = default;
+		inline wstring(size_t count) : basic_string(count) {};
+		inline wstring(const wchar_t* other) : basic_string(other) {};
+		inline wstring(const wstring& other) : basic_string(other) {};
+		inline wstring(wstring&& other) noexcept : basic_string(tiny::move(other)) {};
+		inline wstring(wstring_view other) : basic_string() { this->append(other); };
+
+		inline wstring& operator=(const wstring& other) = default;
+		inline wstring& operator=(wstring&& other) = default;
+		using basic_string::operator=;
+
+		// Moves the buffer into unicodeString without copying, free it with tiny::free_string.
+		inline NTSTATUS release_to(UNICODE_STRING& unicodeString) noexcept {
+			return this->_releaseTo(unicodeString);
+		}
+
+		// Takes over the buffer of unicodeString. The tag cannot be checked, the caller guarantees the
+		// buffer is from release_to or ExAllocatePool2(POOL_FLAG_NON_PAGED, ..., TINY_POOL_TAG).
+		inline NTSTATUS adopt(UNICODE_STRING&& unicodeString) {
+			return this->_adopt(unicodeString);
+		}
+
+		// Read-only UNICODE_STRING pointing into this string, valid until it is modified.
+		// STATUS_NAME_TOO_LONG when the size does not fit the USHORT Length.
+		inline NTSTATUS unicode_string(UNICODE_STRING& unicodeString) const noexcept {
+			return this->_ntString(unicodeString);
+		}
+	};
+
+	inline void free_string(UNICODE_STRING& unicodeString) {
+		if (unicodeString.Buffer)
+			ExFreePoolWithTag(unicodeString.Buffer, TINY_POOL_TAG);
+
+		unicodeString.Length = 0;
+		unicodeString.MaximumLength = 0;
+		unicodeString.Buffer = nullptr;
+	}
+
+	inline void free_string(ANSI_STRING& ansiString) {
+		if (ansiString.Buffer)
+			ExFreePoolWithTag(ansiString.Buffer, TINY_POOL_TAG);
+
+		ansiString.Length = 0;
+		ansiString.MaximumLength = 0;
+		ansiString.Buffer = nullptr;
+	}
+
+	template <typename S, typename = enable_if_t<is_base_of_v<basic_string<typename S::value_type>, S>>>
+	inline S operator+(const S& left, basic_string_view<typename S::value_type> right) {
+		S result;
+		result.reserve(left.size() + right.size());
+		result.append(left.view());
+		result.append(right);
+		return result;
+	}
+
+	template <typename S, typename = enable_if_t<is_base_of_v<basic_string<typename S::value_type>, S>>>
+	inline S operator+(const S& left, typename S::value_type right) {
+		return left + basic_string_view<typename S::value_type>(&right, 1);
+	}
+
+	// Builds a string from pieces with a single allocation and one memcpy per piece.
+	template <typename S, typename... Pieces>
+	inline S concat(const Pieces&... pieces) {
+		const basic_string_view<typename S::value_type> views[] = { pieces... };
+
+		size_t totalSize = 0;
+		for (const auto& view : views)
+			totalSize += view.size();
+
+		S result;
+		result.reserve(totalSize);
+		for (const auto& view : views)
+			result.append(view);
+
+		return result;
+	}
+
+	// Accumulates pieces into a string reserved up front for the expected length.
+	template <typename S>
+	class basic_string_builder {
+	public:
+		using value_type = typename S::value_type;
+
+		explicit basic_string_builder(size_t expectedLength = 0) {
+			_str.reserve(expectedLength);
+		}
+
+		basic_string_builder& append(basic_string_view<value_type> piece) {
+			_str.append(piece);
+			return *this;
+		}
+
+		basic_string_builder& operator<<(basic_string_view<value_type> piece) {
+			return this->append(piece);
+		}
+
+		basic_string_builder& operator<<(const value_type* piece) {
+			return this->append(piece);
+		}
+
+		basic_string_builder& operator<<(value_type c) {
+			_str.push_back(c);
+			return *this;
+		}
+
+		constexpr size_t size() const noexcept {
+			return _str.size();
+		}
+
+		const S& str() const noexcept {
+			return _str;
+		}
+
+		// moves the built string out, builder is left empty
+		S release() noexcept {
+			return tiny::move(_str);
+		}
+	private:
+		S _str;
+	};
+
+	using string_builder = basic_string_builder<string>;
+	using wstring_builder = basic_string_builder<wstring>;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace tiny {
+	// Non-owning pointer/length pair, the text does not have to be null terminated.
+	template <typename T>
+	class basic_string_view {
+	public:
+		using value_type = T;
+
+		inline static const size_t npos = static_cast<size_t>(-1);
+
+		constexpr basic_string_view() noexcept
+			: _data(nullptr), _size(0) {
+		}
+
+		constexpr basic_string_view(const T* str, size_t count) noexcept
+			: _data(str), _size(count) {
+		}
+
+		constexpr basic_string_view(const T* str) noexcept
+			: _data(str), _size(_getTSize(str)) {
+		}
+
+		constexpr const T* data() const noexcept {
+			return _data;
+		}
+
+		constexpr const T* begin() const noexcept {
+			return _data;
+		}
+
+		constexpr const T* end() const noexcept {
+			return _data + _size;
+		}
+
+		constexpr bool empty() const noexcept {
+			return _size == 0;
+		}
+
+		constexpr size_t size() const noexcept {
+			return _size;
+		}
+
+		constexpr const T& front() const {
+			return _data[0];
+		}
+
+		constexpr const T& back() const {
+			return _data[_size - 1];
+		}
+
+		constexpr const T& operator [](size_t idx) const {
+			return _data[idx];
+		}
+
+		constexpr basic_string_view substr(size_t pos, size_t count = npos) const noexcept {
+			if (pos > _size)
+				pos = _size;
+
+			if (count > _size - pos)
+				count = _size - pos;
+
+			return basic_string_view(_data + pos, count);
+		}
+
+		constexpr void remove_prefix(size_t count) noexcept {
+			_data += count;
+			_size -= count;
+		}
+
+		constexpr void remove_suffix(size_t count) noexcept {
+			_size -= count;
+		}
+
+		constexpr int compare(basic_string_view other) const noexcept {
+			auto count = _size < other._size ? _size : other._size;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (_data[i] != other._data[i])
+					return _data[i] < other._data[i] ? -1 : 1;
+			}
+
+			if (_size == other._size)
+				return 0;
+
+			return _size < other._size ? -1 : 1;
+		}
+
+		constexpr bool operator==(basic_string_view other) const noexcept {
+			return _size == other._size && this->compare(other) == 0;
+		}
+
+		constexpr bool operator!=(basic_string_view other) const noexcept {
+			return !(*this == other);
+		}
+	private:
+		const T* _data;
+		size_t _size;
+
+		static constexpr size_t _getTSize(const T* str) noexcept {
+			size_t strSize = 0;
+			while (str && str[strSize])
+				++strSize;
+
+			return strSize;
+		}
+	};
+
+	using string_view = basic_string_view<char>;
+	using wstring_view = basic_string_view<wchar_t>;
+}
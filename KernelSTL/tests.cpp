@@ -1,474 +1,3819 @@
-#include "tests.hpp"
-#include "tiny_stl.hpp"
-
-#define Message(msg, ...) do {DbgPrintEx(0, 0, "[TinyTest]: " msg "\n", __VA_ARGS__);}while(0)
-#define MessageOK(msg, ...) Message(msg " [OK]", __VA_ARGS__)
-#define MessageFAILED(msg, ...) Message(msg " [FAILED]", __VA_ARGS__)
-#define Execute(testName) \
-if(testName()) \
-	MessageOK(#testName); \
-else \
-	MessageFAILED(#testName)
-#define UseCase(useCaseName) Message("    " useCaseName "...")
-#define assert(cond) if(!(cond)) return false;
-
-static bool testVector()
-{
-	UseCase("VectorDefaultConstructor");
-	{
-		tiny::vector<int> vec;
-
-		assert(vec.empty());
-		assert(vec.size() == 0);
-		assert(vec.capacity() == 0);
-		assert(vec.begin() == vec.end());
-	}
-
-	UseCase("VectorResizeConstructor");
-	{
-		tiny::vector<int> vec((size_t)5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 5);
-		assert(vec.begin() != vec.end());
-	}
-
-	// does not follow std::vector implementation due to variadic constructor
-	// but it fills the missing std::initializer_list hole
-	//UseCase("3");
-	{
-		//tiny::vector<int> vec(5);
-
-		//assert(vec.empty() == false);
-		//assert(vec.size() == 1);
-		//assert(vec.capacity() >= 1);
-		//assert(vec.front() == 5);
-		//assert(vec.begin() != vec.end());
-		//assert(*(vec.end()) == 5);
-		//assert(*(vec.end()) == 5);
-	}
-
-	UseCase("VectorPushBack");
-	{
-		tiny::vector<int> vec;
-		vec.push_back(5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 1);
-		assert(vec.capacity() >= 1);
-		assert(vec.front() == 5);
-		assert(vec.begin() != vec.end());
-		assert(*(vec.begin()) == 5);
-		assert(*(vec.data()) == 5);
-	}
-
-	UseCase("VectorClear");
-	{
-		tiny::vector<int> vec;
-		vec.push_back(5);
-		vec.clear();
-
-		assert(vec.empty());
-		assert(vec.size() == 0);
-		assert(vec.capacity() >= 1);
-		assert(vec.begin() == vec.end());
-	}
-
-	UseCase("VectorReserve");
-	{
-		tiny::vector<int> vec;
-		vec.reserve(5);
-
-		assert(vec.empty());
-		assert(vec.size() == 0);
-		assert(vec.capacity() == 5);
-		assert(vec.begin() == vec.end());
-	}
-
-	UseCase("VectorResize");
-	{
-		tiny::vector<int> vec;
-		vec.resize(5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 5);
-		assert(vec.begin() != vec.end());
-	}
-
-	UseCase("VectorResize");
-	{
-		tiny::vector<int> vec;
-		vec.resize(10);
-		vec.resize(5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 10);
-	}
-
-	UseCase("VectorCapacityNotAffectedByResize");
-	{
-		tiny::vector<int> vec;
-		vec.reserve(10);
-		vec.resize(5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 10);
-	}
-
-	UseCase("VectorCapacityNotAffectedByClear");
-	{
-		tiny::vector<int> vec;
-		vec.resize(10);
-		vec.clear();
-
-		assert(vec.empty());
-		assert(vec.size() == 0);
-		assert(vec.capacity() == 10);
-	}
-
-	UseCase("VectorAssign");
-	{
-		tiny::vector<int> vec;
-		vec.assign(10, 5);
-
-		for (const auto& v : vec)
-			assert(v == 5);
-
-		assert(vec.empty() == false);
-		assert(vec.size() == 10);
-		assert(vec.capacity() == 10);
-	}
-
-	UseCase("VectorContinousMemory");
-	{
-		tiny::vector<int> vec;
-
-		for (int i = 0; i < 100; i++)
-			vec.push_back(i);
-
-		for (int i = 0; i < 100; i++)
-		{
-			assert(vec[i] == i);
-			assert(*(vec.data() + i) == i);
-		}
-	}
-
-	UseCase("VectorShrinkToFit");
-	{
-
-		tiny::vector<int> vec;
-		vec.reserve(10);
-		vec.resize(5);
-
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 10);
-
-		vec.shrink_to_fit();
-
-		assert(vec.size() == 5);
-		assert(vec.capacity() == 5);
-
-		vec.clear();
-		vec.shrink_to_fit();
-
-		assert(vec.empty());
-		assert(vec.size() == 0);
-		assert(vec.capacity() == 0);
-	}
-
-	return true;
-}
-
-static bool testString()
-{
-	UseCase("StringDefaultConstructor");
-	{
-		tiny::string str;
-
-		assert(str.empty());
-		assert(str.size() == 0);
-		assert(str.capacity() == 0);
-		assert(str.begin() == str.end());
-	}
-
-	UseCase("StringResizeConstructor");
-	{
-		tiny::string str((size_t)5);
-
-		assert(str.empty() == false);
-		assert(str.size() == 5);
-		assert(str.capacity() == 5);
-		assert(str.begin() != str.end());
-	}
-
-	UseCase("StringCorrectSize");
-	{
-		{
-			tiny::string str;
-			str = "hello";
-
-			assert(str.empty() == false);
-			assert(str.size() == 5);
-			assert(str.capacity() == 5);
-			assert(str.begin() != str.end());
-		}
-
-		{
-			tiny::string str("hello");
-
-			assert(str.empty() == false);
-			assert(str.size() == 5);
-			assert(str.size() == strlen(str.data()));
-			assert(str.capacity() == 5);
-			assert(str.begin() != str.end());
-		}
-	}
-
-	UseCase("StringCompare");
-	{
-		{
-			tiny::string str1("abc");
-			tiny::string str2("abc");
-
-			assert(str1.compare(str2) == 0);
-			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::string str1("abc");
-			tiny::string str2("abcd");
-
-			assert(str1.compare(str2) == -1);
-			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::string str1("abcd");
-			tiny::string str2("abc");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::string str1("bbcd");
-			tiny::string str2("abc");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::string str1("bbc");
-			tiny::string str2("abcd");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
-		}
-	}
-
-	UseCase("StringFind");
-	{
-		{
-			tiny::string str("");
-			assert(str.find("") == tiny::string::npos);
-			assert(str.find("a") == tiny::string::npos);
-			assert(str.find('a') == tiny::string::npos);
-		}
-
-		{
-			tiny::string str("abc");
-
-			assert(str.find("") == tiny::string::npos);
-
-			assert(str.find("a") == 0);
-			assert(str.find('a') == 0);
-
-			assert(str.find("b") == 1);
-			assert(str.find('b') == 1);
-
-			assert(str.find("c") == 2);
-			assert(str.find('c') == 2);
-		}
-
-		{
-			tiny::string str("abc");
-
-			assert(str.find("abc") == 0);
-			assert(str.find("bc") == 1);
-		}
-
-		{
-			tiny::string str1("abcd");
-			tiny::string str2("abc");
-
-			assert(str1.find(str2) == 0);
-			assert(str2.find(str1) == tiny::string::npos);
-		}
-
-		{
-			tiny::string str1("abcdef");
-			tiny::string str2("abc");
-
-			assert(str1.find(str2) == 0);
-			assert(str1.find(str2, 0) == 0);
-			assert(str1.find(str2, 1) == tiny::string::npos);
-		}
-	}
-
-	return true;
-}
-
-static bool testWstring()
-{
-	UseCase("WstringDefaultConstructor");
-	{
-		tiny::string str;
-
-		assert(str.empty());
-		assert(str.size() == 0);
-		assert(str.capacity() == 0);
-		assert(str.begin() == str.end());
-	}
-
-	UseCase("WstringResizeConstructor");
-	{
-		tiny::wstring str((size_t)5);
-
-		assert(str.empty() == false);
-		assert(str.size() == 5);
-		assert(str.capacity() == 5);
-		assert(str.begin() != str.end());
-	}
-
-	UseCase("WstringCorrectSize");
-	{
-		{
-			tiny::wstring str;
-			str = L"hello";
-
-			assert(str.empty() == false);
-			assert(str.size() == 5);
-			assert(str.capacity() == 5);
-			assert(str.begin() != str.end());
-		}
-
-		{
-			tiny::wstring str(L"hello");
-
-			assert(str.empty() == false);
-			assert(str.size() == 5);
-			assert(str.size() == wcslen(str.data()));
-			assert(str.capacity() == 5);
-			assert(str.begin() != str.end());
-		}
-	}
-
-	UseCase("WstringCompare");
-	{
-		{
-			tiny::wstring str1(L"abc");
-			tiny::wstring str2(L"abc");
-
-			assert(str1.compare(str2) == 0);
-			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::wstring str1(L"abc");
-			tiny::wstring str2(L"abcd");
-
-			assert(str1.compare(str2) == -1);
-			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::wstring str1(L"abcd");
-			tiny::wstring str2(L"abc");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::wstring str1(L"bbcd");
-			tiny::wstring str2(L"abc");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
-		}
-
-		{
-			tiny::wstring str1(L"cbc");
-			tiny::wstring str2(L"abcd");
-
-			assert(str1.compare(str2) == 1);
-			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
-		}
-	}
-
-	UseCase("WstringFind");
-	{
-		{
-			tiny::wstring str(L"");
-			assert(str.find(L"") == tiny::wstring::npos);
-			assert(str.find(L"a") == tiny::wstring::npos);
-			assert(str.find(L'a') == tiny::wstring::npos);
-		}
-
-		{
-			tiny::wstring str(L"abc");
-
-			assert(str.find(L"") == tiny::wstring::npos);
-
-			assert(str.find(L"a") == 0);
-			assert(str.find(L'a') == 0);
-
-			assert(str.find(L"b") == 1);
-			assert(str.find(L'b') == 1);
-
-			assert(str.find(L"c") == 2);
-			assert(str.find(L'c') == 2);
-		}
-
-		{
-			tiny::wstring str(L"abc");
-
-			assert(str.find(L"abc") == 0);
-			assert(str.find(L"bc") == 1);
-		}
-
-		{
-			tiny::wstring str1(L"abcd");
-			tiny::wstring str2(L"abc");
-
-			assert(str1.find(str2) == 0);
-			assert(str2.find(str1) == tiny::wstring::npos);
-		}
-
-		{
-			tiny::wstring str1(L"abcdef");
-			tiny::wstring str2(L"abc");
-
-			assert(str1.find(str2) == 0);
-			assert(str1.find(str2, 0) == 0);
-			assert(str1.find(str2, 1) == tiny::wstring::npos);
-		}
-	}
-
-	return true;
-}
-
-namespace tiny {
-	void runTests() {
-		Message("Starting...");
-		Execute(testVector);
-		Execute(testString);
-		Execute(testWstring);
-		Message("Finished...");
-	}
+#include "tests.hpp"
+#include "tiny_stl.hpp"
+
+#define Message(msg, ...) do {DbgPrintEx(0, 0, "[TinyTest]: " msg "\n", __VA_ARGS__);}while(0)
+#define MessageOK(msg, ...) Message(msg " [OK]", __VA_ARGS__)
+#define MessageFAILED(msg, ...) Message(msg " [FAILED]", __VA_ARGS__)
+#define Execute(testName) \
+if(testName()) \
+	MessageOK(#testName); \
+else \
+	MessageFAILED(#testName)
+#define UseCase(useCaseName) Message("    " useCaseName "...")
+#define assert(cond) if(!(cond)) return false;
+
+static bool testVector()
+{
+	UseCase("VectorDefaultConstructor");
+	{
+		tiny::vector<int> vec;
+
+		assert(vec.empty());
+		assert(vec.size() == 0);
+		assert(vec.capacity() == 0);
+		assert(vec.begin() == vec.end());
+	}
+
+	UseCase("VectorResizeConstructor");
+	{
+		tiny::vector<int> vec((size_t)5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 5);
+		assert(vec.begin() != vec.end());
+	}
+
+	// does not follow std::vector implementation due to variadic constructor
+	// but it fills the missing std::initializer_list hole
+	//UseCase("3");
+	{
+		//tiny::vector<int> vec(5);
+
+		//assert(vec.empty() == false);
+		//assert(vec.size() == 1);
+		//assert(vec.capacity() >= 1);
+		//assert(vec.front() == 5);
+		//assert(vec.begin() != vec.end());
+		//assert(*(vec.end()) == 5);
+		//assert(*(vec.end()) == 5);
+	}
+
+	UseCase("VectorPushBack");
+	{
+		tiny::vector<int> vec;
+		vec.push_back(5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 1);
+		assert(vec.capacity() >= 1);
+		assert(vec.front() == 5);
+		assert(vec.begin() != vec.end());
+		assert(*(vec.begin()) == 5);
+		assert(*(vec.data()) == 5);
+	}
+
+	UseCase("VectorClear");
+	{
+		tiny::vector<int> vec;
+		vec.push_back(5);
+		vec.clear();
+
+		assert(vec.empty());
+		assert(vec.size() == 0);
+		assert(vec.capacity() >= 1);
+		assert(vec.begin() == vec.end());
+	}
+
+	UseCase("VectorReserve");
+	{
+		tiny::vector<int> vec;
+		vec.reserve(5);
+
+		assert(vec.empty());
+		assert(vec.size() == 0);
+		assert(vec.capacity() == 5);
+		assert(vec.begin() == vec.end());
+	}
+
+	UseCase("VectorResize");
+	{
+		tiny::vector<int> vec;
+		vec.resize(5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 5);
+		assert(vec.begin() != vec.end());
+	}
+
+	UseCase("VectorResize");
+	{
+		tiny::vector<int> vec;
+		vec.resize(10);
+		vec.resize(5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 10);
+	}
+
+	UseCase("VectorCapacityNotAffectedByResize");
+	{
+		tiny::vector<int> vec;
+		vec.reserve(10);
+		vec.resize(5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 10);
+	}
+
+	UseCase("VectorCapacityNotAffectedByClear");
+	{
+		tiny::vector<int> vec;
+		vec.resize(10);
+		vec.clear();
+
+		assert(vec.empty());
+		assert(vec.size() == 0);
+		assert(vec.capacity() == 10);
+	}
+
+	UseCase("VectorAssign");
+	{
+		tiny::vector<int> vec;
+		vec.assign(10, 5);
+
+		for (const auto& v : vec)
+			assert(v == 5);
+
+		assert(vec.empty() == false);
+		assert(vec.size() == 10);
+		assert(vec.capacity() == 10);
+	}
+
+	UseCase("VectorContinousMemory");
+	{
+		tiny::vector<int> vec;
+
+		for (int i = 0; i < 100; i++)
+			vec.push_back(i);
+
+		for (int i = 0; i < 100; i++)
+		{
+			assert(vec[i] == i);
+			assert(*(vec.data() + i) == i);
+		}
+	}
+
+	UseCase("VectorShrinkToFit");
+	{
+
+		tiny::vector<int> vec;
+		vec.reserve(10);
+		vec.resize(5);
+
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 10);
+
+		vec.shrink_to_fit();
+
+		assert(vec.size() == 5);
+		assert(vec.capacity() == 5);
+
+		vec.clear();
+		vec.shrink_to_fit();
+
+		assert(vec.empty());
+		assert(vec.size() == 0);
+		assert(vec.capacity() == 0);
+	}
+
+	UseCase("VectorBack");
+	{
+		tiny::vector<int> vec;
+		vec.push_back(1);
+		vec.push_back(2);
+
+		assert(vec.back() == 2);
+		assert(vec.front() == 1);
+	}
+
+	UseCase("VectorInsertRange");
+	{
+		int values[] = { 10, 11, 12 };
+		tiny::vector<int> vec;
+		for (int i = 0; i < 5; i++)
+			vec.push_back(i);
+
+		// grows once, the tail moves behind the new elements
+		vec.insert(2, values, values + 3);
+		int expected[] = { 0, 1, 10, 11, 12, 2, 3, 4 };
+		assert(vec.size() == 8);
+		for (size_t i = 0; i < vec.size(); i++)
+			assert(vec[i] == expected[i]);
+
+		// fits, shifted in place
+		vec.reserve(20);
+		vec.insert(0, values, values + 2);
+		vec.insert(vec.size(), values + 2, values + 3);
+		assert(vec.size() == 11 && vec.capacity() == 20);
+		assert(vec[0] == 10 && vec[1] == 11 && vec[2] == 0 && vec[10] == 12);
+
+		vec.insert(5, values, values);
+		assert(vec.size() == 11);
+	}
+
+	UseCase("VectorAppendAndAssignRange");
+	{
+		tiny::vector<int> source;
+		for (int i = 0; i < 100; i++)
+			source.push_back(i);
+
+		tiny::vector<int> vec;
+		vec.append_range(source);
+		vec.append_range(source.begin(), source.begin() + 10);
+		assert(vec.size() == 110);
+		assert(vec[99] == 99 && vec[100] == 0 && vec[109] == 9);
+
+		vec.assign(source.begin() + 50, source.end());
+		assert(vec.size() == 50 && vec[0] == 50 && vec.back() == 99);
+
+		// from a different element type, converted one by one
+		tiny::vector<long long> wide;
+		wide.assign(source.begin(), source.end());
+		assert(wide.size() == 100 && wide[42] == 42);
+	}
+
+	UseCase("VectorRangeNonTrivial");
+	{
+		tiny::vector<tiny::string> names;
+		names.push_back(tiny::string("alpha"));
+		names.push_back(tiny::string("delta"));
+
+		tiny::string inserted[] = { tiny::string("bravo"), tiny::string("charlie") };
+		names.insert(1, inserted, inserted + 2);
+		names.append_range(inserted, inserted + 1);
+
+		const char* expected[] = { "alpha", "bravo", "charlie", "delta", "bravo" };
+		assert(names.size() == 5);
+		for (size_t i = 0; i < names.size(); i++)
+			assert(names[i].view() == tiny::string_view(expected[i]));
+
+		assert(names.erase_if([](const tiny::string& name) { return name.view() == tiny::string_view("bravo"); }) == 2);
+		assert(names.size() == 3 && names[1].view() == tiny::string_view("charlie"));
+
+		tiny::vector<tiny::string> copy;
+		copy = names;
+		assert(copy.size() == 3 && copy[2].view() == tiny::string_view("delta"));
+	}
+
+	UseCase("VectorEraseIf");
+	{
+		tiny::vector<int> vec;
+		for (int i = 0; i < 1000; i++)
+			vec.push_back(i);
+
+		assert(vec.erase_if([](int v) { return v % 3 == 0 || v > 900; }) == 334 + 66);
+		assert(vec.size() == 600);
+		assert(vec[0] == 1 && vec[1] == 2 && vec[2] == 4 && vec.back() == 899);
+		for (size_t i = 1; i < vec.size(); i++)
+			assert(vec[i] % 3 && vec[i] > vec[i - 1]);
+
+		assert(vec.erase_if([](int) { return false; }) == 0);
+		assert(vec.erase_if([](int) { return true; }) == 600);
+		assert(vec.empty());
+	}
+
+	UseCase("VectorInsertOwnElement");
+	{
+		tiny::vector<tiny::string> names;
+		names.push_back(tiny::string("alpha"));
+		names.push_back(tiny::string("bravo"));
+		names.shrink_to_fit();
+
+		// the growth frees the element being copied
+		names.push_back(names[0]);
+		names.reserve(8);
+
+		// without growth the element being copied moves with the gap
+		names.insert(0, names[1]);
+		names.insert(1, names[0]);
+
+		const char* expected[] = { "bravo", "bravo", "alpha", "bravo", "alpha" };
+		assert(names.size() == 5);
+		for (size_t i = 0; i < names.size(); i++)
+			assert(names[i].view() == tiny::string_view(expected[i]));
+
+		tiny::vector<int> ints;
+		ints.push_back(7);
+		ints.shrink_to_fit();
+		ints.push_back(ints[0]);
+		ints.insert(0, ints[1]);
+		assert(ints.size() == 3 && ints[0] == 7 && ints[1] == 7 && ints[2] == 7);
+	}
+
+	UseCase("VectorInsertOwnRange");
+	{
+		// full, so appending itself reallocates
+		tiny::vector<tiny::string> names;
+		names.push_back(tiny::string("alpha"));
+		names.push_back(tiny::string("bravo"));
+		names.shrink_to_fit();
+		names.append_range(names);
+
+		const char* appended[] = { "alpha", "bravo", "alpha", "bravo" };
+		assert(names.size() == 4);
+		for (size_t i = 0; i < names.size(); i++)
+			assert(names[i].view() == tiny::string_view(appended[i]));
+
+		// with spare capacity the gap shifts the range being copied
+		tiny::vector<int> ints;
+		ints.reserve(16);
+		for (int i = 0; i < 5; i++)
+			ints.push_back(i);
+
+		ints.insert(0, ints.begin() + 1, ints.begin() + 3);
+		int inserted[] = { 1, 2, 0, 1, 2, 3, 4 };
+		assert(ints.size() == 7);
+		for (size_t i = 0; i < ints.size(); i++)
+			assert(ints[i] == inserted[i]);
+
+		names.insert(1, names.begin(), names.begin() + 3);
+		const char* overlapped[] = { "alpha", "alpha", "bravo", "alpha", "bravo", "alpha", "bravo" };
+		assert(names.size() == 7);
+		for (size_t i = 0; i < names.size(); i++)
+			assert(names[i].view() == tiny::string_view(overlapped[i]));
+	}
+
+	UseCase("VectorResizeForOverwrite");
+	{
+		tiny::vector<unsigned char> bytes;
+		bytes.resize_for_overwrite(4096);
+		assert(bytes.size() == 4096);
+
+		memset(bytes.begin(), 0xAB, bytes.size());
+		bytes.resize_for_overwrite(16);
+		assert(bytes.size() == 16 && bytes[15] == 0xAB);
+
+		// value-initialized as before, zeroed
+		tiny::vector<int> ints;
+		ints.resize(100);
+		for (auto v : ints)
+			assert(v == 0);
+	}
+
+
+	return true;
+}
+
+static bool testString()
+{
+	UseCase("StringDefaultConstructor");
+	{
+		tiny::string str;
+
+		assert(str.empty());
+		assert(str.size() == 0);
+		assert(str.capacity() == 0);
+		assert(str.begin() == str.end());
+	}
+
+	UseCase("StringResizeConstructor");
+	{
+		tiny::string str((size_t)5);
+
+		assert(str.empty() == false);
+		assert(str.size() == 5);
+		assert(str.capacity() == 5);
+		assert(str.begin() != str.end());
+	}
+
+	UseCase("StringCorrectSize");
+	{
+		{
+			tiny::string str;
+			str = "hello";
+
+			assert(str.empty() == false);
+			assert(str.size() == 5);
+			assert(str.capacity() == 5);
+			assert(str.begin() != str.end());
+		}
+
+		{
+			tiny::string str("hello");
+
+			assert(str.empty() == false);
+			assert(str.size() == 5);
+			assert(str.size() == strlen(str.data()));
+			assert(str.capacity() == 5);
+			assert(str.begin() != str.end());
+		}
+	}
+
+	UseCase("StringCompare");
+	{
+		{
+			tiny::string str1("abc");
+			tiny::string str2("abc");
+
+			assert(str1.compare(str2) == 0);
+			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::string str1("abc");
+			tiny::string str2("abcd");
+
+			assert(str1.compare(str2) == -1);
+			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::string str1("abcd");
+			tiny::string str2("abc");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::string str1("bbcd");
+			tiny::string str2("abc");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::string str1("bbc");
+			tiny::string str2("abcd");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == strcmp(str1.data(), str2.data()));
+		}
+	}
+
+	UseCase("StringFind");
+	{
+		{
+			tiny::string str("");
+			assert(str.find("") == tiny::string::npos);
+			assert(str.find("a") == tiny::string::npos);
+			assert(str.find('a') == tiny::string::npos);
+		}
+
+		{
+			tiny::string str("abc");
+
+			assert(str.find("") == tiny::string::npos);
+
+			assert(str.find("a") == 0);
+			assert(str.find('a') == 0);
+
+			assert(str.find("b") == 1);
+			assert(str.find('b') == 1);
+
+			assert(str.find("c") == 2);
+			assert(str.find('c') == 2);
+		}
+
+		{
+			tiny::string str("abc");
+
+			assert(str.find("abc") == 0);
+			assert(str.find("bc") == 1);
+		}
+
+		{
+			tiny::string str1("abcd");
+			tiny::string str2("abc");
+
+			assert(str1.find(str2) == 0);
+			assert(str2.find(str1) == tiny::string::npos);
+		}
+
+		{
+			tiny::string str1("abcdef");
+			tiny::string str2("abc");
+
+			assert(str1.find(str2) == 0);
+			assert(str1.find(str2, 0) == 0);
+			assert(str1.find(str2, 1) == tiny::string::npos);
+		}
+	}
+
+	return true;
+}
+
+static bool testWstring()
+{
+	UseCase("WstringDefaultConstructor");
+	{
+		tiny::string str;
+
+		assert(str.empty());
+		assert(str.size() == 0);
+		assert(str.capacity() == 0);
+		assert(str.begin() == str.end());
+	}
+
+	UseCase("WstringResizeConstructor");
+	{
+		tiny::wstring str((size_t)5);
+
+		assert(str.empty() == false);
+		assert(str.size() == 5);
+		assert(str.capacity() == 5);
+		assert(str.begin() != str.end());
+	}
+
+	UseCase("WstringCorrectSize");
+	{
+		{
+			tiny::wstring str;
+			str = L"hello";
+
+			assert(str.empty() == false);
+			assert(str.size() == 5);
+			assert(str.capacity() == 5);
+			assert(str.begin() != str.end());
+		}
+
+		{
+			tiny::wstring str(L"hello");
+
+			assert(str.empty() == false);
+			assert(str.size() == 5);
+			assert(str.size() == wcslen(str.data()));
+			assert(str.capacity() == 5);
+			assert(str.begin() != str.end());
+		}
+	}
+
+	UseCase("WstringCompare");
+	{
+		{
+			tiny::wstring str1(L"abc");
+			tiny::wstring str2(L"abc");
+
+			assert(str1.compare(str2) == 0);
+			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::wstring str1(L"abc");
+			tiny::wstring str2(L"abcd");
+
+			assert(str1.compare(str2) == -1);
+			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::wstring str1(L"abcd");
+			tiny::wstring str2(L"abc");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::wstring str1(L"bbcd");
+			tiny::wstring str2(L"abc");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
+		}
+
+		{
+			tiny::wstring str1(L"cbc");
+			tiny::wstring str2(L"abcd");
+
+			assert(str1.compare(str2) == 1);
+			assert(str1.compare(str2) == wcscmp(str1.data(), str2.data()));
+		}
+	}
+
+	UseCase("WstringFind");
+	{
+		{
+			tiny::wstring str(L"");
+			assert(str.find(L"") == tiny::wstring::npos);
+			assert(str.find(L"a") == tiny::wstring::npos);
+			assert(str.find(L'a') == tiny::wstring::npos);
+		}
+
+		{
+			tiny::wstring str(L"abc");
+
+			assert(str.find(L"") == tiny::wstring::npos);
+
+			assert(str.find(L"a") == 0);
+			assert(str.find(L'a') == 0);
+
+			assert(str.find(L"b") == 1);
+			assert(str.find(L'b') == 1);
+
+			assert(str.find(L"c") == 2);
+			assert(str.find(L'c') == 2);
+		}
+
+		{
+			tiny::wstring str(L"abc");
+
+			assert(str.find(L"abc") == 0);
+			assert(str.find(L"bc") == 1);
+		}
+
+		{
+			tiny::wstring str1(L"abcd");
+			tiny::wstring str2(L"abc");
+
+			assert(str1.find(str2) == 0);
+			assert(str2.find(str1) == tiny::wstring::npos);
+		}
+
+		{
+			tiny::wstring str1(L"abcdef");
+			tiny::wstring str2(L"abc");
+
+			assert(str1.find(str2) == 0);
+			assert(str1.find(str2, 0) == 0);
+			assert(str1.find(str2, 1) == tiny::wstring::npos);
+		}
+	}
+
+	return true;
+}
+
+static bool testStringAppend()
+{
+	UseCase("StringPushBackGrowsGeometrically");
+	{
+		tiny::string str;
+
+		for (int i = 0; i < 100; i++)
+			str.push_back('a');
+
+		assert(str.size() == 100);
+		assert(str.size() == strlen(str.data()));
+		assert(str.capacity() >= 100);
+		assert(str.capacity() < 200);
+	}
+
+	UseCase("StringAppend");
+	{
+		tiny::string str("abc");
+		str.append("defgh", 2);
+		str.append(tiny::string_view("xyz"));
+
+		assert(str.size() == 8);
+		assert(str.size() == strlen(str.data()));
+		assert(strcmp(str.data(), "abcdexyz") == 0);
+	}
+
+	UseCase("StringAppendItself");
+	{
+		// every append below reallocates, the source is in the old buffer
+		tiny::string str("abcd");
+		str.shrink_to_fit();
+		str += str;
+		assert(strcmp(str.data(), "abcdabcd") == 0);
+
+		str.shrink_to_fit();
+		str.append(str.view().substr(2, 3));
+		assert(strcmp(str.data(), "abcdabcdcda") == 0);
+
+		str.shrink_to_fit();
+		str.push_back(str.data()[0]);
+		assert(strcmp(str.data(), "abcdabcdcdaa") == 0);
+		assert(str.size() == strlen(str.data()));
+	}
+
+	UseCase("StringOperatorPlus");
+	{
+		tiny::string str1("abc");
+		tiny::string str2("def");
+
+		str1 += 'x';
+		str1 += "yz";
+		str1 += str2;
+
+		assert(strcmp(str1.data(), "abcxyzdef") == 0);
+
+		auto str3 = str2 + "gh";
+		auto str4 = str3 + '!';
+
+		assert(strcmp(str3.data(), "defgh") == 0);
+		assert(strcmp(str4.data(), "defgh!") == 0);
+		assert(strcmp(str2.data(), "def") == 0);
+	}
+
+	UseCase("WstringConcat");
+	{
+		tiny::wstring name(L"file.txt");
+		auto path = tiny::concat<tiny::wstring>(L"\\Device\\HarddiskVolume1", L"\\", name);
+
+		assert(path.size() == 32);
+		assert(path.capacity() == 32);
+		assert(wcscmp(path.data(), L"\\Device\\HarddiskVolume1\\file.txt") == 0);
+	}
+
+	UseCase("WstringBuilder");
+	{
+		tiny::wstring_builder builder(32);
+		builder << L"\\Device\\HarddiskVolume1" << L'\\' << tiny::wstring(L"file.txt");
+
+		assert(builder.size() == 32);
+		assert(builder.str().capacity() == 32);
+
+		auto path = builder.release();
+
+		assert(wcscmp(path.data(), L"\\Device\\HarddiskVolume1\\file.txt") == 0);
+		assert(builder.size() == 0);
+	}
+
+	UseCase("StringMove");
+	{
+		tiny::string str1("abc");
+		tiny::string str2(tiny::move(str1));
+
+		assert(str1.empty());
+		assert(str2.size() == 3);
+
+		str1 = tiny::move(str2);
+
+		assert(str2.empty());
+		assert(strcmp(str1.data(), "abc") == 0);
+	}
+
+	return true;
+}
+
+static bool testFormat()
+{
+	UseCase("FormatToBuffer");
+	{
+		char buffer[64];
+		auto length = tiny::format_to(buffer, "pid={} status={x} name={} {{}}", 1234, 0xC0000001u, "svc.exe");
+
+		assert(length == strlen(buffer));
+		assert(strcmp(buffer, "pid=1234 status=c0000001 name=svc.exe {}") == 0);
+	}
+
+	UseCase("FormatToSigned");
+	{
+		char buffer[32];
+		tiny::format_to(buffer, "{} {} {}", -15, 0, tiny::hex(255));
+
+		assert(strcmp(buffer, "-15 0 ff") == 0);
+	}
+
+	UseCase("FormatToTruncates");
+	{
+		char buffer[4];
+		auto length = tiny::format_to(buffer, "{}", 123456);
+
+		assert(length == 6);
+		assert(strcmp(buffer, "123") == 0);
+	}
+
+	UseCase("FormatToWide");
+	{
+		wchar_t buffer[64];
+		tiny::wstring name(L"file.txt");
+		tiny::format_to(buffer, L"{}\\{} ({})", L"\\Device", name, "ascii");
+
+		assert(wcscmp(buffer, L"\\Device\\file.txt (ascii)") == 0);
+	}
+
+	UseCase("FormatToString");
+	{
+		tiny::string str("id:");
+		auto length = tiny::format_to(str, "{}-{}", 42, "abcdefghijklmnopqrstuvwxyz");
+
+		assert(length == 29);
+		assert(str.size() == 32);
+		assert(str.size() == strlen(str.data()));
+		assert(strcmp(str.data(), "id:42-abcdefghijklmnopqrstuvwxyz") == 0);
+	}
+
+	return true;
+}
+
+static bool testNtStrings()
+{
+	UseCase("WstringReleaseToUnicodeString");
+	{
+		tiny::wstring str(L"hello");
+		auto buffer = str.data();
+		UNICODE_STRING unicodeString;
+
+		assert(NT_SUCCESS(str.release_to(unicodeString)));
+		assert(unicodeString.Buffer == buffer);
+		assert(unicodeString.Length == 5 * sizeof(wchar_t));
+		assert(unicodeString.MaximumLength == 6 * sizeof(wchar_t));
+		assert(str.empty());
+
+		tiny::free_string(unicodeString);
+		assert(unicodeString.Buffer == nullptr);
+	}
+
+	UseCase("WstringAdoptUnicodeString");
+	{
+		tiny::wstring str(L"hello");
+		UNICODE_STRING unicodeString;
+		str.release_to(unicodeString);
+		auto buffer = unicodeString.Buffer;
+
+		tiny::wstring other;
+		assert(NT_SUCCESS(other.adopt(tiny::move(unicodeString))));
+		assert(other.data() == buffer);
+		assert(other.size() == 5);
+		assert(wcscmp(other.data(), L"hello") == 0);
+		assert(unicodeString.Buffer == nullptr);
+	}
+
+	UseCase("WstringAdoptWithoutTerminatorRoom");
+	{
+		UNICODE_STRING unicodeString;
+		unicodeString.Buffer = static_cast<PWCH>(ALLOC_MEMORY(3 * sizeof(wchar_t)));
+		unicodeString.Length = 3 * sizeof(wchar_t);
+		unicodeString.MaximumLength = 3 * sizeof(wchar_t);
+		memcpy(unicodeString.Buffer, L"abc", 3 * sizeof(wchar_t));
+
+		tiny::wstring str;
+		assert(NT_SUCCESS(str.adopt(tiny::move(unicodeString))));
+		assert(str.size() == 3);
+		assert(str.size() == wcslen(str.data()));
+	}
+
+	UseCase("WstringUnicodeStringView");
+	{
+		tiny::wstring str(L"hello");
+		UNICODE_STRING unicodeString;
+
+		assert(NT_SUCCESS(str.unicode_string(unicodeString)));
+		assert(unicodeString.Buffer == str.data());
+		assert(unicodeString.Length == 5 * sizeof(wchar_t));
+
+		// the longest size Length can hold, one more would wrap it to 0
+		str.resize(MAXUSHORT / sizeof(wchar_t));
+		assert(NT_SUCCESS(str.unicode_string(unicodeString)));
+		assert(unicodeString.Length == str.size() * sizeof(wchar_t));
+
+		str.append(L"x");
+		assert(str.unicode_string(unicodeString) == STATUS_NAME_TOO_LONG);
+	}
+
+	UseCase("StringReleaseToAnsiString");
+	{
+		tiny::string str("hello");
+		ANSI_STRING ansiString;
+
+		assert(NT_SUCCESS(str.release_to(ansiString)));
+		assert(ansiString.Length == 5);
+
+		tiny::string other;
+		assert(NT_SUCCESS(other.adopt(tiny::move(ansiString))));
+		assert(strcmp(other.data(), "hello") == 0);
+	}
+
+	return true;
+}
+
+static unsigned testRandom(unsigned& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+template <typename T>
+static bool isSorted(const tiny::vector<T>& vec)
+{
+	for (size_t i = 1; i < vec.size(); ++i)
+	{
+		if (vec[i] < vec[i - 1])
+			return false;
+	}
+
+	return true;
+}
+
+struct StableItem {
+	int key;
+	int order;
+
+	bool operator<(const StableItem& other) const {
+		return key < other.key;
+	}
+};
+
+static bool testAlgorithm()
+{
+	UseCase("SortPatterns");
+	{
+		const size_t sizes[] = { 0, 1, 2, 23, 24, 25, 129, 1000, 5000 };
+
+		for (auto size : sizes)
+		{
+			unsigned state = 12345;
+			tiny::vector<int> random, sorted, reversed, equal, sawtooth;
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				random.push_back(static_cast<int>(testRandom(state) % 1000) - 500);
+				sorted.push_back(static_cast<int>(i));
+				reversed.push_back(static_cast<int>(size - i));
+				equal.push_back(7);
+				sawtooth.push_back(static_cast<int>(i % 16));
+			}
+
+			long long checksum = 0;
+			for (auto v : random)
+				checksum += v;
+
+			tiny::sort(random.begin(), random.end());
+			tiny::sort(sorted.begin(), sorted.end());
+			tiny::sort(reversed.begin(), reversed.end());
+			tiny::sort(equal.begin(), equal.end());
+			tiny::sort(sawtooth.begin(), sawtooth.end());
+
+			assert(isSorted(random));
+			assert(isSorted(sorted));
+			assert(isSorted(reversed));
+			assert(isSorted(equal));
+			assert(isSorted(sawtooth));
+
+			for (auto v : random)
+				checksum -= v;
+
+			assert(checksum == 0);
+		}
+	}
+
+	UseCase("SortWithComparator");
+	{
+		tiny::vector<int> vec;
+		for (int i = 0; i < 100; ++i)
+			vec.push_back(i);
+
+		tiny::sort(vec.begin(), vec.end(), [](int a, int b) { return a > b; });
+
+		for (int i = 0; i < 100; ++i)
+			assert(vec[i] == 99 - i);
+	}
+
+	UseCase("StableSort");
+	{
+		unsigned state = 777;
+		tiny::vector<StableItem> vec;
+		for (int i = 0; i < 1000; ++i)
+			vec.push_back({ static_cast<int>(testRandom(state) % 10), i });
+
+		tiny::stable_sort(vec.begin(), vec.end());
+
+		for (size_t i = 1; i < vec.size(); ++i)
+		{
+			assert(vec[i - 1].key <= vec[i].key);
+			if (vec[i - 1].key == vec[i].key)
+				assert(vec[i - 1].order < vec[i].order);
+		}
+	}
+
+	UseCase("NthElement");
+	{
+		unsigned state = 99;
+		tiny::vector<int> vec;
+		for (int i = 0; i < 1000; ++i)
+			vec.push_back(static_cast<int>(testRandom(state) % 100000));
+
+		tiny::vector<int> sorted(vec);
+		tiny::sort(sorted.begin(), sorted.end());
+
+		const size_t positions[] = { 0, 1, 500, 998, 999 };
+		for (auto pos : positions)
+		{
+			tiny::nth_element(vec.begin(), vec.begin() + pos, vec.end());
+			assert(vec[pos] == sorted[pos]);
+
+			for (size_t i = 0; i < pos; ++i)
+				assert(vec[i] <= vec[pos]);
+
+			for (size_t i = pos + 1; i < vec.size(); ++i)
+				assert(vec[pos] <= vec[i]);
+		}
+	}
+
+	UseCase("BinarySearch");
+	{
+		tiny::vector<int> vec;
+		for (int i = 0; i < 100; ++i)
+			vec.push_back(i / 2 * 2);
+
+		assert(tiny::lower_bound(vec.begin(), vec.end(), 10) - vec.begin() == 10);
+		assert(tiny::upper_bound(vec.begin(), vec.end(), 10) - vec.begin() == 12);
+		assert(tiny::lower_bound(vec.begin(), vec.end(), 11) - vec.begin() == 12);
+		assert(tiny::lower_bound(vec.begin(), vec.end(), 1000) == vec.end());
+		assert(tiny::binary_search(vec.begin(), vec.end(), 98));
+		assert(!tiny::binary_search(vec.begin(), vec.end(), 99));
+		assert(!tiny::binary_search(vec.begin(), vec.end(), -1));
+	}
+
+	UseCase("UniqueRemoveIf");
+	{
+		int values[] = { 1, 1, 2, 2, 2, 3, 1, 1 };
+		auto end = tiny::unique(values, values + 8);
+
+		assert(end - values == 4);
+		assert(values[0] == 1 && values[1] == 2 && values[2] == 3 && values[3] == 1);
+
+		int others[] = { 1, 2, 3, 4, 5, 6 };
+		end = tiny::remove_if(others, others + 6, [](int v) { return v % 2 == 0; });
+
+		assert(end - others == 3);
+		assert(others[0] == 1 && others[1] == 3 && others[2] == 5);
+	}
+
+	UseCase("EraseIf");
+	{
+		tiny::vector<int> vec;
+		for (int i = 0; i < 10; ++i)
+			vec.push_back(i);
+
+		auto removed = tiny::erase_if(vec, [](int v) { return v % 3 == 0; });
+
+		assert(removed == 4);
+		assert(vec.size() == 6);
+		assert(vec[0] == 1 && vec[1] == 2 && vec[2] == 4 && vec[5] == 8);
+	}
+
+	UseCase("SimdFindCount");
+	{
+		unsigned state = 31337;
+		tiny::vector<int> ints;
+		tiny::vector<unsigned char> bytes;
+		tiny::vector<unsigned short> words;
+		tiny::vector<long long> qwords;
+
+		for (int i = 0; i < 301; ++i)
+		{
+			auto value = testRandom(state);
+			ints.push_back(static_cast<int>(value % 50));
+			bytes.push_back(static_cast<unsigned char>(value % 50));
+			words.push_back(static_cast<unsigned short>(value % 50));
+			qwords.push_back(static_cast<long long>(value % 50));
+		}
+
+		for (int needle = 0; needle < 60; ++needle)
+		{
+			size_t expectedCount = 0;
+			size_t expectedIndex = ints.size();
+			for (size_t i = 0; i < ints.size(); ++i)
+			{
+				if (ints[i] != needle)
+					continue;
+
+				if (expectedIndex == ints.size())
+					expectedIndex = i;
+
+				++expectedCount;
+			}
+
+			assert(tiny::count(ints.begin(), ints.end(), needle) == expectedCount);
+			assert(tiny::count(bytes.begin(), bytes.end(), needle) == expectedCount);
+			assert(tiny::count(words.begin(), words.end(), needle) == expectedCount);
+			assert(tiny::count(qwords.begin(), qwords.end(), needle) == expectedCount);
+			assert(static_cast<size_t>(tiny::find(ints.begin(), ints.end(), needle) - ints.begin()) == expectedIndex);
+			assert(static_cast<size_t>(tiny::find(bytes.begin(), bytes.end(), needle) - bytes.begin()) == expectedIndex);
+			assert(static_cast<size_t>(tiny::find(words.begin(), words.end(), needle) - words.begin()) == expectedIndex);
+			assert(static_cast<size_t>(tiny::find(qwords.begin(), qwords.end(), needle) - qwords.begin()) == expectedIndex);
+		}
+
+		assert(tiny::find(bytes.begin(), bytes.end(), 256 + 1) == bytes.end());
+	}
+
+	UseCase("SimdMinMax");
+	{
+		unsigned state = 4242;
+		tiny::vector<int> ints;
+		tiny::vector<unsigned> uints;
+		tiny::vector<signed char> chars;
+
+		for (int i = 0; i < 77; ++i)
+		{
+			auto value = testRandom(state);
+			ints.push_back(static_cast<int>(value));
+			uints.push_back(value);
+			chars.push_back(static_cast<signed char>(value));
+		}
+
+		assert(tiny::min_element(ints.begin(), ints.end()) == tiny::min_element(ints.begin(), ints.end(), tiny::less()));
+		assert(tiny::max_element(ints.begin(), ints.end()) == tiny::max_element(ints.begin(), ints.end(), tiny::less()));
+		assert(tiny::min_element(uints.begin(), uints.end()) == tiny::min_element(uints.begin(), uints.end(), tiny::less()));
+		assert(tiny::max_element(uints.begin(), uints.end()) == tiny::max_element(uints.begin(), uints.end(), tiny::less()));
+		assert(tiny::min_element(chars.begin(), chars.end()) == tiny::min_element(chars.begin(), chars.end(), tiny::less()));
+		assert(tiny::max_element(chars.begin(), chars.end()) == tiny::max_element(chars.begin(), chars.end(), tiny::less()));
+		assert(tiny::min_element(ints.begin(), ints.begin()) == ints.begin());
+	}
+
+	return true;
+}
+
+static bool testThreadPool()
+{
+	tiny::thread_pool pool(4);
+
+	UseCase("ThreadPoolSize");
+	{
+		assert(pool.size() == 4);
+	}
+
+	UseCase("ParallelForVisitsEveryIndexOnce");
+	{
+		tiny::vector<LONG> visits;
+		visits.assign(100000, 0);
+
+		pool.parallel_for(0, visits.size(), [&](size_t i) {
+			InterlockedIncrement(&visits[i]);
+		});
+
+		for (auto v : visits)
+			assert(v == 1);
+
+		pool.parallel_for(5, 5, [&](size_t) {
+			InterlockedIncrement(&visits[0]);
+		});
+
+		assert(visits[0] == 1);
+	}
+
+	UseCase("ParallelForNested");
+	{
+		volatile LONG total = 0;
+
+		pool.parallel_for(0, 16, [&](size_t) {
+			pool.parallel_for(0, 100, [&](size_t) {
+				InterlockedIncrement(&total);
+			}, 10);
+		}, 1);
+
+		assert(total == 1600);
+	}
+
+	UseCase("ParallelReduce");
+	{
+		auto sum = pool.parallel_reduce(0, 100001, 0ull,
+			[](size_t i) { return static_cast<unsigned long long>(i); },
+			[](unsigned long long a, unsigned long long b) { return a + b; });
+
+		assert(sum == 100000ull * 100001ull / 2);
+		assert(pool.parallel_reduce(3, 3, 7, [](size_t) { return 1; }, [](int a, int b) { return a + b; }) == 7);
+	}
+
+	UseCase("ParallelSort");
+	{
+		unsigned state = 2024;
+		tiny::vector<int> vec;
+		for (int i = 0; i < 50000; ++i)
+			vec.push_back(static_cast<int>(testRandom(state) % 1000000));
+
+		pool.parallel_sort(vec.begin(), vec.end());
+
+		assert(vec.size() == 50000);
+		assert(isSorted(vec));
+	}
+
+	return true;
+}
+
+static bool testWorkQueue()
+{
+	UseCase("WorkQueueRunPending");
+	{
+		tiny::work_queue<> queue(8, 0);
+		int order[3] = {};
+		int next = 0;
+
+		for (int i = 0; i < 3; ++i)
+			assert(queue.try_submit([&, i] { order[next++] = i; }) == tiny::work_queue_result::queued);
+
+		assert(queue.depth() == 3);
+		assert(queue.run_pending() == 3);
+		assert(queue.depth() == 0);
+		assert(order[0] == 0 && order[1] == 1 && order[2] == 2);
+	}
+
+	UseCase("WorkQueueCoalesce");
+	{
+		tiny::work_queue<> queue(8, 0);
+		int runs = 0;
+
+		assert(queue.try_submit(42, [&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.try_submit(42, [&] { ++runs; }) == tiny::work_queue_result::coalesced);
+		assert(queue.try_submit(7, [&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.run_pending() == 2);
+		assert(runs == 2);
+
+		// the key is released once the item was taken
+		assert(queue.try_submit(42, [&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.run_pending() == 1);
+		assert(runs == 3);
+
+		auto stats = queue.stats();
+		assert(stats.submitted == 3);
+		assert(stats.coalesced == 1);
+		assert(stats.executed == 3);
+	}
+
+	UseCase("WorkQueueFull");
+	{
+		tiny::work_queue<> queue(2, 0);
+		int runs = 0;
+
+		assert(queue.try_submit([&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.try_submit([&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.try_submit([&] { ++runs; }) == tiny::work_queue_result::full);
+
+		LARGE_INTEGER timeout;
+		timeout.QuadPart = -10000; // 1ms
+		assert(queue.submit([&] { ++runs; }, &timeout) == tiny::work_queue_result::full);
+
+		assert(queue.run_pending() == 2);
+		assert(queue.try_submit([&] { ++runs; }) == tiny::work_queue_result::queued);
+		assert(queue.run_pending() == 1);
+		assert(runs == 3);
+		assert(queue.stats().rejected == 2);
+		assert(queue.stats().maxDepth == 2);
+	}
+
+	UseCase("WorkQueueKeyCollisions");
+	{
+		tiny::work_queue<> queue(64, 0);
+		int runs = 0;
+
+		for (ULONG64 key = 0; key < 64; ++key)
+			assert(queue.try_submit(key * 1024, [&] { ++runs; }) == tiny::work_queue_result::queued);
+
+		// draining erases the keys in submission order, which shifts entries along the probe chains
+		assert(queue.try_submit(1, [&] { ++runs; }) == tiny::work_queue_result::full);
+		assert(queue.run_pending() == 64);
+
+		for (ULONG64 key = 0; key < 32; ++key)
+			assert(queue.try_submit(key * 1024, [&] { ++runs; }) == tiny::work_queue_result::queued);
+
+		for (ULONG64 key = 0; key < 32; ++key)
+			assert(queue.try_submit(key * 1024, [&] { ++runs; }) == tiny::work_queue_result::coalesced);
+
+		assert(queue.run_pending() == 32);
+		assert(runs == 96);
+	}
+
+	UseCase("WorkQueueWorkers");
+	{
+		volatile LONG runs = 0;
+		{
+			tiny::work_queue<> queue(256, 4);
+
+			for (int i = 0; i < 10000; ++i)
+				assert(queue.submit([&] { InterlockedIncrement(&runs); }) == tiny::work_queue_result::queued);
+		}
+
+		assert(runs == 10000);
+	}
+
+	return true;
+}
+
+static int liveObjects = 0;
+
+struct TrackedObject {
+	int value;
+
+	TrackedObject(int v = 0) : value(v) {
+		++liveObjects;
+	}
+
+	TrackedObject(const TrackedObject& other) : value(other.value) {
+		++liveObjects;
+	}
+
+	~TrackedObject() {
+		--liveObjects;
+	}
+};
+
+struct TrackedRefObject : tiny::ref_counted<TrackedRefObject> {
+	TrackedObject tracked;
+};
+
+static bool testMemory()
+{
+	UseCase("UniquePtrEmptyDeleterTakesNoSpace");
+	{
+		assert(sizeof(tiny::unique_ptr<int>) == sizeof(int*));
+		assert(sizeof(tiny::unique_ptr<int, tiny::pool_delete<int, 'TSET'>>) == sizeof(int*));
+	}
+
+	UseCase("UniquePtrLifetime");
+	{
+		{
+			auto ptr = tiny::make_unique<TrackedObject>(5);
+
+			assert(ptr);
+			assert(ptr->value == 5);
+			assert(liveObjects == 1);
+
+			auto moved = tiny::move(ptr);
+
+			assert(!ptr);
+			assert(moved->value == 5);
+			assert(liveObjects == 1);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("UniquePtrReleaseReset");
+	{
+		tiny::unique_ptr<TrackedObject> ptr(new TrackedObject(1));
+		auto raw = ptr.release();
+
+		assert(!ptr);
+		assert(liveObjects == 1);
+
+		ptr.reset(raw);
+		ptr.reset();
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("UniquePtrPoolDeleter");
+	{
+		{
+			auto ptr = tiny::make_unique_pool<TrackedObject, 'TSET'>(3);
+
+			assert(ptr->value == 3);
+			assert(liveObjects == 1);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("UniquePtrLookasideDeleter");
+	{
+		LOOKASIDE_LIST_EX lookaside;
+		if (!NT_SUCCESS(ExInitializeLookasideListEx(&lookaside, nullptr, nullptr, NonPagedPoolNx, 0, sizeof(TrackedObject), 'TSET', 0)))
+			return false;
+
+		{
+			auto ptr = tiny::make_unique_lookaside<TrackedObject>(&lookaside, 4);
+
+			assert(ptr->value == 4);
+			assert(liveObjects == 1);
+		}
+
+		ExDeleteLookasideListEx(&lookaside);
+		assert(liveObjects == 0);
+	}
+
+	UseCase("SharedPtrUseCount");
+	{
+		{
+			tiny::shared_ptr<TrackedObject> ptr(new TrackedObject(2));
+			assert(ptr.use_count() == 1);
+
+			{
+				auto copy = ptr;
+
+				assert(ptr.use_count() == 2);
+				assert(copy.get() == ptr.get());
+			}
+
+			assert(ptr.use_count() == 1);
+			assert(liveObjects == 1);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("MakeShared");
+	{
+		{
+			auto ptr = tiny::make_shared<TrackedObject>(7);
+			tiny::shared_ptr<TrackedObject> other;
+
+			assert(ptr->value == 7);
+			assert(!other);
+
+			other = ptr;
+			assert(other.use_count() == 2);
+
+			ptr.reset();
+			assert(!ptr);
+			assert(other.use_count() == 1);
+			assert(liveObjects == 1);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("RefPtr");
+	{
+		{
+			auto ptr = tiny::make_ref<TrackedRefObject>();
+			assert(ptr->ref_count() == 1);
+
+			{
+				tiny::ref_ptr<TrackedRefObject> copy = ptr;
+				assert(ptr->ref_count() == 2);
+			}
+
+			assert(ptr->ref_count() == 1);
+			assert(liveObjects == 1);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	return true;
+}
+
+static bool testFuture()
+{
+	UseCase("FutureSetValue");
+	{
+		tiny::promise<int> promise;
+		auto future = promise.get_future();
+
+		assert(future.valid());
+		assert(!future.ready());
+		assert(promise.set_value(5));
+		assert(!promise.set_value(6));
+		assert(future.ready());
+		assert(future.status() == STATUS_SUCCESS);
+		assert(future.get() == 5);
+	}
+
+	UseCase("FutureWaitFor");
+	{
+		tiny::promise<int> promise;
+		auto future = promise.get_future();
+
+		assert(!future.wait_for(1));
+		promise.set_value(1);
+		assert(future.wait_for(1));
+	}
+
+	UseCase("FutureStatus");
+	{
+		tiny::future<void> future;
+		{
+			tiny::promise<void> promise;
+			future = promise.get_future();
+		}
+
+		assert(future.ready());
+		assert(future.status() == STATUS_CANCELLED);
+
+		tiny::promise<int> failing;
+		auto failed = failing.get_future();
+		failing.set_status(STATUS_DEVICE_BUSY);
+		assert(failed.status() == STATUS_DEVICE_BUSY);
+	}
+
+	UseCase("FutureValueLifetime");
+	{
+		{
+			tiny::future_slab<TrackedObject> slab;
+			tiny::promise<TrackedObject> promise(slab);
+			auto future = promise.get_future();
+
+			promise.set_value(7);
+			assert(liveObjects == 1);
+			assert(future.get().value == 7);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("FutureThen");
+	{
+		int seen = 0;
+
+		tiny::promise<int> promise;
+		auto future = promise.get_future();
+		future.then([&](tiny::future<int>&& completed) { seen = completed.get(); });
+
+		assert(seen == 0);
+		promise.set_value(3);
+		assert(seen == 3);
+
+		// attached after completion runs right away
+		tiny::promise<int> completedPromise;
+		auto completedFuture = completedPromise.get_future();
+		completedPromise.set_value(4);
+		completedFuture.then([&](tiny::future<int>&& completed) { seen = completed.get(); });
+		assert(seen == 4);
+	}
+
+	UseCase("FutureThenOnWorkQueue");
+	{
+		tiny::work_queue<> queue(8, 0);
+		int seen = 0;
+
+		{
+			tiny::promise<int> promise;
+			promise.get_future().then(queue, [&](tiny::future<int>&& completed) { seen = completed.get(); });
+			promise.set_value(9);
+		}
+
+		assert(seen == 0);
+		assert(queue.run_pending() == 1);
+		assert(seen == 9);
+	}
+
+	UseCase("WhenAll");
+	{
+		tiny::vector<tiny::promise<int>> promises;
+		tiny::vector<tiny::future<int>> futures;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			promises.push_back(tiny::promise<int>());
+			futures.push_back(promises[i].get_future());
+		}
+
+		auto all = tiny::when_all(futures);
+		for (size_t i = 0; i < promises.size(); ++i)
+		{
+			assert(!all.ready());
+			promises[i].set_value(static_cast<int>(i));
+		}
+
+		assert(all.ready());
+		assert(all.status() == STATUS_SUCCESS);
+		assert(futures[7].get() == 7);
+
+		tiny::promise<int> failing;
+		tiny::vector<tiny::future<int>> mixed;
+		mixed.push_back(failing.get_future());
+
+		auto failed = tiny::when_all(mixed);
+		failing.set_status(STATUS_DEVICE_BUSY);
+		assert(failed.status() == STATUS_DEVICE_BUSY);
+
+		tiny::vector<tiny::future<int>> none;
+		assert(tiny::when_all(none).status() == STATUS_SUCCESS);
+	}
+
+	UseCase("WhenAllAcrossThreads");
+	{
+		tiny::thread_pool pool(4);
+		tiny::vector<tiny::promise<int>> promises;
+		tiny::vector<tiny::future<int>> futures;
+
+		for (int i = 0; i < 64; ++i)
+		{
+			promises.push_back(tiny::promise<int>());
+			futures.push_back(promises[i].get_future());
+		}
+
+		auto all = tiny::when_all(futures);
+		pool.parallel_for(0, promises.size(), [&](size_t i) {
+			promises[i].set_value(static_cast<int>(i));
+		}, 1);
+
+		assert(all.status() == STATUS_SUCCESS);
+	}
+
+	return true;
+}
+
+static bool testBitset()
+{
+	UseCase("BitsetSetTest");
+	{
+		tiny::dynamic_bitset bits(130);
+
+		assert(bits.size() == 130);
+		assert(bits.none());
+		assert(bits.find_first() == tiny::dynamic_bitset::npos);
+
+		bits.set(0).set(64).set(129);
+		assert(bits.test(0) && bits.test(64) && bits[129]);
+		assert(!bits.test(1) && !bits.test(128));
+		assert(bits.count() == 3);
+
+		bits.reset(64).flip(1);
+		assert(!bits.test(64) && bits.test(1));
+		assert(bits.count() == 3);
+	}
+
+	UseCase("BitsetResize");
+	{
+		tiny::dynamic_bitset bits(10, true);
+		assert(bits.count() == 10);
+		assert(bits.all());
+
+		bits.resize(100, true);
+		assert(bits.count() == 100);
+
+		bits.resize(70);
+		assert(bits.count() == 70);
+
+		bits.resize(200);
+		assert(bits.count() == 70);
+		assert(!bits.test(70));
+
+		bits.flip();
+		assert(bits.count() == 130);
+		assert(bits.find_first() == 70);
+	}
+
+	UseCase("BitsetFind");
+	{
+		tiny::dynamic_bitset bits(300);
+		bits.set(5).set(70).set(255);
+
+		assert(bits.find_first() == 5);
+		assert(bits.find_next(5) == 70);
+		assert(bits.find_next(70) == 255);
+		assert(bits.find_next(255) == tiny::dynamic_bitset::npos);
+		assert(bits.find_last() == 255);
+
+		bits.set();
+		assert(bits.count() == 300);
+		assert(bits.find_first_clear() == tiny::dynamic_bitset::npos);
+
+		bits.reset(3).reset(200);
+		assert(bits.find_first_clear() == 3);
+		assert(bits.find_next_clear(3) == 200);
+		assert(bits.find_next_clear(200) == tiny::dynamic_bitset::npos);
+		assert(bits.find_next(299) == tiny::dynamic_bitset::npos);
+	}
+
+	UseCase("BitsetRange");
+	{
+		tiny::dynamic_bitset bits(256);
+		bits.set(10, 200, true);
+		assert(bits.count() == 190);
+		assert(bits.find_first() == 10);
+		assert(bits.find_last() == 199);
+
+		bits.set(60, 130, false);
+		assert(bits.count() == 120);
+		assert(bits.find_next_clear(10) == 60);
+		assert(bits.find_next(60) == 130);
+	}
+
+	UseCase("BitsetBulkOperations");
+	{
+		tiny::dynamic_bitset a(100);
+		tiny::dynamic_bitset b(100);
+		a.set(1).set(2).set(99);
+		b.set(2).set(3).set(99);
+
+		auto both = a;
+		both &= b;
+		assert(both.count() == 2 && both.test(2) && both.test(99));
+
+		auto either = a;
+		either |= b;
+		assert(either.count() == 4);
+
+		auto diff = a;
+		diff ^= b;
+		assert(diff.count() == 2 && diff.test(1) && diff.test(3));
+
+		auto onlyA = a;
+		onlyA.and_not(b);
+		assert(onlyA.count() == 1 && onlyA.test(1));
+
+		assert(a != b);
+		b.reset(3).set(1);
+		assert(a == b);
+	}
+
+	UseCase("AtomicBitsetClaim");
+	{
+		tiny::atomic_bitset slots(70);
+
+		assert(slots.count() == 0);
+		for (size_t i = 0; i < 70; ++i)
+			assert(slots.claim() != tiny::atomic_bitset::npos);
+
+		assert(slots.count() == 70);
+		assert(slots.claim() == tiny::atomic_bitset::npos);
+
+		slots.release(42);
+		assert(!slots.test(42));
+		assert(slots.claim() == 42);
+
+		assert(slots.reset(5));
+		assert(!slots.reset(5));
+		assert(!slots.set(5));
+		assert(slots.set(5));
+	}
+
+	UseCase("AtomicBitsetConcurrentClaims");
+	{
+		const size_t slotCount = 4096;
+		tiny::atomic_bitset slots(slotCount);
+		tiny::vector<LONG> owners;
+		owners.assign(slotCount, 0);
+
+		tiny::thread_pool pool(4);
+		pool.parallel_for(0, slotCount, [&](size_t) {
+			auto slot = slots.claim();
+			if (slot != tiny::atomic_bitset::npos)
+				InterlockedIncrement(&owners[slot]);
+		}, 16);
+
+		for (auto owner : owners)
+			assert(owner == 1);
+
+		assert(slots.claim() == tiny::atomic_bitset::npos);
+	}
+
+	return true;
+}
+
+static bool testIntern()
+{
+	UseCase("InternSharesEntries");
+	{
+		tiny::wintern_table table(16);
+
+		tiny::wstring path(L"\\Device\\HarddiskVolume3\\Windows\\explorer.exe");
+		auto first = table.intern(path.view());
+		auto second = table.intern(L"\\Device\\HarddiskVolume3\\Windows\\explorer.exe");
+		auto other = table.intern(L"\\Device\\HarddiskVolume3\\Windows\\notepad.exe");
+
+		assert(first == second);
+		assert(first.data() == second.data());
+		assert(first != other);
+		assert(first.hash() == second.hash());
+		assert(first.size() == path.size());
+		assert(first.view() == path.view());
+		assert(first.data()[first.size()] == 0);
+
+		auto empty = table.intern(L"");
+		assert(empty && empty.size() == 0);
+		assert(empty == table.intern(L""));
+	}
+
+	UseCase("InternFind");
+	{
+		tiny::intern_table table;
+
+		assert(!table.find("volume"));
+		auto interned = table.intern("volume");
+		assert(table.find("volume") == interned);
+		assert(!table.find("volum"));
+	}
+
+	UseCase("InternStatsAndPurge");
+	{
+		tiny::intern_table table(4);
+		{
+			tiny::vector<tiny::interned_string> handles;
+			for (int i = 0; i < 10; ++i)
+				handles.push_back(table.intern("\\Device\\Mup"));
+
+			auto kept = table.intern("kept");
+			table.intern("dropped");
+
+			auto stats = table.stats();
+			assert(stats.entries == 3);
+			assert(stats.references == 11);
+			assert(stats.savedBytes == 9 * sizeof("\\Device\\Mup"));
+			assert(stats.lookups == 12);
+			assert(stats.hits == 9);
+
+			assert(table.purge() == 1);
+			assert(table.stats().entries == 2);
+
+			handles.clear();
+			assert(table.purge() == 1);
+			assert(table.find("kept") == kept);
+		}
+
+		assert(table.purge() == 1);
+		assert(table.stats().entries == 0);
+	}
+
+	UseCase("InternHandleOutlivesTable");
+	{
+		tiny::interned_string survivor;
+		{
+			tiny::intern_table table;
+			survivor = table.intern("survivor");
+		}
+
+		assert(survivor.view() == tiny::string_view("survivor"));
+	}
+
+	UseCase("InternConcurrent");
+	{
+		tiny::intern_table table(64);
+		tiny::thread_pool pool(4);
+		tiny::vector<tiny::interned_string> results;
+		results.resize(4000);
+
+		pool.parallel_for(0, results.size(), [&](size_t i) {
+			char name[32];
+			tiny::format_to(name, "image{}.dll", i % 100);
+			results[i] = table.intern(name);
+
+			if (i % 500 == 0)
+				table.purge();
+		}, 8);
+
+		for (size_t i = 100; i < results.size(); ++i)
+			assert(results[i] == results[i % 100]);
+
+		assert(table.stats().entries == 100);
+	}
+
+	return true;
+}
+
+static size_t popcount64(ULONG64 value)
+{
+	size_t count = 0;
+	for (; value; value &= value - 1)
+		++count;
+
+	return count;
+}
+
+static bool testHash()
+{
+	unsigned state = 4242;
+	tiny::vector<unsigned char> data;
+	for (int i = 0; i < 2100; ++i)
+		data.push_back(static_cast<unsigned char>(testRandom(state)));
+
+	UseCase("HashDependsOnContentsOnly");
+	{
+		// every length class, the copy sits at a different alignment
+		tiny::vector<unsigned char> copy;
+		copy.resize(data.size() + 16);
+
+		for (size_t size = 0; size < data.size(); size += size < 300 ? 1 : 97)
+		{
+			auto offset = size % 16;
+			memcpy(copy.begin() + offset, data.begin(), size);
+
+			assert(tiny::hash_bytes(data.begin(), size) == tiny::hash_bytes(copy.begin() + offset, size));
+			assert(tiny::hash_bytes(data.begin(), size) != tiny::hash_bytes(data.begin(), size, 1));
+		}
+	}
+
+	UseCase("HashUpcaseMatchesUpcasedText");
+	{
+		tiny::wstring mixed;
+		tiny::wstring upper;
+		for (int i = 0; i < 700; ++i)
+		{
+			wchar_t c = static_cast<wchar_t>(L'a' + i % 26);
+			mixed.push_back(i % 3 ? c : static_cast<wchar_t>(c - 32));
+			upper.push_back(static_cast<wchar_t>(c - 32));
+
+			// also covers the scalar lanes against the SSE2 ones for long inputs
+			assert(tiny::hash_upcase(mixed.data(), mixed.size()) == tiny::hash_bytes(upper.data(), upper.size() * sizeof(wchar_t)));
+		}
+
+		tiny::case_insensitive_hash<tiny::wstring> insensitive;
+		tiny::hash<tiny::wstring> sensitive;
+		assert(insensitive(mixed) == sensitive(upper));
+		assert(sensitive(mixed) != sensitive(upper));
+
+		tiny::string path("\\??\\c:\\Windows\\System32");
+		assert(tiny::case_insensitive_hash<tiny::string>()(path) == tiny::hash<tiny::string_view>()("\\??\\C:\\WINDOWS\\SYSTEM32"));
+		assert(tiny::hash<tiny::string>()(path) == tiny::hash<tiny::string_view>()(path.view()));
+	}
+
+	UseCase("HashAvalanche");
+	{
+		// flipping any input bit has to flip each output bit about half of the time
+		const size_t sizes[] = { 4, 12, 40, 300, 1100 };
+		for (auto size : sizes)
+		{
+			size_t flips[64] = {};
+			size_t samples = 0;
+			tiny::vector<unsigned char> key;
+			key.resize(size);
+
+			for (int round = 0; round < 24; ++round)
+			{
+				for (auto& byte : key)
+					byte = static_cast<unsigned char>(testRandom(state));
+
+				auto base = tiny::hash_bytes(key.begin(), size);
+				for (size_t bit = 0; bit < size * 8; bit += size > 100 ? 7 : 1)
+				{
+					key[bit / 8] ^= static_cast<unsigned char>(1 << (bit % 8));
+					auto changed = base ^ tiny::hash_bytes(key.begin(), size);
+					key[bit / 8] ^= static_cast<unsigned char>(1 << (bit % 8));
+
+					for (int out = 0; out < 64; ++out)
+						flips[out] += (changed >> out) & 1;
+
+					++samples;
+				}
+			}
+
+			for (auto count : flips)
+				assert(count * 100 > samples * 40 && count * 100 < samples * 60);
+		}
+
+		size_t flipped = 0;
+		for (ULONG64 value = 1; value < 1000; ++value)
+		{
+			for (int bit = 0; bit < 64; ++bit)
+				flipped += popcount64(tiny::hash_mix(value) ^ tiny::hash_mix(value ^ (1ull << bit)));
+		}
+
+		assert(flipped * 100 > 999 * 64 * 32 * 95 && flipped * 100 < 999 * 64 * 32 * 105);
+	}
+
+	UseCase("HashDistribution");
+	{
+		// sequential keys spread evenly over the low bits a power of two table uses
+		const size_t keys = 65536;
+		const size_t buckets = 1024;
+		tiny::vector<unsigned> integerBuckets;
+		tiny::vector<unsigned> stringBuckets;
+		integerBuckets.assign(buckets, 0);
+		stringBuckets.assign(buckets, 0);
+
+		tiny::hash<unsigned> integerHash;
+		tiny::hash<tiny::string_view> stringHash;
+		char name[32];
+
+		for (unsigned i = 0; i < keys; ++i)
+		{
+			++integerBuckets[integerHash(i) % buckets];
+
+			auto length = tiny::format_to(name, "process{}.exe", i);
+			++stringBuckets[stringHash(tiny::string_view(name, length)) % buckets];
+		}
+
+		for (size_t i = 0; i < buckets; ++i)
+		{
+			assert(integerBuckets[i] > 32 && integerBuckets[i] < 96);
+			assert(stringBuckets[i] > 32 && stringBuckets[i] < 96);
+		}
+	}
+
+	UseCase("HashNoCollisions");
+	{
+		tiny::vector<ULONG64> hashes;
+		wchar_t name[64];
+
+		for (unsigned i = 0; i < 20000; ++i)
+		{
+			auto length = tiny::format_to(name, L"\\Device\\HarddiskVolume{}\\file{}.txt", i % 7, i);
+			hashes.push_back(tiny::hash_bytes(name, length * sizeof(wchar_t)));
+		}
+
+		tiny::sort(hashes.begin(), hashes.end());
+		for (size_t i = 1; i < hashes.size(); ++i)
+			assert(hashes[i] != hashes[i - 1]);
+	}
+
+	return true;
+}
+
+static bool testDeque()
+{
+	UseCase("DequePushPopBothEnds");
+	{
+		tiny::deque<int> values;
+		assert(values.empty());
+
+		for (int i = 0; i < 5000; ++i)
+		{
+			values.push_back(i);
+			values.push_front(-i - 1);
+		}
+
+		assert(values.size() == 10000);
+		assert(values.front() == -5000 && values.back() == 4999);
+
+		for (size_t i = 0; i < values.size(); ++i)
+			assert(values[i] == static_cast<int>(i) - 5000);
+
+		for (int i = 0; i < 4000; ++i)
+		{
+			assert(values.front() == i - 5000);
+			values.pop_front();
+			assert(values.back() == 4999 - i);
+			values.pop_back();
+		}
+
+		assert(values.size() == 2000);
+		assert(values.front() == -1000 && values.back() == 999);
+	}
+
+	UseCase("DequeElementsNeverMove");
+	{
+		tiny::deque<size_t> values;
+		values.push_back(0);
+		auto first = &values[0];
+
+		for (size_t i = 1; i < 100000; ++i)
+			i % 2 ? values.push_back(i) : values.push_front(i);
+
+		assert(first == &values[49999]);
+		assert(*first == 0);
+	}
+
+	UseCase("DequeQueueMemoryStaysBounded");
+	{
+		tiny::deque<size_t> queue;
+		for (size_t i = 0; i < 100; ++i)
+			queue.push_back(i);
+
+		auto bytes = queue.allocated_bytes();
+		for (size_t i = 100; i < 200000; ++i)
+		{
+			queue.push_back(i);
+			assert(queue.front() == i - 100);
+			queue.pop_front();
+		}
+
+		assert(queue.size() == 100);
+		assert(queue.allocated_bytes() <= bytes + tiny::deque<size_t>::ChunkSize * sizeof(size_t));
+
+		while (!queue.empty())
+			queue.pop_back();
+
+		assert(queue.allocated_bytes() <= bytes);
+	}
+
+	UseCase("DequeIterators");
+	{
+		tiny::deque<int, 64> values;
+		for (int i = 0; i < 1000; ++i)
+			values.push_front(i);
+
+		int expected = 999;
+		for (auto value : values)
+			assert(value == expected--);
+
+		assert(values.end() - values.begin() == 1000);
+		assert(values.begin()[10] == 989);
+	}
+
+	UseCase("DequeObjectLifetime");
+	{
+		{
+			tiny::deque<TrackedObject, 256> objects;
+			for (int i = 0; i < 300; ++i)
+			{
+				objects.emplace_back(i);
+				objects.emplace_front(-i);
+			}
+
+			assert(liveObjects == 600);
+
+			objects.pop_front();
+			objects.pop_back();
+			assert(liveObjects == 598);
+
+			auto copy = objects;
+			assert(liveObjects == 1196);
+			assert(copy[0].value == objects[0].value && copy.back().value == 298);
+
+			auto moved = tiny::move(copy);
+			assert(copy.empty() && moved.size() == 598);
+			assert(liveObjects == 1196);
+
+			objects.clear();
+			assert(liveObjects == 598);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("DequeMoveOnly");
+	{
+		tiny::deque<tiny::unique_ptr<int>> values;
+		for (int i = 0; i < 1000; ++i)
+			values.push_back(tiny::make_unique<int>(i));
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			assert(*values.front() == i);
+			values.pop_front();
+		}
+
+		assert(values.empty());
+	}
+
+	return true;
+}
+
+static bool testArena()
+{
+	UseCase("ArenaBumpAllocations");
+	{
+		tiny::arena arena(1024);
+
+		auto first = static_cast<char*>(arena.allocate(10));
+		auto second = static_cast<char*>(arena.allocate(10));
+		auto aligned = static_cast<char*>(arena.allocate(8, 64));
+
+		assert(first && second && aligned);
+		assert(second == first + 16);
+		assert(reinterpret_cast<ULONG_PTR>(aligned) % 64 == 0);
+		assert(arena.used() == 28);
+
+		// the last allocation can be given back, others stay
+		arena.deallocate(aligned, 8);
+		assert(arena.allocate(8, 64) == aligned);
+		arena.deallocate(first, 10);
+		assert(arena.used() == 28);
+	}
+
+	UseCase("ArenaStartsFromBuffer");
+	{
+		alignas(16) char buffer[256];
+		tiny::arena arena(buffer, sizeof(buffer), 1024);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			auto memory = static_cast<char*>(arena.allocate(16));
+			assert(memory >= buffer && memory + 16 <= buffer + sizeof(buffer));
+		}
+
+		assert(arena.reserved() == 0);
+
+		auto overflow = static_cast<char*>(arena.allocate(16));
+		assert(overflow && (overflow < buffer || overflow >= buffer + sizeof(buffer)));
+		assert(arena.reserved() > 0);
+
+		arena.release();
+		assert(arena.reserved() == 0 && arena.used() == 0);
+		assert(arena.allocate(16) == buffer);
+	}
+
+	UseCase("ArenaLargeAllocationsGetOwnBlock");
+	{
+		tiny::arena arena(1024);
+		auto small = static_cast<char*>(arena.allocate(16));
+		auto large = static_cast<char*>(arena.allocate(4096));
+		auto next = static_cast<char*>(arena.allocate(16));
+
+		assert(large);
+		memset(large, 0xAB, 4096);
+		assert(next == small + 16);
+	}
+
+	UseCase("ArenaVector");
+	{
+		tiny::arena arena(4096);
+		{
+			tiny::vector<int, tiny::arena_allocator> values((tiny::arena_allocator(arena)));
+			for (int i = 0; i < 10000; ++i)
+				values.push_back(i);
+
+			for (int i = 0; i < 10000; ++i)
+				assert(values[i] == i);
+
+			// abandoned buffers of the doublings stay below the final one
+			assert(arena.used() < 2 * values.capacity() * sizeof(int));
+
+			auto copy = values;
+			assert(copy.size() == 10000 && copy[9999] == 9999);
+		}
+
+		arena.release();
+		assert(arena.reserved() == 0);
+	}
+
+	UseCase("ArenaNew");
+	{
+		tiny::arena arena;
+		auto object = tiny::arena_new<TrackedObject>(arena, 7);
+
+		assert(object->value == 7);
+		assert(liveObjects == 1);
+
+		object->~TrackedObject();
+		assert(liveObjects == 0);
+	}
+
+	return true;
+}
+
+static bool testObjectPool()
+{
+	UseCase("ObjectPoolHandles");
+	{
+		tiny::object_pool<TrackedObject> pool;
+		{
+			auto first = pool.acquire(1);
+			auto second = pool.acquire(2);
+
+			assert(first->value == 1 && second->value == 2);
+			assert(liveObjects == 2);
+			assert(pool.stats().inUse == 2);
+
+			second.reset();
+			assert(liveObjects == 1);
+			assert(pool.stats().inUse == 1);
+		}
+
+		assert(liveObjects == 0);
+		assert(pool.stats().inUse == 0);
+		assert(pool.stats().slots == 2);
+	}
+
+	UseCase("ObjectPoolReusesSlots");
+	{
+		tiny::object_pool<TrackedObject> pool;
+		for (int i = 0; i < 10000; ++i)
+		{
+			auto object = pool.acquire(i);
+			assert(object->value == i);
+		}
+
+		// at most one slot per processor cache the thread ran on
+		assert(pool.stats().slots <= KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS));
+	}
+
+	UseCase("ObjectPoolPrewarmAndTrim");
+	{
+		tiny::object_pool<TrackedObject> pool(100, 16);
+		assert(pool.stats().slots == 100);
+
+		{
+			tiny::vector<tiny::object_pool<TrackedObject>::handle> handles;
+			for (int i = 0; i < 500; ++i)
+				handles.push_back(pool.acquire(i));
+
+			assert(pool.stats().slots == 500);
+			assert(pool.stats().highWater == 500);
+		}
+
+		// the high-water mark still asks for all of them
+		assert(pool.trim() == 0);
+		assert(pool.stats().highWater == 0);
+
+		assert(pool.trim() == 400);
+		assert(pool.stats().slots == 100);
+		assert(liveObjects == 0);
+	}
+
+#if TINY_POOL_POISON
+	UseCase("ObjectPoolPoisonsFreedSlots");
+	{
+		tiny::object_pool<TrackedObject> pool;
+		auto object = pool.acquire(0x12345678).release();
+		pool.release(object);
+
+		// the first pointer holds the free list link
+		auto bytes = reinterpret_cast<const unsigned char*>(object);
+		for (auto i = sizeof(void*); i < sizeof(TrackedObject); ++i)
+			assert(bytes[i] == 0xDD);
+	}
+#endif
+
+	UseCase("ObjectPoolConcurrentChurn");
+	{
+		tiny::object_pool<size_t> pool(0, 8);
+		tiny::thread_pool workers(4);
+		volatile LONG mismatches = 0;
+
+		workers.parallel_for(0, 4096, [&](size_t i) {
+			tiny::object_pool<size_t>::handle handles[16];
+			for (size_t j = 0; j < 16; ++j)
+				handles[j] = pool.acquire(i * 16 + j);
+
+			for (size_t j = 0; j < 16; ++j)
+			{
+				if (*handles[j] != i * 16 + j)
+					InterlockedIncrement(&mismatches);
+			}
+		}, 1);
+
+		assert(mismatches == 0);
+		assert(pool.stats().inUse == 0);
+
+		// the workers and the calling thread, 16 objects each
+		assert(pool.stats().highWater <= 5 * 16);
+	}
+
+	return true;
+}
+
+struct FlatProcessRecord {
+	ULONG pid;
+	ULONG flags;
+	tiny::flat_string<wchar_t> image;
+};
+
+struct FlatSnapshot {
+	ULONG64 timestamp;
+	tiny::flat_vector<FlatProcessRecord> processes;
+	tiny::flat_vector<tiny::flat_string<wchar_t>> names;
+	tiny::flat_vector<ULONG> ids;
+};
+
+static void writeSnapshot(tiny::flat_writer& writer, const tiny::vector<tiny::wstring>& images, const tiny::vector<ULONG>& ids)
+{
+	auto root = writer.create<FlatSnapshot>();
+	writer.get(root)->timestamp = 0x1122334455667788ull;
+
+	auto records = writer.create_array<FlatProcessRecord>(images.size());
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		auto record = writer.element(records, i);
+		writer.get(record)->pid = static_cast<ULONG>(i * 4);
+		writer.get(record)->flags = static_cast<ULONG>(i % 3);
+		writer.link(writer.field(record, &FlatProcessRecord::image), writer.write(images[i].view()));
+	}
+
+	writer.link(writer.field(root, &FlatSnapshot::processes), records);
+	writer.link(writer.field(root, &FlatSnapshot::names), writer.write_strings(images));
+	writer.link(writer.field(root, &FlatSnapshot::ids), writer.write(ids));
+	writer.finish(root);
+}
+
+static bool testFlat()
+{
+	tiny::vector<tiny::wstring> images;
+	tiny::vector<ULONG> ids;
+	for (int i = 0; i < 200; ++i)
+	{
+		tiny::wstring image(L"\\Device\\HarddiskVolume3\\Windows\\System32\\");
+		for (int j = 0; j < i % 7; ++j)
+			image += L"x";
+		image += L"svchost.exe";
+
+		images.push_back(image);
+		ids.push_back(static_cast<ULONG>(i * 31));
+	}
+
+	images[5] = L"";
+
+	tiny::flat_writer writer;
+	writeSnapshot(writer, images, ids);
+
+	UseCase("FlatRoundTrip");
+	{
+		// somewhere else entirely, as a mapping in another process would be
+		auto copy = static_cast<unsigned char*>(ALLOC_MEMORY(writer.size()));
+		memcpy(copy, writer.data(), writer.size());
+
+		tiny::flat_reader reader(copy, writer.size());
+		auto snapshot = reader.root<FlatSnapshot>();
+
+		assert(snapshot);
+		assert(snapshot->timestamp == 0x1122334455667788ull);
+		assert(reader.contains(snapshot->processes) && reader.contains(snapshot->names) && reader.contains(snapshot->ids));
+		assert(snapshot->processes.size() == images.size());
+		assert(snapshot->names.size() == images.size());
+		assert(snapshot->ids.size() == ids.size());
+
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			auto& record = snapshot->processes[i];
+			assert(record.pid == i * 4 && record.flags == i % 3);
+			assert(reader.contains(record.image) && reader.contains(snapshot->names[i]));
+
+			tiny::wstring_view image(record.image.data(), record.image.size());
+			tiny::wstring_view name(snapshot->names[i].data(), snapshot->names[i].size());
+			assert(image == images[i].view() && name == images[i].view());
+			assert(record.image.data()[record.image.size()] == 0);
+
+			assert(snapshot->ids[i] == ids[i]);
+		}
+
+		assert(snapshot->processes[5].image.empty());
+		FREE_MEMORY(copy);
+	}
+
+	UseCase("FlatFixedBuffer");
+	{
+		auto buffer = ALLOC_MEMORY(writer.size());
+		memset(buffer, 0xCC, writer.size());
+
+		// written in place, byte for byte what the growing writer produced
+		tiny::flat_writer fixed(buffer, writer.size());
+		writeSnapshot(fixed, images, ids);
+
+		assert(fixed.size() == writer.size());
+		assert(memcmp(buffer, writer.data(), writer.size()) == 0);
+		FREE_MEMORY(buffer);
+	}
+
+	UseCase("FlatReaderRejectsDamage");
+	{
+		auto copy = static_cast<unsigned char*>(ALLOC_MEMORY(writer.size()));
+		auto header = reinterpret_cast<tiny::flat_header*>(copy);
+
+		auto reset = [&] { memcpy(copy, writer.data(), writer.size()); };
+
+		reset();
+		assert(tiny::flat_reader(copy, writer.size()).valid());
+		assert(!tiny::flat_reader(copy, writer.size() - 1).valid());
+		assert(!tiny::flat_reader(copy, sizeof(tiny::flat_header) - 1).valid());
+
+		header->magic = 0;
+		assert(!tiny::flat_reader(copy, writer.size()).root<FlatSnapshot>());
+
+		reset();
+		header->version = tiny::flat_version + 1;
+		assert(!tiny::flat_reader(copy, writer.size()).valid());
+
+		reset();
+		header->root = header->size;
+		assert(!tiny::flat_reader(copy, writer.size()).root<FlatSnapshot>());
+
+		// references that leave the buffer
+		reset();
+		tiny::flat_reader reader(copy, writer.size());
+		auto snapshot = const_cast<FlatSnapshot*>(reader.root<FlatSnapshot>());
+
+		snapshot->ids.count = static_cast<unsigned int>(writer.size());
+		assert(!reader.contains(snapshot->ids));
+
+		snapshot->ids.items.offset = -0x1000;
+		snapshot->ids.count = 1;
+		assert(!reader.contains(snapshot->ids));
+
+		auto record = const_cast<FlatProcessRecord*>(&snapshot->processes[0]);
+		record->image.length += 1;
+		assert(!reader.contains(record->image));
+
+		FREE_MEMORY(copy);
+	}
+
+	return true;
+}
+
+static constexpr auto systemProcesses = tiny::make_case_insensitive_keyword_set(
+	L"System", L"smss.exe", L"csrss.exe", L"wininit.exe", L"winlogon.exe", L"services.exe",
+	L"lsass.exe", L"lsaiso.exe", L"svchost.exe", L"fontdrvhost.exe", L"dwm.exe", L"MsMpEng.exe",
+	L"Registry", L"Memory Compression", L"spoolsv.exe", L"explorer.exe", L"sihost.exe", L"taskhostw.exe");
+
+// built and searched entirely by the compiler
+static_assert(systemProcesses.find(L"lsass.exe", 9) == 6, "keyword_set lookup");
+static_assert(systemProcesses.find(L"LSASS.EXE", 9) == 6, "keyword_set case folding");
+static_assert(!systemProcesses.contains(L"lsass.ex", 8), "keyword_set prefix");
+
+static bool testKeywordSet()
+{
+	UseCase("KeywordSetFindsEveryKeyword");
+	{
+		for (size_t i = 0; i < systemProcesses.size(); ++i)
+			assert(systemProcesses.find(systemProcesses[i]) == i);
+
+		constexpr auto extensions = tiny::make_keyword_set(".exe", ".dll", ".sys", ".ps1", ".js");
+		for (size_t i = 0; i < extensions.size(); ++i)
+			assert(extensions.find(extensions[i]) == i);
+
+		assert(extensions.contains(tiny::string(".sys")));
+		assert(!extensions.contains(".SYS"));
+		assert(!extensions.contains(""));
+	}
+
+	UseCase("KeywordSetCaseInsensitive");
+	{
+		tiny::wstring name(L"SvcHost.EXE");
+		assert(systemProcesses.find(name) == 8);
+		assert(systemProcesses.find(L"memory compression") == 13);
+		assert(systemProcesses.contains(L"EXPLORER.EXE"));
+	}
+
+	UseCase("KeywordSetRejectsOthers");
+	{
+		unsigned state = 77;
+		size_t misses = 0;
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			wchar_t name[12];
+			auto size = 1 + testRandom(state) % 11;
+			for (unsigned j = 0; j < size; ++j)
+				name[j] = static_cast<wchar_t>(L'a' + testRandom(state) % 26);
+
+			misses += !systemProcesses.contains(name, size);
+		}
+
+		assert(misses == 10000);
+		assert(!systemProcesses.contains(L"svchost.exe ", 12));
+		assert(!systemProcesses.contains(L"svchost.ex_", 11));
+	}
+
+	UseCase("KeywordSetLarge");
+	{
+		// enough keywords for several per bucket
+		constexpr auto words = tiny::make_keyword_set("alpha", "bravo", "charlie", "delta", "echo", "foxtrot",
+			"golf", "hotel", "india", "juliett", "kilo", "lima", "mike", "november", "oscar", "papa", "quebec",
+			"romeo", "sierra", "tango", "uniform", "victor", "whiskey", "xray", "yankee", "zulu", "zero", "one",
+			"two", "three", "four", "five", "six", "seven", "eight", "nine", "ten", "eleven", "twelve", "thirteen");
+
+		for (size_t i = 0; i < words.size(); ++i)
+			assert(words.find(words[i]) == i);
+
+		assert(!words.contains("fourteen"));
+	}
+
+	return true;
+}
+
+static bool testBloomFilter()
+{
+	UseCase("BloomFilterNoFalseNegatives");
+	{
+		tiny::bloom_filter<ULONG64> filter(10000, 1000);
+		for (ULONG64 i = 0; i < 10000; ++i)
+			filter.insert(i * 7919);
+
+		for (ULONG64 i = 0; i < 10000; ++i)
+			assert(filter.contains(i * 7919));
+
+		// one in a thousand asked for, allow for chance
+		size_t falsePositives = 0;
+		for (ULONG64 i = 0; i < 100000; ++i)
+			falsePositives += filter.contains(i * 7919 + 1);
+
+		assert(falsePositives < 200);
+		assert(filter.size_in_bytes() % 32 == 0);
+	}
+
+	UseCase("BloomFilterLowRate");
+	{
+		// one in 100000 asked for, about 15 expected in 2M lookups
+		tiny::bloom_filter<ULONG64> filter(10000, 100000);
+		for (ULONG64 i = 0; i < 10000; ++i)
+			filter.insert(i * 7919);
+
+		size_t falsePositives = 0;
+		for (ULONG64 i = 0; i < 2000000; ++i)
+			falsePositives += filter.contains(i * 7919 + 1);
+
+		assert(falsePositives < 40);
+	}
+
+	UseCase("BloomFilterFromStrings");
+	{
+		tiny::vector<tiny::wstring> rules;
+		rules.push_back(L"\\Windows\\System32\\drivers\\etc\\hosts");
+		rules.push_back(L"\\Windows\\System32\\config\\SAM");
+		rules.push_back(L"\\ProgramData\\Agent\\policy.bin");
+
+		tiny::bloom_filter<tiny::wstring, tiny::case_insensitive_hash<tiny::wstring_view>> filter(rules, 100000);
+		assert(filter.contains(tiny::wstring_view(L"\\WINDOWS\\System32\\CONFIG\\sam")));
+		assert(filter.contains(rules[2]));
+		assert(!filter.contains(tiny::wstring_view(L"\\Windows\\notepad.exe")));
+	}
+
+	UseCase("BloomFilterConcurrentInserts");
+	{
+		tiny::bloom_filter<size_t> filter(8192, 1000);
+		tiny::thread_pool pool(4);
+		volatile LONG misses = 0;
+
+		for (size_t i = 0; i < 4096; ++i)
+			filter.insert(i);
+
+		// readers of the old keys run alongside writers of the new ones
+		pool.parallel_for(0, 8192, [&](size_t i) {
+			if (i & 1)
+				filter.insert(4096 + i / 2);
+			else if (!filter.contains(i / 2))
+				InterlockedIncrement(&misses);
+		}, 64);
+
+		assert(misses == 0);
+		for (size_t i = 0; i < 8192; ++i)
+			assert(filter.contains(i));
+	}
+
+	UseCase("CuckooFilterInsertErase");
+	{
+		tiny::cuckoo_filter<ULONG64> filter(10000, 1000);
+		for (ULONG64 i = 0; i < 10000; ++i)
+			assert(filter.insert(i));
+
+		assert(filter.size() == 10000);
+		for (ULONG64 i = 0; i < 10000; ++i)
+			assert(filter.contains(i));
+
+		for (ULONG64 i = 0; i < 10000; i += 2)
+			assert(filter.erase(i));
+
+		assert(filter.size() == 5000);
+		for (ULONG64 i = 1; i < 10000; i += 2)
+			assert(filter.contains(i));
+
+		size_t falsePositives = 0;
+		for (ULONG64 i = 0; i < 10000; i += 2)
+			falsePositives += filter.contains(i);
+
+		assert(falsePositives < 10);
+	}
+
+	UseCase("CuckooFilterFull");
+	{
+		// 95% of the slots fill, the rest is refused without losing earlier keys
+		tiny::cuckoo_filter<ULONG64> filter(950, 1000);
+		size_t inserted = 0;
+		while (filter.insert(inserted))
+			++inserted;
+
+		assert(inserted >= 950);
+		assert(filter.size() == inserted);
+
+		for (ULONG64 i = 0; i < inserted; ++i)
+			assert(filter.contains(i));
+	}
+
+	UseCase("CuckooFilterSizedFromRate");
+	{
+		tiny::cuckoo_filter<ULONG64> coarse(1000, 100);
+		tiny::cuckoo_filter<ULONG64> fine(1000, 100000);
+		assert(fine.size_in_bytes() >= coarse.size_in_bytes() * 8);
+
+		for (ULONG64 i = 0; i < 1000; ++i)
+			fine.insert(i);
+
+		size_t falsePositives = 0;
+		for (ULONG64 i = 1000; i < 201000; ++i)
+			falsePositives += fine.contains(i);
+
+		assert(falsePositives < 10);
+	}
+
+	UseCase("CuckooFilterConcurrentReaders");
+	{
+		tiny::cuckoo_filter<size_t> filter(8192, 1000);
+		tiny::thread_pool pool(4);
+		volatile LONG misses = 0;
+
+		for (size_t i = 0; i < 4096; ++i)
+			filter.insert(i);
+
+		// inserts move old fingerprints between buckets while they are looked up
+		pool.parallel_for(0, 8192, [&](size_t i) {
+			if (i & 1)
+				filter.insert(4096 + i / 2);
+			else if (!filter.contains(i / 2))
+				InterlockedIncrement(&misses);
+		}, 64);
+
+		assert(misses == 0);
+		assert(filter.size() == 8192);
+	}
+
+	return true;
+}
+
+struct ScanVerdict {
+	ULONG result;
+	ULONG64 scanTime;
+};
+
+static bool testLruCache()
+{
+	UseCase("LruCacheGetPut");
+	{
+		tiny::lru_cache<ULONG64, ScanVerdict> cache(100);
+		ScanVerdict verdict = {};
+
+		assert(!cache.get(1, verdict));
+		assert(cache.put(1, ScanVerdict{ 7, 1000 }));
+		assert(cache.get(1, verdict) && verdict.result == 7 && verdict.scanTime == 1000);
+
+		// replaces in place
+		cache.put(1, ScanVerdict{ 8, 2000 });
+		assert(cache.get(1, verdict) && verdict.result == 8);
+		assert(cache.size() == 1);
+
+		assert(cache.erase(1));
+		assert(!cache.erase(1));
+		assert(!cache.get(1, verdict));
+
+		auto stats = cache.stats();
+		assert(stats.hits == 2 && stats.misses == 2 && stats.evictions == 0);
+	}
+
+	UseCase("LruCacheEvictsLeastRecent");
+	{
+		tiny::lru_cache<ULONG64, ULONG> cache(100);
+		for (ULONG i = 0; i < 100; ++i)
+			cache.put(i, i);
+
+		// hits keep the first half alive, the rest is evicted oldest first
+		ULONG value;
+		for (ULONG i = 0; i < 50; ++i)
+			assert(cache.get(i, value) && value == i);
+
+		for (ULONG i = 100; i < 150; ++i)
+			cache.put(i, i);
+
+		assert(cache.size() == 100);
+		assert(cache.stats().evictions == 50);
+
+		for (ULONG i = 0; i < 50; ++i)
+			assert(cache.get(i, value));
+
+		for (ULONG i = 50; i < 100; ++i)
+			assert(!cache.get(i, value));
+
+		for (ULONG i = 100; i < 150; ++i)
+			assert(cache.get(i, value));
+	}
+
+	UseCase("LruCacheByteCapacity");
+	{
+		tiny::lru_cache<tiny::wstring, ULONG> cache(1000, 4096);
+		wchar_t name[32];
+
+		for (ULONG i = 0; i < 100; ++i)
+		{
+			auto length = tiny::format_to(name, L"file{}.txt", i);
+			cache.put(tiny::wstring(tiny::wstring_view(name, length)), i, 100);
+		}
+
+		auto stats = cache.stats();
+		assert(stats.entries == 40 && stats.bytes == 4000);
+		assert(stats.evictions == 60);
+
+		ULONG value;
+		assert(cache.get(tiny::wstring(L"file99.txt"), value) && value == 99);
+		assert(!cache.get(tiny::wstring(L"file0.txt"), value));
+
+		// larger than the whole budget, not cached
+		assert(!cache.put(tiny::wstring(L"huge.bin"), 1, 8192));
+		assert(!cache.get(tiny::wstring(L"huge.bin"), value));
+	}
+
+	UseCase("LruCacheReleasesEntries");
+	{
+		{
+			tiny::lru_cache<ULONG, TrackedObject> cache(10);
+			for (int i = 0; i < 100; ++i)
+				cache.put(i, TrackedObject(i));
+
+			assert(liveObjects == 10);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	UseCase("ShardedLruCacheConcurrent");
+	{
+		tiny::sharded_lru_cache<ULONG64, ULONG64> cache(4096, 0, 8);
+		tiny::thread_pool pool(4);
+		volatile LONG mismatches = 0;
+
+		pool.parallel_for(0, 16384, [&](size_t i) {
+			ULONG64 key = i % 2048;
+			ULONG64 value;
+
+			if (cache.get(key, value))
+			{
+				if (value != key * 3)
+					InterlockedIncrement(&mismatches);
+			}
+			else
+			{
+				cache.put(key, key * 3);
+			}
+		}, 64);
+
+		assert(mismatches == 0);
+
+		auto stats = cache.stats();
+		assert(stats.hits + stats.misses == 16384);
+		assert(stats.entries <= 4096);
+		assert(stats.misses >= 2048);
+
+		cache.clear();
+		assert(cache.stats().entries == 0);
+	}
+
+	return true;
+}
+
+static bool testHistogram()
+{
+	UseCase("HistogramPercentiles");
+	{
+		tiny::histogram histogram("uniform");
+		for (ULONG64 i = 1; i <= 10000; ++i)
+			histogram.record(i);
+
+		auto summary = histogram.summary();
+		assert(summary.count == 10000);
+		assert(summary.mean == 5000);
+		assert(summary.max == 10000);
+
+		// within the bucket width of the exact percentile, never below it
+		assert(summary.p50 >= 5000 && summary.p50 <= 5000 + 5000 / 16);
+		assert(summary.p99 >= 9900 && summary.p99 <= 9900 + 9900 / 16);
+		assert(summary.p999 >= 9990 && summary.p999 <= 10000);
+		assert(!strcmp(histogram.name(), "uniform"));
+	}
+
+	UseCase("HistogramSmallAndLargeValues");
+	{
+		tiny::histogram histogram;
+		for (ULONG64 i = 0; i < 16; ++i)
+			histogram.record(i);
+
+		auto snapshot = histogram.snapshot();
+		assert(snapshot.value_at(500) == 7);
+		assert(snapshot.value_at(1000) == 15);
+
+		// beyond the bucket range only max is exact
+		histogram.record(1ull << 50);
+		snapshot = histogram.snapshot();
+		assert(snapshot.max() == 1ull << 50);
+		assert(snapshot.value_at(1000) == 1ull << 50);
+		assert(snapshot.count() == 17);
+
+		histogram.reset();
+		assert(histogram.summary().count == 0 && histogram.summary().max == 0);
+	}
+
+	UseCase("HistogramMerge");
+	{
+		tiny::histogram fast;
+		tiny::histogram slow;
+		for (int i = 0; i < 990; ++i)
+			fast.record(100);
+
+		for (int i = 0; i < 10; ++i)
+			slow.record(100000);
+
+		auto merged = fast.snapshot();
+		merged.add(slow.snapshot());
+
+		auto summary = merged.summary();
+		assert(summary.count == 1000);
+		assert(summary.p50 >= 100 && summary.p50 < 107);
+		assert(summary.p99 >= 100 && summary.p99 < 107);
+		assert(summary.p999 >= 100000);
+		assert(summary.max == 100000);
+	}
+
+	UseCase("HistogramConcurrentRecording");
+	{
+		tiny::histogram histogram;
+		tiny::thread_pool pool(4);
+
+		pool.parallel_for(0, 100000, [&](size_t i) {
+			histogram.record(i % 1000);
+		}, 256);
+
+		auto summary = histogram.summary();
+		assert(summary.count == 100000);
+		assert(summary.max == 999);
+	}
+
+	UseCase("ScopedTimer");
+	{
+		TINY_HISTOGRAM(histogram, "sleep");
+		for (int i = 0; i < 3; ++i)
+		{
+			TINY_SCOPED_TIMER(histogram);
+			LARGE_INTEGER interval;
+			interval.QuadPart = -10000; // 1ms
+			KeDelayExecutionThread(KernelMode, FALSE, &interval);
+		}
+
+		{
+			TINY_SCOPED_CYCLE_TIMER(histogram);
+		}
+
+		auto summary = histogram.summary();
+#if TINY_INSTRUMENTATION
+		assert(summary.count == 4);
+		assert(summary.max >= 1000000);
+#else
+		assert(summary.count == 0);
+#endif
+		assert(!strcmp(histogram.name(), "sleep"));
+
+		tiny::stopwatch stopwatch;
+		tiny::cycle_stopwatch cycles;
+		assert(stopwatch.elapsed_nanoseconds() < 1000000000ull);
+		assert(cycles.elapsed_cycles() > 0);
+	}
+
+	return true;
+}
+
+enum TestTraceFormat : USHORT {
+	TraceVectorGrow = 1,
+	TraceScanVerdict,
+	TraceSigned,
+};
+
+static const tiny::trace_format testTraceFormats[] = {
+	{ TraceVectorGrow, "vector grow {} -> {}" },
+	{ TraceScanVerdict, "file {x} verdict {}" },
+	{ TraceSigned, "delta {i} {{raw {}}}" },
+};
+
+static bool testTrace()
+{
+	UseCase("TraceWriteAndDrain");
+	{
+		tiny::trace_buffer trace(64);
+		for (ULONG64 i = 0; i < 10; ++i)
+			TINY_TRACE(trace, TraceVectorGrow, i, i * 2);
+
+		tiny::vector<tiny::trace_record> records;
+		assert(trace.drain(records) == 0);
+		assert(records.size() == (TINY_INSTRUMENTATION ? 10 : 0));
+
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			assert(records[i].format == TraceVectorGrow);
+			assert(records[i].argCount == 2);
+			assert(records[i].args[0] == i && records[i].args[1] == i * 2);
+			assert(i == 0 || records[i].timestamp >= records[i - 1].timestamp);
+		}
+
+		// only new events on the next drain
+		trace.write(TraceScanVerdict, 0xABCDull, 3);
+		records.clear();
+		trace.drain(records);
+		assert(records.size() == 1 && records[0].args[0] == 0xABCD);
+	}
+
+	UseCase("TraceOverwritesOldest");
+	{
+		tiny::trace_buffer trace(16);
+		for (ULONG64 i = 0; i < 100; ++i)
+			trace.write(TraceVectorGrow, i);
+
+		tiny::vector<tiny::trace_record> records;
+		auto lost = trace.drain(records);
+
+		// the thread may have moved between processors, each ring keeps its newest 16
+		assert(records.size() + lost == 100);
+		assert(records[records.size() - 1].args[0] == 99);
+	}
+
+	UseCase("TraceFormatRecord");
+	{
+		tiny::trace_record record = {};
+		record.argCount = 2;
+		record.args[0] = 0x1F;
+		record.args[1] = 0;
+
+		char text[64];
+		assert(tiny::trace_format_record(text, sizeof(text), testTraceFormats[1].text, record) == 17);
+		assert(!strcmp(text, "file 1f verdict 0"));
+
+		record.args[0] = static_cast<ULONG64>(-42ll);
+		record.args[1] = 7;
+		tiny::trace_format_record(text, sizeof(text), testTraceFormats[2].text, record);
+		assert(!strcmp(text, "delta -42 {raw 7}"));
+
+		// cut like snprintf, the full length is still returned
+		char small[8];
+		record.args[0] = 1000;
+		record.args[1] = 2000;
+		assert(tiny::trace_format_record(small, sizeof(small), testTraceFormats[0].text, record) == 24);
+		assert(!strcmp(small, "vector "));
+	}
+
+	UseCase("TraceConcurrentWriters");
+	{
+		tiny::trace_buffer trace(8192);
+		tiny::thread_pool pool(4);
+
+		pool.parallel_for(0, 4000, [&](size_t i) {
+			trace.write(TraceScanVerdict, i, i & 1);
+		}, 64);
+
+		tiny::vector<tiny::trace_record> records;
+		assert(trace.drain(records) == 0);
+		assert(records.size() == 4000);
+
+		tiny::dynamic_bitset seen(4000);
+		for (auto& record : records)
+		{
+			assert(record.args[1] == (record.args[0] & 1));
+			seen.set(static_cast<size_t>(record.args[0]));
+		}
+
+		assert(seen.count() == 4000);
+	}
+
+	UseCase("TraceDump");
+	{
+		tiny::trace_buffer trace;
+		trace.write(TraceVectorGrow, 4, 8);
+		trace.write(TraceSigned, -1, 2);
+
+		tiny::vector<tiny::trace_record> records;
+		auto lost = trace.drain(records);
+
+		tiny::flat_writer writer;
+		tiny::write_trace_dump(writer, records, testTraceFormats, ARRAYSIZE(testTraceFormats), trace.frequency(), lost);
+
+		tiny::flat_reader reader(writer.data(), writer.size());
+		auto dump = reader.root<tiny::trace_dump>();
+		assert(dump && reader.contains(dump->records) && reader.contains(dump->formats));
+		assert(dump->records.size() == 2 && dump->formats.size() == 3);
+		assert(dump->frequency == trace.frequency());
+
+		auto& format = dump->formats[2];
+		assert(format.id == TraceSigned && reader.contains(format.text));
+
+		char text[64];
+		tiny::trace_format_record(text, sizeof(text), format.text.data(), dump->records[1]);
+		assert(!strcmp(text, "delta -1 {raw 2}"));
+	}
+
+	return true;
+}
+
+static bool testUnicode()
+{
+	UseCase("UnicodeAsciiRoundTrip");
+	{
+		tiny::wstring wide;
+		assert(NT_SUCCESS(tiny::to_wstring("\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\etc\\hosts", wide)));
+		assert(wide == tiny::wstring(L"\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\etc\\hosts"));
+		assert(wide.size() == wcslen(wide.data()));
+
+		tiny::string narrow;
+		assert(NT_SUCCESS(tiny::to_string(wide, narrow)));
+		assert(narrow == tiny::string("\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\etc\\hosts"));
+		assert(narrow.size() == strlen(narrow.data()));
+	}
+
+	UseCase("UnicodeMultiByteRoundTrip");
+	{
+		// U+00FC, U+5C71, U+1F600 as a surrogate pair
+		const char utf8[] = "C:\\Users\\J\xC3\xBC" "rgen\\\xE5\xB1\xB1\\\xF0\x9F\x98\x80.txt";
+		const wchar_t utf16[] = L"C:\\Users\\J\x00FC" L"rgen\\\x5C71\\\xD83D\xDE00.txt";
+
+		size_t length = 0;
+		assert(NT_SUCCESS(tiny::utf16_length(utf8, length)));
+		assert(length == wcslen(utf16));
+		assert(NT_SUCCESS(tiny::utf8_length(utf16, length)));
+		assert(length == strlen(utf8));
+
+		tiny::wstring wide;
+		assert(NT_SUCCESS(tiny::to_wstring(utf8, wide)));
+		assert(wide == tiny::wstring(utf16));
+
+		tiny::string narrow;
+		assert(NT_SUCCESS(tiny::to_string(wide, narrow)));
+		assert(narrow == tiny::string(utf8));
+	}
+
+	UseCase("UnicodeEveryPosition");
+	{
+		// a non-ASCII character at each offset crosses every block boundary of the fast paths
+		for (size_t size = 0; size < 40; ++size)
+		{
+			for (size_t at = 0; at <= size; ++at)
+			{
+				tiny::wstring source;
+				for (size_t i = 0; i < size; ++i)
+					source.push_back(static_cast<wchar_t>('a' + i % 26));
+
+				if (at < size)
+					source.insert(at + 1, static_cast<wchar_t>(at % 3 == 0 ? 0x00E9 : at % 3 == 1 ? 0x20AC : 0xD801));
+				if (at < size && at % 3 == 2)
+					source.insert(at + 2, static_cast<wchar_t>(0xDC37));
+
+				tiny::string narrow;
+				tiny::wstring wide;
+				assert(NT_SUCCESS(tiny::to_string(source, narrow)));
+				assert(NT_SUCCESS(tiny::to_wstring(narrow, wide)));
+				assert(wide == source);
+
+				size_t expected = size + (at < size ? (at % 3 == 0 ? 2 : at % 3 == 1 ? 3 : 4) : 0);
+				assert(narrow.size() == expected);
+			}
+		}
+	}
+
+	UseCase("UnicodeEmbeddedNul");
+	{
+		tiny::wstring wide;
+		assert(NT_SUCCESS(tiny::to_wstring(tiny::string_view("a\0b", 3), wide)));
+		assert(wide.size() == 3);
+		assert(wide.begin()[1] == 0);
+	}
+
+	UseCase("UnicodeRejectsInvalidUtf8");
+	{
+		const char* invalid[] = {
+			"\x80", // continuation without lead
+			"\xC0\x80", // overlong NUL
+			"\xE0\x80\x80", // overlong
+			"\xED\xA0\x80", // encoded surrogate
+			"\xF4\x90\x80\x80", // above U+10FFFF
+			"\xF5\x80\x80\x80",
+			"\xC3", // truncated
+			"abc\xE5\xB1",
+			"\xE5(\xB1",
+			"0123456789abcdef\xFF",
+		};
+
+		for (auto text : invalid)
+		{
+			tiny::wstring wide(L"unchanged");
+			size_t length = 0;
+
+			assert(tiny::utf16_length(text, length) == STATUS_ILLEGAL_CHARACTER);
+			assert(tiny::to_wstring(text, wide) == STATUS_ILLEGAL_CHARACTER);
+			assert(wide == tiny::wstring(L"unchanged"));
+		}
+	}
+
+	UseCase("UnicodeRejectsUnpairedSurrogates");
+	{
+		const wchar_t high[] = { 'a', 0xD800, 0 };
+		const wchar_t low[] = { 0xDC00, 'a', 0 };
+		const wchar_t swapped[] = { 0xDC00, 0xD800, 0 };
+		const wchar_t interrupted[] = { 0xD800, 'a', 0xDC00, 0 };
+		const wchar_t* invalid[] = { high, low, swapped, interrupted };
+
+		for (auto text : invalid)
+		{
+			tiny::string narrow;
+			size_t length = 0;
+
+			assert(tiny::utf8_length(text, length) == STATUS_ILLEGAL_CHARACTER);
+			assert(tiny::to_string(text, narrow) == STATUS_ILLEGAL_CHARACTER);
+		}
+	}
+
+	UseCase("UnicodeCallerBuffer");
+	{
+		wchar_t wide[8];
+		size_t length = 0;
+
+		assert(tiny::utf8_to_utf16("\\??\\C:\\Windows", wide, 8, length) == STATUS_BUFFER_TOO_SMALL);
+		assert(length == 14);
+
+		assert(NT_SUCCESS(tiny::utf8_to_utf16("C:\\J\xC3\xBC", wide, 8, length)));
+		assert(length == 5);
+		assert(wide[4] == 0x00FC);
+
+		char narrow[4];
+		assert(tiny::utf16_to_utf8(L"\x20AC\x20AC", narrow, 4, length) == STATUS_BUFFER_TOO_SMALL);
+		assert(length == 6);
+
+		assert(NT_SUCCESS(tiny::utf16_to_utf8(L"\x20AC", narrow, 4, length)));
+		assert(length == 3);
+		assert(!memcmp(narrow, "\xE2\x82\xAC", 3));
+	}
+
+	UseCase("UnicodeIntoArena");
+	{
+		char buffer[256];
+		tiny::arena arena(buffer, sizeof(buffer));
+
+		tiny::wstring_view wide;
+		assert(NT_SUCCESS(tiny::to_wstring("\\SystemRoot\\System32\\ntoskrnl.exe", arena, wide)));
+		assert(wide == tiny::wstring_view(L"\\SystemRoot\\System32\\ntoskrnl.exe"));
+		assert(wide.data()[wide.size()] == 0);
+
+		tiny::string_view narrow;
+		assert(NT_SUCCESS(tiny::to_string(wide, arena, narrow)));
+		assert(narrow == tiny::string_view("\\SystemRoot\\System32\\ntoskrnl.exe"));
+		assert(narrow.data()[narrow.size()] == 0);
+
+		assert(arena.reserved() == 0);
+	}
+
+	return true;
+}
+
+static bool testPriorityQueue()
+{
+	UseCase("PriorityQueuePopsInOrder");
+	{
+		tiny::priority_queue<int> queue;
+		unsigned state = 17;
+		for (int i = 0; i < 1000; ++i)
+			queue.push(static_cast<int>(testRandom(state) % 500));
+
+		assert(queue.size() == 1000);
+
+		auto previous = queue.top();
+		while (!queue.empty())
+		{
+			assert(queue.top() <= previous);
+			previous = queue.top();
+			queue.pop();
+		}
+	}
+
+	UseCase("PriorityQueueSmallestFirst");
+	{
+		tiny::priority_queue<ULONG64, tiny::greater, 2> queue;
+		const ULONG64 deadlines[] = { 50, 10, 40, 20, 30 };
+		for (auto deadline : deadlines)
+			queue.push(deadline);
+
+		for (ULONG64 expected = 10; expected <= 50; expected += 10)
+		{
+			assert(queue.top() == expected);
+			queue.pop();
+		}
+
+		assert(queue.empty());
+	}
+
+	UseCase("PriorityQueueUpdateAndErase");
+	{
+		tiny::priority_queue<int, tiny::greater> queue;
+		tiny::vector<tiny::priority_queue<int, tiny::greater>::handle> handles;
+		for (int i = 0; i < 100; ++i)
+			handles.push_back(queue.push(1000 + i));
+
+		// decrease-key moves an element to the top, raising it moves it back
+		queue.update(handles[50], 5);
+		assert(queue.top() == 5);
+		assert(queue.top_handle() == handles[50]);
+		assert(queue.get(handles[50]) == 5);
+
+		queue.update(handles[50], 5000);
+		assert(queue.top() == 1000);
+
+		queue.erase(handles[0]);
+		queue.erase(handles[99]);
+		assert(queue.size() == 98);
+		assert(queue.top() == 1001);
+
+		// handles of the remaining elements followed every move
+		for (int i = 1; i < 99; ++i)
+			assert(queue.get(handles[i]) == (i == 50 ? 5000 : 1000 + i));
+
+		// erased handles are reused
+		auto reused = queue.push(1);
+		assert(reused == handles[99] || reused == handles[0]);
+		assert(queue.top_handle() == reused);
+	}
+
+	UseCase("PriorityQueueRandomOperations");
+	{
+		tiny::priority_queue<int, tiny::less, 8> queue;
+		tiny::vector<tiny::priority_queue<int, tiny::less, 8>::handle> handles;
+		tiny::vector<int> values; // reference, indexed like handles
+		unsigned state = 5;
+
+		for (int round = 0; round < 5000; ++round)
+		{
+			auto action = testRandom(state) % 4;
+			if (action < 2 || handles.empty())
+			{
+				auto value = static_cast<int>(testRandom(state) % 10000);
+				handles.push_back(queue.push(value));
+				values.push_back(value);
+			}
+			else
+			{
+				auto i = testRandom(state) % handles.size();
+				if (action == 2)
+				{
+					values[i] = static_cast<int>(testRandom(state) % 10000);
+					queue.update(handles[i], values[i]);
+				}
+				else
+				{
+					queue.erase(handles[i]);
+					handles.erase(i);
+					values.erase(i);
+				}
+			}
+
+			auto best = *tiny::max_element(values.begin(), values.end());
+			assert(queue.size() == values.size());
+			assert(queue.top() == best);
+		}
+	}
+
+	UseCase("PriorityQueueNonTrivial");
+	{
+		struct TrackedLess {
+			bool operator()(const TrackedObject& left, const TrackedObject& right) const {
+				return left.value < right.value;
+			}
+		};
+
+		liveObjects = 0;
+		{
+			tiny::priority_queue<TrackedObject, TrackedLess> queue;
+			for (int i = 0; i < 50; ++i)
+				queue.push(TrackedObject(i * 7 % 50));
+
+			for (int i = 49; i >= 25; --i)
+			{
+				assert(queue.top().value == i);
+				queue.pop();
+			}
+
+			assert(liveObjects == 25);
+		}
+
+		assert(liveObjects == 0);
+	}
+
+	return true;
+}
+
+static bool testTimerWheel()
+{
+	UseCase("TimerWheelFiresAtExpiry");
+	{
+		tiny::timer_wheel<ULONG64> wheel(100);
+		const ULONG64 expiries[] = { 101, 150, 163, 164, 165, 227, 228, 4195, 4196, 5000, 300000, 1ull << 25 };
+		for (auto expiry : expiries)
+			wheel.schedule(expiry, expiry);
+
+		assert(wheel.size() == RTL_NUMBER_OF(expiries));
+
+		// one tick at a time up to the first few, then in jumps of varying size
+		size_t fired = 0;
+		bool early = false;
+		ULONG64 now = 100;
+		const ULONG64 steps[] = { 1, 1, 62, 1, 1, 1, 100, 4000, 1, 1, 1000000, (1ull << 25) };
+		for (auto step : steps)
+		{
+			now += step;
+			fired += wheel.advance(now, [&](ULONG64 expiry) { early |= expiry > now; });
+		}
+
+		assert(!early);
+		assert(fired == RTL_NUMBER_OF(expiries));
+		assert(wheel.size() == 0);
+		assert(wheel.now() == now);
+	}
+
+	UseCase("TimerWheelMatchesReference");
+	{
+		tiny::timer_wheel<ULONG> wheel;
+		tiny::vector<ULONG64> expiryOf;
+		tiny::vector<char> pending;
+		tiny::vector<tiny::timer_wheel<ULONG>::timer_id> ids;
+		unsigned state = 11;
+		bool wrong = false;
+
+		// a timer fires at its tick, one scheduled due already on the tick after
+		auto check = [&](ULONG i) {
+			wrong |= !pending[i] || expiryOf[i] > wheel.now() || expiryOf[i] + 1 < wheel.now();
+			pending[i] = false;
+		};
+
+		for (ULONG i = 0; i < 20000; ++i)
+		{
+			// mostly near, some far beyond the range of the lower levels
+			auto delta = testRandom(state) % 10 ? testRandom(state) % 5000 : testRandom(state) % 300000;
+			expiryOf.push_back(wheel.now() + delta);
+			pending.push_back(true);
+			ids.push_back(wheel.schedule(expiryOf[i], i));
+
+			if (i % 7 == 3)
+			{
+				assert(wheel.cancel(ids[i / 2]) == static_cast<bool>(pending[i / 2]));
+				pending[i / 2] = false;
+			}
+
+			wheel.advance(wheel.now() + testRandom(state) % 40, check);
+		}
+
+		wheel.advance(wheel.now() + 400000, check);
+
+		assert(!wrong);
+		assert(wheel.size() == 0);
+		for (auto waiting : pending)
+			assert(!waiting);
+	}
+
+	UseCase("TimerWheelCancelAndReschedule");
+	{
+		tiny::timer_wheel<int> wheel;
+		auto first = wheel.schedule(10, 1);
+		auto second = wheel.schedule(20, 2);
+		auto third = wheel.schedule(30, 3);
+
+		assert(wheel.cancel(second));
+		assert(!wheel.cancel(second));
+		assert(wheel.reschedule(third, 5));
+
+		int order[3] = {};
+		size_t count = 0;
+		wheel.advance(100, [&](int value) { order[count++] = value; });
+
+		assert(count == 2 && order[0] == 3 && order[1] == 1);
+
+		// stale ids are refused, also once their node is reused
+		assert(!wheel.cancel(first));
+		assert(!wheel.reschedule(third, 200));
+
+		auto reused = wheel.schedule(150, 4);
+		assert(reused != first && reused != third);
+		assert(!wheel.cancel(first) && !wheel.cancel(third));
+		assert(wheel.cancel(reused));
+	}
+
+	UseCase("TimerWheelExpireSchedules");
+	{
+		tiny::timer_wheel<ULONG64> wheel;
+		wheel.schedule(1, 1);
+
+		// a due timer scheduled by expire() waits for the next tick, a periodic one keeps going
+		size_t fired = 0;
+		wheel.advance(1, [&](ULONG64 value) {
+			++fired;
+			wheel.schedule(0, value + 1);
+			wheel.schedule(wheel.now() + 64, 100);
+		});
+
+		assert(fired == 1);
+		assert(wheel.size() == 2);
+
+		tiny::vector<ULONG64> ticks;
+		wheel.advance(65, [&](ULONG64 value) { ticks.push_back(wheel.now() * 1000 + value); });
+
+		assert(ticks.size() == 2);
+		assert(ticks[0] == 2002 && ticks[1] == 65100);
+	}
+
+	UseCase("TimerWheelIdleJump");
+	{
+		tiny::timer_wheel<int> wheel(1000);
+		assert(wheel.advance(1ull << 40, [](int) {}) == 0);
+		assert(wheel.now() == 1ull << 40);
+
+		wheel.schedule(wheel.now() + 3, 1);
+		assert(wheel.advance(wheel.now() + 2, [](int) {}) == 0);
+		assert(wheel.advance(wheel.now() + 1, [](int) {}) == 1);
+	}
+
+	return true;
+}
+
+struct PingPong {
+	tiny::atomic<ULONG> turn;
+	ULONG rounds;
+};
+
+static void pingPongThread(PVOID context)
+{
+	auto state = static_cast<PingPong*>(context);
+
+	// odd turns are this thread's
+	for (ULONG i = 0; i < state->rounds; ++i)
+	{
+		state->turn.wait(2 * i, tiny::memory_order_acquire);
+		state->turn.store(2 * i + 2, tiny::memory_order_release);
+		state->turn.notify_one();
+	}
+
+	PsTerminateSystemThread(STATUS_SUCCESS);
+}
+
+static bool testAtomic()
+{
+	UseCase("AtomicIntegerOperations");
+	{
+		tiny::atomic<LONG> value(5);
+		assert(value.load(tiny::memory_order_relaxed) == 5);
+
+		value.store(7, tiny::memory_order_release);
+		assert(value.load(tiny::memory_order_acquire) == 7);
+		assert(value.exchange(9, tiny::memory_order_acq_rel) == 7);
+		assert(value.fetch_add(3) == 9);
+		assert(value.fetch_sub(2, tiny::memory_order_relaxed) == 12);
+		assert(++value == 11 && value++ == 11 && value == 12);
+		assert(--value == 11 && value-- == 11 && value == 10);
+		assert((value += 5) == 15 && (value -= 15) == 0);
+
+		value = 0x0F;
+		assert(value.fetch_or(0xF0) == 0x0F && value == 0xFF);
+		assert(value.fetch_and(0x3C) == 0xFF && value == 0x3C);
+		assert(value.fetch_xor(0xFF) == 0x3C && value == 0xC3);
+
+		LONG expected = 1;
+		assert(!value.compare_exchange_strong(expected, 2) && expected == 0xC3);
+		assert(value.compare_exchange_strong(expected, 2) && value == 2);
+
+		while (!value.compare_exchange_weak(expected, 3, tiny::memory_order_acq_rel))
+			;
+
+		assert(value == 3);
+	}
+
+	UseCase("AtomicEveryWidth");
+	{
+		tiny::atomic<UCHAR> byte(0xFF);
+		assert(++byte == 0 && byte.fetch_sub(1) == 0 && byte == 0xFF);
+
+		tiny::atomic<SHORT> word(-1);
+		assert(word.fetch_add(2) == -1 && word == 1);
+
+		tiny::atomic<ULONG64> quad(1ull << 40);
+		assert(quad.fetch_add(1ull << 40) == 1ull << 40 && quad == 1ull << 41);
+		assert(quad.exchange(0) == 1ull << 41 && quad == 0);
+
+		tiny::atomic<bool> flag;
+		assert(!flag && !flag.exchange(true) && flag);
+	}
+
+	UseCase("AtomicPointerMovesByElements");
+	{
+		ULONG64 values[4] = {};
+		tiny::atomic<ULONG64*> pointer(values);
+
+		assert(pointer.fetch_add(2) == values && pointer == values + 2);
+		assert(pointer.fetch_sub(1) == values + 2 && pointer == values + 1);
+		assert(++pointer == values + 2 && (pointer -= 2) == values);
+	}
+
+	UseCase("AtomicDoubleWidth");
+	{
+		struct tagged {
+			PVOID pointer;
+			ULONG64 tag;
+		};
+
+		int target = 0;
+		tiny::atomic<tagged> head(tagged{ nullptr, 0 });
+
+		auto current = head.load(tiny::memory_order_acquire);
+		assert(!current.pointer && !current.tag);
+
+		// a swap with the right pointer but a stale tag fails
+		assert(head.compare_exchange_strong(current, tagged{ &target, 1 }));
+		auto stale = tagged{ &target, 0 };
+		assert(!head.compare_exchange_strong(stale, tagged{ nullptr, 2 }, tiny::memory_order_release));
+		assert(stale.pointer == &target && stale.tag == 1);
+
+		auto previous = head.exchange(tagged{ nullptr, 3 });
+		assert(previous.pointer == &target && previous.tag == 1);
+
+		head.store(tagged{ &target, 4 }, tiny::memory_order_release);
+		current = head;
+		assert(current.pointer == &target && current.tag == 4);
+	}
+
+	UseCase("AtomicConcurrentUpdates");
+	{
+		tiny::thread_pool pool(4);
+		tiny::atomic<ULONG64> sum;
+		tiny::atomic<LONG> maximum(-1);
+
+		struct tagged {
+			ULONG64 low;
+			ULONG64 high;
+		};
+
+		tiny::atomic<tagged> pair(tagged{ 0, 0 });
+
+		pool.parallel_for(0, 100000, [&](size_t i) {
+			sum.fetch_add(i, tiny::memory_order_relaxed);
+
+			auto seen = maximum.load(tiny::memory_order_relaxed);
+			while (seen < static_cast<LONG>(i) && !maximum.compare_exchange_weak(seen, static_cast<LONG>(i), tiny::memory_order_relaxed))
+				;
+
+			// both halves move together
+			auto current = pair.load(tiny::memory_order_relaxed);
+			while (!pair.compare_exchange_weak(current, tagged{ current.low + 1, current.high + 2 }))
+				;
+		});
+
+		assert(sum == 100000ull * 99999 / 2);
+		assert(maximum == 99999);
+
+		auto current = pair.load();
+		assert(current.low == 100000 && current.high == 200000);
+	}
+
+	UseCase("AtomicFlag");
+	{
+		tiny::atomic_flag flag;
+		assert(!flag.test());
+		assert(!flag.test_and_set(tiny::memory_order_acquire));
+		assert(flag.test_and_set() && flag.test());
+
+		// returns at once when the value differs
+		flag.wait(false);
+
+		flag.clear(tiny::memory_order_release);
+		assert(!flag.test());
+		flag.notify_all();
+	}
+
+	UseCase("AtomicWaitNotify");
+	{
+		PingPong state{ 0, 1000 };
+
+		tiny::system_thread thread;
+		thread.start(pingPongThread, &state);
+
+		for (ULONG i = 0; i < state.rounds; ++i)
+		{
+			state.turn.store(2 * i + 1, tiny::memory_order_release);
+			state.turn.notify_one();
+			state.turn.wait(2 * i + 1, tiny::memory_order_acquire);
+		}
+
+		thread.join();
+		assert(state.turn == 2 * state.rounds);
+	}
+
+	return true;
+}
+
+static bool normalizesTo(const wchar_t* path, const wchar_t* expected)
+{
+	tiny::wstring text(path);
+	tiny::normalize_path(text);
+	return text == tiny::wstring(expected);
+}
+
+static bool testPath()
+{
+	UseCase("NormalizePathPrefixes");
+	{
+		assert(normalizesTo(L"\\??\\C:\\Windows", L"\\??\\C:\\WINDOWS"));
+		assert(normalizesTo(L"\\DosDevices\\c:\\Windows", L"\\??\\C:\\WINDOWS"));
+		assert(normalizesTo(L"\\GLOBAL??\\C:\\Windows", L"\\??\\C:\\WINDOWS"));
+		assert(normalizesTo(L"\\dosdevices\\C:", L"\\??\\C:"));
+		assert(normalizesTo(L"\\Device\\HarddiskVolume3\\Windows", L"\\DEVICE\\HARDDISKVOLUME3\\WINDOWS"));
+		assert(normalizesTo(L"\\SystemRoot\\System32", L"\\SYSTEMROOT\\SYSTEM32"));
+	}
+
+	UseCase("NormalizePathDots");
+	{
+		assert(normalizesTo(L"\\??\\C:\\Windows\\.\\System32\\..\\explorer.exe", L"\\??\\C:\\WINDOWS\\EXPLORER.EXE"));
+		assert(normalizesTo(L"\\??\\C:\\a\\b\\..\\..\\..\\..\\c", L"\\??\\C:\\C"));
+		assert(normalizesTo(L"\\??\\C:\\..", L"\\??\\C:"));
+		assert(normalizesTo(L"\\??\\UNC\\server\\share\\..\\..\\file", L"\\??\\UNC\\SERVER\\SHARE\\FILE"));
+		assert(normalizesTo(L"\\Device\\Mup\\..\\x", L"\\DEVICE\\MUP\\X"));
+		assert(normalizesTo(L"\\a\\..\\..", L"\\"));
+		assert(normalizesTo(L"\\a\\.hidden\\..a\\...", L"\\A\\.HIDDEN\\..A\\..."));
+
+		// relative paths keep what they cannot resolve
+		assert(normalizesTo(L"a\\..\\..\\b\\.", L"..\\B"));
+		assert(normalizesTo(L"a\\b\\..", L"A"));
+		assert(normalizesTo(L".", L""));
+	}
+
+	UseCase("NormalizePathSeparators");
+	{
+		assert(normalizesTo(L"\\??\\C:\\\\Windows\\\\\\System32\\", L"\\??\\C:\\WINDOWS\\SYSTEM32"));
+		assert(normalizesTo(L"\\\\\\", L"\\"));
+		assert(normalizesTo(L"\\", L"\\"));
+		assert(normalizesTo(L"", L""));
+	}
+
+	UseCase("NormalizePathCaseFolding");
+	{
+		// long components take the eight character steps, the non-ASCII ones the slow path
+		assert(normalizesTo(L"\\??\\C:\\Program Files\\averylongdirectoryname\\caf\u00e9\\na\u00efve.txt",
+			L"\\??\\C:\\PROGRAM FILES\\AVERYLONGDIRECTORYNAME\\CAF\u00c9\\NA\u00cfVE.TXT"));
+		assert(normalizesTo(L"\\abcdefghijklmnopqrstuvwxyz{|}~`@[]^_", L"\\ABCDEFGHIJKLMNOPQRSTUVWXYZ{|}~`@[]^_"));
+	}
+
+	UseCase("NormalizePathVolumes");
+	{
+		tiny::volume_map volumes;
+		volumes.set(L"\\Device\\HarddiskVolume3", 7);
+		volumes.set(L"\\Device\\HarddiskVolume30", 9);
+		assert(volumes.size() == 2);
+		assert(volumes.find(L"\\DEVICE\\harddiskvolume3") == 7);
+		assert(!volumes.find(L"\\Device\\HarddiskVolume"));
+
+		tiny::wstring path(L"\\Device\\HarddiskVolume3\\Windows\\..\\Users\\\\Public\\");
+		assert(tiny::normalize_path(path, volumes) == 7);
+		assert(path == tiny::wstring(L"\\USERS\\PUBLIC"));
+
+		path = L"\\device\\harddiskvolume30\\..";
+		assert(tiny::normalize_path(path, volumes) == 9);
+		assert(path == tiny::wstring(L"\\"));
+
+		path = L"\\Device\\HarddiskVolume4\\Windows";
+		assert(tiny::normalize_path(path, volumes) == 0);
+		assert(path == tiny::wstring(L"\\DEVICE\\HARDDISKVOLUME4\\WINDOWS"));
+
+		// only the device right after \Device\ is a volume
+		path = L"\\??\\HarddiskVolume3\\x";
+		assert(tiny::normalize_path(path, volumes) == 0);
+
+		volumes.set(L"\\Device\\HarddiskVolume3", 8);
+		assert(volumes.size() == 2 && volumes.find(L"\\Device\\HarddiskVolume3") == 8);
+		assert(volumes.erase(L"\\Device\\HarddiskVolume3") && !volumes.erase(L"\\Device\\HarddiskVolume3"));
+		assert(volumes.size() == 1 && !volumes.find(L"\\Device\\HarddiskVolume3"));
+	}
+
+	UseCase("NormalizePathBuffer");
+	{
+		// in place on a UNICODE_STRING buffer
+		wchar_t buffer[] = L"\\DosDevices\\C:\\Windows\\System32\\..\\notepad.exe";
+		UNICODE_STRING name;
+		RtlInitUnicodeString(&name, buffer);
+
+		name.Length = static_cast<USHORT>(tiny::normalize_path(name.Buffer, name.Length / sizeof(wchar_t)) * sizeof(wchar_t));
+		assert(tiny::wstring_view(name.Buffer, name.Length / sizeof(wchar_t)) == tiny::wstring_view(L"\\??\\C:\\WINDOWS\\NOTEPAD.EXE"));
+	}
+
+	UseCase("NormalizePathIsStable");
+	{
+		// random paths from separators, dots and names normalize to a fixed point
+		const wchar_t* pieces[] = { L"\\", L".", L"..", L"a", L"Bc", L"\u00e9", L"??", L"UNC", L"Device", L"DosDevices", L"abcdefghijk" };
+		unsigned state = 5;
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			tiny::wstring path;
+			auto count = testRandom(state) % 12;
+			for (unsigned j = 0; j < count; ++j)
+				path += pieces[testRandom(state) % RTL_NUMBER_OF(pieces)];
+
+			auto size = path.size();
+			tiny::normalize_path(path);
+			assert(path.size() <= size);
+
+			tiny::wstring again(path);
+			tiny::normalize_path(again);
+			assert(again == path);
+
+			for (auto component : tiny::path_components(path))
+				assert(component != tiny::wstring_view(L".") && !component.empty());
+		}
+	}
+
+	UseCase("PathComponents");
+	{
+		const wchar_t* expected[] = { L"??", L"C:", L"Windows", L"System32" };
+		tiny::wstring path(L"\\??\\C:\\\\Windows\\System32\\");
+
+		size_t count = 0;
+		for (auto component : tiny::path_components(path))
+		{
+			assert(count < RTL_NUMBER_OF(expected));
+			assert(component == tiny::wstring_view(expected[count]));
+
+			// views into the path itself
+			assert(component.data() >= path.begin() && component.end() <= path.end());
+			++count;
+		}
+
+		assert(count == RTL_NUMBER_OF(expected));
+
+		count = 0;
+		for (auto component : tiny::path_components(L"\\\\"))
+			count += component.size() + 1;
+
+		assert(count == 0);
+
+		auto components = tiny::path_components(L"relative");
+		assert(components.begin() != components.end() && *components.begin() == tiny::wstring_view(L"relative"));
+	}
+
+	return true;
+}
+
+namespace tiny {
+	void runTests() {
+		Message("Starting...");
+		Execute(testVector);
+		Execute(testString);
+		Execute(testWstring);
+		Execute(testStringAppend);
+		Execute(testFormat);
+		Execute(testNtStrings);
+		Execute(testAlgorithm);
+		Execute(testThreadPool);
+		Execute(testWorkQueue);
+		Execute(testMemory);
+		Execute(testFuture);
+		Execute(testBitset);
+		Execute(testIntern);
+		Execute(testHash);
+		Execute(testDeque);
+		Execute(testArena);
+		Execute(testObjectPool);
+		Execute(testFlat);
+		Execute(testKeywordSet);
+		Execute(testBloomFilter);
+		Execute(testLruCache);
+		Execute(testHistogram);
+		Execute(testTrace);
+		Execute(testUnicode);
+		Execute(testPriorityQueue);
+		Execute(testTimerWheel);
+		Execute(testAtomic);
+		Execute(testPath);
+		Message("Finished...");
+	}
 }
\ No newline at end of file
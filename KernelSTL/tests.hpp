@@ -1,5 +1,5 @@
-#pragma once
-
-namespace tiny{
-void runTests();
+#pragma once
+
+namespace tiny{
+void runTests();
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+// Kernel builds run system threads and wait on kernel semaphores. Any other build, e.g.
+// HostTests\thread_tests.cpp, runs std::thread and std::counting_semaphore, which needs C++20,
+// and uses nothing from the kernel.
+#ifdef _KERNEL_MODE
+#define TINY_KERNEL_THREADS 1
+#include "common.hpp"
+#else
+#include <thread>
+#include <semaphore>
+#endif
+
+namespace tiny {
+#ifdef TINY_KERNEL_THREADS
+	// System thread owned by the driver, the destructor waits for the thread to exit.
+	class system_thread {
+	public:
+		system_thread& operator=(const system_thread&) = delete;
+		system_thread(const system_thread&) = delete;
+
+		inline system_thread() : _threadObject(nullptr) {
+		}
+
+		inline ~system_thread() {
+			this->join();
+		}
+
+		inline void start(PKSTART_ROUTINE routine, PVOID context) {
+			auto status = this->try_start(routine, context);
+			if (!NT_SUCCESS(status))
+				ExRaiseStatus(status);
+		}
+
+		// Like start, a failure is returned instead of raised. The thread has not run or has
+		// already exited then.
+		inline NTSTATUS try_start(PKSTART_ROUTINE routine, PVOID context) noexcept {
+			OBJECT_ATTRIBUTES attributes;
+			InitializeObjectAttributes(&attributes, nullptr, OBJ_KERNEL_HANDLE, nullptr, nullptr);
+
+			HANDLE threadHandle;
+			auto status = PsCreateSystemThread(&threadHandle, THREAD_ALL_ACCESS, &attributes, nullptr, nullptr, routine, context);
+			if (!NT_SUCCESS(status))
+				return status;
+
+			status = ObReferenceObjectByHandle(threadHandle, SYNCHRONIZE, *PsThreadType, KernelMode, &_threadObject, nullptr);
+
+			// the thread is running, without its object it can only be joined through the handle
+			if (!NT_SUCCESS(status))
+			{
+				_threadObject = nullptr;
+				ZwWaitForSingleObject(threadHandle, FALSE, nullptr);
+			}
+
+			ZwClose(threadHandle);
+			return status;
+		}
+
+		inline bool joinable() const noexcept {
+			return _threadObject != nullptr;
+		}
+
+		inline void join() {
+			if (!_threadObject)
+				return;
+
+			KeWaitForSingleObject(_threadObject, Executive, KernelMode, FALSE, nullptr);
+			ObDereferenceObject(_threadObject);
+			_threadObject = nullptr;
+		}
+	private:
+		PVOID _threadObject;
+	};
+
+	// Counting semaphore starting at zero, acquire waits at PASSIVE_LEVEL.
+	class semaphore {
+	public:
+		semaphore& operator=(const semaphore&) = delete;
+		semaphore(const semaphore&) = delete;
+
+		inline semaphore() {
+			KeInitializeSemaphore(&_semaphore, 0, MAXLONG);
+		}
+
+		inline void release(LONG count = 1) {
+			KeReleaseSemaphore(&_semaphore, 0, count, FALSE);
+		}
+
+		inline void acquire() {
+			KeWaitForSingleObject(&_semaphore, Executive, KernelMode, FALSE, nullptr);
+		}
+	private:
+		KSEMAPHORE _semaphore;
+	};
+#else
+	// std::thread joined by the destructor, start throws std::system_error on failure.
+	class system_thread {
+	public:
+		system_thread& operator=(const system_thread&) = delete;
+		system_thread(const system_thread&) = delete;
+
+		system_thread() = default;
+
+		~system_thread() {
+			this->join();
+		}
+
+		void start(void (*routine)(void* context), void* context) {
+			_thread = std::thread(routine, context);
+		}
+
+		bool joinable() const noexcept {
+			return _thread.joinable();
+		}
+
+		void join() {
+			if (_thread.joinable())
+				_thread.join();
+		}
+	private:
+		std::thread _thread;
+	};
+
+	class semaphore {
+	public:
+		semaphore& operator=(const semaphore&) = delete;
+		semaphore(const semaphore&) = delete;
+
+		semaphore()
+			: _semaphore(0) {
+		}
+
+		void release(long count = 1) {
+			_semaphore.release(count);
+		}
+
+		void acquire() {
+			_semaphore.acquire();
+		}
+	private:
+		std::counting_semaphore<> _semaphore;
+	};
+#endif
+}
@@ -0,0 +1,529 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "mutex.hpp"
+#include "thread.hpp"
+#include "algorithm.hpp"
+
+namespace tiny {
+	struct _pool_worker;
+
+	// Unit of work scheduled on the pool, tasks are owned by the job that created them.
+	struct _pool_task {
+		void (*run)(_pool_task* task, _pool_worker* worker);
+	};
+
+	/*
+	* Chase-Lev work-stealing deque with a fixed capacity. The owning worker pushes and pops at the
+	* bottom, other workers steal from the top.
+	*/
+	class _work_stealing_deque {
+	public:
+		static const LONG64 capacity = 1024;
+
+		_work_stealing_deque() noexcept
+			: _top(0), _bottom(0) {
+		}
+
+		// owner only, fails when the deque is full
+		bool push(_pool_task* task) noexcept {
+			auto bottom = _bottom;
+			if (bottom - _top >= capacity)
+				return false;
+
+			_tasks[bottom & (capacity - 1)] = task;
+			KeMemoryBarrier();
+			_bottom = bottom + 1;
+
+			return true;
+		}
+
+		// owner only
+		_pool_task* pop() noexcept {
+			auto bottom = _bottom - 1;
+			InterlockedExchange64(&_bottom, bottom);
+
+			auto top = _top;
+			if (top > bottom)
+			{
+				_bottom = bottom + 1;
+				return nullptr;
+			}
+
+			auto task = _tasks[bottom & (capacity - 1)];
+			if (top == bottom)
+			{
+				// last task, race with thieves for it
+				if (InterlockedCompareExchange64(&_top, top + 1, top) != top)
+					task = nullptr;
+
+				_bottom = bottom + 1;
+			}
+
+			return task;
+		}
+
+		// any thread
+		_pool_task* steal() noexcept {
+			auto top = _top;
+			KeMemoryBarrier();
+			auto bottom = _bottom;
+
+			if (top >= bottom)
+				return nullptr;
+
+			auto task = _tasks[top & (capacity - 1)];
+			if (InterlockedCompareExchange64(&_top, top + 1, top) != top)
+				return nullptr;
+
+			return task;
+		}
+	private:
+		volatile LONG64 _top;
+		volatile LONG64 _bottom;
+		_pool_task* volatile _tasks[capacity];
+	};
+
+	class thread_pool;
+
+	struct _pool_worker {
+		thread_pool* pool;
+		PETHREAD self;
+		system_thread thread;
+		unsigned random;
+		_work_stealing_deque deque;
+	};
+
+	// Shared state of one parallel_for call, tasks are preallocated so scheduling never allocates.
+	struct _range_job;
+
+	struct _range_task : _pool_task {
+		_range_job* job;
+		size_t begin;
+		size_t end;
+	};
+
+	struct _range_job {
+		thread_pool* pool;
+		void (*invoke)(void* body, size_t begin, size_t end);
+		void* body;
+		size_t grain;
+		volatile LONG64 pending;
+		volatile LONG64 nextTask;
+		LONG64 taskCount;
+		_range_task* tasks;
+		KEVENT done;
+	};
+
+	/*
+	* Fork-join pool of system threads with per-worker work-stealing deques. Ranges are split in
+	* halves down to the grain size, the halves are pushed on the local deque and idle workers steal
+	* the largest pending pieces from the top. Must be used at PASSIVE_LEVEL.
+	*/
+	class thread_pool {
+	public:
+		thread_pool& operator=(const thread_pool&) = delete;
+		thread_pool(const thread_pool&) = delete;
+
+		// workerCount == 0 starts one worker per active processor
+		explicit thread_pool(size_t workerCount = 0);
+		~thread_pool();
+
+		size_t size() const noexcept {
+			return _workers.size();
+		}
+
+		// Calls body(i) for every i in [begin, end), returns once all calls have finished.
+		template <typename Body>
+		void parallel_for(size_t begin, size_t end, Body&& body, size_t grain = 0);
+
+		// Calls body(first, last) for disjoint subranges covering [begin, end).
+		template <typename Body>
+		void parallel_for_range(size_t begin, size_t end, Body&& body, size_t grain = 0);
+
+		// Folds map(i) over [begin, end) with combine, chunks are combined in index order.
+		template <typename T, typename Map, typename Combine>
+		T parallel_reduce(size_t begin, size_t end, const T& identity, Map&& map, Combine&& combine, size_t grain = 0);
+
+		// Sorts chunks in parallel and merges them pairwise in parallel rounds.
+		template <typename T, typename Compare>
+		void parallel_sort(T* first, T* last, Compare comp);
+
+		template <typename T>
+		void parallel_sort(T* first, T* last) {
+			this->parallel_sort(first, last, tiny::less());
+		}
+
+		size_t grain_for(size_t count) const noexcept {
+			auto grain = count / (this->size() * 8);
+			return grain ? grain : 1;
+		}
+	private:
+		tiny::vector<_pool_worker*> _workers;
+		tiny::vector<_pool_task*> _injected;
+		tiny::mutex _injectedLock;
+		tiny::semaphore _wakeup;
+		volatile LONG _sleeping;
+		volatile LONG _stopping;
+
+		static void _workerMain(PVOID context);
+		static void _runRange(_pool_task* task, _pool_worker* worker);
+
+		void _stop();
+		void _workerLoop(_pool_worker* worker);
+		void _runJob(_range_job& job, size_t begin, size_t end);
+		void _push(_pool_worker* worker, _pool_task* task);
+		void _notify();
+		_pool_task* _findWork(_pool_worker* worker);
+		_pool_worker* _currentWorker() const noexcept;
+	};
+
+	inline thread_pool::thread_pool(size_t workerCount)
+		: _sleeping(0), _stopping(0) {
+		if (!workerCount)
+			workerCount = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+
+		_workers.reserve(workerCount);
+
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			auto worker = static_cast<_pool_worker*>(ALLOC_MEMORY(sizeof(_pool_worker)));
+			if (!worker)
+			{
+				this->_stop();
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+			}
+
+			new (worker) _pool_worker();
+			worker->pool = this;
+			worker->self = nullptr;
+			worker->random = static_cast<unsigned>(i * 2654435761u + 1);
+			_workers.push_back(worker);
+		}
+
+		// the workers started so far run on this pool, they are stopped before the raise unwinds it
+		for (auto worker : _workers)
+		{
+			auto status = worker->thread.try_start(_workerMain, worker);
+			if (!NT_SUCCESS(status))
+			{
+				this->_stop();
+				ExRaiseStatus(status);
+			}
+		}
+	}
+
+	inline thread_pool::~thread_pool() {
+		this->_stop();
+	}
+
+	// Also cleans up after a constructor that failed part way, its workers may not all run.
+	inline void thread_pool::_stop() {
+		InterlockedExchange(&_stopping, 1);
+		if (!_workers.empty())
+			_wakeup.release(static_cast<LONG>(_workers.size()));
+
+		// all workers have to exit before any deque goes away, the others may still steal from it
+		for (auto worker : _workers)
+			worker->thread.join();
+
+		for (auto worker : _workers)
+		{
+			worker->~_pool_worker();
+			FREE_MEMORY(worker);
+		}
+
+		_workers.clear();
+	}
+
+	template <typename Body>
+	inline void thread_pool::parallel_for(size_t begin, size_t end, Body&& body, size_t grain) {
+		this->parallel_for_range(begin, end, [&body](size_t first, size_t last) {
+			for (auto i = first; i < last; ++i)
+				body(i);
+		}, grain);
+	}
+
+	template <typename Body>
+	inline void thread_pool::parallel_for_range(size_t begin, size_t end, Body&& body, size_t grain) {
+		if (begin >= end)
+			return;
+
+		_range_job job;
+		job.pool = this;
+		job.body = const_cast<void*>(static_cast<const void*>(&body));
+		job.grain = grain ? grain : this->grain_for(end - begin);
+		job.invoke = [](void* context, size_t first, size_t last) {
+			(*static_cast<remove_reference_t<Body>*>(context))(first, last);
+		};
+
+		this->_runJob(job, begin, end);
+	}
+
+	template <typename T, typename Map, typename Combine>
+	inline T thread_pool::parallel_reduce(size_t begin, size_t end, const T& identity, Map&& map, Combine&& combine, size_t grain) {
+		if (begin >= end)
+			return identity;
+
+		if (!grain)
+			grain = this->grain_for(end - begin);
+
+		auto chunks = (end - begin + grain - 1) / grain;
+		tiny::vector<T> partials;
+		partials.assign(chunks, identity);
+
+		this->parallel_for(0, chunks, [&](size_t chunk) {
+			auto first = begin + chunk * grain;
+			auto last = end - first > grain ? first + grain : end;
+
+			T value = identity;
+			for (auto i = first; i < last; ++i)
+				value = combine(value, map(i));
+
+			partials[chunk] = value;
+		}, 1);
+
+		T result = identity;
+		for (const auto& value : partials)
+			result = combine(result, value);
+
+		return result;
+	}
+
+	template <typename T, typename Compare>
+	inline void thread_pool::parallel_sort(T* first, T* last, Compare comp) {
+		size_t count = last - first;
+		auto chunk = this->grain_for(count);
+		if (chunk < 2048)
+			chunk = 2048;
+
+		if (count <= chunk || this->size() < 2)
+			return tiny::sort(first, last, comp);
+
+		auto chunks = (count + chunk - 1) / chunk;
+		this->parallel_for(0, chunks, [&](size_t index) {
+			auto chunkFirst = first + index * chunk;
+			auto chunkLast = count - index * chunk > chunk ? chunkFirst + chunk : last;
+			tiny::sort(chunkFirst, chunkLast, comp);
+		}, 1);
+
+		tiny::vector<T> buffer(count);
+		auto source = first;
+		auto target = buffer.begin();
+
+		for (auto width = chunk; width < count; width *= 2)
+		{
+			auto pairs = (count + 2 * width - 1) / (2 * width);
+
+			this->parallel_for(0, pairs, [&](size_t pair) {
+				auto left = pair * 2 * width;
+				auto middle = left + width < count ? left + width : count;
+				auto right = middle + width < count ? middle + width : count;
+
+				auto l = source + left;
+				auto r = source + middle;
+				auto out = target + left;
+
+				while (l != source + middle && r != source + right)
+					*out++ = comp(*r, *l) ? tiny::move(*r++) : tiny::move(*l++);
+
+				while (l != source + middle)
+					*out++ = tiny::move(*l++);
+
+				while (r != source + right)
+					*out++ = tiny::move(*r++);
+			}, 1);
+
+			tiny::swap(source, target);
+		}
+
+		if (source != first)
+		{
+			this->parallel_for_range(0, count, [&](size_t begin, size_t end) {
+				for (auto i = begin; i < end; ++i)
+					first[i] = tiny::move(source[i]);
+			});
+		}
+	}
+
+	//
+	// private
+	//
+
+	inline void thread_pool::_workerMain(PVOID context) {
+		auto worker = static_cast<_pool_worker*>(context);
+		worker->self = PsGetCurrentThread();
+		worker->pool->_workerLoop(worker);
+
+		PsTerminateSystemThread(STATUS_SUCCESS);
+	}
+
+	inline void thread_pool::_workerLoop(_pool_worker* worker) {
+		const int spinCount = 256;
+
+		while (!_stopping)
+		{
+			auto task = this->_findWork(worker);
+
+			for (int spin = 0; !task && spin < spinCount && !_stopping; ++spin)
+			{
+				YieldProcessor();
+				task = this->_findWork(worker);
+			}
+
+			if (!task)
+			{
+				InterlockedIncrement(&_sleeping);
+
+				// recheck after announcing the sleep, _notify reads _sleeping after publishing work
+				task = this->_findWork(worker);
+				if (!task && !_stopping)
+					_wakeup.acquire();
+
+				InterlockedDecrement(&_sleeping);
+			}
+
+			if (task)
+				task->run(task, worker);
+		}
+	}
+
+	inline void thread_pool::_runRange(_pool_task* task, _pool_worker* worker) {
+		auto rangeTask = static_cast<_range_task*>(task);
+		auto job = rangeTask->job;
+		auto begin = rangeTask->begin;
+		auto end = rangeTask->end;
+
+		while (end - begin > job->grain)
+		{
+			auto index = InterlockedIncrement64(&job->nextTask) - 1;
+			if (index >= job->taskCount)
+				break;
+
+			auto middle = begin + (end - begin) / 2;
+			auto& child = job->tasks[index];
+			child.run = _runRange;
+			child.job = job;
+			child.begin = middle;
+			child.end = end;
+
+			InterlockedIncrement64(&job->pending);
+			job->pool->_push(worker, &child);
+			end = middle;
+		}
+
+		job->invoke(job->body, begin, end);
+
+		if (InterlockedDecrement64(&job->pending) == 0)
+			KeSetEvent(&job->done, 0, FALSE);
+	}
+
+	inline void thread_pool::_runJob(_range_job& job, size_t begin, size_t end) {
+		// every split produces one task and leaves are never smaller than half the grain
+		job.taskCount = static_cast<LONG64>(2 * ((end - begin) / job.grain) + 2);
+		job.tasks = static_cast<_range_task*>(ALLOC_MEMORY(job.taskCount * sizeof(_range_task)));
+		if (!job.tasks)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		job.pending = 1;
+		job.nextTask = 1;
+		KeInitializeEvent(&job.done, NotificationEvent, FALSE);
+
+		auto& root = job.tasks[0];
+		root.run = _runRange;
+		root.job = &job;
+		root.begin = begin;
+		root.end = end;
+
+		auto worker = this->_currentWorker();
+		if (worker)
+		{
+			// nested call from a worker, keep executing tasks instead of blocking the thread
+			this->_push(worker, &root);
+			while (job.pending)
+			{
+				auto task = this->_findWork(worker);
+				if (task)
+					task->run(task, worker);
+				else
+					YieldProcessor();
+			}
+
+			// the last task may still be inside KeSetEvent
+			KeWaitForSingleObject(&job.done, Executive, KernelMode, FALSE, nullptr);
+		}
+		else
+		{
+			this->_push(nullptr, &root);
+			KeWaitForSingleObject(&job.done, Executive, KernelMode, FALSE, nullptr);
+		}
+
+		FREE_MEMORY(job.tasks);
+	}
+
+	inline void thread_pool::_push(_pool_worker* worker, _pool_task* task) {
+		if (!worker || !worker->deque.push(task))
+		{
+			tiny::scoped_lock<tiny::mutex> lock(_injectedLock);
+			_injected.push_back(task);
+		}
+
+		this->_notify();
+	}
+
+	inline void thread_pool::_notify() {
+		KeMemoryBarrier();
+		if (_sleeping > 0)
+			_wakeup.release();
+	}
+
+	inline _pool_task* thread_pool::_findWork(_pool_worker* worker) {
+		auto task = worker->deque.pop();
+		if (task)
+			return task;
+
+		if (!_injected.empty())
+		{
+			tiny::scoped_lock<tiny::mutex> lock(_injectedLock);
+			if (!_injected.empty())
+			{
+				task = _injected[_injected.size() - 1];
+				_injected.pop_back();
+				return task;
+			}
+		}
+
+		// xorshift picks the first victim, then the others are tried in order
+		worker->random ^= worker->random << 13;
+		worker->random ^= worker->random >> 17;
+		worker->random ^= worker->random << 5;
+
+		auto count = _workers.size();
+		auto start = worker->random % count;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto victim = _workers[(start + i) % count];
+			if (victim == worker)
+				continue;
+
+			task = victim->deque.steal();
+			if (task)
+				return task;
+		}
+
+		return nullptr;
+	}
+
+	inline _pool_worker* thread_pool::_currentWorker() const noexcept {
+		auto current = PsGetCurrentThread();
+		for (auto worker : _workers)
+		{
+			if (worker->self == current)
+				return worker;
+		}
+
+		return nullptr;
+	}
+}
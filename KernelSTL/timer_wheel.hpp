@@ -0,0 +1,301 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "bitset.hpp"
+
+namespace tiny {
+	/*
+	* Hierarchical timing wheel for large numbers of deadlines in ticks of the caller's choosing,
+	* e.g. KeQueryInterruptTime() in 10ms units. Four levels of 64 slots cover 2^24 ticks ahead,
+	* later deadlines wait on the last level and are placed again as it turns. schedule() and
+	* cancel() are O(1). advance() is driven by one periodic tick, it fires every timer that is
+	* due as a batch and moves timers between levels only when a level turns. Timers live in a
+	* tiny::vector, ids carry a generation so a stale id is refused. Not synchronized, callers
+	* share one lock with the tick.
+	*/
+	template <typename T>
+	class timer_wheel {
+	public:
+		using timer_id = ULONG64; // never 0
+
+		timer_wheel& operator=(const timer_wheel&) = delete;
+		timer_wheel(const timer_wheel&) = delete;
+
+		explicit timer_wheel(ULONG64 now = 0);
+
+		ULONG64 now() const noexcept {
+			return _next - 1;
+		}
+
+		size_t size() const noexcept {
+			return _size;
+		}
+
+		// room for count timers without growing
+		void reserve(size_t count) {
+			_nodes.reserve(count);
+		}
+
+		// timers due already fire on the next tick
+		timer_id schedule(ULONG64 expiry, const T& payload) {
+			return this->_schedule(expiry, T(payload));
+		}
+
+		timer_id schedule(ULONG64 expiry, T&& payload) {
+			return this->_schedule(expiry, tiny::move(payload));
+		}
+
+		// false when the timer already fired or was canceled
+		bool cancel(timer_id id) noexcept;
+
+		bool reschedule(timer_id id, ULONG64 expiry) noexcept;
+
+		// Processes the ticks up to now and calls expire(T&&) for every timer due by then, in
+		// order of their ticks. expire may schedule and cancel timers, returns the number fired.
+		template <typename Expire>
+		size_t advance(ULONG64 now, Expire&& expire);
+	private:
+		static constexpr ULONG _slotBits = 6;
+		static constexpr ULONG _slots = 1 << _slotBits;
+		static constexpr ULONG _levels = 4;
+		static constexpr ULONG64 _range = 1ull << (_slotBits * _levels);
+		static constexpr ULONG _firing = _levels * _slots; // list of the tick being fired
+		static constexpr ULONG _none = MAXULONG;
+
+		struct _node {
+			ULONG64 expiry;
+			ULONG next;
+			ULONG prev;
+			ULONG list; // _none while free
+			ULONG generation;
+			T payload;
+		};
+
+		tiny::vector<_node> _nodes;
+		ULONG _free; // free nodes chained through next
+		ULONG _heads[_firing + 1];
+		ULONG64 _occupied[_levels]; // slots with timers, by level
+		ULONG64 _next; // first tick not processed
+		size_t _size;
+
+		timer_id _schedule(ULONG64 expiry, T&& payload);
+		void _place(ULONG index) noexcept;
+		void _link(ULONG index, ULONG list) noexcept;
+		void _unlink(ULONG index) noexcept;
+		void _cascade(ULONG level, ULONG slot) noexcept;
+		_node* _find(timer_id id) noexcept;
+	};
+
+	template <typename T>
+	inline timer_wheel<T>::timer_wheel(ULONG64 now)
+		: _free(_none), _next(now + 1), _size(0) {
+		for (auto& head : _heads)
+			head = _none;
+
+		for (auto& occupied : _occupied)
+			occupied = 0;
+	}
+
+	template <typename T>
+	inline bool timer_wheel<T>::cancel(timer_id id) noexcept {
+		auto node = this->_find(id);
+		if (!node)
+			return false;
+
+		auto index = static_cast<ULONG>(node - _nodes.begin());
+		this->_unlink(index);
+
+		node->payload = T();
+		node->list = _none;
+		node->next = _free;
+		_free = index;
+		--_size;
+
+		return true;
+	}
+
+	template <typename T>
+	inline bool timer_wheel<T>::reschedule(timer_id id, ULONG64 expiry) noexcept {
+		auto node = this->_find(id);
+		if (!node)
+			return false;
+
+		auto index = static_cast<ULONG>(node - _nodes.begin());
+		this->_unlink(index);
+
+		node->expiry = expiry;
+		this->_place(index);
+
+		return true;
+	}
+
+	template <typename T>
+	template <typename Expire>
+	inline size_t timer_wheel<T>::advance(ULONG64 now, Expire&& expire) {
+		size_t fired = 0;
+
+		while (_next <= now)
+		{
+			if (!_size)
+			{
+				_next = now + 1;
+				break;
+			}
+
+			auto tick = _next;
+			auto slot = static_cast<ULONG>(tick & (_slots - 1));
+
+			// a level turns when the ones below it wrap around
+			for (ULONG level = 1; level < _levels && !(tick & ((1ull << (_slotBits * level)) - 1)); ++level)
+				this->_cascade(level, static_cast<ULONG>(tick >> (_slotBits * level)) & (_slots - 1));
+
+			if (!(_occupied[0] & (1ull << slot)))
+			{
+				// skip empty slots up to the next turn of level 1
+				auto ahead = _occupied[0] & ~((2ull << slot) - 1);
+				auto skip = ahead ? _lowest_bit(ahead) - slot : _slots - slot;
+				auto last = now + 1 - tick;
+
+				_next = tick + (skip < last ? skip : last);
+				continue;
+			}
+
+			// timers scheduled by expire() go behind this tick, even when they are due already
+			_heads[_firing] = tiny::exchange(_heads[slot], _none);
+			_occupied[0] &= ~(1ull << slot);
+			for (auto index = _heads[_firing]; index != _none; index = _nodes[index].next)
+				_nodes[index].list = _firing;
+
+			_next = tick + 1;
+
+			while (_heads[_firing] != _none)
+			{
+				auto index = _heads[_firing];
+				this->_unlink(index);
+
+				auto& node = _nodes[index];
+				auto payload = tiny::move(node.payload);
+				node.payload = T();
+				node.list = _none;
+				node.next = _free;
+				_free = index;
+				--_size;
+
+				expire(tiny::move(payload));
+				++fired;
+			}
+		}
+
+		return fired;
+	}
+
+	//
+	// private
+	//
+
+	template <typename T>
+	inline typename timer_wheel<T>::timer_id timer_wheel<T>::_schedule(ULONG64 expiry, T&& payload) {
+		ULONG index;
+		if (_free != _none)
+		{
+			index = _free;
+			_free = _nodes[index].next;
+			_nodes[index].payload = tiny::move(payload);
+		}
+		else
+		{
+			index = static_cast<ULONG>(_nodes.size());
+			_nodes.push_back(_node{ 0, _none, _none, _none, 0, tiny::move(payload) });
+		}
+
+		auto& node = _nodes[index];
+		node.expiry = expiry;
+
+		// ids of released nodes stop matching
+		if (!++node.generation)
+			node.generation = 1;
+
+		this->_place(index);
+		++_size;
+
+		return static_cast<timer_id>(node.generation) << 32 | index;
+	}
+
+	// Puts the timer into the slot that is processed or cascaded at its expiry.
+	template <typename T>
+	inline void timer_wheel<T>::_place(ULONG index) noexcept {
+		auto expiry = _nodes[index].expiry > _next ? _nodes[index].expiry : _next;
+		auto delta = expiry - _next;
+
+		if (delta >= _range)
+		{
+			expiry = _next + _range - 1;
+			delta = _range - 1;
+		}
+
+		ULONG level = 0;
+		while (delta >= 1ull << (_slotBits * (level + 1)))
+			++level;
+
+		auto slot = static_cast<ULONG>(expiry >> (_slotBits * level)) & (_slots - 1);
+		this->_link(index, level * _slots + slot);
+		_occupied[level] |= 1ull << slot;
+	}
+
+	template <typename T>
+	inline void timer_wheel<T>::_link(ULONG index, ULONG list) noexcept {
+		auto& node = _nodes[index];
+		node.list = list;
+		node.prev = _none;
+		node.next = _heads[list];
+
+		if (node.next != _none)
+			_nodes[node.next].prev = index;
+
+		_heads[list] = index;
+	}
+
+	template <typename T>
+	inline void timer_wheel<T>::_unlink(ULONG index) noexcept {
+		auto& node = _nodes[index];
+
+		if (node.prev != _none)
+			_nodes[node.prev].next = node.next;
+		else
+			_heads[node.list] = node.next;
+
+		if (node.next != _none)
+			_nodes[node.next].prev = node.prev;
+
+		if (node.list != _firing && _heads[node.list] == _none)
+			_occupied[node.list / _slots] &= ~(1ull << (node.list % _slots));
+	}
+
+	template <typename T>
+	inline void timer_wheel<T>::_cascade(ULONG level, ULONG slot) noexcept {
+		auto index = tiny::exchange(_heads[level * _slots + slot], _none);
+		_occupied[level] &= ~(1ull << slot);
+
+		while (index != _none)
+		{
+			auto next = _nodes[index].next;
+			this->_place(index);
+			index = next;
+		}
+	}
+
+	template <typename T>
+	inline typename timer_wheel<T>::_node* timer_wheel<T>::_find(timer_id id) noexcept {
+		auto index = static_cast<ULONG>(id);
+		if (index >= _nodes.size())
+			return nullptr;
+
+		auto& node = _nodes[index];
+		if (node.list == _none || node.generation != static_cast<ULONG>(id >> 32))
+			return nullptr;
+
+		return &node;
+	}
+}
@@ -1,6 +1,34 @@
-#pragma once
-
-#include "common.hpp"
-#include "vector.hpp"
-#include "string.hpp"
-#include "mutex.hpp"
+#pragma once
+
+#include "common.hpp"
+#include "vector.hpp"
+#include "string_view.hpp"
+#include "string.hpp"
+#include "format.hpp"
+#include "mutex.hpp"
+#include "utility.hpp"
+#include "memory.hpp"
+#include "algorithm.hpp"
+#include "thread.hpp"
+#include "thread_pool.hpp"
+#include "work_queue.hpp"
+#include "future.hpp"
+#include "bitset.hpp"
+#include "hash.hpp"
+#include "intern.hpp"
+#include "deque.hpp"
+#include "arena.hpp"
+#include "object_pool.hpp"
+#include "flat.hpp"
+#include "keyword_set.hpp"
+#include "bloom_filter.hpp"
+#include "lru_cache.hpp"
+#include "stopwatch.hpp"
+#include "histogram.hpp"
+#include "trace_layout.hpp"
+#include "trace.hpp"
+#include "unicode.hpp"
+#include "priority_queue.hpp"
+#include "timer_wheel.hpp"
+#include "atomic.hpp"
+#include "path.hpp"
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "mutex.hpp"
+#include "algorithm.hpp"
+#include "flat.hpp"
+#include "stopwatch.hpp"
+#include "trace_layout.hpp"
+
+namespace tiny {
+	template <typename T>
+	inline ULONG64 _trace_arg(T value) noexcept {
+		if constexpr (is_pointer_v<T>)
+			return reinterpret_cast<ULONG_PTR>(value);
+		else
+			return static_cast<ULONG64>(static_cast<LONG64>(value)); // signed values sign-extend for {i}
+	}
+
+	/*
+	* Binary event log with a ring per processor. An event is a format id, up to six integer or
+	* pointer arguments and a performance counter timestamp in one cache-line slot. Writers
+	* claim a slot of the local ring with one interlocked increment and never wait, when a ring
+	* is full the oldest events are overwritten. drain() collects what the rings hold ordered by
+	* time, the text is only produced by trace_format_record when someone reads it.
+	* write() is usable at any IRQL, drain() up to DISPATCH_LEVEL.
+	*/
+	class trace_buffer {
+	public:
+		trace_buffer& operator=(const trace_buffer&) = delete;
+		trace_buffer(const trace_buffer&) = delete;
+
+		// rounded up to a power of two
+		explicit trace_buffer(size_t eventsPerProcessor = 4096);
+		~trace_buffer();
+
+		template <typename... Args>
+		void write(USHORT format, Args... args) noexcept {
+			static_assert(sizeof...(Args) <= trace_max_args, "trace events take up to six arguments");
+
+			ULONG64 values[sizeof...(Args) + 1] = { _trace_arg(args)... };
+			this->_write(format, values, sizeof...(Args));
+		}
+
+		// Appends the events written since the last drain, returns the number lost to overwriting.
+		ULONG64 drain(tiny::vector<trace_record>& records);
+
+		ULONG64 frequency() const noexcept {
+			return _frequency;
+		}
+	private:
+		// header: committed bit, argument count, format, event index
+		static constexpr ULONG64 _committed = 1ull << 63;
+		static constexpr ULONG64 _indexMask = (1ull << 40) - 1;
+
+		struct _slot {
+			volatile ULONG64 header;
+			volatile ULONG64 timestamp;
+			volatile ULONG64 args[trace_max_args];
+		};
+
+		struct _ring {
+			volatile LONG64 head; // events claimed since the start
+			LONG64 read;
+			_slot* slots;
+			char padding[64];
+		};
+
+		_ring* _rings;
+		ULONG _ringCount;
+		size_t _mask;
+		ULONG64 _frequency;
+		tiny::spin_lock _drainLock;
+
+		void _write(USHORT format, const ULONG64* args, size_t count) noexcept;
+		void _free() noexcept;
+	};
+
+	inline trace_buffer::trace_buffer(size_t eventsPerProcessor)
+		: _mask(0) {
+		size_t slots = 1;
+		while (slots < eventsPerProcessor)
+			slots <<= 1;
+
+		_mask = slots - 1;
+
+		LARGE_INTEGER frequency;
+		KeQueryPerformanceCounter(&frequency);
+		_frequency = static_cast<ULONG64>(frequency.QuadPart);
+
+		_ringCount = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+		_rings = static_cast<_ring*>(ALLOC_MEMORY(_ringCount * sizeof(_ring)));
+		if (!_rings)
+			ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+		memset(_rings, 0, _ringCount * sizeof(_ring));
+
+		// slot arrays of a page or more come page aligned, so slots stay within a cache line
+		for (ULONG i = 0; i < _ringCount; ++i)
+		{
+			_rings[i].slots = static_cast<_slot*>(ALLOC_MEMORY(slots * sizeof(_slot)));
+			if (!_rings[i].slots)
+			{
+				this->_free();
+				ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+			}
+
+			memset(_rings[i].slots, 0, slots * sizeof(_slot));
+		}
+	}
+
+	inline trace_buffer::~trace_buffer() {
+		this->_free();
+	}
+
+	inline ULONG64 trace_buffer::drain(tiny::vector<trace_record>& records) {
+		tiny::scoped_lock<tiny::spin_lock> lock(_drainLock);
+
+		auto first = records.size();
+		ULONG64 lost = 0;
+
+		for (ULONG processor = 0; processor < _ringCount; ++processor)
+		{
+			auto& ring = _rings[processor];
+			auto head = ring.head;
+			auto capacity = static_cast<LONG64>(_mask + 1);
+
+			if (head - ring.read > capacity)
+			{
+				lost += static_cast<ULONG64>(head - capacity - ring.read);
+				ring.read = head - capacity;
+			}
+
+			for (; ring.read < head; ++ring.read)
+			{
+				auto& slot = ring.slots[static_cast<size_t>(ring.read) & _mask];
+				auto header = slot.header;
+				auto index = static_cast<ULONG64>(ring.read) & _indexMask;
+
+				// a writer that claimed the slot has not finished, pick it up next time
+				if (!(header & _committed) || (header & _indexMask) < index)
+					break;
+
+				trace_record record;
+				record.timestamp = slot.timestamp;
+				record.processor = processor;
+				record.format = static_cast<unsigned short>(header >> 40);
+				record.argCount = static_cast<unsigned short>((header >> 56) & 0xF);
+				for (unsigned int i = 0; i < trace_max_args; ++i)
+					record.args[i] = i < record.argCount ? slot.args[i] : 0;
+
+				// overwritten by a later round while it was copied
+				if ((header & _indexMask) != index || slot.header != header)
+				{
+					++lost;
+					continue;
+				}
+
+				records.push_back(record);
+			}
+		}
+
+		tiny::stable_sort(records.begin() + first, records.end(), [](const trace_record& a, const trace_record& b) {
+			return a.timestamp < b.timestamp;
+		});
+
+		return lost;
+	}
+
+	// Writes the records with the text of their formats as a flat buffer rooted at trace_dump.
+	template <typename Allocator>
+	inline void write_trace_dump(flat_writer& writer, const tiny::vector<trace_record, Allocator>& records,
+		const trace_format* formats, size_t formatCount, ULONG64 frequency, ULONG64 lost) {
+		auto root = writer.create<trace_dump>();
+		writer.get(root)->frequency = frequency;
+		writer.get(root)->lost = lost;
+
+		auto dumpFormats = writer.create_array<trace_dump_format>(formatCount);
+		for (size_t i = 0; i < formatCount; ++i)
+		{
+			auto element = writer.element(dumpFormats, i);
+			writer.get(element)->id = formats[i].id;
+			writer.link(writer.field(element, &trace_dump_format::text), writer.write(string_view(formats[i].text)));
+		}
+
+		writer.link(writer.field(root, &trace_dump::formats), dumpFormats);
+		writer.link(writer.field(root, &trace_dump::records), writer.write(records));
+		writer.finish(root);
+	}
+
+	//
+	// private
+	//
+
+	inline void trace_buffer::_write(USHORT format, const ULONG64* args, size_t count) noexcept {
+		auto& ring = _rings[KeGetCurrentProcessorNumberEx(nullptr) % _ringCount];
+		auto index = static_cast<ULONG64>(InterlockedIncrement64(&ring.head) - 1);
+		auto& slot = ring.slots[static_cast<size_t>(index) & _mask];
+
+		// slot fields are volatile, the stores stay in this order
+		slot.header = 0;
+		slot.timestamp = static_cast<ULONG64>(KeQueryPerformanceCounter(nullptr).QuadPart);
+		for (size_t i = 0; i < count; ++i)
+			slot.args[i] = args[i];
+
+		slot.header = _committed | (static_cast<ULONG64>(count) << 56) | (static_cast<ULONG64>(format) << 40) | (index & _indexMask);
+	}
+
+	inline void trace_buffer::_free() noexcept {
+		for (ULONG i = 0; i < _ringCount; ++i)
+		{
+			if (_rings[i].slots)
+				FREE_MEMORY(_rings[i].slots);
+		}
+
+		FREE_MEMORY(_rings);
+	}
+}
+
+#if TINY_INSTRUMENTATION
+// TINY_TRACE(trace, TraceGrow, oldSize, newSize); with TraceGrow an id from the driver's format table
+#define TINY_TRACE(buffer, format, ...) (buffer).write((format), __VA_ARGS__)
+#else
+#define TINY_TRACE(buffer, format, ...) ((void)0)
+#endif
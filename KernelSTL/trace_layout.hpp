@@ -0,0 +1,108 @@
+#pragma once
+
+// Layout of drained trace events and the formatter for them. This header has no kernel
+// dependencies, the host decoder includes it on its own to print a trace dump.
+#include "flat_layout.hpp"
+
+namespace tiny {
+	constexpr unsigned int trace_max_args = 6;
+
+	// Format strings take {} for unsigned, {i} for signed and {x} for hex arguments, {{ and }}
+	// for braces. Ids are the driver's own, 0 and 0xFFFF are not used.
+	struct trace_format {
+		unsigned short id;
+		const char* text;
+	};
+
+	struct trace_record {
+		unsigned long long timestamp; // performance counter ticks
+		unsigned int processor;
+		unsigned short format;
+		unsigned short argCount;
+		unsigned long long args[trace_max_args];
+	};
+
+	struct trace_dump_format {
+		unsigned int id;
+		flat_string<char> text;
+	};
+
+	// Root of a flat buffer written by write_trace_dump, records are ordered by timestamp.
+	struct trace_dump {
+		unsigned long long frequency; // performance counter ticks per second
+		unsigned long long lost; // overwritten before they were drained
+		flat_vector<trace_dump_format> formats;
+		flat_vector<trace_record> records;
+	};
+
+	inline size_t _trace_put_number(char* buffer, size_t size, size_t length, unsigned long long value, unsigned int base, bool negative) noexcept {
+		char digits[24];
+		size_t count = 0;
+
+		do
+		{
+			digits[count++] = "0123456789abcdef"[value % base];
+			value /= base;
+		} while (value);
+
+		if (negative)
+			digits[count++] = '-';
+
+		while (count)
+		{
+			if (length + 1 < size)
+				buffer[length] = digits[count - 1];
+
+			++length;
+			--count;
+		}
+
+		return length;
+	}
+
+	// Writes the record as text and returns the length it needs without the terminator,
+	// the output is cut to fit size like snprintf.
+	inline size_t trace_format_record(char* buffer, size_t size, const char* format, const trace_record& record) noexcept {
+		size_t length = 0;
+		unsigned int arg = 0;
+
+		for (auto c = format; *c; ++c)
+		{
+			if ((c[0] == '{' && c[1] == '{') || (c[0] == '}' && c[1] == '}'))
+				++c;
+			else if (c[0] == '{')
+			{
+				auto end = c + 1;
+				while (*end && *end != '}')
+					++end;
+
+				if (*end)
+				{
+					auto spec = end - c == 2 ? c[1] : 0;
+					auto value = arg < record.argCount ? record.args[arg] : 0;
+					++arg;
+
+					if (spec == 'x')
+						length = _trace_put_number(buffer, size, length, value, 16, false);
+					else if (spec == 'i' && static_cast<long long>(value) < 0)
+						length = _trace_put_number(buffer, size, length, 0 - value, 10, true);
+					else
+						length = _trace_put_number(buffer, size, length, value, 10, false);
+
+					c = end;
+					continue;
+				}
+			}
+
+			if (length + 1 < size)
+				buffer[length] = *c;
+
+			++length;
+		}
+
+		if (size)
+			buffer[length < size ? length : size - 1] = 0;
+
+		return length;
+	}
+}
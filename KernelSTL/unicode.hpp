@@ -0,0 +1,370 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "string_view.hpp"
+#include "string.hpp"
+#include "arena.hpp"
+#include "algorithm.hpp"
+
+namespace tiny {
+	// Decodes one UTF-8 sequence, returns its length or 0 when it is malformed, overlong,
+	// truncated or encodes a surrogate or a value above U+10FFFF.
+	inline size_t _utf8_decode(const unsigned char* first, const unsigned char* last, ULONG& codePoint) noexcept {
+		auto lead = first[0];
+		if (lead < 0x80)
+		{
+			codePoint = lead;
+			return 1;
+		}
+
+		size_t length;
+		unsigned char low = 0x80, high = 0xBF; // allowed range of the second byte
+		if (lead >= 0xC2 && lead <= 0xDF)
+		{
+			length = 2;
+			codePoint = lead & 0x1F;
+		}
+		else if (lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			codePoint = lead & 0x0F;
+			if (lead == 0xE0)
+				low = 0xA0;
+			else if (lead == 0xED)
+				high = 0x9F;
+		}
+		else if (lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			codePoint = lead & 0x07;
+			if (lead == 0xF0)
+				low = 0x90;
+			else if (lead == 0xF4)
+				high = 0x8F;
+		}
+		else
+			return 0;
+
+		if (static_cast<size_t>(last - first) < length || first[1] < low || first[1] > high)
+			return 0;
+
+		for (size_t i = 1; i < length; ++i)
+		{
+			if ((first[i] & 0xC0) != 0x80)
+				return 0;
+
+			codePoint = (codePoint << 6) | (first[i] & 0x3F);
+		}
+
+		return length;
+	}
+
+	// Decodes one UTF-16 code point, returns the number of units or 0 for an unpaired surrogate.
+	inline size_t _utf16_decode(const wchar_t* first, const wchar_t* last, ULONG& codePoint) noexcept {
+		ULONG unit = static_cast<USHORT>(first[0]);
+		if (unit < 0xD800 || unit > 0xDFFF)
+		{
+			codePoint = unit;
+			return 1;
+		}
+
+		if (unit > 0xDBFF || last - first < 2)
+			return 0;
+
+		ULONG next = static_cast<USHORT>(first[1]);
+		if (next < 0xDC00 || next > 0xDFFF)
+			return 0;
+
+		codePoint = 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00);
+		return 2;
+	}
+
+	inline size_t _utf8_encoded_length(ULONG codePoint) noexcept {
+		return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x10000 ? 3 : 4;
+	}
+
+#ifdef TINY_SSE2
+	// eight UTF-16 units of which none is a surrogate
+	inline bool _utf16_no_surrogates(__m128i units) noexcept {
+		auto masked = _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xF800)));
+		return !_mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_set1_epi16(static_cast<short>(0xD800))));
+	}
+
+	// lanes of units above limit, counted with unsigned saturation
+	inline size_t _utf16_count_above(__m128i units, short limit) noexcept {
+		auto equal = _mm_cmpeq_epi16(_mm_subs_epu16(units, _mm_set1_epi16(limit)), _mm_setzero_si128());
+		return 8 - _popcount16(static_cast<unsigned>(_mm_movemask_epi8(equal))) / 2;
+	}
+#endif
+
+	// Number of UTF-16 units the UTF-8 text converts to, fails with STATUS_ILLEGAL_CHARACTER
+	// on invalid input. This is the validating pass, the conversions below run it first.
+	inline NTSTATUS utf16_length(string_view source, size_t& length) noexcept {
+		auto first = reinterpret_cast<const unsigned char*>(source.data());
+		auto last = first + source.size();
+		size_t result = 0;
+
+		while (first != last)
+		{
+#ifdef TINY_SSE2
+			// sixteen ASCII bytes at a time, paths and names rarely leave this loop. A shorter tail
+			// is checked as the last sixteen bytes, overlapping ones already counted.
+			if (source.size() >= 16)
+			{
+				auto count = last - first < 16 ? last - first : 16;
+				if (!_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count - 16))))
+				{
+					result += count;
+					first += count;
+					continue;
+				}
+			}
+#endif
+			if (*first < 0x80)
+			{
+				++result;
+				++first;
+				continue;
+			}
+
+			ULONG codePoint;
+			auto bytes = _utf8_decode(first, last, codePoint);
+			if (!bytes)
+				return STATUS_ILLEGAL_CHARACTER;
+
+			result += codePoint < 0x10000 ? 1 : 2;
+			first += bytes;
+		}
+
+		length = result;
+		return STATUS_SUCCESS;
+	}
+
+	// Number of UTF-8 bytes the UTF-16 text converts to, fails with STATUS_ILLEGAL_CHARACTER
+	// on an unpaired surrogate.
+	inline NTSTATUS utf8_length(wstring_view source, size_t& length) noexcept {
+		auto first = source.data();
+		auto last = first + source.size();
+		size_t result = 0;
+
+		while (first != last)
+		{
+#ifdef TINY_SSE2
+			// without surrogates every unit is one, two or three bytes. A shorter tail is loaded
+			// as the last eight units with the ones already counted cleared.
+			if (source.size() >= 8)
+			{
+				auto count = last - first < 8 ? last - first : 8;
+				auto units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count - 8));
+				if (count < 8)
+					units = _mm_and_si128(units, _mm_cmpgt_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _mm_set1_epi16(static_cast<short>(7 - count))));
+
+				if (_utf16_no_surrogates(units))
+				{
+					result += count + _utf16_count_above(units, 0x7F) + _utf16_count_above(units, 0x7FF);
+					first += count;
+					continue;
+				}
+			}
+#endif
+			ULONG codePoint;
+			auto units = _utf16_decode(first, last, codePoint);
+			if (!units)
+				return STATUS_ILLEGAL_CHARACTER;
+
+			result += _utf8_encoded_length(codePoint);
+			first += units;
+		}
+
+		length = result;
+		return STATUS_SUCCESS;
+	}
+
+	// Converts validated UTF-8, the output has room for exactly utf16_length units.
+	inline void _utf8_to_utf16(const unsigned char* first, const unsigned char* last, wchar_t* output) noexcept {
+#ifdef TINY_SSE2
+		auto size = last - first;
+#endif
+		while (first != last)
+		{
+#ifdef TINY_SSE2
+			// an all ASCII tail converts to the same units that were stored for the overlap
+			if (size >= 16)
+			{
+				auto count = last - first < 16 ? last - first : 16;
+				auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count - 16));
+				if (!_mm_movemask_epi8(bytes))
+				{
+					// ASCII widens by interleaving with zero bytes
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + count - 16), _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + count - 8), _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+					first += count;
+					output += count;
+					continue;
+				}
+			}
+#endif
+			if (*first < 0x80)
+			{
+				*output++ = *first++;
+				continue;
+			}
+
+			ULONG codePoint = 0;
+			first += _utf8_decode(first, last, codePoint);
+
+			if (codePoint < 0x10000)
+				*output++ = static_cast<wchar_t>(codePoint);
+			else
+			{
+				codePoint -= 0x10000;
+				*output++ = static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+				*output++ = static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+			}
+		}
+	}
+
+	// Converts validated UTF-16, the output has room for exactly utf8_length bytes.
+	inline void _utf16_to_utf8(const wchar_t* first, const wchar_t* last, unsigned char* output) noexcept {
+#ifdef TINY_SSE2
+		auto size = last - first;
+#endif
+		while (first != last)
+		{
+#ifdef TINY_SSE2
+			if (size >= 16)
+			{
+				auto count = last - first < 16 ? last - first : 16;
+				auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count - 16));
+				auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count - 8));
+				if (!_utf16_count_above(_mm_or_si128(low, high), 0x7F))
+				{
+					// ASCII narrows with one saturating pack
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + count - 16), _mm_packus_epi16(low, high));
+					first += count;
+					output += count;
+					continue;
+				}
+			}
+#endif
+			ULONG codePoint = 0;
+			first += _utf16_decode(first, last, codePoint);
+
+			if (codePoint < 0x80)
+				*output++ = static_cast<unsigned char>(codePoint);
+			else if (codePoint < 0x800)
+			{
+				*output++ = static_cast<unsigned char>(0xC0 | (codePoint >> 6));
+				*output++ = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				*output++ = static_cast<unsigned char>(0xE0 | (codePoint >> 12));
+				*output++ = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*output++ = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				*output++ = static_cast<unsigned char>(0xF0 | (codePoint >> 18));
+				*output++ = static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F));
+				*output++ = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*output++ = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+	}
+
+	// Converts into a caller buffer without terminating it. length receives the units written,
+	// or the units needed along with STATUS_BUFFER_TOO_SMALL, in which case nothing is written.
+	inline NTSTATUS utf8_to_utf16(string_view source, wchar_t* buffer, size_t capacity, size_t& length) noexcept {
+		auto status = utf16_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		if (length > capacity)
+			return STATUS_BUFFER_TOO_SMALL;
+
+		auto first = reinterpret_cast<const unsigned char*>(source.data());
+		_utf8_to_utf16(first, first + source.size(), buffer);
+		return STATUS_SUCCESS;
+	}
+
+	// Converts into a caller buffer without terminating it, see utf8_to_utf16.
+	inline NTSTATUS utf16_to_utf8(wstring_view source, char* buffer, size_t capacity, size_t& length) noexcept {
+		auto status = utf8_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		if (length > capacity)
+			return STATUS_BUFFER_TOO_SMALL;
+
+		_utf16_to_utf8(source.data(), source.data() + source.size(), reinterpret_cast<unsigned char*>(buffer));
+		return STATUS_SUCCESS;
+	}
+
+	// Replaces result with the UTF-16 form of the UTF-8 text, with at most one allocation.
+	// result is left untouched when the text is invalid.
+	inline NTSTATUS to_wstring(string_view source, wstring& result) {
+		size_t length;
+		auto status = utf16_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		result.resize_for_overwrite(length);
+
+		auto first = reinterpret_cast<const unsigned char*>(source.data());
+		_utf8_to_utf16(first, first + source.size(), result.begin());
+		return STATUS_SUCCESS;
+	}
+
+	// Replaces result with the UTF-8 form of the UTF-16 text, see to_wstring.
+	inline NTSTATUS to_string(wstring_view source, string& result) {
+		size_t length;
+		auto status = utf8_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		result.resize_for_overwrite(length);
+
+		_utf16_to_utf8(source.data(), source.data() + source.size(), reinterpret_cast<unsigned char*>(result.begin()));
+		return STATUS_SUCCESS;
+	}
+
+	// Converts into memory of the arena, result is terminated and lives until the arena is released.
+	// STATUS_INSUFFICIENT_RESOURCES when the arena cannot grow.
+	inline NTSTATUS to_wstring(string_view source, arena& owner, wstring_view& result) {
+		size_t length;
+		auto status = utf16_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		auto buffer = static_cast<wchar_t*>(owner.allocate((length + 1) * sizeof(wchar_t)));
+		if (!buffer)
+			return STATUS_INSUFFICIENT_RESOURCES;
+
+		auto first = reinterpret_cast<const unsigned char*>(source.data());
+		_utf8_to_utf16(first, first + source.size(), buffer);
+		buffer[length] = 0;
+
+		result = wstring_view(buffer, length);
+		return STATUS_SUCCESS;
+	}
+
+	// Converts into memory of the arena, see to_wstring.
+	inline NTSTATUS to_string(wstring_view source, arena& owner, string_view& result) {
+		size_t length;
+		auto status = utf8_length(source, length);
+		if (!NT_SUCCESS(status))
+			return status;
+
+		auto buffer = static_cast<char*>(owner.allocate(length + 1, 1));
+		if (!buffer)
+			return STATUS_INSUFFICIENT_RESOURCES;
+
+		_utf16_to_utf8(source.data(), source.data() + source.size(), reinterpret_cast<unsigned char*>(buffer));
+		buffer[length] = 0;
+
+		result = string_view(buffer, length);
+		return STATUS_SUCCESS;
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace tiny {
+	template <typename T>
+	struct remove_reference {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_reference<T&> {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_reference<T&&> {
+		using type = T;
+	};
+
+	template <typename T>
+	using remove_reference_t = typename remove_reference<T>::type;
+
+	template <bool Cond, typename T = void>
+	struct enable_if {
+	};
+
+	template <typename T>
+	struct enable_if<true, T> {
+		using type = T;
+	};
+
+	template <bool Cond, typename T = void>
+	using enable_if_t = typename enable_if<Cond, T>::type;
+
+	template <typename T>
+	struct remove_cv {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_cv<const T> {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_cv<volatile T> {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_cv<const volatile T> {
+		using type = T;
+	};
+
+	template <typename T>
+	using remove_cv_t = typename remove_cv<T>::type;
+
+	template <typename T>
+	struct remove_pointer {
+		using type = T;
+	};
+
+	template <typename T>
+	struct remove_pointer<T*> {
+		using type = T;
+	};
+
+	template <typename T>
+	using remove_pointer_t = typename remove_pointer<remove_cv_t<T>>::type;
+
+	template <typename T, typename U>
+	inline constexpr bool is_same_v = false;
+
+	template <typename T>
+	inline constexpr bool is_same_v<T, T> = true;
+
+	template <typename T>
+	inline constexpr bool is_pointer_v = false;
+
+	template <typename T>
+	inline constexpr bool is_pointer_v<T*> = true;
+
+	template <typename T>
+	inline constexpr bool _is_integral = false;
+
+	template <> inline constexpr bool _is_integral<char> = true;
+	template <> inline constexpr bool _is_integral<signed char> = true;
+	template <> inline constexpr bool _is_integral<unsigned char> = true;
+	template <> inline constexpr bool _is_integral<wchar_t> = true;
+	template <> inline constexpr bool _is_integral<char16_t> = true;
+	template <> inline constexpr bool _is_integral<short> = true;
+	template <> inline constexpr bool _is_integral<unsigned short> = true;
+	template <> inline constexpr bool _is_integral<int> = true;
+	template <> inline constexpr bool _is_integral<unsigned int> = true;
+	template <> inline constexpr bool _is_integral<long> = true;
+	template <> inline constexpr bool _is_integral<unsigned long> = true;
+	template <> inline constexpr bool _is_integral<long long> = true;
+	template <> inline constexpr bool _is_integral<unsigned long long> = true;
+
+	// bool is left out on purpose, it is not useful as an arithmetic type
+	template <typename T>
+	inline constexpr bool is_integral_v = _is_integral<remove_cv_t<T>>;
+
+	template <typename T>
+	inline constexpr bool is_signed_v = is_integral_v<T> && static_cast<T>(-1) < static_cast<T>(0);
+
+	template <typename T>
+	inline constexpr bool is_trivially_copyable_v = __is_trivially_copyable(T);
+
+	template <typename T>
+	inline constexpr bool is_trivially_default_constructible_v = __is_trivially_constructible(T);
+
+	template <typename T>
+	T&& declval() noexcept;
+
+	template <typename Base, typename Derived>
+	inline constexpr bool is_base_of_v = __is_base_of(Base, Derived);
+
+	template <typename T>
+	inline constexpr remove_reference_t<T>&& move(T&& value) noexcept {
+		return static_cast<remove_reference_t<T>&&>(value);
+	}
+
+	template <typename T>
+	inline constexpr T&& forward(remove_reference_t<T>& value) noexcept {
+		return static_cast<T&&>(value);
+	}
+
+	template <typename T>
+	inline constexpr T&& forward(remove_reference_t<T>&& value) noexcept {
+		return static_cast<T&&>(value);
+	}
+
+	template <typename T>
+	inline void swap(T& left, T& right) {
+		T temp = tiny::move(left);
+		left = tiny::move(right);
+		right = tiny::move(temp);
+	}
+
+	template <typename T, typename U = T>
+	inline T exchange(T& obj, U&& newValue) {
+		T oldValue = tiny::move(obj);
+		obj = tiny::forward<U>(newValue);
+		return oldValue;
+	}
+}
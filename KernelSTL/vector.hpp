@@ -1,286 +1,572 @@
-#pragma once
-
-#include "common.hpp"
-#define Debug(msg, ...) do {DbgPrintEx(0, 0, "[Tiny]: " msg "\n", __VA_ARGS__);}while(0)
-namespace tiny {
-template <typename T>
-class vector {
-public:
-	vector();
-	~vector();
-	vector(size_t count);
-	//template <typename... Args>
-	//vector(Args&&... args);
-
-	vector(const vector& other) {
-		operator=(other);
-	};
-
-	void assign(size_t count, const T& value);
-
-	constexpr const T* data() const noexcept;
-	constexpr const T& back() const;
-	constexpr const T& front() const;
-
-	constexpr T* begin() const noexcept;
-	constexpr T* end() const;
-
-	constexpr bool empty() const noexcept;
-	constexpr size_t size() const noexcept;
-	constexpr size_t capacity() const noexcept;
-	constexpr size_t max_size() const noexcept;
-
-	void resize(size_t count);
-	void reserve(size_t count);
-	void erase(size_t pos);
-	void erase(size_t first, size_t last);
-	void clear() noexcept;
-	void shrink_to_fit();
-
-	constexpr T& at(size_t pos) const;
-
-	constexpr void insert(size_t pos, const T& value);
-	constexpr void push_back(const T& value);
-	constexpr void pop_back();
-
-	constexpr const T& operator [](size_t idx) const {
-		return _buffer[idx];
-	}
-
-	T& operator [](size_t idx) {
-		return _buffer[idx];
-	}
-
-	vector& operator=(const vector& other) {
-		this->_freeBuffer();
-
-		if (other._capacity) {
-			this->reserve(other._capacity);
-
-			for (size_t i = 0; i < other._size; ++i)
-				this->_buffer[i] = other._buffer[i];
-
-			this->_size = other._size;
-		}
-
-		return *this;
-	};
-private:
-	T* _buffer;
-	size_t _size;
-	size_t _capacity;
-
-	void _reserve(size_t count);
-	void _freeBuffer();
-};
-
-template <typename T>
-inline vector<T>::~vector() {
-	this->_freeBuffer();
-}
-
-template <typename T>
-inline vector<T>::vector()
-	: _buffer(nullptr), _size(0), _capacity(0) {
-}
-
-template <typename T>
-inline vector<T>::vector(size_t count)
-	: vector() {
-	this->resize(count);
-}
-
-//template <typename T>
-//template <typename... Args>
-//inline vector<T>::vector(Args&&... args) {
-//	int temp[] = { (this->push_back(args), 0)... };
-//	UNREFERENCED_PARAMETER(temp);
-//}
-
-template <typename T>
-inline void vector<T>::assign(size_t count, const T& value) {
-	this->clear();
-	this->reserve(count);
-
-	_size = count;
-	while (count--)
-		_buffer[count] = value;
-}
-
-template <typename T>
-inline constexpr const T* vector<T>::data() const noexcept {
-	return _buffer;
-}
-
-template <typename T>
-inline constexpr const T& vector<T>::back() const {
-	return _buffer[_size];
-}
-
-template <typename T>
-inline constexpr const T& vector<T>::front() const {
-	return _buffer[0];
-}
-
-template <typename T>
-inline constexpr T* vector<T>::begin() const noexcept{
-	return _buffer;
-}
-
-template <typename T>
-inline constexpr T* vector<T>::end() const {
-	return _buffer + _size;
-}
-
-template <typename T>
-inline constexpr bool vector<T>::empty() const noexcept {
-	return _size == 0;
-}
-
-template <typename T>
-inline constexpr size_t vector<T>::size() const noexcept {
-	return _size;
-}
-
-template <typename T>
-inline constexpr size_t vector<T>::capacity() const noexcept {
-	return _capacity;
-}
-
-template <typename T>
-inline constexpr size_t vector<T>::max_size() const noexcept {
-	return static_cast<size_t>(-1) / sizeof(T);
-}
-
-template <typename T>
-inline void vector<T>::resize(size_t count) {
-	if (count == _size)
-		return;
-
-	if (!count)
-		return this->clear();
-
-	if (count <= _size)
-		return this->erase(count, _size);
-
-	this->reserve(count);
-	
-	for (size_t i = _size; i < count; ++i)
-		_buffer[i] = T();
-
-	_size = count;
-}
-
-template <typename T>
-inline void vector<T>::reserve(size_t count) {
-	if (count <= _capacity)
-		return;
-
-	this->_reserve(count);
-}
-
-template <typename T>
-inline void vector<T>::erase(size_t pos) {
-	if (pos == _size - 1)
-	{
-		this->pop_back();
-		return;
-	}
-
-	_buffer[pos].~T();
-	memcpy(_buffer + pos, _buffer + pos + 1, (_size-- - pos) * sizeof(T));
-}
-
-template <typename T>
-inline void vector<T>::erase(size_t first, size_t last) {
-	if (first == last)
-		return;
-
-	for (auto i = first; i < last; ++i)
-		_buffer[i].~T();
-
-	memcpy(_buffer + first, _buffer + last, (_size - last) * sizeof(T));
-	_size -= last - first;
-}
-
-template <typename T>
-inline void vector<T>::clear() noexcept {
-	while (!this->empty())
-		this->pop_back();
-}
-
-template <typename T>
-inline void vector<T>::shrink_to_fit() {
-	if (_size == _capacity)
-		return;
-
-	this->_reserve(_size);
-}
-
-template <typename T>
-inline constexpr T& vector<T>::at(size_t pos) const {
-	if (pos >= _size)
-		return nullptr;
-
-	return _buffer[pos];
-}
-
-template <typename T>
-inline constexpr void vector<T>::insert(size_t pos, const T& value) {
-	if (_size == _capacity)
-		this->reserve(_capacity + 1);
-
-	memcpy(_buffer + pos + 1, _buffer + pos, (_size - pos) * sizeof(T));
-	_buffer[pos] = value;
-	_size++;
-}
-
-template <typename T>
-inline constexpr void vector<T>::push_back(const T& value) {
-	if (_size == _capacity)
-		this->reserve(_capacity + 1);
-
-	_buffer[_size++] = value;
-}
-
-template <typename T>
-inline constexpr void vector<T>::pop_back() {
-	_buffer[--_size].~T();
-}
-
-//
-// private
-//
-
-template <typename T>
-inline void vector<T>::_reserve(size_t count) {
-	if (!count)
-		return this->_freeBuffer();
-
-	auto newBuffer = reinterpret_cast<T*>(ALLOC_MEMORY(count * sizeof(T)));
-	if (!newBuffer)
-		ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
-
-	for (size_t i = 0; i < _size; ++i)
-		newBuffer[i] = _buffer[i];
-
-	auto currentSize = _size;
-	this->_freeBuffer();
-
-	_buffer = newBuffer;
-	_capacity = count;
-	_size = currentSize;
-}
-
-template <typename T>
-inline void vector<T>::_freeBuffer() {
-	if (!_buffer)
-		return;
-
-	this->clear();
-
-	FREE_MEMORY(_buffer);
-	_buffer = nullptr;
-	_capacity = 0;
-}
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#define Debug(msg, ...) do {DbgPrintEx(0, 0, "[Tiny]: " msg "\n", __VA_ARGS__);}while(0)
+namespace tiny {
+// Allocator has to provide allocate(size) returning nullptr on failure and deallocate(ptr, size).
+template <typename T, typename Allocator = pool_allocator>
+class vector : private Allocator {
+public:
+	vector();
+	~vector();
+	vector(size_t count);
+
+	explicit vector(const Allocator& allocator)
+		: Allocator(allocator), _buffer(nullptr), _size(0), _capacity(0) {
+	}
+	//template <typename... Args>
+	//vector(Args&&... args);
+
+	vector(const vector& other)
+		: vector(other.get_allocator()) {
+		operator=(other);
+	};
+
+	vector(vector&& other) noexcept
+		: Allocator(other.get_allocator()), _buffer(other._buffer), _size(other._size), _capacity(other._capacity) {
+		other._buffer = nullptr;
+		other._size = 0;
+		other._capacity = 0;
+	};
+
+	void assign(size_t count, const T& value);
+
+	// Ranges are given by random access iterators and may not point into this vector. insert
+	// and append_range accept a range of this vector and copy it out first.
+	template <typename It, typename = enable_if_t<!is_integral_v<It>>>
+	void assign(It first, It last);
+
+	constexpr const T* data() const noexcept;
+	constexpr const T& back() const;
+	constexpr const T& front() const;
+
+	constexpr T* begin() const noexcept;
+	constexpr T* end() const;
+
+	constexpr bool empty() const noexcept;
+	constexpr size_t size() const noexcept;
+	constexpr size_t capacity() const noexcept;
+	constexpr size_t max_size() const noexcept;
+
+	void resize(size_t count);
+
+	// New elements are default-initialized, for trivial types left as they are.
+	void resize_for_overwrite(size_t count);
+	void reserve(size_t count);
+	void erase(size_t pos);
+	void erase(size_t first, size_t last);
+
+	// returns the number of erased elements
+	template <typename Pred>
+	size_t erase_if(Pred pred);
+	void clear() noexcept;
+	void shrink_to_fit();
+
+	Allocator get_allocator() const noexcept {
+		return *this;
+	}
+
+	// Only for pool_allocator, the buffer is exchanged with FREE_MEMORY/ALLOC_MEMORY owners.
+	T* release() noexcept;
+	void adopt(T* buffer, size_t size, size_t capacity) noexcept;
+
+	constexpr T& at(size_t pos) const;
+
+	constexpr void insert(size_t pos, const T& value);
+
+	template <typename It>
+	void insert(size_t pos, It first, It last);
+
+	template <typename It>
+	void append_range(It first, It last) {
+		this->insert(_size, first, last);
+	}
+
+	// anything with begin() and end(), e.g. another vector or a string view
+	template <typename Range>
+	void append_range(const Range& range) {
+		this->insert(_size, range.begin(), range.end());
+	}
+	constexpr void push_back(const T& value);
+	constexpr void push_back(T&& value);
+	constexpr void pop_back();
+
+	constexpr const T& operator [](size_t idx) const {
+		return _buffer[idx];
+	}
+
+	T& operator [](size_t idx) {
+		return _buffer[idx];
+	}
+
+	vector& operator=(const vector& other) {
+		if (this == &other)
+			return *this;
+
+		this->_freeBuffer();
+
+		if (other._capacity) {
+			this->reserve(other._capacity);
+			_copyConstruct(_buffer, other._buffer, other._size);
+			this->_size = other._size;
+		}
+
+		return *this;
+	};
+
+	vector& operator=(vector&& other) noexcept {
+		if (this == &other)
+			return *this;
+
+		this->_freeBuffer();
+
+		static_cast<Allocator&>(*this) = other.get_allocator();
+		_buffer = other._buffer;
+		_size = other._size;
+		_capacity = other._capacity;
+
+		other._buffer = nullptr;
+		other._size = 0;
+		other._capacity = 0;
+
+		return *this;
+	};
+private:
+	T* _buffer;
+	size_t _size;
+	size_t _capacity;
+
+	void _reserve(size_t count);
+	void _freeBuffer();
+	void _openGap(size_t pos, size_t count);
+
+	template <typename It>
+	static void _copyConstruct(T* destination, It first, size_t count);
+
+	// Doubling keeps appends amortized O(1), an arena never reuses the abandoned buffers
+	// and this bounds them to the size of the final one.
+	size_t _grownCapacity() const noexcept {
+		return _capacity < 4 ? 4 : _capacity * 2;
+	}
+
+	bool _holds(const T* element) const noexcept {
+		return element >= _buffer && element < _buffer + _size;
+	}
+};
+
+template <typename T, typename Allocator>
+inline vector<T, Allocator>::~vector() {
+	this->_freeBuffer();
+}
+
+template <typename T, typename Allocator>
+inline vector<T, Allocator>::vector()
+	: _buffer(nullptr), _size(0), _capacity(0) {
+}
+
+template <typename T, typename Allocator>
+inline vector<T, Allocator>::vector(size_t count)
+	: vector() {
+	this->resize(count);
+}
+
+//template <typename T>
+//template <typename... Args>
+//inline vector<T, Allocator>::vector(Args&&... args) {
+//	int temp[] = { (this->push_back(args), 0)... };
+//	UNREFERENCED_PARAMETER(temp);
+//}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::assign(size_t count, const T& value) {
+	this->clear();
+	this->reserve(count);
+
+	if constexpr (is_trivially_copyable_v<T> && sizeof(T) == 1)
+	{
+		memset(_buffer, static_cast<int>(*reinterpret_cast<const unsigned char*>(&value)), count);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+			new (_buffer + i) T(value);
+	}
+
+	_size = count;
+}
+
+template <typename T, typename Allocator>
+template <typename It, typename>
+inline void vector<T, Allocator>::assign(It first, It last) {
+	auto count = static_cast<size_t>(last - first);
+
+	this->clear();
+	this->reserve(count);
+
+	_copyConstruct(_buffer, first, count);
+	_size = count;
+}
+
+template <typename T, typename Allocator>
+inline constexpr const T* vector<T, Allocator>::data() const noexcept {
+	return _buffer;
+}
+
+template <typename T, typename Allocator>
+inline constexpr const T& vector<T, Allocator>::back() const {
+	return _buffer[_size - 1];
+}
+
+template <typename T, typename Allocator>
+inline constexpr const T& vector<T, Allocator>::front() const {
+	return _buffer[0];
+}
+
+template <typename T, typename Allocator>
+inline constexpr T* vector<T, Allocator>::begin() const noexcept{
+	return _buffer;
+}
+
+template <typename T, typename Allocator>
+inline constexpr T* vector<T, Allocator>::end() const {
+	return _buffer + _size;
+}
+
+template <typename T, typename Allocator>
+inline constexpr bool vector<T, Allocator>::empty() const noexcept {
+	return _size == 0;
+}
+
+template <typename T, typename Allocator>
+inline constexpr size_t vector<T, Allocator>::size() const noexcept {
+	return _size;
+}
+
+template <typename T, typename Allocator>
+inline constexpr size_t vector<T, Allocator>::capacity() const noexcept {
+	return _capacity;
+}
+
+template <typename T, typename Allocator>
+inline constexpr size_t vector<T, Allocator>::max_size() const noexcept {
+	return static_cast<size_t>(-1) / sizeof(T);
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::resize(size_t count) {
+	if (count == _size)
+		return;
+
+	if (!count)
+		return this->clear();
+
+	if (count <= _size)
+		return this->erase(count, _size);
+
+	this->reserve(count);
+
+	// value-initialization of these is zeroing
+	if constexpr (is_trivially_default_constructible_v<T>)
+	{
+		memset(_buffer + _size, 0, (count - _size) * sizeof(T));
+	}
+	else
+	{
+		for (size_t i = _size; i < count; ++i)
+			new (_buffer + i) T();
+	}
+
+	_size = count;
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::resize_for_overwrite(size_t count) {
+	if (count <= _size)
+		return this->resize(count);
+
+	this->reserve(count);
+
+	// default-initialization, compiles to nothing for trivial types
+	for (size_t i = _size; i < count; ++i)
+		new (_buffer + i) T;
+
+	_size = count;
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::reserve(size_t count) {
+	if (count <= _capacity)
+		return;
+
+	this->_reserve(count);
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::erase(size_t pos) {
+	if (pos == _size - 1)
+	{
+		this->pop_back();
+		return;
+	}
+
+	_buffer[pos].~T();
+	memmove(_buffer + pos, _buffer + pos + 1, (_size - pos - 1) * sizeof(T));
+	--_size;
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::erase(size_t first, size_t last) {
+	if (first == last)
+		return;
+
+	for (auto i = first; i < last; ++i)
+		_buffer[i].~T();
+
+	memmove(_buffer + first, _buffer + last, (_size - last) * sizeof(T));
+	_size -= last - first;
+}
+
+// Kept elements are relocated down bitwise in runs, one memmove for each run of kept
+// elements that follows a removed one.
+template <typename T, typename Allocator>
+template <typename Pred>
+inline size_t vector<T, Allocator>::erase_if(Pred pred) {
+	size_t kept = 0;
+	size_t run = 0; // first kept element not relocated yet
+
+	for (size_t i = 0; i < _size; ++i)
+	{
+		if (!pred(_buffer[i]))
+			continue;
+
+		_buffer[i].~T();
+
+		if (kept != run)
+			memmove(static_cast<void*>(_buffer + kept), _buffer + run, (i - run) * sizeof(T));
+
+		kept += i - run;
+		run = i + 1;
+	}
+
+	if (kept != run)
+		memmove(static_cast<void*>(_buffer + kept), _buffer + run, (_size - run) * sizeof(T));
+
+	kept += _size - run;
+
+	auto removed = _size - kept;
+	_size = kept;
+	return removed;
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::clear() noexcept {
+	while (!this->empty())
+		this->pop_back();
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::shrink_to_fit() {
+	if (_size == _capacity)
+		return;
+
+	this->_reserve(_size);
+}
+
+// Hands the buffer over to the caller, it has to be freed with FREE_MEMORY.
+template <typename T, typename Allocator>
+inline T* vector<T, Allocator>::release() noexcept {
+	auto buffer = _buffer;
+
+	_buffer = nullptr;
+	_size = 0;
+	_capacity = 0;
+
+	return buffer;
+}
+
+// Takes ownership of a buffer allocated from non-paged pool, first `size` elements are constructed.
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::adopt(T* buffer, size_t size, size_t capacity) noexcept {
+	this->_freeBuffer();
+
+	_buffer = buffer;
+	_size = buffer ? size : 0;
+	_capacity = buffer ? capacity : 0;
+}
+
+template <typename T, typename Allocator>
+inline constexpr T& vector<T, Allocator>::at(size_t pos) const {
+	if (pos >= _size)
+		return nullptr;
+
+	return _buffer[pos];
+}
+
+template <typename T, typename Allocator>
+inline constexpr void vector<T, Allocator>::insert(size_t pos, const T& value) {
+	if (this->_holds(&value))
+	{
+		// value is one of the elements, opening the gap moves it
+		T copy(value);
+		this->_openGap(pos, 1);
+		new (_buffer + pos) T(tiny::move(copy));
+	}
+	else
+	{
+		this->_openGap(pos, 1);
+		new (_buffer + pos) T(value);
+	}
+
+	_size++;
+}
+
+template <typename T, typename Allocator>
+template <typename It>
+inline void vector<T, Allocator>::insert(size_t pos, It first, It last) {
+	auto count = static_cast<size_t>(last - first);
+	if (!count)
+		return;
+
+	if constexpr (is_pointer_v<It> && is_same_v<remove_cv_t<remove_pointer_t<It>>, T>)
+	{
+		if (this->_holds(first))
+		{
+			// the range is part of this vector, opening the gap moves or frees it
+			vector copy(this->get_allocator());
+			copy.assign(first, last);
+			this->insert(pos, copy.begin(), copy.end());
+			return;
+		}
+	}
+
+	this->_openGap(pos, count);
+	_copyConstruct(_buffer + pos, first, count);
+	_size += count;
+}
+
+template <typename T, typename Allocator>
+inline constexpr void vector<T, Allocator>::push_back(const T& value) {
+	if (_size == _capacity)
+	{
+		// value may be one of the elements, growing frees them
+		T copy(value);
+		this->reserve(this->_grownCapacity());
+		new (_buffer + _size) T(tiny::move(copy));
+	}
+	else
+		new (_buffer + _size) T(value);
+
+	_size++;
+}
+
+template <typename T, typename Allocator>
+inline constexpr void vector<T, Allocator>::push_back(T&& value) {
+	if (_size == _capacity)
+	{
+		T moved(tiny::move(value));
+		this->reserve(this->_grownCapacity());
+		new (_buffer + _size) T(tiny::move(moved));
+	}
+	else
+		new (_buffer + _size) T(tiny::move(value));
+
+	_size++;
+}
+
+template <typename T, typename Allocator>
+inline constexpr void vector<T, Allocator>::pop_back() {
+	_buffer[--_size].~T();
+}
+
+//
+// private
+//
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::_reserve(size_t count) {
+	if (!count)
+		return this->_freeBuffer();
+
+	auto newBuffer = reinterpret_cast<T*>(this->allocate(count * sizeof(T)));
+	if (!newBuffer)
+		ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+	for (size_t i = 0; i < _size; ++i)
+		new (newBuffer + i) T(tiny::move(_buffer[i]));
+
+	auto currentSize = _size;
+	this->_freeBuffer();
+
+	_buffer = newBuffer;
+	_capacity = count;
+	_size = currentSize;
+}
+
+// Makes room for count elements at pos, with at most one reallocation or one memmove.
+// The gap is raw memory, _size is left for the caller to update.
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::_openGap(size_t pos, size_t count) {
+	if (_size + count <= _capacity)
+	{
+		memmove(_buffer + pos + count, _buffer + pos, (_size - pos) * sizeof(T));
+		return;
+	}
+
+	auto capacity = this->_grownCapacity();
+	if (capacity < _size + count)
+		capacity = _size + count;
+
+	auto newBuffer = reinterpret_cast<T*>(this->allocate(capacity * sizeof(T)));
+	if (!newBuffer)
+		ExRaiseStatus(STATUS_MEMORY_NOT_ALLOCATED);
+
+	if constexpr (is_trivially_copyable_v<T>)
+	{
+		if (_size)
+		{
+			memcpy(newBuffer, _buffer, pos * sizeof(T));
+			memcpy(newBuffer + pos + count, _buffer + pos, (_size - pos) * sizeof(T));
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < _size; ++i)
+			new (newBuffer + (i < pos ? i : i + count)) T(tiny::move(_buffer[i]));
+	}
+
+	auto currentSize = _size;
+	this->_freeBuffer();
+
+	_buffer = newBuffer;
+	_capacity = capacity;
+	_size = currentSize;
+}
+
+template <typename T, typename Allocator>
+template <typename It>
+inline void vector<T, Allocator>::_copyConstruct(T* destination, It first, size_t count) {
+	if constexpr (is_pointer_v<It> && is_same_v<remove_cv_t<remove_pointer_t<It>>, T> && is_trivially_copyable_v<T>)
+	{
+		if (count)
+			memcpy(destination, first, count * sizeof(T));
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i, ++first)
+			new (destination + i) T(*first);
+	}
+}
+
+template <typename T, typename Allocator>
+inline void vector<T, Allocator>::_freeBuffer() {
+	if (!_buffer)
+		return;
+
+	this->clear();
+
+	this->deallocate(_buffer, _capacity * sizeof(T));
+	_buffer = nullptr;
+	_capacity = 0;
+}
 }
\ No newline at end of file
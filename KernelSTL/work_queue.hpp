@@ -0,0 +1,413 @@
+#pragma once
+
+#include "common.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "mutex.hpp"
+#include "thread.hpp"
+
+namespace tiny {
+	enum class work_queue_result {
+		queued,
+		coalesced, // an item with the same key is still pending, the new one was dropped
+		full
+	};
+
+	struct work_queue_stats {
+		size_t depth;
+		size_t maxDepth;
+		ULONG64 submitted;
+		ULONG64 coalesced;
+		ULONG64 rejected;
+		ULONG64 executed;
+		ULONG64 batches;
+		ULONG64 averageLatencyUs; // from submit to the start of execution
+		ULONG64 maxLatencyUs;
+	};
+
+	/*
+	* Deferred work queue with a fixed slab of nodes, callables are stored inline so submitting never
+	* allocates. try_submit can be called up to DISPATCH_LEVEL, workers run at PASSIVE_LEVEL and take
+	* up to BatchSize items per lock acquisition. Items submitted with a key are coalesced while an
+	* item with the same key is still waiting.
+	*/
+	template <size_t InlineSize = 64, size_t BatchSize = 32>
+	class work_queue {
+	public:
+		work_queue& operator=(const work_queue&) = delete;
+		work_queue(const work_queue&) = delete;
+
+		// workerCount == 0 leaves draining to run_pending
+		work_queue(size_t capacity, size_t workerCount);
+		~work_queue();
+
+		template <typename F>
+		work_queue_result try_submit(F&& callable) {
+			return this->_submit(false, 0, tiny::forward<F>(callable));
+		}
+
+		template <typename F>
+		work_queue_result try_submit(ULONG64 key, F&& callable) {
+			return this->_submit(true, key, tiny::forward<F>(callable));
+		}
+
+		// PASSIVE_LEVEL only, waits for a free node when the queue is full
+		template <typename F>
+		work_queue_result submit(F&& callable, PLARGE_INTEGER timeout = nullptr) {
+			return this->_submitWait(false, 0, tiny::forward<F>(callable), timeout);
+		}
+
+		template <typename F>
+		work_queue_result submit(ULONG64 key, F&& callable, PLARGE_INTEGER timeout = nullptr) {
+			return this->_submitWait(true, key, tiny::forward<F>(callable), timeout);
+		}
+
+		// executes everything pending on the calling thread, returns number of executed items
+		size_t run_pending();
+
+		size_t depth() const noexcept {
+			return _count;
+		}
+
+		size_t capacity() const noexcept {
+			return _nodes.size();
+		}
+
+		work_queue_stats stats();
+	private:
+		struct _node {
+			alignas(16) unsigned char storage[InlineSize];
+			void (*invoke)(void* storage);
+			void (*destroy)(void* storage);
+			ULONG64 key;
+			LONGLONG enqueueTime;
+			bool hasKey;
+		};
+
+		struct _key_slot {
+			ULONG64 key;
+			size_t node; // node index + 1, 0 marks an empty slot
+		};
+
+		tiny::vector<_node> _nodes;
+		tiny::vector<size_t> _ring;
+		tiny::vector<size_t> _free;
+		tiny::vector<_key_slot> _keys;
+		size_t _head;
+		size_t _count;
+		size_t _freeCount;
+
+		tiny::spin_lock _lock;
+		tiny::vector<system_thread*> _workers;
+		KSEMAPHORE _wakeup;
+		KEVENT _space;
+		size_t _idleWorkers;
+		size_t _wakesPending;
+		bool _stopping;
+
+		LONGLONG _frequency;
+		work_queue_stats _stats;
+		ULONG64 _latencyTotal;
+
+		template <typename F>
+		work_queue_result _submit(bool hasKey, ULONG64 key, F&& callable);
+
+		template <typename F>
+		work_queue_result _submitWait(bool hasKey, ULONG64 key, F&& callable, PLARGE_INTEGER timeout);
+
+		static void _workerMain(PVOID context);
+		size_t _takeBatch(size_t* batch);
+		void _runBatch(size_t* batch, size_t count);
+
+		size_t _keySlot(ULONG64 key) const noexcept;
+		size_t _keyFind(ULONG64 key) const noexcept;
+		void _keyErase(ULONG64 key) noexcept;
+	};
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline work_queue<InlineSize, BatchSize>::work_queue(size_t capacity, size_t workerCount)
+		: _head(0), _count(0), _freeCount(capacity), _idleWorkers(0), _wakesPending(0), _stopping(false), _latencyTotal(0) {
+		_nodes.resize(capacity);
+		_ring.resize(capacity);
+		_free.resize(capacity);
+
+		for (size_t i = 0; i < capacity; ++i)
+			_free[i] = capacity - 1 - i;
+
+		// power of two at least twice the capacity keeps probe sequences short
+		size_t keySlots = 1;
+		while (keySlots < capacity * 2)
+			keySlots <<= 1;
+
+		_keys.resize(keySlots);
+		memset(&_stats, 0, sizeof(_stats));
+
+		LARGE_INTEGER frequency;
+		KeQueryPerformanceCounter(&frequency);
+		_frequency = frequency.QuadPart;
+
+		KeInitializeSemaphore(&_wakeup, 0, MAXLONG);
+		KeInitializeEvent(&_space, SynchronizationEvent, FALSE);
+
+		_workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			auto worker = new system_thread();
+			_workers.push_back(worker);
+			worker->start(_workerMain, this);
+		}
+	}
+
+	// Pending items are executed before the workers exit.
+	template <size_t InlineSize, size_t BatchSize>
+	inline work_queue<InlineSize, BatchSize>::~work_queue() {
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+			_stopping = true;
+		}
+
+		KeReleaseSemaphore(&_wakeup, 0, static_cast<LONG>(_workers.size()), FALSE);
+
+		for (auto worker : _workers)
+			delete worker;
+
+		this->run_pending();
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline size_t work_queue<InlineSize, BatchSize>::run_pending() {
+		size_t batch[BatchSize];
+		size_t executed = 0;
+
+		for (auto count = this->_takeBatch(batch); count; count = this->_takeBatch(batch))
+		{
+			this->_runBatch(batch, count);
+			executed += count;
+		}
+
+		return executed;
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline work_queue_stats work_queue<InlineSize, BatchSize>::stats() {
+		tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+		auto result = _stats;
+		result.depth = _count;
+		result.averageLatencyUs = _stats.executed ? _latencyTotal / _stats.executed : 0;
+
+		return result;
+	}
+
+	//
+	// private
+	//
+
+	template <size_t InlineSize, size_t BatchSize>
+	template <typename F>
+	inline work_queue_result work_queue<InlineSize, BatchSize>::_submit(bool hasKey, ULONG64 key, F&& callable) {
+		using Callable = remove_cv_t<remove_reference_t<F>>;
+		static_assert(sizeof(Callable) <= InlineSize, "callable does not fit into the node storage");
+		static_assert(alignof(Callable) <= 16, "callable is over-aligned");
+
+		bool wake = false;
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+			if (hasKey && this->_keyFind(key) != 0)
+			{
+				++_stats.coalesced;
+				return work_queue_result::coalesced;
+			}
+
+			if (!_freeCount)
+			{
+				++_stats.rejected;
+				return work_queue_result::full;
+			}
+
+			auto index = _free[--_freeCount];
+			auto& node = _nodes[index];
+
+			new (node.storage) Callable(tiny::forward<F>(callable));
+			node.invoke = [](void* storage) { (*static_cast<Callable*>(storage))(); };
+			node.destroy = [](void* storage) { static_cast<Callable*>(storage)->~Callable(); };
+			node.hasKey = hasKey;
+			node.key = key;
+			node.enqueueTime = KeQueryPerformanceCounter(nullptr).QuadPart;
+
+			if (hasKey)
+			{
+				auto slot = this->_keySlot(key);
+				_keys[slot].key = key;
+				_keys[slot].node = index + 1;
+			}
+
+			_ring[(_head + _count) % _ring.size()] = index;
+			++_count;
+			++_stats.submitted;
+
+			if (_count > _stats.maxDepth)
+				_stats.maxDepth = _count;
+
+			if (_idleWorkers > _wakesPending)
+			{
+				++_wakesPending;
+				wake = true;
+			}
+		}
+
+		if (wake)
+			KeReleaseSemaphore(&_wakeup, 0, 1, FALSE);
+
+		return work_queue_result::queued;
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	template <typename F>
+	inline work_queue_result work_queue<InlineSize, BatchSize>::_submitWait(bool hasKey, ULONG64 key, F&& callable, PLARGE_INTEGER timeout) {
+		while (true)
+		{
+			auto result = this->_submit(hasKey, key, callable);
+			if (result != work_queue_result::full)
+				return result;
+
+			if (KeWaitForSingleObject(&_space, Executive, KernelMode, FALSE, timeout) == STATUS_TIMEOUT)
+				return result;
+		}
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline void work_queue<InlineSize, BatchSize>::_workerMain(PVOID context) {
+		auto queue = static_cast<work_queue*>(context);
+		size_t batch[BatchSize];
+
+		while (true)
+		{
+			auto count = queue->_takeBatch(batch);
+			if (count)
+			{
+				queue->_runBatch(batch, count);
+				continue;
+			}
+
+			{
+				tiny::scoped_lock<tiny::spin_lock> lock(queue->_lock);
+				if (queue->_count)
+					continue;
+
+				if (queue->_stopping)
+					break;
+
+				++queue->_idleWorkers;
+			}
+
+			KeWaitForSingleObject(&queue->_wakeup, Executive, KernelMode, FALSE, nullptr);
+
+			tiny::scoped_lock<tiny::spin_lock> lock(queue->_lock);
+			--queue->_idleWorkers;
+			if (queue->_wakesPending)
+				--queue->_wakesPending;
+		}
+
+		PsTerminateSystemThread(STATUS_SUCCESS);
+	}
+
+	// Detaches up to BatchSize items, their keys stop coalescing from this point on.
+	template <size_t InlineSize, size_t BatchSize>
+	inline size_t work_queue<InlineSize, BatchSize>::_takeBatch(size_t* batch) {
+		tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+		auto count = _count < BatchSize ? _count : BatchSize;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto index = _ring[_head];
+			_head = (_head + 1) % _ring.size();
+
+			if (_nodes[index].hasKey)
+				this->_keyErase(_nodes[index].key);
+
+			batch[i] = index;
+		}
+
+		_count -= count;
+		if (count)
+			++_stats.batches;
+
+		return count;
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline void work_queue<InlineSize, BatchSize>::_runBatch(size_t* batch, size_t count) {
+		ULONG64 latencyTotal = 0;
+		ULONG64 latencyMax = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto& node = _nodes[batch[i]];
+
+			auto waited = KeQueryPerformanceCounter(nullptr).QuadPart - node.enqueueTime;
+			auto latencyUs = static_cast<ULONG64>(waited) * 1000000 / _frequency;
+			latencyTotal += latencyUs;
+			if (latencyUs > latencyMax)
+				latencyMax = latencyUs;
+
+			node.invoke(node.storage);
+			node.destroy(node.storage);
+		}
+
+		{
+			tiny::scoped_lock<tiny::spin_lock> lock(_lock);
+
+			for (size_t i = 0; i < count; ++i)
+				_free[_freeCount++] = batch[i];
+
+			_stats.executed += count;
+			_latencyTotal += latencyTotal;
+			if (latencyMax > _stats.maxLatencyUs)
+				_stats.maxLatencyUs = latencyMax;
+		}
+
+		KeSetEvent(&_space, 0, FALSE);
+	}
+
+	// Returns the slot holding key or the empty slot where it belongs.
+	template <size_t InlineSize, size_t BatchSize>
+	inline size_t work_queue<InlineSize, BatchSize>::_keySlot(ULONG64 key) const noexcept {
+		auto mask = _keys.size() - 1;
+		auto slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+		while (_keys[slot].node && _keys[slot].key != key)
+			slot = (slot + 1) & mask;
+
+		return slot;
+	}
+
+	template <size_t InlineSize, size_t BatchSize>
+	inline size_t work_queue<InlineSize, BatchSize>::_keyFind(ULONG64 key) const noexcept {
+		return _keys[this->_keySlot(key)].node;
+	}
+
+	// Linear probing deletion, following entries are shifted back so no tombstones are needed.
+	template <size_t InlineSize, size_t BatchSize>
+	inline void work_queue<InlineSize, BatchSize>::_keyErase(ULONG64 key) noexcept {
+		auto mask = _keys.size() - 1;
+		auto hole = this->_keySlot(key);
+		if (!_keys[hole].node)
+			return;
+
+		_keys[hole].node = 0;
+		for (auto slot = (hole + 1) & mask; _keys[slot].node; slot = (slot + 1) & mask)
+		{
+			auto home = static_cast<size_t>((_keys[slot].key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+			// move the entry back when the hole lies between its home slot and its current slot
+			if (((slot - home) & mask) >= ((slot - hole) & mask))
+			{
+				_keys[hole] = _keys[slot];
+				_keys[slot].node = 0;
+				hole = slot;
+			}
+		}
+	}
+}
@@ -0,0 +1,82 @@
+//
+// Prints a trace dump written by tiny::write_trace_dump as text, one event per line.
+// Host tool, build from the repository root with cl /EHsc /IKernelSTL TraceDecoder\trace_decoder.cpp
+//
+// usage: trace_decoder <dump file>
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace_layout.hpp"
+
+static const char* findFormat(const tiny::flat_reader& reader, const tiny::trace_dump& dump, unsigned int id)
+{
+	if (!reader.contains(dump.formats))
+		return nullptr;
+
+	for (auto& format : dump.formats)
+	{
+		if (format.id == id && reader.contains(format.text))
+			return format.text.data();
+	}
+
+	return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <dump file>\n", argv[0]);
+		return 1;
+	}
+
+	auto file = fopen(argv[1], "rb");
+	if (!file)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	auto size = static_cast<size_t>(ftell(file));
+	fseek(file, 0, SEEK_SET);
+
+	// malloc alignment is enough for the 8-byte fields of the layout
+	auto data = malloc(size ? size : 1);
+	auto read = data ? fread(data, 1, size, file) : 0;
+	fclose(file);
+
+	tiny::flat_reader reader(data, read);
+	auto dump = reader.root<tiny::trace_dump>();
+	if (!dump || !reader.contains(dump->records))
+	{
+		fprintf(stderr, "%s is not a trace dump\n", argv[1]);
+		free(data);
+		return 1;
+	}
+
+	auto frequency = dump->frequency ? dump->frequency : 1;
+	auto start = dump->records.empty() ? 0 : dump->records[0].timestamp;
+	char text[1024];
+
+	for (auto& record : dump->records)
+	{
+		auto ticks = record.timestamp - start;
+		auto micros = ticks / frequency * 1000000 + ticks % frequency * 1000000 / frequency;
+
+		auto format = findFormat(reader, *dump, record.format);
+		if (format)
+			tiny::trace_format_record(text, sizeof(text), format, record);
+		else
+			snprintf(text, sizeof(text), "<unknown format %u>", record.format);
+
+		printf("%12llu.%06llu [%u] %s\n", micros / 1000000, micros % 1000000, record.processor, text);
+	}
+
+	if (dump->lost)
+		printf("%llu events lost to overwriting\n", dump->lost);
+
+	free(data);
+	return 0;
+}